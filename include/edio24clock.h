@@ -0,0 +1,100 @@
+/**
+ * \file    edio24clock.h
+ * \brief   The time source and timers for E-DIO24 tools
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ */
+#ifndef _EDIO24CLOCK_H
+#define _EDIO24CLOCK_H 1
+
+#include <stdlib.h>    /* size_t */
+#include <sys/types.h> /* ssize_t */
+#include <stdint.h> // uint64_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define EDIO24_TIMER_IDX_NONE ((size_t)(-1)) /**< the timer is not scheduled */
+
+#define EDIO24_CLOCK_WHEEL_BITS   6  /**< the bits of the time of a level of the wheel */
+#define EDIO24_CLOCK_WHEEL_SLOTS  (1 << EDIO24_CLOCK_WHEEL_BITS) /**< the slots of a level, the bits of a uint64_t */
+#define EDIO24_CLOCK_WHEEL_LEVELS 11 /**< the levels to cover 64 bits of microseconds */
+#define EDIO24_CLOCK_SLOT_LATE    (EDIO24_CLOCK_WHEEL_LEVELS * EDIO24_CLOCK_WHEEL_SLOTS) /**< the slot of the timers started at a time passed */
+
+typedef struct _edio24_timer_t edio24_timer_t;
+typedef struct _edio24_clock_t edio24_clock_t;
+
+/**
+ * \brief the callback function of a timer
+ * \param ptm: the timer
+ * \param userdata: the pointer passed by edio24_timer_start()
+ */
+typedef void (* edio24_timer_cb_t)(edio24_timer_t * ptm, void * userdata);
+
+/**
+ * \brief the callback function when the earliest deadline of a clock may be changed
+ * \param pclk: the clock
+ * \param userdata: the pointer passed by edio24_clock_set_notify()
+ *
+ * The driver of the clock (for example a libuv timer) should re-arm itself.
+ */
+typedef void (* edio24_clock_notify_cb_t)(edio24_clock_t * pclk, void * userdata);
+
+/** a timer, the memory is owned by the caller */
+struct _edio24_timer_t {
+    uint64_t deadline; /**< the time to fire, in microseconds */
+    uint64_t seq;      /**< the sequence number, keep the order of the timers with the same deadline */
+    size_t idx;        /**< the slot in the wheel of the clock, EDIO24_TIMER_IDX_NONE if not scheduled */
+    edio24_timer_t * prev; /**< the timers in the same slot, in the order of start */
+    edio24_timer_t * next;
+    edio24_timer_cb_t cb;
+    void * userdata;
+};
+
+/** a slot of the wheel */
+typedef struct _edio24_clock_slot_t {
+    edio24_timer_t * head;
+    edio24_timer_t * tail;
+} edio24_clock_slot_t;
+
+/** a clock with a queue of timers */
+struct _edio24_clock_t {
+    char flg_virtual;      /**< 1 -- the virtual time, which only moves forward by edio24_clock_forward() */
+    uint64_t time_virtual; /**< the current virtual time, in microseconds */
+    uint64_t time_base;    /**< the monotonic time when the clock starts, in microseconds */
+    uint64_t seq;          /**< the sequence number for the next timer */
+
+    // the hierarchical wheel of the timers, one microsecond per slot of level 0
+    uint64_t time_wheel;   /**< the time the timers are fired up to */
+    uint64_t bitmap[EDIO24_CLOCK_WHEEL_LEVELS]; /**< bit i -- the slot i of the level is not empty */
+    edio24_clock_slot_t slots[EDIO24_CLOCK_SLOT_LATE + 1];
+    size_t sz_cur;         /**< the number of timers in the wheel */
+    char flg_next;         /**< 1 -- deadline_next is the earliest deadline */
+    uint64_t deadline_next;
+
+    edio24_clock_notify_cb_t cb_notify;
+    void * userdata_notify;
+};
+
+int  edio24_clock_init   (edio24_clock_t * pclk, char flg_virtual);
+void edio24_clock_clean  (edio24_clock_t * pclk);
+void edio24_clock_set_notify (edio24_clock_t * pclk, edio24_clock_notify_cb_t cb, void * userdata);
+uint64_t edio24_clock_now (edio24_clock_t * pclk);
+int  edio24_clock_next   (edio24_clock_t * pclk, uint64_t * timeout);
+int  edio24_clock_next_deadline (edio24_clock_t * pclk, uint64_t * deadline);
+size_t edio24_clock_run  (edio24_clock_t * pclk);
+size_t edio24_clock_forward (edio24_clock_t * pclk, uint64_t duration);
+size_t edio24_clock_sleep (edio24_clock_t * pclk, uint64_t duration);
+
+void edio24_timer_init   (edio24_timer_t * ptm);
+int  edio24_timer_start  (edio24_clock_t * pclk, edio24_timer_t * ptm, uint64_t timeout, edio24_timer_cb_t cb, void * userdata);
+int  edio24_timer_start_at (edio24_clock_t * pclk, edio24_timer_t * ptm, uint64_t deadline, edio24_timer_cb_t cb, void * userdata);
+int  edio24_timer_stop   (edio24_clock_t * pclk, edio24_timer_t * ptm);
+#define edio24_timer_is_active(ptm) (EDIO24_TIMER_IDX_NONE != (ptm)->idx)
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif /* _EDIO24CLOCK_H */
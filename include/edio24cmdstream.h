@@ -0,0 +1,55 @@
+/**
+ * \file    edio24cmdstream.h
+ * \brief   The precompiled binary stream of E-DIO24 commands
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ */
+#ifndef _EDIO24CMDSTREAM_H
+#define _EDIO24CMDSTREAM_H 1
+
+#include "libedio24.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define EDIO24_CMDSTREAM_MAGIC    "E24C" /**< the first 4 bytes of a stream */
+#define EDIO24_CMDSTREAM_VERSION  (0x01)
+#define EDIO24_CMDSTREAM_HDR_SIZE 8      /**< the magic, the version and 3 reserved bytes */
+
+// the records following the header
+#define EDIO24_CMDSTREAM_OP_PKT     (0x01) /**< [op][size lo][size hi][packet], the frame id is 0 and the checksum is for frame id 0 */
+#define EDIO24_CMDSTREAM_OP_SLEEP   (0x02) /**< [op][4 bytes microseconds, little endian], move the time of the following records */
+#define EDIO24_CMDSTREAM_OP_BARRIER (0x03) /**< [op], wait for all of the responses of the previous packets */
+
+/** a stream being written, the buffer grows on demand */
+typedef struct _edio24_cmdstream_t {
+    uint8_t * buf;
+    size_t sz_max; /**< the size of the buffer */
+    size_t sz;     /**< the byte size of the stream, including the header */
+} edio24_cmdstream_t;
+
+/** a record read from a stream, the pointers refer to the stream */
+typedef struct _edio24_cmdrec_t {
+    uint8_t op;          /**< EDIO24_CMDSTREAM_OP_xxx */
+    size_t pos;          /**< the offset of the record in the stream */
+    const uint8_t * pkt; /**< the template of the packet, copy it by edio24_cmdstream_emit() */
+    size_t sz_pkt;
+    uint32_t sleep;      /**< the microseconds of EDIO24_CMDSTREAM_OP_SLEEP */
+} edio24_cmdrec_t;
+
+int  edio24_cmdstream_init (edio24_cmdstream_t * pcs);
+void edio24_cmdstream_clean (edio24_cmdstream_t * pcs);
+int  edio24_cmdstream_add_pkt (edio24_cmdstream_t * pcs, const uint8_t * pkt, size_t sz);
+int  edio24_cmdstream_add_sleep (edio24_cmdstream_t * pcs, uint64_t duration);
+int  edio24_cmdstream_add_barrier (edio24_cmdstream_t * pcs);
+
+ssize_t edio24_cmdstream_check (const uint8_t * buf, size_t sz);
+ssize_t edio24_cmdstream_next (const uint8_t * buf, size_t sz, size_t off, edio24_cmdrec_t * prec);
+ssize_t edio24_cmdstream_emit (const edio24_cmdrec_t * prec, uint8_t * buffer, size_t sz_buf, uint8_t * frame_id);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif /* _EDIO24CMDSTREAM_H */
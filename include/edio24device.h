@@ -0,0 +1,96 @@
+/**
+ * \file    edio24device.h
+ * \brief   The state model of a simulated E-DIO24 device
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ */
+#ifndef _EDIO24DEVICE_H
+#define _EDIO24DEVICE_H 1
+
+#include "libedio24.h"
+#include "edio24session.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#if defined(USE_EDIO24_SERVER) && (USE_EDIO24_SERVER == 1)
+
+#define EDIO24_DEVICE_PINS         (0x00FFFFFF) /**< the mask of the 24 DIO pins */
+#define EDIO24_DEVICE_CONFMEM_SIZE 0x10  /**< the byte size of the configuration memory */
+#define EDIO24_DEVICE_SETMEM_SIZE  0x100 /**< the byte size of the settings memory */
+#define EDIO24_DEVICE_USRMEM_SIZE  0xEF0 /**< the byte size of the user memory, address 0 - 0xEEF */
+#define EDIO24_DEVICE_POKE         (0xFF) /**< the command passed to on_change() if the state is changed by the API */
+
+typedef struct _edio24_device_t edio24_device_t;
+
+/** the hooks of a device, all of the callbacks are optional */
+typedef struct _edio24_device_hooks_t {
+    /**
+     * \brief called before a request is processed
+     * \param pdev: the device
+     * \param cmd: the command of the request
+     * \param pkt: the request packet
+     * \param sz: the byte size of the packet
+     * \param userdata: the userdata of the hooks
+     * \return 0 to process the request; >0 the status (EDIO24_STATUS_ERROR_xxx) of a fail response; <0 to drop the request without response
+     */
+    int (* on_request)(edio24_device_t * pdev, uint8_t cmd, const uint8_t * pkt, size_t sz, void * userdata);
+    /**
+     * \brief called after the state of the device is changed
+     * \param pdev: the device
+     * \param cmd: the command changed the state, or EDIO24_DEVICE_POKE
+     * \param userdata: the userdata of the hooks
+     */
+    void (* on_change)(edio24_device_t * pdev, uint8_t cmd, void * userdata);
+    void * userdata;
+} edio24_device_hooks_t;
+
+/** the statistics of a device */
+typedef struct _edio24_device_stats_t {
+    size_t num_request; /**< the number of requests processed */
+    size_t num_fail;    /**< the number of fail responses */
+    size_t num_drop;    /**< the number of requests dropped by the hook */
+} edio24_device_stats_t;
+
+/** the state of a simulated device */
+struct _edio24_device_t {
+    int id;
+
+    uint32_t dconf;   /**< the direction of the pins, 1 -- input, 0 -- output */
+    uint32_t dout;    /**< the output latch */
+    uint32_t din_ext; /**< the levels driven by the outside to the input pins */
+    uint32_t din;     /**< the levels of the pins */
+    uint32_t counter; /**< the event counter, the rising edges of DIO0 */
+    uint16_t status;
+    uint8_t netconf[12]; /**< the IPv4 address, the subnet mask and the gateway */
+
+    uint8_t confmem[EDIO24_DEVICE_CONFMEM_SIZE];
+    uint8_t setmem[EDIO24_DEVICE_SETMEM_SIZE];
+    uint8_t usrmem[EDIO24_DEVICE_USRMEM_SIZE];
+
+    char flg_bootloader; /**< 1 -- the device entered the bootloader by CMD_FIRMWARE */
+    uint8_t blink;       /**< the count of the last CMD_BLINKLED */
+    size_t num_reset;    /**< the number of CMD_RESET */
+
+    edio24_device_hooks_t hooks;
+    edio24_device_stats_t stats;
+};
+
+int  edio24_device_init (edio24_device_t * pdev, int id);
+void edio24_device_reset (edio24_device_t * pdev);
+void edio24_device_set_hooks (edio24_device_t * pdev, const edio24_device_hooks_t * hooks);
+void edio24_device_set_input (edio24_device_t * pdev, uint32_t mask, uint32_t value);
+void edio24_device_set_output (edio24_device_t * pdev, uint32_t mask, uint32_t value);
+void edio24_device_set_config (edio24_device_t * pdev, uint32_t mask, uint32_t value);
+
+int edio24_device_process_tcp (edio24_device_t * pdev, char flg_force_fail, uint8_t * buffer_in, size_t sz_in, uint8_t * buffer_out, size_t *sz_out, size_t * sz_processed, size_t * sz_needed_in, size_t * sz_needed_out);
+void edio24_device_attach (edio24_device_t * pdev, edio24_svrsession_t * psvr);
+
+#endif // USE_EDIO24_SERVER
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif /* _EDIO24DEVICE_H */
@@ -0,0 +1,66 @@
+/**
+ * \file    edio24dmsg.h
+ * \brief   The messages between the edio24d daemon and its clients
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ */
+#ifndef _EDIO24DMSG_H
+#define _EDIO24DMSG_H 1
+
+#include "libedio24.h"
+#include "edio24session.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define EDIO24D_SOCKET_PATH "/tmp/edio24d.sock" /**< the default UNIX domain socket of the daemon */
+
+#define EDIO24D_MSG_START    (0xD4) /**< the first byte of a message */
+#define EDIO24D_MSG_HDR_SIZE 6      /**< [start][type][device lo][device hi][size lo][size hi], followed by the payload */
+#define EDIO24D_MSG_PAYLOAD_MAX (EDIO24_PKT_LENGTH_MIN + 1024) /**< the max byte size of the payload */
+
+// the types of the messages
+#define EDIO24D_MSG_PKT  (0x01) /**< a request packet to the device, or the response packet from the device */
+#define EDIO24D_MSG_LIST (0x02) /**< the states of the devices; the device of the reply is the number of the devices */
+
+#define EDIO24D_LIST_ENTRY_SIZE 8   /**< [state][reserved][IPv4 address, 4 bytes network order][TCP port lo][TCP port hi] */
+
+// the states of a device in the daemon
+#define EDIO24D_DEV_IDLE       0 /**< waiting to retry */
+#define EDIO24D_DEV_OPENING    1 /**< the UDP 'open device' is sent */
+#define EDIO24D_DEV_CONNECTING 2 /**< the TCP connection is in progress */
+#define EDIO24D_DEV_READY      3 /**< the session is ready for requests */
+
+/** a message read from a buffer, the payload refers to the buffer */
+typedef struct _edio24d_msg_t {
+    uint8_t type;      /**< EDIO24D_MSG_xxx */
+    uint16_t device;   /**< the index of the device in the daemon */
+    const uint8_t * payload;
+    size_t sz_payload;
+} edio24d_msg_t;
+
+ssize_t edio24d_msg_create (uint8_t * buffer, size_t sz_buf, uint8_t type, uint16_t device, const uint8_t * payload, size_t sz_payload);
+ssize_t edio24d_msg_read (const uint8_t * buffer, size_t sz_buf, edio24d_msg_t * pmsg);
+uint8_t edio24d_pkt_reframe (uint8_t * pkt, size_t sz, uint8_t frame_id);
+
+/** the transport of a session to a device through the daemon */
+typedef struct _edio24d_client_t {
+    edio24_transport_t base; /**< pass it to edio24_session_init() */
+    edio24_transport_t * ptr; /**< the transport to the daemon, for example the UNIX domain socket */
+    uint16_t device;          /**< the index of the device in the daemon */
+
+    size_t sz_rxmax;
+    size_t sz_rx;
+    uint8_t * rxbuf;
+    size_t num_error;         /**< the number of the illegal messages or the messages of the other devices */
+} edio24d_client_t;
+
+int  edio24d_client_init (edio24d_client_t * pcl, edio24_transport_t * ptr, uint16_t device);
+void edio24d_client_clean (edio24d_client_t * pcl);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif /* _EDIO24DMSG_H */
@@ -0,0 +1,84 @@
+/**
+ * \file    edio24rec.h
+ * \brief   The compact recording of the samples of the devices
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ */
+#ifndef _EDIO24REC_H
+#define _EDIO24REC_H 1
+
+#include "libedio24.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define EDIO24_REC_MAGIC       "E24R" /**< the first 4 bytes of a recording */
+#define EDIO24_REC_VERSION     (0x01)
+#define EDIO24_REC_HDR_SIZE    8      /**< the magic, the version and 3 reserved bytes */
+
+#define EDIO24_REC_CHUNK_MAGIC "E24K" /**< the first 4 bytes of a chunk */
+#define EDIO24_REC_CHUNK_HDR_SIZE 32  /**< [magic][size of records, 4][number of records, 4][FNV-1a of records, 4][first time, 8][last time, 8] */
+#define EDIO24_REC_CHUNK_SIZE  65536  /**< the default max byte size of a chunk */
+#define EDIO24_REC_DEVICES_MAX 1024   /**< the max number of the devices */
+#define EDIO24_REC_PREV_SIZE   (EDIO24_REC_DEVICES_MAX * 8) /**< the number of the values of the state of a decoder */
+
+/** a sample of a device */
+typedef struct _edio24_rec_t {
+    uint64_t time;   /**< the microseconds since the Epoch */
+    uint16_t device; /**< the index of the device */
+    uint8_t cmd;     /**< the read command, EDIO24_CMD_DIN_R, EDIO24_CMD_COUNTER_R etc. */
+    uint32_t value;  /**< the decoded value */
+} edio24_rec_t;
+
+/** the chunk being encoded */
+typedef struct _edio24_rec_writer_t {
+    uint8_t * buf;        /**< the chunk, starts with the header */
+    size_t sz_chunk;      /**< the max byte size of a chunk */
+    size_t sz;            /**< the byte size of the chunk */
+    uint32_t num_records;
+    uint64_t time_first;
+    uint64_t time_last;
+    uint64_t delta;       /**< the time delta of the last record */
+    uint16_t device;      /**< the device of the last record */
+    uint32_t * prev;      /**< the last values of each device and command in the chunk */
+} edio24_rec_writer_t;
+
+int  edio24_rec_writer_init (edio24_rec_writer_t * pw, size_t sz_chunk);
+void edio24_rec_writer_clean (edio24_rec_writer_t * pw);
+int  edio24_rec_writer_append (edio24_rec_writer_t * pw, const edio24_rec_t * prec);
+uint8_t * edio24_rec_writer_take (edio24_rec_writer_t * pw, size_t * psz);
+ssize_t edio24_rec_create_header (uint8_t * buf, size_t sz);
+
+/** the index entry of a chunk */
+typedef struct _edio24_rec_chunk_t {
+    size_t offset;        /**< the offset of the chunk header in the recording */
+    uint32_t sz_data;     /**< the byte size of the records */
+    uint32_t num_records;
+    uint64_t time_first;
+    uint64_t time_last;
+} edio24_rec_chunk_t;
+
+/** the index of a recording in the memory, the recording is not copied */
+typedef struct _edio24_rec_reader_t {
+    const uint8_t * buf;
+    size_t sz;
+    size_t sz_valid;      /**< the byte size of the whole chunks, the rest is a chunk being written or broken */
+    edio24_rec_chunk_t * chunks;
+    size_t num_chunks;
+    uint32_t * prev;      /**< the decoder state */
+} edio24_rec_reader_t;
+
+int  edio24_rec_reader_init (edio24_rec_reader_t * pr, const uint8_t * buf, size_t sz);
+void edio24_rec_reader_clean (edio24_rec_reader_t * pr);
+size_t  edio24_rec_reader_seek (const edio24_rec_reader_t * pr, uint64_t time);
+ssize_t edio24_rec_reader_decode (edio24_rec_reader_t * pr, size_t idx, edio24_rec_t * recs, size_t num);
+ssize_t edio24_rec_decode_chunk (const edio24_rec_reader_t * pr, size_t idx, uint32_t * prev, edio24_rec_t * recs, size_t num);
+
+size_t  edio24_rec_scan_changes (const uint32_t * vals, size_t num, uint32_t prev, uint32_t mask, uint32_t * idx, size_t max);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif /* _EDIO24REC_H */
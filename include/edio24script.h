@@ -0,0 +1,64 @@
+/**
+ * \file    edio24script.h
+ * \brief   The parser of the E-DIO24 command script
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ */
+#ifndef _EDIO24SCRIPT_H
+#define _EDIO24SCRIPT_H 1
+
+#include "libedio24.h"
+#include "edio24cmdstream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// the types of the arguments
+#define EDIO24_SCRIPT_ARG_HEX   1 /**< a hexadecimal number, the prefix 0x is optional */
+#define EDIO24_SCRIPT_ARG_DEC   2 /**< a decimal number */
+#define EDIO24_SCRIPT_ARG_BYTES 3 /**< a hexadecimal byte string, the prefix 0x and pairs of digits */
+
+// the kinds of the commands
+#define EDIO24_SCRIPT_PKT     1 /**< a request packet of the command cmd */
+#define EDIO24_SCRIPT_SLEEP   2 /**< a delay, EDIO24_CMDSTREAM_OP_SLEEP */
+#define EDIO24_SCRIPT_BARRIER 3 /**< wait for the responses, EDIO24_CMDSTREAM_OP_BARRIER */
+
+#define EDIO24_SCRIPT_ARGS_MAX 3
+
+/** the schema of an argument */
+typedef struct _edio24_script_arg_t {
+    uint8_t type;       /**< EDIO24_SCRIPT_ARG_xxx */
+    uint64_t max;       /**< the max value, or the max byte size of EDIO24_SCRIPT_ARG_BYTES */
+    const char * name;
+} edio24_script_arg_t;
+
+/** a command of the script */
+typedef struct _edio24_script_cmd_t {
+    const char * keyword;
+    uint8_t len;        /**< the length of the keyword */
+    uint8_t kind;       /**< EDIO24_SCRIPT_xxx */
+    uint8_t cmd;        /**< EDIO24_CMD_xxx of EDIO24_SCRIPT_PKT */
+    uint8_t num_args;
+    edio24_script_arg_t args[EDIO24_SCRIPT_ARGS_MAX];
+    const char * example; /**< a line of the command */
+} edio24_script_cmd_t;
+
+/** the error of a line */
+typedef struct _edio24_script_err_t {
+    size_t column;      /**< the column of the error, start from 1 */
+    const char * msg;
+    const char * arg;   /**< the name of the argument, NULL if the error is not in an argument */
+} edio24_script_err_t;
+
+int edio24_script_init (void);
+size_t edio24_script_num_cmds (void);
+const edio24_script_cmd_t * edio24_script_cmd (size_t idx);
+const edio24_script_cmd_t * edio24_script_lookup (const char * word, size_t len);
+int edio24_script_compile_line (edio24_cmdstream_t * pcs, const char * line, size_t len, edio24_script_err_t * perr);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif /* _EDIO24SCRIPT_H */
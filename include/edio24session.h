@@ -0,0 +1,279 @@
+/**
+ * \file    edio24session.h
+ * \brief   The client session and the transports of E-DIO24 commands
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ */
+#ifndef _EDIO24SESSION_H
+#define _EDIO24SESSION_H 1
+
+#include "libedio24.h"
+#include "edio24clock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/*****************************************************************************/
+typedef struct _edio24_transport_t edio24_transport_t;
+
+/**
+ * \brief the callback function of the receiver of a transport
+ * \param userdata: the pointer passed by edio24_transport_set_receiver()
+ * \param buf: the data received
+ * \param sz: the byte size of the data
+ */
+typedef void (* edio24_transport_recv_cb_t)(void * userdata, uint8_t * buf, size_t sz);
+
+/** a byte stream between a client session and a device, for example TCP or the loopback */
+struct _edio24_transport_t {
+    /** queue the data to be sent, return the bytes queued, <0 on error */
+    ssize_t (* send)(edio24_transport_t * ptr, const uint8_t * buf, size_t sz);
+    void * data; /**< the owner of the transport */
+
+    edio24_transport_recv_cb_t cb_recv; /**< the receiver, set by the session */
+    void * userdata_recv;
+};
+
+void edio24_transport_set_receiver (edio24_transport_t * ptr, edio24_transport_recv_cb_t cb, void * userdata);
+ssize_t edio24_transport_send (edio24_transport_t * ptr, const uint8_t * buf, size_t sz);
+
+int  edio24_rxbuf_append (uint8_t ** prxbuf, size_t * psz_rxmax, size_t * psz_rx, const uint8_t * buf, size_t sz);
+void edio24_rxbuf_consume (uint8_t * rxbuf, size_t * psz_rx, size_t sz);
+
+/*****************************************************************************/
+/** a byte ring buffer, it grows if the data can't fit in */
+typedef struct _edio24_ring_t {
+    uint8_t * buf;
+    size_t sz_max; /**< the size of the buffer, power of 2 */
+    size_t head;   /**< the total bytes read */
+    size_t tail;   /**< the total bytes written */
+} edio24_ring_t;
+
+int  edio24_ring_init (edio24_ring_t * pr, size_t sz_max);
+void edio24_ring_clean (edio24_ring_t * pr);
+#define edio24_ring_used(pr) ((pr)->tail - (pr)->head)
+ssize_t edio24_ring_write (edio24_ring_t * pr, const uint8_t * buf, size_t sz);
+size_t edio24_ring_peek (edio24_ring_t * pr, uint8_t ** pbuf);
+void edio24_ring_consume (edio24_ring_t * pr, size_t sz);
+
+/*****************************************************************************/
+typedef struct _edio24_loopback_t edio24_loopback_t;
+
+/**
+ * \brief the callback function when the data is queued in a loopback
+ * \param plb: the loopback
+ * \param userdata: the pointer passed by edio24_loopback_set_notify()
+ *
+ * The driver should call edio24_loopback_pump() later.
+ */
+typedef void (* edio24_loopback_notify_cb_t)(edio24_loopback_t * plb, void * userdata);
+
+/** a pair of transports connected by two ring buffers in memory */
+struct _edio24_loopback_t {
+    edio24_transport_t end[2]; /**< end[0] for the client, end[1] for the device */
+    edio24_ring_t ring[2];     /**< ring[i] holds the data sent by end[i] */
+    size_t bytes[2];           /**< the bytes delivered from end[i] */
+
+    edio24_loopback_notify_cb_t cb_notify;
+    void * userdata_notify;
+};
+
+#define edio24_loopback_client(plb) (&((plb)->end[0]))
+#define edio24_loopback_device(plb) (&((plb)->end[1]))
+
+int  edio24_loopback_init (edio24_loopback_t * plb, size_t sz_ring);
+void edio24_loopback_clean (edio24_loopback_t * plb);
+void edio24_loopback_set_notify (edio24_loopback_t * plb, edio24_loopback_notify_cb_t cb, void * userdata);
+size_t edio24_loopback_pump (edio24_loopback_t * plb);
+
+/*****************************************************************************/
+/** a response received */
+typedef struct _edio24_response_t {
+    uint8_t cmd;    /**< the command, without the reply bit */
+    uint8_t frame;  /**< the frame id */
+    uint8_t status; /**< the status, 0 on success */
+    uint16_t count; /**< the byte size of the data */
+    uint8_t * data; /**< the data area */
+    uint8_t * pkt;  /**< the whole packet */
+    size_t sz_pkt;  /**< the byte size of the packet */
+} edio24_response_t;
+
+typedef struct _edio24_session_t edio24_session_t;
+
+/**
+ * \brief the callback function of a request
+ * \param pss: the session
+ * \param presp: the response; NULL if the request is cancelled
+ * \param userdata: the pointer passed by edio24_session_send()
+ */
+typedef void (* edio24_session_cb_t)(edio24_session_t * pss, const edio24_response_t * presp, void * userdata);
+
+/** a request waiting for the response */
+typedef struct _edio24_request_t {
+    uint8_t cmd;
+    uint8_t frame;
+    edio24_session_cb_t cb;
+    void * userdata;
+    size_t seq;     /**< the number of the requests sent before it */
+    uint64_t time;  /**< the time it is sent, if the session has a clock */
+    uint8_t * pkt;  /**< the copy of the packet to be sent again, NULL if the request is not retried */
+    size_t sz_pkt;
+    uint64_t deadline;  /**< the time after which the request is not sent again */
+    size_t num_retries; /**< the number of times the request is sent again */
+} edio24_request_t;
+
+/** a failed request waiting for the backoff to be sent again, see edio24_session_set_retry() */
+typedef struct _edio24_retry_t {
+    edio24_timer_t tm;
+    edio24_session_t * pss;
+    edio24_request_t req;
+    struct _edio24_retry_t * next;
+} edio24_retry_t;
+
+#define EDIO24_SESSION_NUM_READS 10     /**< the number of the read commands, see edio24_session_set_cache() */
+#define EDIO24_SESSION_READ_DATA_MAX 8  /**< the max byte size of the data of a read request to be coalesced */
+
+/** a request waiting for the response of an identical read */
+typedef struct _edio24_waiter_t {
+    uint8_t frame;  /**< the frame id of the request */
+    edio24_session_cb_t cb;
+    void * userdata;
+} edio24_waiter_t;
+
+/** a read in flight, or its response cached */
+typedef struct _edio24_read_t {
+    uint8_t cmd;
+    uint8_t frame;      /**< the frame id of the request sent */
+    char flg_inflight;  /**< 1 -- waiting for the response, 0 -- the response is cached */
+    uint16_t count;     /**< the byte size of the data of the request */
+    uint8_t data[EDIO24_SESSION_READ_DATA_MAX];
+    size_t gen;         /**< the generation of the command when the request is sent */
+    uint64_t time;      /**< the time the response is received */
+    size_t sz_pkt;
+    uint8_t * pkt;      /**< the response cached */
+    size_t num_waiters;
+    size_t sz_waiters;
+    edio24_waiter_t * waiters;
+} edio24_read_t;
+
+/** the statistics of a session */
+typedef struct _edio24_session_stats_t {
+    size_t num_request; /**< the number of requests sent */
+    size_t num_respond; /**< the number of responses matched to the requests */
+    size_t num_error;   /**< the number of the illegal or unexpected packets */
+    size_t num_coalesce; /**< the number of the reads returned by the response of an identical read in flight */
+    size_t num_cached;  /**< the number of the reads returned by the response cached */
+    size_t bytes_out;   /**< the byte size of data sent */
+    size_t bytes_in;    /**< the byte size of data received */
+    size_t window;      /**< the max number of requests in flight, 0 -- no limit, see edio24_session_set_window() */
+    uint64_t rtt_min;   /**< the min microseconds between a request and its response */
+    uint64_t rtt_avg;   /**< the smoothed microseconds between a request and its response */
+    size_t num_backoff_busy; /**< the number of times the window is shrunk by the responses of busy, not ready or timeout */
+    size_t num_backoff_rtt;  /**< the number of times the window is shrunk by the RTT inflated */
+    size_t num_retry;   /**< the number of the requests sent again after busy, timeout or protocol error */
+    size_t num_giveup;  /**< the number of the failed requests not sent again because of the deadline */
+    size_t num_timeout; /**< the number of the requests not responded in time, see edio24_session_set_timeout() */
+} edio24_session_stats_t;
+
+#define EDIO24_SESSION_WINDOW_MAX 256   /**< the default max size of the adaptive window */
+#define EDIO24_SESSION_RTT_SLACK  2000  /**< the microseconds of the RTT over twice the min not taken as the queue of the device */
+#define EDIO24_SESSION_RETRY_BACKOFF 10000   /**< the default microseconds before the first retry of a failed request */
+#define EDIO24_SESSION_RETRY_BUDGET  1000000 /**< the default max microseconds from the first send of a request to its last retry */
+
+/** a client session to a device */
+struct _edio24_session_t {
+    edio24_transport_t * ptr;
+    uint8_t frame; /**< the frame id of the next request, pass &frame to edio24_pkt_create_cmd_xxx() */
+
+    size_t sz_max;    /**< the size of the request queue */
+    size_t head;      /**< the index of the first request in the queue */
+    size_t num;       /**< the number of requests in the queue */
+    edio24_request_t * pending; /**< the requests waiting for the responses */
+
+    size_t sz_rxmax;  /**< the size of the receive buffer */
+    size_t sz_rx;     /**< the byte size of data in the receive buffer */
+    uint8_t * rxbuf;  /**< the received data not processed */
+
+    edio24_session_cb_t cb_default; /**< the callback of the responses not matched */
+    void * userdata_default;
+
+    // the reads coalesced and cached, see edio24_session_set_cache()
+    edio24_clock_t * pclk;  /**< the time of the cache */
+    uint32_t mask_read;     /**< bit i -- the i-th read command is coalesced */
+    uint64_t ttl[EDIO24_SESSION_NUM_READS]; /**< the microseconds to keep the response of the i-th read command */
+    size_t gen[EDIO24_SESSION_NUM_READS]; /**< increased by each request which changes the result of the i-th read command */
+    size_t num_reads;
+    size_t sz_reads;
+    edio24_read_t * reads;
+
+    // the adaptive window of the requests in flight, see edio24_session_set_window()
+    size_t win_min;         /**< 0 -- the window is not adaptive */
+    size_t win_max;
+    size_t ssthresh;        /**< the window grows by one for each response below it, by one for a whole window above it */
+    size_t num_acked;       /**< the responses since the window grows last time, above ssthresh */
+    size_t seq_backoff;     /**< the requests sent before the last backoff don't shrink the window again */
+    size_t num_rtt;         /**< the number of the RTT measured */
+
+    // the failed requests sent again, see edio24_session_set_retry()
+    uint64_t retry_backoff; /**< the microseconds before the first retry, doubled by each retry, 0 -- no retry */
+    uint64_t retry_budget;  /**< the max microseconds from the first send of a request to its last retry */
+    size_t num_retrying;    /**< the number of the requests waiting for the backoff */
+    edio24_retry_t * retries;
+
+    // the deadlines of the requests in flight, see edio24_session_set_timeout()
+    uint64_t timeout;       /**< the microseconds to wait for a response, 0 -- wait forever */
+    edio24_timer_t tm_timeout; /**< armed to the deadline of the oldest request */
+
+    edio24_session_stats_t stats;
+};
+
+int  edio24_session_init (edio24_session_t * pss, edio24_transport_t * ptr);
+void edio24_session_clean (edio24_session_t * pss);
+void edio24_session_set_default (edio24_session_t * pss, edio24_session_cb_t cb, void * userdata);
+int  edio24_session_set_cache (edio24_session_t * pss, edio24_clock_t * pclk, uint8_t cmd, uint64_t ttl);
+int  edio24_session_set_window (edio24_session_t * pss, edio24_clock_t * pclk, size_t win_min, size_t win_max);
+int  edio24_session_set_retry (edio24_session_t * pss, edio24_clock_t * pclk, uint64_t backoff, uint64_t budget);
+int  edio24_session_set_timeout (edio24_session_t * pss, edio24_clock_t * pclk, uint64_t timeout);
+int  edio24_session_send (edio24_session_t * pss, const uint8_t * pkt, size_t sz, edio24_session_cb_t cb, void * userdata);
+int  edio24_session_recv (edio24_session_t * pss, uint8_t * buf, size_t sz);
+#define edio24_session_inflight(pss) ((pss)->num + (pss)->num_retrying) /**< the requests not responded, including the ones waiting to be sent again */
+#define edio24_session_window(pss) ((pss)->stats.window) /**< the max number of requests in flight, 0 -- no limit */
+
+#if defined(USE_EDIO24_SERVER) && (USE_EDIO24_SERVER == 1)
+/*****************************************************************************/
+/**
+ * \brief the callback function to process the requests of a device session
+ * \param userdata: the pointer passed by edio24_svrsession_set_process()
+ *
+ * The other arguments and the return value are the same as edio24_svr_process_tcp()
+ */
+typedef int (* edio24_svr_process_cb_t)(void * userdata, char flg_force_fail, uint8_t * buffer_in, size_t sz_in, uint8_t * buffer_out, size_t *sz_out, size_t * sz_processed, size_t * sz_needed_in, size_t * sz_needed_out);
+
+/** the device side of a transport, the requests are processed by edio24_svr_process_tcp() or the callback set */
+typedef struct _edio24_svrsession_t {
+    edio24_transport_t * ptr;
+    char flg_randfail; /**< 1 -- send out fail message randomly on requests */
+
+    edio24_svr_process_cb_t cb_process; /**< the processor of the requests, NULL -- edio24_svr_process_tcp() */
+    void * userdata_process;
+
+    size_t sz_rxmax;
+    size_t sz_rx;
+    uint8_t * rxbuf;
+
+    size_t num_request; /**< the number of requests processed */
+    size_t num_respond; /**< the number of responses sent */
+} edio24_svrsession_t;
+
+int  edio24_svrsession_init (edio24_svrsession_t * psvr, edio24_transport_t * ptr, char flg_randfail);
+void edio24_svrsession_clean (edio24_svrsession_t * psvr);
+void edio24_svrsession_set_process (edio24_svrsession_t * psvr, edio24_svr_process_cb_t cb, void * userdata);
+int  edio24_svrsession_recv (edio24_svrsession_t * psvr, uint8_t * buf, size_t sz);
+#endif // USE_EDIO24_SERVER
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif /* _EDIO24SESSION_H */
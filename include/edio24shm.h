@@ -0,0 +1,121 @@
+/**
+ * \file    edio24shm.h
+ * \brief   The latest states of the devices in a POSIX shared memory
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ */
+#ifndef _EDIO24SHM_H
+#define _EDIO24SHM_H 1
+
+#include "libedio24.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define EDIO24_SHM_NAME    "/edio24d"  /**< the default name of the shared memory of edio24d */
+#define EDIO24_SHM_MAGIC   0x34494445  /**< "EDI4" */
+#define EDIO24_SHM_VERSION 1
+#define EDIO24_SHM_READ_RETRY 100000   /**< the max times to read a slot being written */
+
+#define EDIO24_SHM_RING_MAGIC   0x52494445  /**< "EDIR" */
+#define EDIO24_SHM_RING_VERSION 1
+#define EDIO24_SHM_RING_ENTRIES 65536       /**< the default number of the samples in the ring */
+
+// the bits of edio24_shm_state_t.flags
+#define EDIO24_SHM_CONNECTED  0x01 /**< the session to the device is ready */
+#define EDIO24_SHM_DIN        0x02 /**< din is valid */
+#define EDIO24_SHM_DOUT       0x04 /**< dout is valid */
+#define EDIO24_SHM_DCONF      0x08 /**< dconf is valid */
+#define EDIO24_SHM_COUNTER    0x10 /**< counter is valid */
+#define EDIO24_SHM_STATUS     0x20 /**< status is valid */
+
+/** the state of a device */
+typedef struct _edio24_shm_state_t {
+    uint32_t flags;   /**< EDIO24_SHM_xxx */
+    uint32_t din;     /**< the DIO pins */
+    uint32_t dout;    /**< the DIO latch */
+    uint32_t dconf;   /**< the DIO configuration, 1 -- input */
+    uint32_t counter; /**< the event counter */
+    uint32_t status;  /**< the device status */
+    uint64_t time;    /**< the microseconds since the Epoch of the last update */
+    uint64_t num_update; /**< the number of the updates */
+} edio24_shm_state_t;
+
+/** the header of the shared memory */
+typedef struct _edio24_shm_hdr_t {
+    uint32_t magic;    /**< EDIO24_SHM_MAGIC */
+    uint32_t version;  /**< EDIO24_SHM_VERSION */
+    uint32_t num_devs; /**< the number of the devices */
+    uint32_t sz_slot;  /**< the byte size of a slot, the slots start from the offset sz_slot */
+} edio24_shm_hdr_t;
+
+/** a slot of a device, the state is protected by the sequence lock */
+typedef struct _edio24_shm_slot_t {
+    uint32_t seq;      /**< odd while the state is being written */
+    uint32_t reserved;
+    edio24_shm_state_t state;
+} edio24_shm_slot_t;
+
+/** a mapping of the shared memory */
+typedef struct _edio24_shm_t {
+    edio24_shm_hdr_t * hdr;
+    size_t size;        /**< the byte size of the mapping */
+    char flg_owner;     /**< 1 -- created by the publisher, unlinked by edio24_shm_close() */
+    char name[64];
+} edio24_shm_t;
+
+int  edio24_shm_state_update (edio24_shm_state_t * pst, const uint8_t * pkt, size_t sz, uint64_t now);
+int  edio24_shm_state_value (const edio24_shm_state_t * pst, uint8_t cmd, uint32_t * pval);
+
+int  edio24_shm_create (edio24_shm_t * pshm, const char * name, size_t num_devs);
+int  edio24_shm_open (edio24_shm_t * pshm, const char * name);
+void edio24_shm_close (edio24_shm_t * pshm);
+int  edio24_shm_publish (edio24_shm_t * pshm, size_t idx, const edio24_shm_state_t * pst);
+int  edio24_shm_read (const edio24_shm_t * pshm, size_t idx, edio24_shm_state_t * pst);
+#define edio24_shm_num_devs(pshm) ((pshm)->hdr->num_devs)
+
+/** a sample of a device */
+typedef struct _edio24_shm_sample_t {
+    uint64_t time;   /**< the microseconds of CLOCK_MONOTONIC */
+    uint16_t device; /**< the index of the device */
+    uint8_t cmd;     /**< the read command, EDIO24_CMD_DIN_R, EDIO24_CMD_COUNTER_R etc. */
+    uint8_t reserved;
+    uint32_t value;  /**< the decoded value */
+} edio24_shm_sample_t;
+
+/** the header of the ring of the samples */
+typedef struct _edio24_shm_ring_hdr_t {
+    uint32_t magic;       /**< EDIO24_SHM_RING_MAGIC */
+    uint32_t version;     /**< EDIO24_SHM_RING_VERSION */
+    uint32_t num_entries; /**< the number of the entries, a power of 2 */
+    uint32_t sz_entry;    /**< the byte size of an entry, the entries start from the offset 64 */
+    uint64_t head;        /**< the number of the samples written */
+} edio24_shm_ring_hdr_t;
+
+/** an entry of the ring */
+typedef struct _edio24_shm_entry_t {
+    uint64_t seq;     /**< the position of the sample + 1, 0 while the sample is being written */
+    edio24_shm_sample_t sample;
+} edio24_shm_entry_t;
+
+/** a mapping of the ring */
+typedef struct _edio24_shm_ring_t {
+    edio24_shm_ring_hdr_t * hdr;
+    size_t size;        /**< the byte size of the mapping */
+    char flg_owner;     /**< 1 -- created by the publisher, unlinked by edio24_shm_ring_close() */
+    char name[64];
+} edio24_shm_ring_t;
+
+int  edio24_shm_ring_create (edio24_shm_ring_t * pring, const char * name, size_t num_entries);
+int  edio24_shm_ring_open (edio24_shm_ring_t * pring, const char * name);
+void edio24_shm_ring_close (edio24_shm_ring_t * pring);
+int  edio24_shm_ring_push (edio24_shm_ring_t * pring, const edio24_shm_sample_t * psample);
+uint64_t edio24_shm_ring_head (const edio24_shm_ring_t * pring);
+ssize_t edio24_shm_ring_read (const edio24_shm_ring_t * pring, uint64_t * pcursor, edio24_shm_sample_t * samples, size_t num, uint64_t * num_lost);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif /* _EDIO24SHM_H */
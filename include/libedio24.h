@@ -53,10 +53,42 @@ extern "C" {
 #endif // __cplusplus
 
 #define EDIO24_PKT_LENGTH_MIN 7 /**< the mininal length of a edio24 packet */
+#define EDIO24_PKT_OFFSET_DATA 6 /**< the offset of the data area in a edio24 packet */
 
 #define EDIO24_PORT_DISCOVER 54211
 #define EDIO24_PORT_COMMAND  54211
 
+// the commands in the TCP packets
+#define EDIO24_CMD_DIN_R        (0x00) /**< Read DIO pins */
+#define EDIO24_CMD_DOUT_R       (0x02) /**< Read DIO latch value */
+#define EDIO24_CMD_DOUT_W       (0x03) /**< Write DIO latch value */
+#define EDIO24_CMD_DCONF_R      (0x04) /**< Read DIO configuration value */
+#define EDIO24_CMD_DCONF_W      (0x05) /**< Write DIO Configuration value */
+#define EDIO24_CMD_COUNTER_R    (0x30) /**< Read event counter */
+#define EDIO24_CMD_COUNTER_W    (0x31) /**< Reset event counter */
+#define EDIO24_CMD_CONF_MEM_R   (0x40) /**< Read configuration memeory */
+#define EDIO24_CMD_CONF_MEM_W   (0x41) /**< Write configuration memory */
+#define EDIO24_CMD_USR_MEM_R    (0x42) /**< Read user memory */
+#define EDIO24_CMD_USR_MEM_W    (0x43) /**< Write user memory */
+#define EDIO24_CMD_SET_MEM_R    (0x44) /**< Read settings memory */
+#define EDIO24_CMD_SET_MEM_W    (0x45) /**< Write settings memory */
+#define EDIO24_CMD_BOOT_MEM_R   (0x46) /**< Read bootloader memory */
+#define EDIO24_CMD_BOOT_MEM_W   (0x47) /**< Write bootloader memory */
+#define EDIO24_CMD_BLINKLED     (0x50) /**< Blink the LED */
+#define EDIO24_CMD_RESET        (0x51) /**< Reset the device */
+#define EDIO24_CMD_STATUS       (0x52) /**< Read the device status */
+#define EDIO24_CMD_NETWORK_CONF (0x54) /**< Read device network configuration */
+#define EDIO24_CMD_FIRMWARE     (0x60) /**< Enter bootloader for firmware upgrade */
+
+// the status in the responses
+#define EDIO24_STATUS_SUCCESS         0 /**< Command succeeded */
+#define EDIO24_STATUS_ERROR_PROTOCOL  1 /**< Command failed due to improper protocol */
+#define EDIO24_STATUS_ERROR_PARAMETER 2 /**< Command failed due to invalid parameters */
+#define EDIO24_STATUS_ERROR_BUSY      3 /**< Command failed because resource was busy */
+#define EDIO24_STATUS_ERROR_READY     4 /**< Command failed because the resource was not ready */
+#define EDIO24_STATUS_ERROR_TIMEOUT   5 /**< Command failed due to a resource timeout */
+#define EDIO24_STATUS_ERROR_OTHER     6 /**< Command failed due to some other error */
+
 // create a packet
 ssize_t edio24_pkt_create_opendev       (uint8_t *buffer, size_t sz_buf, uint32_t connect_code);
 ssize_t edio24_pkt_create_discoverydev  (uint8_t *buffer, size_t sz_buf);
@@ -91,9 +123,10 @@ ssize_t edio24_pkt_create_cmd_setmemw   (uint8_t *buffer, size_t sz_buf, uint8_t
 ssize_t edio24_pkt_create_cmd_bootmemr  (uint8_t *buffer, size_t sz_buf, uint8_t * frame_id, uint16_t address, uint16_t count);
 ssize_t edio24_pkt_create_cmd_bootmemw  (uint8_t *buffer, size_t sz_buf, uint8_t * frame_id, uint16_t address, uint16_t count, uint8_t *buffer_data);
 
-//int edio24_pkt_read_hdr_start   (uint8_t *buffer, size_t sz_buf, uint8_t * value);
+int edio24_pkt_read_hdr_start    (uint8_t *buffer, size_t sz_buf, uint8_t * value);
 int edio24_pkt_read_hdr_command  (uint8_t *buffer, size_t sz_buf, uint8_t * value);
-//int edio24_pkt_read_hdr_frameid (uint8_t *buffer, size_t sz_buf, uint8_t * value);
+int edio24_pkt_read_hdr_frameid  (uint8_t *buffer, size_t sz_buf, uint8_t * value);
+int edio24_pkt_read_hdr_status   (uint8_t *buffer, size_t sz_buf, uint8_t * value);
 int edio24_pkt_read_hdr_count    (uint8_t *buffer, size_t sz_buf, uint16_t * value);
 
 int edio24_pkt_read_ret_doutr    (uint8_t *buffer, size_t sz_buf, uint32_t * value);
@@ -108,6 +141,9 @@ int edio24_pkt_read_ret_confmemr (uint8_t *buffer, size_t sz_buf, uint16_t count
 #define edio24_pkt_read_ret_bootmemr edio24_pkt_read_ret_confmemr
 
 int edio24_pkt_verify (uint8_t *buffer, size_t sz_buf);
+ssize_t edio24_pkt_create_respond (uint8_t * buffer_out, size_t sz_out, uint8_t cmd, uint8_t frame_id, uint8_t status, size_t data_count_respond, uint8_t * buffer_data);
+#define EDIO24_PKT_START  (0xDB) /**< the first byte of a packet */
+#define EDIO24_PKT_REPLY  (0x80) /**< the bit set in the command of a response */
 
 #if defined(USE_EDIO24_SERVER) && (USE_EDIO24_SERVER == 1)
 // for the server simulator
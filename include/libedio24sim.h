@@ -0,0 +1,80 @@
+/**
+ * \file    libedio24sim.h
+ * \brief   The embeddable E-DIO24 simulator, a fleet of simulated devices on a libuv loop
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ */
+#ifndef _LIBEDIO24SIM_H
+#define _LIBEDIO24SIM_H 1
+
+#ifndef USE_EDIO24_SERVER
+#define USE_EDIO24_SERVER 1
+#endif
+
+#include <uv.h>
+
+#include "libedio24.h"
+#include "edio24clock.h"
+#include "edio24session.h"
+#include "edio24device.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+typedef struct _edio24sim_t edio24sim_t;
+
+/** the statistics of the connections of a simulated device */
+typedef struct _edio24sim_stats_t {
+    size_t num_accept;  /**< the number of accepted TCP connections and attached transports */
+    size_t num_reject;  /**< the number of TCP connections rejected because of busy */
+    size_t num_udp;     /**< the number of UDP packets received */
+    size_t num_request; /**< the number of requests processed */
+    size_t num_respond; /**< the number of responses sent */
+    size_t bytes_in;    /**< the byte size of data received */
+    size_t bytes_out;   /**< the byte size of data sent */
+} edio24sim_stats_t;
+
+/** a simulated device in a fleet */
+typedef struct _edio24sim_dev_t {
+    edio24sim_t * psim; /**< the fleet */
+    edio24_device_t dev; /**< the state of the device, query and poke it by edio24_device_xxx() */
+
+    char flg_randfail; /**< 1 -- send out fail message randomly on requests */
+    uint64_t latency;  /**< the time in microseconds the device takes to respond a request, it needs the clock of the fleet */
+
+    char flg_listen; /**< 1 -- the UDP and TCP ports are opened */
+    uv_udp_t uvudp;
+    uv_tcp_t uvtcp;
+    uv_tcp_t * client;          /**< the TCP connection, only one connection is allowed */
+    edio24_transport_t * peer;  /**< the transport attached by edio24sim_attach() */
+
+    edio24_transport_t transport; /**< the responses are sent by it to the client or the peer */
+    edio24_svrsession_t svr;
+    struct _edio24sim_wbuf_t * pending; /**< the responses waiting for the latency */
+
+    edio24sim_stats_t stats;
+} edio24sim_dev_t;
+
+/** a fleet of simulated devices on one loop */
+struct _edio24sim_t {
+    uv_loop_t * loop;
+    edio24_clock_t * clock; /**< the clock of the latency, NULL -- respond immediately */
+    size_t num;             /**< the number of devices */
+    edio24sim_dev_t * devs;
+};
+
+int  edio24sim_init (edio24sim_t * psim, uv_loop_t * loop, size_t num, edio24_clock_t * clock);
+void edio24sim_close (edio24sim_t * psim);
+void edio24sim_clean (edio24sim_t * psim);
+edio24sim_dev_t * edio24sim_dev (edio24sim_t * psim, size_t idx);
+
+int  edio24sim_listen (edio24sim_t * psim, size_t idx, const char * host, int port_udp, int port_tcp, char flg_reuseport);
+int  edio24sim_attach (edio24sim_t * psim, size_t idx, edio24_transport_t * ptr);
+void edio24sim_detach (edio24sim_t * psim, size_t idx);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif /* _LIBEDIO24SIM_H */
@@ -0,0 +1,758 @@
+/**
+ * \file    edio24clock.c
+ * \brief   The time source and timers for E-DIO24 tools
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ *
+ * A clock is either real (the monotonic time of the system) or virtual.
+ * The virtual time only moves forward when the user calls edio24_clock_forward(),
+ * the timers crossed are fired in the order of (deadline, start sequence),
+ * so a test scenario runs as fast as the CPU and gives the same result every run.
+ *
+ * The timers are kept in a hierarchical wheel of 64 slots per level, a slot of level 0 is
+ * one microsecond. Starting and stopping a timer are O(1), so a deadline for each of the
+ * thousands of requests in flight is cheap. The slots of a level are found by the bitmap.
+ */
+
+#include <stdio.h>
+#include <string.h> // memset()
+#include <unistd.h> // usleep()
+#include <assert.h>
+
+#if defined(_WIN32) || defined(__WIN32__)
+#include <windows.h>
+#else
+#include <time.h> // clock_gettime()
+#endif
+
+#include "edio24clock.h"
+
+/**
+ * \brief get the monotonic time of the system
+ * \return the time in microseconds
+ */
+static uint64_t
+edio24_clock_monotonic(void)
+{
+#if defined(_WIN32) || defined(__WIN32__)
+    LARGE_INTEGER freq;
+    LARGE_INTEGER cnt;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&cnt);
+    return (uint64_t)(cnt.QuadPart / freq.QuadPart) * 1000000
+        + (uint64_t)(cnt.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+/**
+ * \brief initialize a clock
+ * \param pclk: the clock
+ * \param flg_virtual: 1 -- use the virtual time; 0 -- use the real time
+ * \return 0 on success, <0 on error
+ */
+int
+edio24_clock_init(edio24_clock_t * pclk, char flg_virtual)
+{
+    if (NULL == pclk) {
+        return -1;
+    }
+    memset(pclk, 0, sizeof(*pclk));
+    pclk->flg_virtual = flg_virtual;
+    pclk->time_virtual = 0;
+    pclk->time_base = edio24_clock_monotonic();
+    return 0;
+}
+
+/**
+ * \brief release the resources of a clock
+ * \param pclk: the clock
+ *
+ * The timers still in the wheel are detached without being fired.
+ */
+void
+edio24_clock_clean(edio24_clock_t * pclk)
+{
+    edio24_timer_t * ptm;
+    size_t i;
+    if (NULL == pclk) {
+        return;
+    }
+    for (i = 0; i <= EDIO24_CLOCK_SLOT_LATE; i ++) {
+        for (ptm = pclk->slots[i].head; NULL != ptm; ptm = ptm->next) {
+            ptm->idx = EDIO24_TIMER_IDX_NONE;
+        }
+        pclk->slots[i].head = pclk->slots[i].tail = NULL;
+    }
+    memset(pclk->bitmap, 0, sizeof(pclk->bitmap));
+    pclk->sz_cur = 0;
+    pclk->flg_next = 0;
+}
+
+/**
+ * \brief set the callback function called when the earliest deadline may be changed
+ * \param pclk: the clock
+ * \param cb: the callback function, NULL to disable
+ * \param userdata: the pointer passed to the callback
+ */
+void
+edio24_clock_set_notify(edio24_clock_t * pclk, edio24_clock_notify_cb_t cb, void * userdata)
+{
+    assert (NULL != pclk);
+    pclk->cb_notify = cb;
+    pclk->userdata_notify = userdata;
+}
+
+/**
+ * \brief get the current time of the clock
+ * \param pclk: the clock
+ * \return the time in microseconds since the clock starts
+ */
+uint64_t
+edio24_clock_now(edio24_clock_t * pclk)
+{
+    assert (NULL != pclk);
+    if (pclk->flg_virtual) {
+        return pclk->time_virtual;
+    }
+    return edio24_clock_monotonic() - pclk->time_base;
+}
+
+#define TIMER_BEFORE(a, b) (((a)->deadline < (b)->deadline) || (((a)->deadline == (b)->deadline) && ((a)->seq < (b)->seq)))
+
+/**
+ * \brief get the slot of a deadline in the wheel
+ * \param pclk: the clock
+ * \param deadline: the deadline of a timer
+ * \return the index of the slot
+ *
+ * The level is the highest group of bits the deadline differs from the time of the wheel,
+ * so the slots of a level never wrap around: a slot above level 0 is cascaded to the lower
+ * levels when the time of the wheel reaches its start.
+ */
+static size_t
+edio24_clock_slot_of(edio24_clock_t * pclk, uint64_t deadline)
+{
+    uint64_t diff;
+    size_t level = 0;
+    if (deadline < pclk->time_wheel) {
+        return EDIO24_CLOCK_SLOT_LATE;
+    }
+    diff = deadline ^ pclk->time_wheel;
+    if (diff > 0) {
+        level = (63 - __builtin_clzll(diff)) / EDIO24_CLOCK_WHEEL_BITS;
+    }
+    return level * EDIO24_CLOCK_WHEEL_SLOTS + ((deadline >> (level * EDIO24_CLOCK_WHEEL_BITS)) & (EDIO24_CLOCK_WHEEL_SLOTS - 1));
+}
+
+/**
+ * \brief append a timer to its slot
+ * \param pclk: the clock
+ * \param ptm: the timer not in the wheel
+ *
+ * The timers started at a time passed are rare, they are sorted by (deadline, seq).
+ */
+static void
+edio24_clock_slot_append(edio24_clock_t * pclk, edio24_timer_t * ptm)
+{
+    size_t idx = edio24_clock_slot_of(pclk, ptm->deadline);
+    edio24_clock_slot_t * ps = &(pclk->slots[idx]);
+    edio24_timer_t * p = ps->tail;
+
+    if (EDIO24_CLOCK_SLOT_LATE == idx) {
+        for (; (NULL != p) && TIMER_BEFORE(ptm, p); p = p->prev);
+    } else {
+        pclk->bitmap[idx / EDIO24_CLOCK_WHEEL_SLOTS] |= (1ULL << (idx % EDIO24_CLOCK_WHEEL_SLOTS));
+    }
+    ptm->prev = p;
+    ptm->next = (NULL == p ? ps->head : p->next);
+    if (NULL != ptm->prev) {
+        ptm->prev->next = ptm;
+    } else {
+        ps->head = ptm;
+    }
+    if (NULL != ptm->next) {
+        ptm->next->prev = ptm;
+    } else {
+        ps->tail = ptm;
+    }
+    ptm->idx = idx;
+}
+
+/**
+ * \brief remove a timer from its slot
+ */
+static void
+edio24_clock_slot_remove(edio24_clock_t * pclk, edio24_timer_t * ptm)
+{
+    edio24_clock_slot_t * ps = &(pclk->slots[ptm->idx]);
+    if (NULL != ptm->prev) {
+        ptm->prev->next = ptm->next;
+    } else {
+        ps->head = ptm->next;
+    }
+    if (NULL != ptm->next) {
+        ptm->next->prev = ptm->prev;
+    } else {
+        ps->tail = ptm->prev;
+    }
+    if ((NULL == ps->head) && (ptm->idx < EDIO24_CLOCK_SLOT_LATE)) {
+        pclk->bitmap[ptm->idx / EDIO24_CLOCK_WHEEL_SLOTS] &= ~(1ULL << (ptm->idx % EDIO24_CLOCK_WHEEL_SLOTS));
+    }
+    ptm->idx = EDIO24_TIMER_IDX_NONE;
+    ptm->prev = ptm->next = NULL;
+}
+
+/**
+ * \brief remove a timer from the wheel without notification
+ * \param pclk: the clock
+ * \param ptm: the timer in the wheel
+ */
+static void
+edio24_clock_queue_remove(edio24_clock_t * pclk, edio24_timer_t * ptm)
+{
+    assert (ptm->idx <= EDIO24_CLOCK_SLOT_LATE);
+    edio24_clock_slot_remove(pclk, ptm);
+    pclk->sz_cur --;
+    if (pclk->flg_next && (ptm->deadline <= pclk->deadline_next)) {
+        pclk->flg_next = 0;
+    }
+}
+
+/**
+ * \brief move the timers of a slot to the lower levels, the time of the wheel is at the start of the slot
+ */
+static void
+edio24_clock_cascade(edio24_clock_t * pclk, size_t idx)
+{
+    edio24_timer_t * ptm = pclk->slots[idx].head;
+    edio24_timer_t * next;
+    pclk->slots[idx].head = pclk->slots[idx].tail = NULL;
+    pclk->bitmap[idx / EDIO24_CLOCK_WHEEL_SLOTS] &= ~(1ULL << (idx % EDIO24_CLOCK_WHEEL_SLOTS));
+    // in the order of start, the timers with the same deadline keep their order
+    for (; NULL != ptm; ptm = next) {
+        next = ptm->next;
+        ptm->prev = ptm->next = NULL;
+        edio24_clock_slot_append(pclk, ptm);
+    }
+}
+
+/**
+ * \brief find the earliest timer
+ * \return the timer, NULL if no timer
+ */
+static edio24_timer_t *
+edio24_clock_earliest(edio24_clock_t * pclk)
+{
+    edio24_timer_t * pmin;
+    edio24_timer_t * p;
+    size_t level;
+
+    if (NULL != pclk->slots[EDIO24_CLOCK_SLOT_LATE].head) {
+        return pclk->slots[EDIO24_CLOCK_SLOT_LATE].head;
+    }
+    for (level = 0; level < EDIO24_CLOCK_WHEEL_LEVELS; level ++) {
+        if (0 == pclk->bitmap[level]) {
+            continue;
+        }
+        pmin = pclk->slots[level * EDIO24_CLOCK_WHEEL_SLOTS + __builtin_ctzll(pclk->bitmap[level])].head;
+        // the deadlines in a slot of level 0 are the same, the others are not sorted
+        for (p = (level > 0 ? pmin->next : NULL); NULL != p; p = p->next) {
+            if (TIMER_BEFORE(p, pmin)) {
+                pmin = p;
+            }
+        }
+        return pmin;
+    }
+    return NULL;
+}
+
+/**
+ * \brief initialize a timer
+ * \param ptm: the timer
+ */
+void
+edio24_timer_init(edio24_timer_t * ptm)
+{
+    assert (NULL != ptm);
+    memset(ptm, 0, sizeof(*ptm));
+    ptm->idx = EDIO24_TIMER_IDX_NONE;
+}
+
+/**
+ * \brief start a timer at a time of the clock, restart it if it is active
+ * \param pclk: the clock
+ * \param ptm: the timer
+ * \param deadline: the time to fire, in microseconds; a time passed fires at the next run
+ * \param cb: the callback function
+ * \param userdata: the pointer passed to the callback
+ * \return 0 on success, <0 on error
+ *
+ * A series of timers started at absolute deadlines do not accumulate the delay of the callbacks.
+ */
+int
+edio24_timer_start_at(edio24_clock_t * pclk, edio24_timer_t * ptm, uint64_t deadline, edio24_timer_cb_t cb, void * userdata)
+{
+    if ((NULL == pclk) || (NULL == ptm) || (NULL == cb)) {
+        return -1;
+    }
+    if (edio24_timer_is_active(ptm)) {
+        edio24_clock_queue_remove(pclk, ptm);
+    }
+    ptm->deadline = deadline;
+    ptm->seq = pclk->seq ++;
+    ptm->cb = cb;
+    ptm->userdata = userdata;
+    edio24_clock_slot_append(pclk, ptm);
+    pclk->sz_cur ++;
+
+    if (1 == pclk->sz_cur) {
+        pclk->flg_next = 1;
+        pclk->deadline_next = deadline;
+    } else if (pclk->flg_next) {
+        if (deadline >= pclk->deadline_next) {
+            return 0;
+        }
+        pclk->deadline_next = deadline;
+    }
+    // the new timer may be the earliest
+    if (NULL != pclk->cb_notify) {
+        pclk->cb_notify(pclk, pclk->userdata_notify);
+    }
+    return 0;
+}
+
+/**
+ * \brief start a timer, restart it if it is active
+ * \param pclk: the clock
+ * \param ptm: the timer
+ * \param timeout: the time to wait, in microseconds
+ * \param cb: the callback function
+ * \param userdata: the pointer passed to the callback
+ * \return 0 on success, <0 on error
+ */
+int
+edio24_timer_start(edio24_clock_t * pclk, edio24_timer_t * ptm, uint64_t timeout, edio24_timer_cb_t cb, void * userdata)
+{
+    if (NULL == pclk) {
+        return -1;
+    }
+    return edio24_timer_start_at(pclk, ptm, edio24_clock_now(pclk) + timeout, cb, userdata);
+}
+
+/**
+ * \brief stop a timer
+ * \param pclk: the clock
+ * \param ptm: the timer
+ * \return 0 on success, <0 on error
+ */
+int
+edio24_timer_stop(edio24_clock_t * pclk, edio24_timer_t * ptm)
+{
+    char flg_first;
+    if ((NULL == pclk) || (NULL == ptm)) {
+        return -1;
+    }
+    if (! edio24_timer_is_active(ptm)) {
+        return 0;
+    }
+    flg_first = ((! pclk->flg_next) || (ptm->deadline <= pclk->deadline_next));
+    edio24_clock_queue_remove(pclk, ptm);
+    if (flg_first && (NULL != pclk->cb_notify)) {
+        pclk->cb_notify(pclk, pclk->userdata_notify);
+    }
+    return 0;
+}
+
+/**
+ * \brief get the earliest deadline of the timers
+ * \param pclk: the clock
+ * \param deadline: the time of the clock the next timer fires, in microseconds
+ * \return 0 on success, <0 if no timer in the wheel
+ */
+int
+edio24_clock_next_deadline(edio24_clock_t * pclk, uint64_t * deadline)
+{
+    assert (NULL != pclk);
+    if (pclk->sz_cur < 1) {
+        return -1;
+    }
+    if (! pclk->flg_next) {
+        pclk->deadline_next = edio24_clock_earliest(pclk)->deadline;
+        pclk->flg_next = 1;
+    }
+    if (NULL != deadline) {
+        *deadline = pclk->deadline_next;
+    }
+    return 0;
+}
+
+/**
+ * \brief get the time to wait for the next timer
+ * \param pclk: the clock
+ * \param timeout: the time to wait, in microseconds; 0 if the timer is due
+ * \return 0 on success, <0 if no timer in the wheel
+ */
+int
+edio24_clock_next(edio24_clock_t * pclk, uint64_t * timeout)
+{
+    uint64_t deadline;
+    uint64_t now;
+    if (edio24_clock_next_deadline(pclk, &deadline) < 0) {
+        return -1;
+    }
+    now = edio24_clock_now(pclk);
+    if (NULL != timeout) {
+        *timeout = (deadline > now ? deadline - now : 0);
+    }
+    return 0;
+}
+
+/**
+ * \brief fire the timers which deadline is not after the time
+ * \param pclk: the clock
+ * \param now: the time
+ * \return the number of timers fired
+ */
+static size_t
+edio24_clock_run_until(edio24_clock_t * pclk, uint64_t now)
+{
+    edio24_timer_t * ptm;
+    uint64_t start;
+    size_t level;
+    size_t idx;
+    size_t cnt = 0;
+
+    for (;;) {
+        // the timers started at a time passed are before all of the others in the wheel
+        ptm = pclk->slots[EDIO24_CLOCK_SLOT_LATE].head;
+        if (NULL == ptm) {
+            for (level = 0; (level < EDIO24_CLOCK_WHEEL_LEVELS) && (0 == pclk->bitmap[level]); level ++);
+            if (level >= EDIO24_CLOCK_WHEEL_LEVELS) {
+                break;
+            }
+            idx = level * EDIO24_CLOCK_WHEEL_SLOTS + __builtin_ctzll(pclk->bitmap[level]);
+            if (level > 0) {
+                // the start of the slot, the bits above the level are the same as the time of the wheel
+                start = ((uint64_t)(idx % EDIO24_CLOCK_WHEEL_SLOTS) << (level * EDIO24_CLOCK_WHEEL_BITS));
+                if ((level + 1) * EDIO24_CLOCK_WHEEL_BITS < 64) {
+                    start |= pclk->time_wheel & ~((1ULL << ((level + 1) * EDIO24_CLOCK_WHEEL_BITS)) - 1);
+                }
+                if (start > now) {
+                    break;
+                }
+                pclk->time_wheel = start;
+                edio24_clock_cascade(pclk, idx);
+                continue;
+            }
+            ptm = pclk->slots[idx].head;
+            if (ptm->deadline > now) {
+                break;
+            }
+            pclk->time_wheel = ptm->deadline;
+        }
+        edio24_clock_queue_remove(pclk, ptm);
+        if (pclk->flg_virtual && (pclk->time_virtual < ptm->deadline)) {
+            pclk->time_virtual = ptm->deadline;
+        }
+        cnt ++;
+        ptm->cb(ptm, ptm->userdata);
+    }
+    if (pclk->time_wheel < now) {
+        pclk->time_wheel = now;
+    }
+    if ((cnt > 0) && (NULL != pclk->cb_notify)) {
+        pclk->cb_notify(pclk, pclk->userdata_notify);
+    }
+    return cnt;
+}
+
+/**
+ * \brief fire the timers which are due
+ * \param pclk: the clock
+ * \return the number of timers fired
+ */
+size_t
+edio24_clock_run(edio24_clock_t * pclk)
+{
+    assert (NULL != pclk);
+    return edio24_clock_run_until(pclk, edio24_clock_now(pclk));
+}
+
+/**
+ * \brief move the virtual time forward
+ * \param pclk: the clock
+ * \param duration: the time to move, in microseconds
+ * \return the number of timers fired
+ *
+ * The timers crossed are fired in order, and the time seen by each callback is its deadline.
+ * It only fires the due timers for a real clock.
+ */
+size_t
+edio24_clock_forward(edio24_clock_t * pclk, uint64_t duration)
+{
+    uint64_t end;
+    size_t cnt;
+    assert (NULL != pclk);
+    if (! pclk->flg_virtual) {
+        return edio24_clock_run(pclk);
+    }
+    end = pclk->time_virtual + duration;
+    cnt = edio24_clock_run_until(pclk, end);
+    if (pclk->time_virtual < end) {
+        pclk->time_virtual = end;
+    }
+    return cnt;
+}
+
+/**
+ * \brief sleep on the clock
+ * \param pclk: the clock
+ * \param duration: the time to sleep, in microseconds
+ * \return the number of timers fired
+ *
+ * It returns immediately for a virtual clock, after moving the time forward.
+ */
+size_t
+edio24_clock_sleep(edio24_clock_t * pclk, uint64_t duration)
+{
+    assert (NULL != pclk);
+    if (! pclk->flg_virtual) {
+        usleep(duration);
+    }
+    return edio24_clock_forward(pclk, duration);
+}
+
+#if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
+#include <ciut.h>
+
+static void
+test_clock_record_cb(edio24_timer_t * ptm, void * userdata)
+{
+    uint64_t * log = (uint64_t *)userdata;
+    /* log[0]: the number of records; log[1..]: the (seq << 32 | deadline) of the timers fired */
+    log[0] ++;
+    log[log[0]] = (ptm->seq << 32) | (ptm->deadline & 0xFFFFFFFF);
+}
+
+typedef struct _test_clock_chain_t {
+    edio24_clock_t * pclk;
+    edio24_timer_t tm;
+    int cnt;
+    uint64_t times[10];
+} test_clock_chain_t;
+
+static void
+test_clock_chain_cb(edio24_timer_t * ptm, void * userdata)
+{
+    test_clock_chain_t * pc = (test_clock_chain_t *)userdata;
+    pc->times[pc->cnt] = edio24_clock_now(pc->pclk);
+    pc->cnt ++;
+    if (pc->cnt < 10) {
+        edio24_timer_start(pc->pclk, ptm, 1000, test_clock_chain_cb, pc);
+    }
+}
+
+typedef struct _test_clock_order_t {
+    edio24_clock_t * pclk;
+    uint32_t rand;       /**< the state of the random numbers */
+    size_t cnt;          /**< the number of timers fired */
+    size_t num_restart;  /**< the max number of timers restarted in the callback */
+    size_t err;          /**< the number of timers fired out of order or not at the deadline */
+    uint64_t deadline;   /**< the last timer fired */
+    uint64_t seq;
+} test_clock_order_t;
+
+static uint32_t
+test_clock_rand(test_clock_order_t * po)
+{
+    po->rand = po->rand * 1103515245 + 12345;
+    return (po->rand >> 8);
+}
+
+/* the timeout of a random level of the wheel */
+static uint64_t
+test_clock_rand_timeout(test_clock_order_t * po)
+{
+    uint64_t tmo = ((uint64_t)test_clock_rand(po) << 24) | test_clock_rand(po);
+    return tmo & ((1ULL << (test_clock_rand(po) % 40)) - 1);
+}
+
+static void
+test_clock_order_cb(edio24_timer_t * ptm, void * userdata)
+{
+    test_clock_order_t * po = (test_clock_order_t *)userdata;
+    if ((ptm->deadline < po->deadline) || ((ptm->deadline == po->deadline) && (ptm->seq < po->seq))
+        || (ptm->deadline != edio24_clock_now(po->pclk))) {
+        po->err ++;
+    }
+    po->deadline = ptm->deadline;
+    po->seq = ptm->seq;
+    po->cnt ++;
+    if (po->num_restart > 0) {
+        po->num_restart --;
+        edio24_timer_start(po->pclk, ptm, test_clock_rand(po) % 3 * test_clock_rand_timeout(po), test_clock_order_cb, po);
+    }
+}
+
+TEST_CASE( .name="edio24-clock", .description="test edio24 virtual clock and timers.", .skip=0 ) {
+    edio24_clock_t clk;
+    edio24_timer_t tms[8];
+    uint64_t log[20];
+    uint64_t tmo;
+    size_t i;
+
+    SECTION("test parameters for edio24_clock_xxx") {
+        REQUIRE(0 > edio24_clock_init(NULL, 1));
+        REQUIRE(0 == edio24_clock_init(&clk, 1));
+        REQUIRE(0 == edio24_clock_now(&clk));
+        REQUIRE(0 > edio24_clock_next(&clk, &tmo));
+        edio24_timer_init(&(tms[0]));
+        REQUIRE(0 == edio24_timer_is_active(&(tms[0])));
+        REQUIRE(0 > edio24_timer_start(NULL, &(tms[0]), 10, test_clock_record_cb, log));
+        REQUIRE(0 > edio24_timer_start(&clk, NULL, 10, test_clock_record_cb, log));
+        REQUIRE(0 > edio24_timer_start(&clk, &(tms[0]), 10, NULL, log));
+        REQUIRE(0 == edio24_timer_stop(&clk, &(tms[0])));
+        REQUIRE(0 == edio24_clock_forward(&clk, 1234));
+        REQUIRE(1234 == edio24_clock_now(&clk));
+        REQUIRE(0 == edio24_clock_sleep(&clk, 3600000000ULL));
+        REQUIRE(3600001234ULL == edio24_clock_now(&clk));
+        edio24_clock_clean(&clk);
+    }
+    SECTION("test the order of the timers") {
+        static const uint64_t timeouts[8] = {50, 10, 30, 10, 70, 20, 10, 60};
+        memset(log, 0, sizeof(log));
+        REQUIRE(0 == edio24_clock_init(&clk, 1));
+        for (i = 0; i < 8; i ++) {
+            edio24_timer_init(&(tms[i]));
+            REQUIRE(0 == edio24_timer_start(&clk, &(tms[i]), timeouts[i], test_clock_record_cb, log));
+            REQUIRE(edio24_timer_is_active(&(tms[i])));
+        }
+        REQUIRE(0 == edio24_clock_next(&clk, &tmo));
+        REQUIRE(10 == tmo);
+        /* restart timer 4 to 15, and stop timer 7 */
+        REQUIRE(0 == edio24_timer_start(&clk, &(tms[4]), 15, test_clock_record_cb, log));
+        REQUIRE(0 == edio24_timer_stop(&clk, &(tms[7])));
+        REQUIRE(0 == edio24_timer_is_active(&(tms[7])));
+
+        REQUIRE(3 == edio24_clock_forward(&clk, 10));
+        REQUIRE(10 == edio24_clock_now(&clk));
+        /* the timers with the same deadline fire in the order of start */
+        REQUIRE(((uint64_t)1 << 32 | 10) == log[1]);
+        REQUIRE(((uint64_t)3 << 32 | 10) == log[2]);
+        REQUIRE(((uint64_t)6 << 32 | 10) == log[3]);
+
+        REQUIRE(0 == edio24_clock_next(&clk, &tmo));
+        REQUIRE(5 == tmo);
+        REQUIRE(4 == edio24_clock_forward(&clk, 90));
+        REQUIRE(100 == edio24_clock_now(&clk));
+        REQUIRE(7 == log[0]);
+        REQUIRE(((uint64_t)8 << 32 | 15) == log[4]);
+        REQUIRE(20 == (log[5] & 0xFFFFFFFF));
+        REQUIRE(30 == (log[6] & 0xFFFFFFFF));
+        REQUIRE(50 == (log[7] & 0xFFFFFFFF));
+        REQUIRE(0 > edio24_clock_next(&clk, &tmo));
+        for (i = 0; i < 8; i ++) {
+            REQUIRE(0 == edio24_timer_is_active(&(tms[i])));
+        }
+        edio24_clock_clean(&clk);
+    }
+    SECTION("test the timers started in the callback") {
+        test_clock_chain_t chain;
+        memset(&chain, 0, sizeof(chain));
+        REQUIRE(0 == edio24_clock_init(&clk, 1));
+        chain.pclk = &clk;
+        edio24_timer_init(&(chain.tm));
+        REQUIRE(0 == edio24_timer_start(&clk, &(chain.tm), 1000, test_clock_chain_cb, &chain));
+        /* a 10 ms chain of timers in one step */
+        REQUIRE(10 == edio24_clock_forward(&clk, 3600000000ULL));
+        REQUIRE(10 == chain.cnt);
+        for (i = 0; i < 10; i ++) {
+            REQUIRE((i + 1) * 1000 == chain.times[i]);
+        }
+        REQUIRE(3600000000ULL == edio24_clock_now(&clk));
+        edio24_clock_clean(&clk);
+    }
+    SECTION("test the timers started at a deadline") {
+        memset(log, 0, sizeof(log));
+        REQUIRE(0 == edio24_clock_init(&clk, 1));
+        edio24_timer_init(&(tms[0]));
+        edio24_timer_init(&(tms[1]));
+        REQUIRE(0 > edio24_timer_start_at(NULL, &(tms[0]), 10, test_clock_record_cb, log));
+        REQUIRE(0 > edio24_timer_start_at(&clk, &(tms[0]), 10, NULL, log));
+        REQUIRE(0 == edio24_clock_forward(&clk, 100));
+        REQUIRE(0 == edio24_timer_start_at(&clk, &(tms[0]), 250, test_clock_record_cb, log));
+        /* a deadline passed is due at once */
+        REQUIRE(0 == edio24_timer_start_at(&clk, &(tms[1]), 40, test_clock_record_cb, log));
+        REQUIRE(0 == edio24_clock_next(&clk, &tmo));
+        REQUIRE(0 == tmo);
+        REQUIRE(1 == edio24_clock_forward(&clk, 0));
+        REQUIRE(40 == (log[1] & 0xFFFFFFFF));
+        REQUIRE(100 == edio24_clock_now(&clk));
+        REQUIRE(0 == edio24_clock_next(&clk, &tmo));
+        REQUIRE(150 == tmo);
+        REQUIRE(1 == edio24_clock_forward(&clk, 1000));
+        REQUIRE(250 == (log[2] & 0xFFFFFFFF));
+        REQUIRE(2 == log[0]);
+        edio24_clock_clean(&clk);
+    }
+    SECTION("test the order of the timers in the wheel") {
+        static edio24_timer_t tmw[2000];
+        test_clock_order_t order;
+        size_t num_active = 0;
+        memset(&order, 0, sizeof(order));
+        REQUIRE(0 == edio24_clock_init(&clk, 1));
+        order.pclk = &clk;
+        order.rand = 1;
+        order.num_restart = 1000;
+        for (i = 0; i < 2000; i ++) {
+            edio24_timer_init(&(tmw[i]));
+            REQUIRE(0 == edio24_timer_start(&clk, &(tmw[i]), test_clock_rand_timeout(&order), test_clock_order_cb, &order));
+            if (i % 7 == 3) {
+                REQUIRE(0 == edio24_timer_stop(&clk, &(tmw[i - 2])));
+            }
+            if (i % 5 == 4) {
+                /* the same deadline as a timer started before */
+                REQUIRE(0 == edio24_timer_start_at(&clk, &(tmw[i]), tmw[i - 1].deadline, test_clock_order_cb, &order));
+            }
+            if (i % 100 == 99) {
+                edio24_clock_forward(&clk, test_clock_rand_timeout(&order));
+                REQUIRE(0 == order.err);
+            }
+        }
+        for (i = 0; i < 2000; i ++) {
+            if (edio24_timer_is_active(&(tmw[i]))) {
+                num_active ++;
+            }
+        }
+        REQUIRE(num_active == clk.sz_cur);
+        REQUIRE(0 == edio24_clock_next(&clk, &tmo));
+        num_active += order.cnt + order.num_restart;
+        edio24_clock_forward(&clk, 1ULL << 41);
+        REQUIRE(0 == order.err);
+        REQUIRE(0 == order.num_restart);
+        REQUIRE(num_active == order.cnt);
+        REQUIRE(0 == clk.sz_cur);
+        REQUIRE(0 > edio24_clock_next(&clk, &tmo));
+        edio24_clock_clean(&clk);
+    }
+    SECTION("test the real clock") {
+        uint64_t t0;
+        memset(log, 0, sizeof(log));
+        REQUIRE(0 == edio24_clock_init(&clk, 0));
+        t0 = edio24_clock_now(&clk);
+        edio24_timer_init(&(tms[0]));
+        REQUIRE(0 == edio24_timer_start(&clk, &(tms[0]), 1000, test_clock_record_cb, log));
+        edio24_clock_sleep(&clk, 100);
+        edio24_clock_sleep(&clk, 2000);
+        REQUIRE(1 == log[0]);
+        REQUIRE(0 == edio24_timer_is_active(&(tms[0])));
+        REQUIRE(edio24_clock_now(&clk) >= t0 + 2100);
+        edio24_clock_clean(&clk);
+    }
+}
+
+#endif /* CIUT_ENABLED */
@@ -0,0 +1,390 @@
+/**
+ * \file    edio24cmdstream.c
+ * \brief   The precompiled binary stream of E-DIO24 commands
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ *
+ * A script of commands is compiled once into a stream of records: the packets are encoded
+ * with the frame id 0, and the Sleep lines become timing records. A client maps the file
+ * and walks the records, it only copies a packet and patches the frame id and the checksum
+ * to send it, no text is parsed.
+ */
+
+#include <stdio.h>
+#include <string.h> // memcpy()
+#include <assert.h>
+
+#include "edio24cmdstream.h"
+
+#define EDIO24_PKT_OFFSET_FRAME 2 /**< the offset of the frame id in a edio24 packet */
+#ifndef EDIO24_PKT_LENGTH_MAX
+#define EDIO24_PKT_LENGTH_MAX (EDIO24_PKT_LENGTH_MIN + 1024) /**< the count of data is not larger than 1024 */
+#endif
+
+/**
+ * \brief reserve the space at the end of a stream
+ * \param pcs: the stream
+ * \param sz: the byte size to be appended
+ * \return the pointer to the space, NULL on error
+ */
+static uint8_t *
+edio24_cmdstream_reserve (edio24_cmdstream_t * pcs, size_t sz)
+{
+    uint8_t * p;
+    if (pcs->sz + sz > pcs->sz_max) {
+        size_t sz_new = (pcs->sz_max < 256 ? 256 : pcs->sz_max);
+        while (sz_new < pcs->sz + sz) {
+            sz_new *= 2;
+        }
+        p = (uint8_t *)realloc(pcs->buf, sz_new);
+        if (NULL == p) {
+            fprintf(stderr, "edio24 error: out of memory for command stream\n");
+            return NULL;
+        }
+        pcs->buf = p;
+        pcs->sz_max = sz_new;
+    }
+    p = pcs->buf + pcs->sz;
+    pcs->sz += sz;
+    return p;
+}
+
+/**
+ * \brief initialize a stream with the header
+ * \param pcs: the stream
+ * \return 0 on success, <0 on error
+ */
+int
+edio24_cmdstream_init (edio24_cmdstream_t * pcs)
+{
+    uint8_t * p;
+    if (NULL == pcs) {
+        return -1;
+    }
+    memset(pcs, 0, sizeof(*pcs));
+    p = edio24_cmdstream_reserve(pcs, EDIO24_CMDSTREAM_HDR_SIZE);
+    if (NULL == p) {
+        return -1;
+    }
+    memset(p, 0, EDIO24_CMDSTREAM_HDR_SIZE);
+    memcpy(p, EDIO24_CMDSTREAM_MAGIC, 4);
+    p[4] = EDIO24_CMDSTREAM_VERSION;
+    return 0;
+}
+
+void
+edio24_cmdstream_clean (edio24_cmdstream_t * pcs)
+{
+    if (NULL == pcs) {
+        return;
+    }
+    free(pcs->buf);
+    memset(pcs, 0, sizeof(*pcs));
+}
+
+/**
+ * \brief append a packet
+ * \param pcs: the stream
+ * \param pkt: the packet created by edio24_pkt_create_cmd_xxx(), with any frame id
+ * \param sz: the byte size of the packet
+ * \return 0 on success, <0 on error
+ */
+int
+edio24_cmdstream_add_pkt (edio24_cmdstream_t * pcs, const uint8_t * pkt, size_t sz)
+{
+    uint8_t * p;
+    if ((NULL == pcs) || (NULL == pkt) || (sz < EDIO24_PKT_LENGTH_MIN) || (sz > EDIO24_PKT_LENGTH_MAX)) {
+        return -1;
+    }
+    if (EDIO24_PKT_START != pkt[0]) {
+        return -1;
+    }
+    p = edio24_cmdstream_reserve(pcs, 3 + sz);
+    if (NULL == p) {
+        return -1;
+    }
+    p[0] = EDIO24_CMDSTREAM_OP_PKT;
+    p[1] = sz & 0xFF;
+    p[2] = (sz >> 8) & 0xFF;
+    memcpy(p + 3, pkt, sz);
+    /* the template has the frame id 0, the checksum is 0xFF - sum */
+    p[3 + sz - 1] += p[3 + EDIO24_PKT_OFFSET_FRAME];
+    p[3 + EDIO24_PKT_OFFSET_FRAME] = 0;
+    return 0;
+}
+
+/**
+ * \brief append a delay
+ * \param pcs: the stream
+ * \param duration: the microseconds, a long delay is split into several records
+ * \return 0 on success, <0 on error
+ */
+int
+edio24_cmdstream_add_sleep (edio24_cmdstream_t * pcs, uint64_t duration)
+{
+    uint8_t * p;
+    uint32_t val;
+    if (NULL == pcs) {
+        return -1;
+    }
+    while (duration > 0) {
+        val = (duration > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)duration);
+        p = edio24_cmdstream_reserve(pcs, 5);
+        if (NULL == p) {
+            return -1;
+        }
+        p[0] = EDIO24_CMDSTREAM_OP_SLEEP;
+        p[1] = val & 0xFF;
+        p[2] = (val >> 8) & 0xFF;
+        p[3] = (val >> 16) & 0xFF;
+        p[4] = (val >> 24) & 0xFF;
+        duration -= val;
+    }
+    return 0;
+}
+
+/**
+ * \brief append a barrier
+ * \param pcs: the stream
+ * \return 0 on success, <0 on error
+ */
+int
+edio24_cmdstream_add_barrier (edio24_cmdstream_t * pcs)
+{
+    uint8_t * p;
+    if (NULL == pcs) {
+        return -1;
+    }
+    p = edio24_cmdstream_reserve(pcs, 1);
+    if (NULL == p) {
+        return -1;
+    }
+    p[0] = EDIO24_CMDSTREAM_OP_BARRIER;
+    return 0;
+}
+
+/**
+ * \brief check the header of a stream
+ * \param buf: the data, for example a mapped file
+ * \param sz: the byte size of the data
+ * \return the offset of the first record, <0 if it is not a stream of the supported version
+ */
+ssize_t
+edio24_cmdstream_check (const uint8_t * buf, size_t sz)
+{
+    if ((NULL == buf) || (sz < EDIO24_CMDSTREAM_HDR_SIZE)) {
+        return -1;
+    }
+    if (0 != memcmp(buf, EDIO24_CMDSTREAM_MAGIC, 4)) {
+        return -1;
+    }
+    if (EDIO24_CMDSTREAM_VERSION != buf[4]) {
+        fprintf(stderr, "edio24 error: unsupported command stream version %d\n", buf[4]);
+        return -1;
+    }
+    return EDIO24_CMDSTREAM_HDR_SIZE;
+}
+
+/**
+ * \brief read a record
+ * \param buf: the stream
+ * \param sz: the byte size of the stream
+ * \param off: the offset of the record
+ * \param prec: return the record
+ * \return the byte size of the record, add it to the offset for the next one; 0 at the end of the stream; <0 if the record is broken
+ */
+ssize_t
+edio24_cmdstream_next (const uint8_t * buf, size_t sz, size_t off, edio24_cmdrec_t * prec)
+{
+    const uint8_t * p;
+    size_t sz_pkt;
+    uint16_t count;
+
+    assert (NULL != prec);
+    if (off >= sz) {
+        return 0;
+    }
+    assert (NULL != buf);
+    p = buf + off;
+    prec->op = p[0];
+    prec->pos = off;
+    switch (p[0]) {
+    case EDIO24_CMDSTREAM_OP_PKT:
+        if (off + 3 > sz) {
+            return -1;
+        }
+        sz_pkt = p[1] | ((size_t)p[2] << 8);
+        if ((sz_pkt < EDIO24_PKT_LENGTH_MIN) || (off + 3 + sz_pkt > sz)) {
+            return -1;
+        }
+        count = p[3 + 4] | ((uint16_t)p[3 + 5] << 8);
+        if ((EDIO24_PKT_START != p[3]) || (EDIO24_PKT_LENGTH_MIN + count != sz_pkt)) {
+            return -1;
+        }
+        prec->pkt = p + 3;
+        prec->sz_pkt = sz_pkt;
+        return 3 + sz_pkt;
+
+    case EDIO24_CMDSTREAM_OP_SLEEP:
+        if (off + 5 > sz) {
+            return -1;
+        }
+        prec->sleep = p[1] | ((uint32_t)p[2] << 8) | ((uint32_t)p[3] << 16) | ((uint32_t)p[4] << 24);
+        return 5;
+
+    case EDIO24_CMDSTREAM_OP_BARRIER:
+        return 1;
+    }
+    return -1;
+}
+
+/**
+ * \brief copy the packet of a record, and set its frame id
+ * \param prec: the record of EDIO24_CMDSTREAM_OP_PKT
+ * \param buffer: the buffer to store the packet
+ * \param sz_buf: the size of the buffer
+ * \param frame_id: the frame id, it's increased by 1
+ * \return the byte size of the packet, <0 on error
+ */
+ssize_t
+edio24_cmdstream_emit (const edio24_cmdrec_t * prec, uint8_t * buffer, size_t sz_buf, uint8_t * frame_id)
+{
+    if ((NULL == prec) || (NULL == buffer) || (NULL == frame_id)) {
+        return -1;
+    }
+    if ((EDIO24_CMDSTREAM_OP_PKT != prec->op) || (prec->sz_pkt < EDIO24_PKT_LENGTH_MIN) || (prec->sz_pkt > sz_buf)) {
+        return -1;
+    }
+    memcpy(buffer, prec->pkt, prec->sz_pkt);
+    buffer[EDIO24_PKT_OFFSET_FRAME] = *frame_id;
+    buffer[prec->sz_pkt - 1] -= *frame_id;
+    (*frame_id) ++;
+    return prec->sz_pkt;
+}
+
+#if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
+#include <ciut.h>
+
+TEST_CASE( .name="edio24-cmdstream", .description="test edio24 binary command stream.", .skip=0 ) {
+    edio24_cmdstream_t cs;
+    edio24_cmdrec_t rec;
+    uint8_t pkt[EDIO24_PKT_LENGTH_MAX];
+    uint8_t pkt2[EDIO24_PKT_LENGTH_MAX];
+    uint8_t data[20];
+    uint8_t frame;
+    uint8_t frame2;
+    ssize_t ret;
+    ssize_t ret2;
+    size_t off;
+
+    SECTION("test parameters for edio24_cmdstream_xxx") {
+        REQUIRE(0 > edio24_cmdstream_init(NULL));
+        REQUIRE(0 == edio24_cmdstream_init(&cs));
+        REQUIRE(EDIO24_CMDSTREAM_HDR_SIZE == cs.sz);
+        REQUIRE(EDIO24_CMDSTREAM_HDR_SIZE == edio24_cmdstream_check(cs.buf, cs.sz));
+        REQUIRE(0 > edio24_cmdstream_check(cs.buf, EDIO24_CMDSTREAM_HDR_SIZE - 1));
+        REQUIRE(0 > edio24_cmdstream_check(NULL, 10));
+        REQUIRE(0 > edio24_cmdstream_check((const uint8_t *)"DIn\nDOutR\n", 10));
+        REQUIRE(0 > edio24_cmdstream_add_pkt(&cs, NULL, 7));
+        REQUIRE(0 > edio24_cmdstream_add_pkt(&cs, (const uint8_t *)"DIn\nDOutR\n", 10));
+        REQUIRE(0 > edio24_cmdstream_add_pkt(&cs, pkt, 3));
+        REQUIRE(0 > edio24_cmdstream_add_sleep(NULL, 10));
+        REQUIRE(0 > edio24_cmdstream_add_barrier(NULL));
+        REQUIRE(0 == edio24_cmdstream_next(cs.buf, cs.sz, cs.sz, &rec));
+        REQUIRE(EDIO24_CMDSTREAM_HDR_SIZE == cs.sz);
+        cs.buf[4] = EDIO24_CMDSTREAM_VERSION + 1;
+        REQUIRE(0 > edio24_cmdstream_check(cs.buf, cs.sz));
+        edio24_cmdstream_clean(&cs);
+        edio24_cmdstream_clean(NULL);
+    }
+    SECTION("test the packets emitted are the same as created") {
+        frame = 200;
+        REQUIRE(0 == edio24_cmdstream_init(&cs));
+        ret = edio24_pkt_create_cmd_doutw(pkt, sizeof(pkt), &frame, 0xFF, 0x31);
+        REQUIRE(0 == edio24_cmdstream_add_pkt(&cs, pkt, ret));
+        REQUIRE(0 == edio24_cmdstream_add_sleep(&cs, 10000));
+        REQUIRE(0 == edio24_cmdstream_add_barrier(&cs));
+        ret = edio24_pkt_create_cmd_dinr(pkt, sizeof(pkt), &frame);
+        REQUIRE(0 == edio24_cmdstream_add_pkt(&cs, pkt, ret));
+        memset(data, 0x5A, sizeof(data));
+        ret = edio24_pkt_create_cmd_confmemw(pkt, sizeof(pkt), &frame, 0x1, 5, data);
+        REQUIRE(0 == edio24_cmdstream_add_pkt(&cs, pkt, ret));
+        /* a sleep longer than 32 bits */
+        REQUIRE(0 == edio24_cmdstream_add_sleep(&cs, 0x100000010ULL));
+        REQUIRE(0 == edio24_cmdstream_add_sleep(&cs, 0));
+
+        /* walk the stream, the frame id starts from 255 and wraps */
+        frame = 255;
+        frame2 = 255;
+        off = edio24_cmdstream_check(cs.buf, cs.sz);
+        REQUIRE(EDIO24_CMDSTREAM_HDR_SIZE == off);
+
+        ret = edio24_cmdstream_next(cs.buf, cs.sz, off, &rec);
+        REQUIRE(ret > 0);
+        REQUIRE(EDIO24_CMDSTREAM_OP_PKT == rec.op);
+        REQUIRE(off == rec.pos);
+        REQUIRE(0 == rec.pkt[2]);
+        ret2 = edio24_cmdstream_emit(&rec, pkt, sizeof(pkt), &frame);
+        REQUIRE(0 < ret2);
+        REQUIRE(ret2 == edio24_pkt_create_cmd_doutw(pkt2, sizeof(pkt2), &frame2, 0xFF, 0x31));
+        REQUIRE(0 == memcmp(pkt, pkt2, ret2));
+        REQUIRE(0 == edio24_pkt_verify(pkt, ret2));
+        REQUIRE(0 == frame);
+        off += ret;
+
+        ret = edio24_cmdstream_next(cs.buf, cs.sz, off, &rec);
+        REQUIRE(5 == ret);
+        REQUIRE(EDIO24_CMDSTREAM_OP_SLEEP == rec.op);
+        REQUIRE(10000 == rec.sleep);
+        REQUIRE(0 > edio24_cmdstream_emit(&rec, pkt, sizeof(pkt), &frame));
+        off += ret;
+
+        ret = edio24_cmdstream_next(cs.buf, cs.sz, off, &rec);
+        REQUIRE(1 == ret);
+        REQUIRE(EDIO24_CMDSTREAM_OP_BARRIER == rec.op);
+        off += ret;
+
+        ret = edio24_cmdstream_next(cs.buf, cs.sz, off, &rec);
+        REQUIRE(ret > 0);
+        ret2 = edio24_cmdstream_emit(&rec, pkt, sizeof(pkt), &frame);
+        REQUIRE(ret2 == edio24_pkt_create_cmd_dinr(pkt2, sizeof(pkt2), &frame2));
+        REQUIRE(0 == memcmp(pkt, pkt2, ret2));
+        REQUIRE(0 == pkt[2]);
+        off += ret;
+
+        ret = edio24_cmdstream_next(cs.buf, cs.sz, off, &rec);
+        REQUIRE(ret > 0);
+        REQUIRE(0 > edio24_cmdstream_emit(&rec, pkt, rec.sz_pkt - 1, &frame));
+        {
+            // the packet shorter than a header
+            edio24_cmdrec_t rec_short = rec;
+            rec_short.sz_pkt = EDIO24_PKT_LENGTH_MIN - 1;
+            REQUIRE(0 > edio24_cmdstream_emit(&rec_short, pkt, sizeof(pkt), &frame));
+        }
+        ret2 = edio24_cmdstream_emit(&rec, pkt, sizeof(pkt), &frame);
+        REQUIRE(ret2 == edio24_pkt_create_cmd_confmemw(pkt2, sizeof(pkt2), &frame2, 0x1, 5, data));
+        REQUIRE(0 == memcmp(pkt, pkt2, ret2));
+        REQUIRE(0 == edio24_pkt_verify(pkt, ret2));
+        off += ret;
+
+        ret = edio24_cmdstream_next(cs.buf, cs.sz, off, &rec);
+        REQUIRE(5 == ret);
+        REQUIRE(0xFFFFFFFF == rec.sleep);
+        off += ret;
+        ret = edio24_cmdstream_next(cs.buf, cs.sz, off, &rec);
+        REQUIRE(5 == ret);
+        REQUIRE(0x11 == rec.sleep);
+        off += ret;
+        REQUIRE(0 == edio24_cmdstream_next(cs.buf, cs.sz, off, &rec));
+        REQUIRE(off == cs.sz);
+
+        /* the broken records */
+        REQUIRE(0 > edio24_cmdstream_next(cs.buf, cs.sz - 2, off - 5, &rec));
+        REQUIRE(0 > edio24_cmdstream_next(cs.buf, EDIO24_CMDSTREAM_HDR_SIZE + 5, EDIO24_CMDSTREAM_HDR_SIZE, &rec));
+        cs.buf[EDIO24_CMDSTREAM_HDR_SIZE] = 0x7F;
+        REQUIRE(0 > edio24_cmdstream_next(cs.buf, cs.sz, EDIO24_CMDSTREAM_HDR_SIZE, &rec));
+        edio24_cmdstream_clean(&cs);
+    }
+}
+
+#endif /* CIUT_ENABLED */
@@ -0,0 +1,596 @@
+/**
+ * \file    edio24device.c
+ * \brief   The state model of a simulated E-DIO24 device
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ *
+ * Unlike the stateless edio24_svr_process_tcp(), the device keeps the
+ * DIO latch, the direction of pins, the event counter and the memories,
+ * so a request changes what the following requests read back.
+ * The state can be queried and poked directly by the caller, and the hooks
+ * can inject the failures or watch the changes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h> // rand()
+#include <string.h> // memmove()
+#include <assert.h>
+
+#include "edio24device.h"
+
+#if defined(USE_EDIO24_SERVER) && (USE_EDIO24_SERVER == 1)
+
+#ifndef EDIO24_PKT_LENGTH_MAX
+#define EDIO24_PKT_LENGTH_MAX (EDIO24_PKT_LENGTH_MIN + 1024) /**< the count of data is not larger than 1024 */
+#endif
+
+/**
+ * \brief update the levels of the pins, and count the rising edges of DIO0
+ * \param pdev: the device
+ *
+ * The pins configured as outputs read back the latch,
+ * the inputs read the levels driven by the outside.
+ */
+static void
+edio24_device_update (edio24_device_t * pdev)
+{
+    uint32_t din;
+
+    din = ((pdev->dout & ~(pdev->dconf)) | (pdev->din_ext & pdev->dconf)) & EDIO24_DEVICE_PINS;
+    if ((0 == (pdev->din & 0x01)) && (0 != (din & 0x01))) {
+        pdev->counter ++;
+    }
+    pdev->din = din;
+}
+
+static void
+edio24_device_notify (edio24_device_t * pdev, uint8_t cmd)
+{
+    if (NULL != pdev->hooks.on_change) {
+        pdev->hooks.on_change(pdev, cmd, pdev->hooks.userdata);
+    }
+}
+
+/**
+ * \brief initialize a device with the factory defaults
+ * \param pdev: the device
+ * \param id: the id of the device, it's also used in the default IPv4 address
+ * \return 0 on success, <0 on error
+ */
+int
+edio24_device_init (edio24_device_t * pdev, int id)
+{
+    if (NULL == pdev) {
+        return -1;
+    }
+    memset(pdev, 0, sizeof(*pdev));
+    pdev->id = id;
+    // 192.168.0.(101+id)/24, gateway 192.168.0.1
+    pdev->netconf[0] = 192; pdev->netconf[1] = 168; pdev->netconf[2] = 0; pdev->netconf[3] = (101 + id) & 0xFF;
+    pdev->netconf[4] = 255; pdev->netconf[5] = 255; pdev->netconf[6] = 255; pdev->netconf[7] = 0;
+    pdev->netconf[8] = 192; pdev->netconf[9] = 168; pdev->netconf[10] = 0; pdev->netconf[11] = 1;
+    // the erased flash
+    memset(pdev->confmem, 0xFF, sizeof(pdev->confmem));
+    memset(pdev->setmem, 0xFF, sizeof(pdev->setmem));
+    memset(pdev->usrmem, 0xFF, sizeof(pdev->usrmem));
+    edio24_device_reset(pdev);
+    return 0;
+}
+
+/**
+ * \brief reset the volatile state of a device, the memories are kept
+ * \param pdev: the device
+ *
+ * All of the pins are inputs after reset, the latch and the counter are cleared.
+ */
+void
+edio24_device_reset (edio24_device_t * pdev)
+{
+    assert (NULL != pdev);
+    pdev->dconf = EDIO24_DEVICE_PINS;
+    pdev->dout = 0;
+    pdev->status = 0;
+    pdev->flg_bootloader = 0;
+    pdev->din = ((pdev->dout & ~(pdev->dconf)) | (pdev->din_ext & pdev->dconf)) & EDIO24_DEVICE_PINS;
+    pdev->counter = 0;
+}
+
+/**
+ * \brief install the hooks of a device
+ * \param pdev: the device
+ * \param hooks: the hooks, NULL to remove all of them
+ */
+void
+edio24_device_set_hooks (edio24_device_t * pdev, const edio24_device_hooks_t * hooks)
+{
+    assert (NULL != pdev);
+    if (NULL == hooks) {
+        memset(&(pdev->hooks), 0, sizeof(pdev->hooks));
+        return;
+    }
+    pdev->hooks = *hooks;
+}
+
+/**
+ * \brief drive the input pins from the outside
+ * \param pdev: the device
+ * \param mask: the pins to be changed
+ * \param value: the levels of the pins
+ */
+void
+edio24_device_set_input (edio24_device_t * pdev, uint32_t mask, uint32_t value)
+{
+    assert (NULL != pdev);
+    pdev->din_ext = ((pdev->din_ext & ~mask) | (value & mask)) & EDIO24_DEVICE_PINS;
+    edio24_device_update(pdev);
+    edio24_device_notify(pdev, EDIO24_DEVICE_POKE);
+}
+
+/**
+ * \brief change the output latch, the same as CMD_DOUT_W
+ * \param pdev: the device
+ * \param mask: the bits to be changed
+ * \param value: the value of the bits
+ */
+void
+edio24_device_set_output (edio24_device_t * pdev, uint32_t mask, uint32_t value)
+{
+    assert (NULL != pdev);
+    pdev->dout = ((pdev->dout & ~mask) | (value & mask)) & EDIO24_DEVICE_PINS;
+    edio24_device_update(pdev);
+    edio24_device_notify(pdev, EDIO24_DEVICE_POKE);
+}
+
+/**
+ * \brief change the direction of the pins, the same as CMD_DCONF_W
+ * \param pdev: the device
+ * \param mask: the bits to be changed
+ * \param value: the direction of the bits, 1 -- input, 0 -- output
+ */
+void
+edio24_device_set_config (edio24_device_t * pdev, uint32_t mask, uint32_t value)
+{
+    assert (NULL != pdev);
+    pdev->dconf = ((pdev->dconf & ~mask) | (value & mask)) & EDIO24_DEVICE_PINS;
+    edio24_device_update(pdev);
+    edio24_device_notify(pdev, EDIO24_DEVICE_POKE);
+}
+
+static void
+edio24_device_write_value (uint8_t * buf, uint32_t value, size_t bytes)
+{
+    size_t i;
+    for (i = 0; i < bytes; i ++) {
+        buf[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+static uint32_t
+edio24_device_read_value (const uint8_t * buf, size_t bytes)
+{
+    uint32_t val = 0;
+    size_t i;
+    for (i = bytes; i > 0; i --) {
+        val = (val << 8) | buf[i - 1];
+    }
+    return val;
+}
+
+/**
+ * \brief get the memory of a memory command
+ * \param pdev: the device
+ * \param cmd: the command
+ * \param sz_mem: return the byte size of the memory
+ * \return the memory, NULL if the command is not one of the memory read/write commands
+ */
+static uint8_t *
+edio24_device_memory (edio24_device_t * pdev, uint8_t cmd, size_t * sz_mem)
+{
+    switch (cmd) {
+    case EDIO24_CMD_CONF_MEM_R:
+    case EDIO24_CMD_CONF_MEM_W:
+        *sz_mem = sizeof(pdev->confmem);
+        return pdev->confmem;
+    case EDIO24_CMD_SET_MEM_R:
+    case EDIO24_CMD_SET_MEM_W:
+        *sz_mem = sizeof(pdev->setmem);
+        return pdev->setmem;
+    case EDIO24_CMD_USR_MEM_R:
+    case EDIO24_CMD_USR_MEM_W:
+        *sz_mem = sizeof(pdev->usrmem);
+        return pdev->usrmem;
+    }
+    *sz_mem = 0;
+    return NULL;
+}
+
+/**
+ * \brief process a received client packet by the state of the device
+ * \param pdev: the device
+ * \param flg_force_fail: 1 - force output a fail response message
+ * \param buffer_in: the buffer contains received packets
+ * \param sz_in: the byte size of the received packets
+ * \param buffer_out: the buffer for the content of packet need to send
+ * \param sz_out: pass in the size of buffer_out, pass out the byte size of data in the buffer_out need to send
+ * \param sz_processed: the bytes size processed in the buffer_in
+ * \param sz_needed_in: the bytes size of data need to append to buffer_in
+ * \param sz_needed_out: the bytes size of buffer need to extend for current buffer_out, if set, try pass in a more larger buffer_out to continue
+ *
+ * \return <0 fatal error, user should kill this connection;
+ *         =2 the packet illegal, the caller should check if sz_out > 0 and send back the response in buffer_out;
+ *         =1 need more data, the byte size need data is stored in sz_needed;
+ *         =0 on successs, the variable sz_processed return processed data byte size;
+ *
+ * The arguments are the same as edio24_svr_process_tcp().
+ * The state is changed only if the response can be stored in the buffer_out,
+ * so the caller can retry the same request with a larger buffer.
+ */
+int
+edio24_device_process_tcp (edio24_device_t * pdev, char flg_force_fail, uint8_t * buffer_in, size_t sz_in,
+                   uint8_t * buffer_out, size_t *sz_out,
+                   size_t * sz_processed, size_t * sz_needed_in, size_t * sz_needed_out)
+{
+    int ret = 0;
+    int r;
+    uint8_t cmd;
+    uint8_t frame;
+    uint8_t status = EDIO24_STATUS_SUCCESS;
+    uint16_t count;
+    uint32_t address = 0;
+    uint32_t sz_data = 0;
+    uint8_t * data_in;
+    uint8_t * data_out;
+    uint8_t * mem = NULL;
+    size_t sz_mem = 0;
+    size_t len_data = 0;
+    char flg_change = 0;
+
+    if ((NULL == pdev) || (NULL == buffer_in) || (NULL == buffer_out) || (NULL == sz_out)) {
+        return -1;
+    }
+    if ((NULL == sz_processed) || (NULL == sz_needed_in) || (NULL == sz_needed_out)) {
+        return -1;
+    }
+    *sz_processed = 0;
+    *sz_needed_in = 0;
+    *sz_needed_out = 0;
+
+    if (sz_in < EDIO24_PKT_LENGTH_MIN) {
+        *sz_needed_in = EDIO24_PKT_LENGTH_MIN - sz_in;
+        return 1;
+    }
+    edio24_pkt_read_hdr_command(buffer_in, sz_in, &cmd);
+    edio24_pkt_read_hdr_frameid(buffer_in, sz_in, &frame);
+    if (edio24_pkt_read_hdr_count(buffer_in, sz_in, &count) < 0) {
+        return -1;
+    }
+    if (EDIO24_PKT_LENGTH_MIN + count > sz_in) {
+        *sz_needed_in = EDIO24_PKT_LENGTH_MIN + count - sz_in;
+        return 1;
+    }
+    data_in = buffer_in + EDIO24_PKT_OFFSET_DATA;
+
+    if (0 != edio24_pkt_verify(buffer_in, sz_in)) {
+        status = EDIO24_STATUS_ERROR_PROTOCOL;
+        ret = 2;
+    } else if (NULL != pdev->hooks.on_request) {
+        r = pdev->hooks.on_request(pdev, cmd, buffer_in, EDIO24_PKT_LENGTH_MIN + count, pdev->hooks.userdata);
+        if (r < 0) {
+            // drop the request silently
+            pdev->stats.num_drop ++;
+            *sz_out = 0;
+            *sz_processed = EDIO24_PKT_LENGTH_MIN + count;
+            return 0;
+        }
+        status = r & 0xFF;
+    }
+    if ((EDIO24_STATUS_SUCCESS == status) && flg_force_fail) {
+        status = (rand() % EDIO24_STATUS_ERROR_OTHER) + 1;
+    }
+
+    // check the parameters, and get the size of the response
+    if (EDIO24_STATUS_SUCCESS == status) {
+        switch (cmd) {
+        case EDIO24_CMD_DIN_R:
+        case EDIO24_CMD_DOUT_R:
+        case EDIO24_CMD_DCONF_R:
+            len_data = 3;
+            break;
+        case EDIO24_CMD_DOUT_W:
+        case EDIO24_CMD_DCONF_W:
+            if (6 != count) {
+                status = EDIO24_STATUS_ERROR_PROTOCOL;
+            }
+            break;
+        case EDIO24_CMD_COUNTER_R:
+            len_data = 4;
+            break;
+        case EDIO24_CMD_STATUS:
+            len_data = 2;
+            break;
+        case EDIO24_CMD_NETWORK_CONF:
+            len_data = sizeof(pdev->netconf);
+            break;
+        case EDIO24_CMD_CONF_MEM_R:
+        case EDIO24_CMD_SET_MEM_R:
+        case EDIO24_CMD_USR_MEM_R:
+        case EDIO24_CMD_BOOT_MEM_R:
+            if (4 != count) {
+                status = EDIO24_STATUS_ERROR_PROTOCOL;
+                break;
+            }
+            address = edio24_device_read_value(data_in, 2);
+            sz_data = edio24_device_read_value(data_in + 2, 2);
+            if ((sz_data < 1) || (sz_data > 1024)) {
+                status = EDIO24_STATUS_ERROR_PARAMETER;
+                break;
+            }
+            mem = edio24_device_memory(pdev, cmd, &sz_mem);
+            if ((NULL != mem) && (address + sz_data > sz_mem)) {
+                status = EDIO24_STATUS_ERROR_PARAMETER;
+                break;
+            }
+            len_data = sz_data;
+            break;
+        case EDIO24_CMD_CONF_MEM_W:
+        case EDIO24_CMD_SET_MEM_W:
+        case EDIO24_CMD_USR_MEM_W:
+            if (count < 2) {
+                status = EDIO24_STATUS_ERROR_PROTOCOL;
+                break;
+            }
+            address = edio24_device_read_value(data_in, 2);
+            sz_data = count - 2;
+            mem = edio24_device_memory(pdev, cmd, &sz_mem);
+            if (address + sz_data > sz_mem) {
+                status = EDIO24_STATUS_ERROR_PARAMETER;
+            }
+            break;
+        case EDIO24_CMD_BLINKLED:
+            if (count < 1) {
+                status = EDIO24_STATUS_ERROR_PROTOCOL;
+            }
+            break;
+        case EDIO24_CMD_COUNTER_W:
+        case EDIO24_CMD_BOOT_MEM_W:
+        case EDIO24_CMD_RESET:
+        case EDIO24_CMD_FIRMWARE:
+            break;
+        default:
+            fprintf(stderr, "edio24 device %d: unsupport command 0x%02X\n", pdev->id, cmd);
+            status = EDIO24_STATUS_ERROR_PROTOCOL;
+            break;
+        }
+    }
+    if (EDIO24_STATUS_SUCCESS != status) {
+        len_data = 0;
+    }
+    if (EDIO24_PKT_LENGTH_MIN + len_data > *sz_out) {
+        *sz_needed_out = EDIO24_PKT_LENGTH_MIN + len_data - *sz_out;
+        *sz_out = 0;
+        return 1;
+    }
+
+    // apply the request
+    data_out = buffer_out + EDIO24_PKT_OFFSET_DATA;
+    if (EDIO24_STATUS_SUCCESS == status) {
+        switch (cmd) {
+        case EDIO24_CMD_DIN_R:
+            edio24_device_write_value(data_out, pdev->din, 3);
+            break;
+        case EDIO24_CMD_DOUT_R:
+            edio24_device_write_value(data_out, pdev->dout, 3);
+            break;
+        case EDIO24_CMD_DCONF_R:
+            edio24_device_write_value(data_out, pdev->dconf, 3);
+            break;
+        case EDIO24_CMD_DOUT_W:
+        case EDIO24_CMD_DCONF_W:
+        {
+            uint32_t mask = edio24_device_read_value(data_in, 3);
+            uint32_t value = edio24_device_read_value(data_in + 3, 3);
+            if (EDIO24_CMD_DOUT_W == cmd) {
+                pdev->dout = ((pdev->dout & ~mask) | (value & mask)) & EDIO24_DEVICE_PINS;
+            } else {
+                pdev->dconf = ((pdev->dconf & ~mask) | (value & mask)) & EDIO24_DEVICE_PINS;
+            }
+            edio24_device_update(pdev);
+            flg_change = 1;
+        }
+            break;
+        case EDIO24_CMD_COUNTER_R:
+            edio24_device_write_value(data_out, pdev->counter, 4);
+            break;
+        case EDIO24_CMD_COUNTER_W:
+            pdev->counter = 0;
+            flg_change = 1;
+            break;
+        case EDIO24_CMD_STATUS:
+            edio24_device_write_value(data_out, pdev->status, 2);
+            break;
+        case EDIO24_CMD_NETWORK_CONF:
+            memmove(data_out, pdev->netconf, sizeof(pdev->netconf));
+            break;
+        case EDIO24_CMD_CONF_MEM_R:
+        case EDIO24_CMD_SET_MEM_R:
+        case EDIO24_CMD_USR_MEM_R:
+            memmove(data_out, mem + address, sz_data);
+            break;
+        case EDIO24_CMD_BOOT_MEM_R:
+            // the bootloader is not simulated, return the erased flash
+            memset(data_out, 0xFF, sz_data);
+            break;
+        case EDIO24_CMD_CONF_MEM_W:
+        case EDIO24_CMD_SET_MEM_W:
+        case EDIO24_CMD_USR_MEM_W:
+            if (sz_data > 0) {
+                memmove(mem + address, data_in + 2, sz_data);
+            }
+            flg_change = 1;
+            break;
+        case EDIO24_CMD_BLINKLED:
+            pdev->blink = data_in[0];
+            break;
+        case EDIO24_CMD_RESET:
+            pdev->num_reset ++;
+            edio24_device_reset(pdev);
+            flg_change = 1;
+            break;
+        case EDIO24_CMD_FIRMWARE:
+            pdev->flg_bootloader = 1;
+            flg_change = 1;
+            break;
+        }
+    } else {
+        pdev->stats.num_fail ++;
+    }
+    pdev->stats.num_request ++;
+    edio24_pkt_create_respond(buffer_out, *sz_out, cmd, frame, status, len_data, data_out);
+    *sz_out = EDIO24_PKT_LENGTH_MIN + len_data;
+    *sz_processed = EDIO24_PKT_LENGTH_MIN + count;
+    if (flg_change) {
+        edio24_device_notify(pdev, cmd);
+    }
+    return ret;
+}
+
+static int
+edio24_device_on_process (void * userdata, char flg_force_fail, uint8_t * buffer_in, size_t sz_in, uint8_t * buffer_out, size_t *sz_out, size_t * sz_processed, size_t * sz_needed_in, size_t * sz_needed_out)
+{
+    return edio24_device_process_tcp((edio24_device_t *)userdata, flg_force_fail, buffer_in, sz_in, buffer_out, sz_out, sz_processed, sz_needed_in, sz_needed_out);
+}
+
+/**
+ * \brief let the device process the requests of a device session
+ * \param pdev: the device
+ * \param psvr: the device session
+ */
+void
+edio24_device_attach (edio24_device_t * pdev, edio24_svrsession_t * psvr)
+{
+    assert (NULL != pdev);
+    assert (NULL != psvr);
+    edio24_svrsession_set_process(psvr, edio24_device_on_process, pdev);
+}
+
+#endif // USE_EDIO24_SERVER
+
+#if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
+#include <ciut.h>
+
+/**
+ * \brief send a request to the device and check the size of the response
+ * \param pdev: the device
+ * \param pkt: the request
+ * \param sz: the byte size of the request
+ * \param out: the buffer of the response
+ * \param sz_out: the byte size of the buffer
+ * \return the status of the response, <0 on error
+ */
+static int
+test_device_request (edio24_device_t * pdev, uint8_t * pkt, ssize_t sz, uint8_t * out, size_t sz_out)
+{
+    size_t sz_processed;
+    size_t sz_needed_in;
+    size_t sz_needed_out;
+    uint8_t status;
+
+    if (sz < 1) {
+        return -1;
+    }
+    if (0 != edio24_device_process_tcp(pdev, 0, pkt, sz, out, &sz_out, &sz_processed, &sz_needed_in, &sz_needed_out)) {
+        return -1;
+    }
+    if ((sz_processed != sz) || (0 != edio24_pkt_verify(out, sz_out))) {
+        return -1;
+    }
+    if (edio24_pkt_read_hdr_status(out, sz_out, &status) < 0) {
+        return -1;
+    }
+    return status;
+}
+
+TEST_CASE( .name="edio24-device", .description="test the state of the simulated device.", .skip=0 ) {
+    edio24_device_t dev;
+    uint8_t pkt[EDIO24_PKT_LENGTH_MAX];
+    uint8_t out[EDIO24_PKT_LENGTH_MAX];
+    uint8_t data[16];
+    uint8_t frame = 0;
+    uint32_t val32;
+    size_t sz_out;
+    size_t sz_processed;
+    size_t sz_needed_in;
+    size_t sz_needed_out;
+    ssize_t ret;
+    size_t i;
+
+    REQUIRE(0 > edio24_device_init(NULL, 0));
+    REQUIRE(0 == edio24_device_init(&dev, 2));
+    REQUIRE(EDIO24_DEVICE_PINS == dev.dconf);
+    REQUIRE(103 == dev.netconf[3]);
+
+    SECTION("test the partial packets and the buffer size") {
+        ret = edio24_pkt_create_cmd_doutw(pkt, sizeof(pkt), &frame, 0x01, 0x01);
+        sz_out = sizeof(out);
+        REQUIRE(1 == edio24_device_process_tcp(&dev, 0, pkt, 3, out, &sz_out, &sz_processed, &sz_needed_in, &sz_needed_out));
+        REQUIRE(EDIO24_PKT_LENGTH_MIN - 3 == sz_needed_in);
+        REQUIRE(1 == edio24_device_process_tcp(&dev, 0, pkt, ret - 1, out, &sz_out, &sz_processed, &sz_needed_in, &sz_needed_out));
+        REQUIRE(1 == sz_needed_in);
+        ret = edio24_pkt_create_cmd_dinr(pkt, sizeof(pkt), &frame);
+        sz_out = EDIO24_PKT_LENGTH_MIN;
+        REQUIRE(1 == edio24_device_process_tcp(&dev, 0, pkt, ret, out, &sz_out, &sz_processed, &sz_needed_in, &sz_needed_out));
+        REQUIRE(3 == sz_needed_out);
+        REQUIRE(0 == dev.stats.num_request);
+    }
+    SECTION("test the DIO and the counter") {
+        ret = edio24_pkt_create_cmd_dconfw(pkt, sizeof(pkt), &frame, 0x000001, 0);
+        REQUIRE(0 == test_device_request(&dev, pkt, ret, out, sizeof(out)));
+        for (i = 0; i < 3; i ++) {
+            ret = edio24_pkt_create_cmd_doutw(pkt, sizeof(pkt), &frame, 0x000001, 0x000001);
+            REQUIRE(0 == test_device_request(&dev, pkt, ret, out, sizeof(out)));
+            ret = edio24_pkt_create_cmd_doutw(pkt, sizeof(pkt), &frame, 0x000001, 0);
+            REQUIRE(0 == test_device_request(&dev, pkt, ret, out, sizeof(out)));
+        }
+        ret = edio24_pkt_create_cmd_dcounterr(pkt, sizeof(pkt), &frame);
+        REQUIRE(0 == test_device_request(&dev, pkt, ret, out, sizeof(out)));
+        REQUIRE(0 == edio24_pkt_read_ret_counterr(out, sizeof(out), &val32));
+        REQUIRE(3 == val32);
+        ret = edio24_pkt_create_cmd_dcounterw(pkt, sizeof(pkt), &frame);
+        REQUIRE(0 == test_device_request(&dev, pkt, ret, out, sizeof(out)));
+        REQUIRE(0 == dev.counter);
+
+        ret = edio24_pkt_create_cmd_dconfr(pkt, sizeof(pkt), &frame);
+        REQUIRE(0 == test_device_request(&dev, pkt, ret, out, sizeof(out)));
+        REQUIRE(0 == edio24_pkt_read_ret_dconfr(out, sizeof(out), &val32));
+        REQUIRE(0xFFFFFE == val32);
+        ret = edio24_pkt_create_cmd_reset(pkt, sizeof(pkt), &frame);
+        REQUIRE(0 == test_device_request(&dev, pkt, ret, out, sizeof(out)));
+        REQUIRE(1 == dev.num_reset);
+        REQUIRE(EDIO24_DEVICE_PINS == dev.dconf);
+    }
+    SECTION("test the memories") {
+        for (i = 0; i < sizeof(data); i ++) {
+            data[i] = 0x30 + i;
+        }
+        ret = edio24_pkt_create_cmd_usermemw(pkt, sizeof(pkt), &frame, 0xEE0, sizeof(data), data);
+        REQUIRE(0 == test_device_request(&dev, pkt, ret, out, sizeof(out)));
+        ret = edio24_pkt_create_cmd_usermemr(pkt, sizeof(pkt), &frame, 0xEE8, 8);
+        REQUIRE(0 == test_device_request(&dev, pkt, ret, out, sizeof(out)));
+        REQUIRE(0 == edio24_pkt_read_ret_usermemr(out, sizeof(out), 8, data));
+        REQUIRE(0x38 == data[0]);
+        REQUIRE(0x3F == data[7]);
+        // out of range
+        ret = edio24_pkt_create_cmd_usermemr(pkt, sizeof(pkt), &frame, 0xEE8, 9);
+        REQUIRE(EDIO24_STATUS_ERROR_PARAMETER == test_device_request(&dev, pkt, ret, out, sizeof(out)));
+        ret = edio24_pkt_create_cmd_confmemw(pkt, sizeof(pkt), &frame, 0x0F, 2, data);
+        REQUIRE(EDIO24_STATUS_ERROR_PARAMETER == test_device_request(&dev, pkt, ret, out, sizeof(out)));
+        ret = edio24_pkt_create_cmd_setmemr(pkt, sizeof(pkt), &frame, 0, 0);
+        REQUIRE(EDIO24_STATUS_ERROR_PARAMETER == test_device_request(&dev, pkt, ret, out, sizeof(out)));
+        REQUIRE(3 == dev.stats.num_fail);
+        // the memories are kept after reset
+        ret = edio24_pkt_create_cmd_reset(pkt, sizeof(pkt), &frame);
+        REQUIRE(0 == test_device_request(&dev, pkt, ret, out, sizeof(out)));
+        REQUIRE(0x30 == dev.usrmem[0xEE0]);
+    }
+}
+#endif /* CIUT_ENABLED */
@@ -0,0 +1,370 @@
+/**
+ * \file    edio24dmsg.c
+ * \brief   The messages between the edio24d daemon and its clients
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ *
+ * The daemon keeps the sessions to the devices open, the clients send the request packets
+ * to the daemon by a UNIX domain socket. Each packet is wrapped by a 6 bytes header
+ * which carries the index of the device, and the response is returned in the same way.
+ * The daemon assigns its own frame id to a request, and restores the frame id of the
+ * client in the response, so the clients sharing a device do not see each other.
+ */
+
+#include <stdio.h>
+#include <string.h> // memmove()
+#include <assert.h>
+
+#include "edio24dmsg.h"
+
+#ifndef EDIO24_PKT_OFFSET_FRAME
+#define EDIO24_PKT_OFFSET_FRAME 2 /**< the offset of the frame id in a edio24 packet */
+#endif
+#ifndef EDIO24_PKT_LENGTH_MAX
+#define EDIO24_PKT_LENGTH_MAX (EDIO24_PKT_LENGTH_MIN + 1024) /**< the count of data is not larger than 1024 */
+#endif
+
+/**
+ * \brief fill the buffer with a message
+ * \param buffer: the buffer to be filled
+ * \param sz_buf: the byte size of the buffer
+ * \param type: the type of the message, EDIO24D_MSG_xxx
+ * \param device: the index of the device
+ * \param payload: the payload
+ * \param sz_payload: the byte size of the payload
+ * \return <0 on fail, >0 the size of message
+ */
+ssize_t
+edio24d_msg_create (uint8_t * buffer, size_t sz_buf, uint8_t type, uint16_t device, const uint8_t * payload, size_t sz_payload)
+{
+    if ((NULL == buffer) || ((NULL == payload) && (sz_payload > 0))) {
+        return -1;
+    }
+    if (sz_payload > EDIO24D_MSG_PAYLOAD_MAX) {
+        return -1;
+    }
+    if (EDIO24D_MSG_HDR_SIZE + sz_payload > sz_buf) {
+        return -1;
+    }
+    buffer[0] = EDIO24D_MSG_START;
+    buffer[1] = type;
+    buffer[2] = device & 0xFF;
+    buffer[3] = (device >> 8) & 0xFF;
+    buffer[4] = sz_payload & 0xFF;
+    buffer[5] = (sz_payload >> 8) & 0xFF;
+    if (sz_payload > 0) {
+        memmove(buffer + EDIO24D_MSG_HDR_SIZE, payload, sz_payload);
+    }
+    return EDIO24D_MSG_HDR_SIZE + sz_payload;
+}
+
+/**
+ * \brief read a message from the head of the buffer
+ * \param buffer: the data received
+ * \param sz_buf: the byte size of the data
+ * \param pmsg: return the message
+ * \return the byte size of the message; 0 if need more data; <0 if the data is not a message
+ */
+ssize_t
+edio24d_msg_read (const uint8_t * buffer, size_t sz_buf, edio24d_msg_t * pmsg)
+{
+    size_t sz_payload;
+
+    if ((NULL == buffer) || (NULL == pmsg)) {
+        return -1;
+    }
+    if (sz_buf < 1) {
+        return 0;
+    }
+    if (EDIO24D_MSG_START != buffer[0]) {
+        return -1;
+    }
+    if (sz_buf < EDIO24D_MSG_HDR_SIZE) {
+        return 0;
+    }
+    sz_payload = buffer[4] | ((size_t)buffer[5] << 8);
+    if (sz_payload > EDIO24D_MSG_PAYLOAD_MAX) {
+        return -1;
+    }
+    if (EDIO24D_MSG_HDR_SIZE + sz_payload > sz_buf) {
+        return 0;
+    }
+    pmsg->type = buffer[1];
+    pmsg->device = buffer[2] | ((uint16_t)buffer[3] << 8);
+    pmsg->payload = buffer + EDIO24D_MSG_HDR_SIZE;
+    pmsg->sz_payload = sz_payload;
+    return EDIO24D_MSG_HDR_SIZE + sz_payload;
+}
+
+/**
+ * \brief change the frame id of a packet and keep the checksum valid
+ * \param pkt: the packet, a request or a response
+ * \param sz: the byte size of the packet
+ * \param frame_id: the new frame id
+ * \return the frame id before the change
+ */
+uint8_t
+edio24d_pkt_reframe (uint8_t * pkt, size_t sz, uint8_t frame_id)
+{
+    uint8_t old;
+    assert (NULL != pkt);
+    assert (sz >= EDIO24_PKT_LENGTH_MIN);
+    old = pkt[EDIO24_PKT_OFFSET_FRAME];
+    pkt[EDIO24_PKT_OFFSET_FRAME] = frame_id;
+    pkt[sz - 1] += old - frame_id;
+    return old;
+}
+
+/*****************************************************************************/
+static ssize_t
+edio24d_client_send (edio24_transport_t * ptr, const uint8_t * buf, size_t sz)
+{
+    edio24d_client_t * pcl = (edio24d_client_t *)(ptr->data);
+    uint8_t msg[EDIO24D_MSG_HDR_SIZE + EDIO24D_MSG_PAYLOAD_MAX];
+    ssize_t ret;
+
+    assert (NULL != pcl);
+    ret = edio24d_msg_create(msg, sizeof(msg), EDIO24D_MSG_PKT, pcl->device, buf, sz);
+    if (ret < 0) {
+        return -1;
+    }
+    // one write for the header and the packet, the other clients can't get in between
+    if (edio24_transport_send(pcl->ptr, msg, ret) < 0) {
+        return -1;
+    }
+    return sz;
+}
+
+static void
+edio24d_client_recv (void * userdata, uint8_t * buf, size_t sz)
+{
+    edio24d_client_t * pcl = (edio24d_client_t *)userdata;
+    uint8_t pkt[EDIO24D_MSG_PAYLOAD_MAX];
+    edio24d_msg_t msg;
+    ssize_t ret;
+
+    assert (NULL != pcl);
+    if (edio24_rxbuf_append(&(pcl->rxbuf), &(pcl->sz_rxmax), &(pcl->sz_rx), buf, sz) < 0) {
+        return;
+    }
+    while (pcl->sz_rx > 0) {
+        ret = edio24d_msg_read(pcl->rxbuf, pcl->sz_rx, &msg);
+        if (ret == 0) {
+            break; // need more data
+        }
+        if (ret < 0) {
+            uint8_t * p = (uint8_t *)memchr(pcl->rxbuf + 1, EDIO24D_MSG_START, pcl->sz_rx - 1);
+            pcl->num_error ++;
+            edio24_rxbuf_consume(pcl->rxbuf, &(pcl->sz_rx), (NULL == p ? pcl->sz_rx : (size_t)(p - pcl->rxbuf)));
+            continue;
+        }
+        if ((EDIO24D_MSG_PKT != msg.type) || (pcl->device != msg.device)) {
+            pcl->num_error ++;
+            edio24_rxbuf_consume(pcl->rxbuf, &(pcl->sz_rx), ret);
+            continue;
+        }
+        // copy out the packet, the session may send more requests in its callback
+        memmove(pkt, msg.payload, msg.sz_payload);
+        sz = msg.sz_payload;
+        edio24_rxbuf_consume(pcl->rxbuf, &(pcl->sz_rx), ret);
+        if (NULL != pcl->base.cb_recv) {
+            pcl->base.cb_recv(pcl->base.userdata_recv, pkt, sz);
+        }
+    }
+}
+
+/**
+ * \brief initialize a transport to a device through the daemon
+ * \param pcl: the transport
+ * \param ptr: the transport connected to the daemon
+ * \param device: the index of the device in the daemon
+ * \return 0 on success, <0 on error
+ *
+ * The messages received by ptr are passed to pcl, and the packets of the device are passed to the session on pcl->base.
+ */
+int
+edio24d_client_init (edio24d_client_t * pcl, edio24_transport_t * ptr, uint16_t device)
+{
+    if ((NULL == pcl) || (NULL == ptr)) {
+        return -1;
+    }
+    memset(pcl, 0, sizeof(*pcl));
+    pcl->ptr = ptr;
+    pcl->device = device;
+    pcl->base.send = edio24d_client_send;
+    pcl->base.data = pcl;
+    edio24_transport_set_receiver(ptr, edio24d_client_recv, pcl);
+    return 0;
+}
+
+/**
+ * \brief release the transport
+ * \param pcl: the transport
+ */
+void
+edio24d_client_clean (edio24d_client_t * pcl)
+{
+    if (NULL == pcl) {
+        return;
+    }
+    if ((NULL != pcl->ptr) && (pcl->ptr->userdata_recv == pcl)) {
+        edio24_transport_set_receiver(pcl->ptr, NULL, NULL);
+    }
+    free(pcl->rxbuf);
+    pcl->rxbuf = NULL;
+    pcl->sz_rxmax = pcl->sz_rx = 0;
+}
+
+#if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
+#include <ciut.h>
+
+/** a daemon with one simulated device, on the device end of a loopback */
+typedef struct _test_edio24d_t {
+    edio24_transport_t * ptr;
+    uint8_t frame; /**< the frame id of the daemon */
+    size_t num_pkt;
+    size_t num_reject;
+    size_t sz_rxmax;
+    size_t sz_rx;
+    uint8_t * rxbuf;
+} test_edio24d_t;
+
+static void
+test_edio24d_recv (void * userdata, uint8_t * buf, size_t sz)
+{
+    test_edio24d_t * pd = (test_edio24d_t *)userdata;
+    uint8_t out[EDIO24D_MSG_HDR_SIZE + EDIO24D_MSG_PAYLOAD_MAX];
+    uint8_t pkt[EDIO24D_MSG_PAYLOAD_MAX];
+    edio24d_msg_t msg;
+    size_t sz_out;
+    size_t sz_processed;
+    size_t sz_needed_in;
+    size_t sz_needed_out;
+    uint8_t frame;
+    ssize_t ret;
+
+    edio24_rxbuf_append(&(pd->rxbuf), &(pd->sz_rxmax), &(pd->sz_rx), buf, sz);
+    while ((ret = edio24d_msg_read(pd->rxbuf, pd->sz_rx, &msg)) > 0) {
+        memmove(pkt, msg.payload, msg.sz_payload);
+        edio24_rxbuf_consume(pd->rxbuf, &(pd->sz_rx), ret);
+        if ((EDIO24D_MSG_PKT != msg.type) || (msg.device != 0)) {
+            pd->num_reject ++;
+            continue;
+        }
+        pd->num_pkt ++;
+        frame = edio24d_pkt_reframe(pkt, msg.sz_payload, pd->frame ++);
+        assert (0 == edio24_pkt_verify(pkt, msg.sz_payload));
+        sz_out = sizeof(out) - EDIO24D_MSG_HDR_SIZE;
+        if (0 != edio24_svr_process_tcp(0, pkt, msg.sz_payload, out + EDIO24D_MSG_HDR_SIZE, &sz_out, &sz_processed, &sz_needed_in, &sz_needed_out)) {
+            continue;
+        }
+        edio24d_pkt_reframe(out + EDIO24D_MSG_HDR_SIZE, sz_out, frame);
+        memmove(pkt, out + EDIO24D_MSG_HDR_SIZE, sz_out);
+        ret = edio24d_msg_create(out, sizeof(out), EDIO24D_MSG_PKT, msg.device, pkt, sz_out);
+        edio24_transport_send(pd->ptr, out, ret);
+    }
+}
+
+static void
+test_edio24d_session_cb (edio24_session_t * pss, const edio24_response_t * presp, void * userdata)
+{
+    int * pcnt = (int *)userdata;
+    if ((NULL != presp) && (EDIO24_STATUS_SUCCESS == presp->status)) {
+        (*pcnt) ++;
+    }
+}
+
+TEST_CASE( .name="edio24-dmsg", .description="test the messages of edio24 daemon.", .skip=0 ) {
+    uint8_t msg[EDIO24D_MSG_HDR_SIZE + EDIO24D_MSG_PAYLOAD_MAX];
+    uint8_t pkt[EDIO24_PKT_LENGTH_MAX];
+    edio24d_msg_t m;
+    uint8_t frame;
+    ssize_t ret;
+    ssize_t sz;
+
+    SECTION("test parameters for edio24d_msg_xxx") {
+        REQUIRE(0 > edio24d_msg_create(NULL, sizeof(msg), EDIO24D_MSG_PKT, 0, pkt, 7));
+        REQUIRE(0 > edio24d_msg_create(msg, sizeof(msg), EDIO24D_MSG_PKT, 0, NULL, 7));
+        REQUIRE(0 > edio24d_msg_create(msg, 10, EDIO24D_MSG_PKT, 0, pkt, 7));
+        REQUIRE(0 > edio24d_msg_create(msg, sizeof(msg), EDIO24D_MSG_PKT, 0, pkt, EDIO24D_MSG_PAYLOAD_MAX + 1));
+        REQUIRE(EDIO24D_MSG_HDR_SIZE == edio24d_msg_create(msg, sizeof(msg), EDIO24D_MSG_LIST, 0, NULL, 0));
+        REQUIRE(0 > edio24d_msg_read(NULL, 10, &m));
+        REQUIRE(0 > edio24d_msg_read(msg, 10, NULL));
+    }
+    SECTION("test edio24d_msg_create and edio24d_msg_read") {
+        frame = 0;
+        sz = edio24_pkt_create_cmd_doutw(pkt, sizeof(pkt), &frame, 0xFF, 0x31);
+        ret = edio24d_msg_create(msg, sizeof(msg), EDIO24D_MSG_PKT, 0x1234, pkt, sz);
+        REQUIRE(EDIO24D_MSG_HDR_SIZE + sz == ret);
+        REQUIRE(EDIO24D_MSG_START == msg[0]);
+        REQUIRE(0x34 == msg[2]);
+        REQUIRE(0x12 == msg[3]);
+        REQUIRE(0 == edio24d_msg_read(msg, 0, &m));
+        REQUIRE(0 == edio24d_msg_read(msg, EDIO24D_MSG_HDR_SIZE - 1, &m));
+        REQUIRE(0 == edio24d_msg_read(msg, ret - 1, &m));
+        REQUIRE(ret == edio24d_msg_read(msg, ret + 3, &m));
+        REQUIRE(EDIO24D_MSG_PKT == m.type);
+        REQUIRE(0x1234 == m.device);
+        REQUIRE(sz == m.sz_payload);
+        REQUIRE(0 == memcmp(pkt, m.payload, sz));
+        msg[0] = 0;
+        REQUIRE(0 > edio24d_msg_read(msg, ret, &m));
+        msg[0] = EDIO24D_MSG_START;
+        msg[5] = 0xFF;
+        REQUIRE(0 > edio24d_msg_read(msg, ret, &m));
+    }
+    SECTION("test edio24d_pkt_reframe") {
+        uint8_t pkt2[EDIO24_PKT_LENGTH_MAX];
+        uint8_t frame2 = 200;
+        frame = 5;
+        sz = edio24_pkt_create_cmd_usermemr(pkt, sizeof(pkt), &frame, 0x10, 0x20);
+        REQUIRE(5 == edio24d_pkt_reframe(pkt, sz, 200));
+        REQUIRE(0 == edio24_pkt_verify(pkt, sz));
+        REQUIRE(sz == edio24_pkt_create_cmd_usermemr(pkt2, sizeof(pkt2), &frame2, 0x10, 0x20));
+        REQUIRE(0 == memcmp(pkt, pkt2, sz));
+        REQUIRE(200 == edio24d_pkt_reframe(pkt, sz, 5));
+        REQUIRE(0 == edio24_pkt_verify(pkt, sz));
+    }
+    SECTION("test the sessions through the daemon") {
+        edio24_loopback_t lb;
+        edio24d_client_t cl;
+        edio24_session_t ss;
+        test_edio24d_t dmn;
+        int cnt = 0;
+        int i;
+
+        REQUIRE(0 == edio24_loopback_init(&lb, 16));
+        memset(&dmn, 0, sizeof(dmn));
+        dmn.ptr = edio24_loopback_device(&lb);
+        dmn.frame = 77;
+        edio24_transport_set_receiver(dmn.ptr, test_edio24d_recv, &dmn);
+        REQUIRE(0 > edio24d_client_init(NULL, edio24_loopback_client(&lb), 0));
+        REQUIRE(0 == edio24d_client_init(&cl, edio24_loopback_client(&lb), 0));
+        REQUIRE(0 == edio24_session_init(&ss, &(cl.base)));
+        for (i = 0; i < 300; i ++) {
+            ret = edio24_pkt_create_cmd_usermemr(pkt, sizeof(pkt), &(ss.frame), 0x10, i + 1);
+            REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_edio24d_session_cb, &cnt));
+        }
+        edio24_loopback_pump(&lb);
+        REQUIRE(300 == dmn.num_pkt);
+        REQUIRE(300 == cnt);
+        REQUIRE(300 == ss.stats.num_respond);
+        REQUIRE(0 == ss.stats.num_error);
+        REQUIRE(0 == edio24_session_inflight(&ss));
+
+        /* the messages of the other devices and the junk are dropped */
+        ret = edio24d_msg_create(msg, sizeof(msg), EDIO24D_MSG_PKT, 1, pkt, 7);
+        edio24_transport_send(dmn.ptr, msg, ret);
+        edio24_transport_send(dmn.ptr, (const uint8_t *)"\x00\x01", 2);
+        edio24_loopback_pump(&lb);
+        REQUIRE(2 == cl.num_error);
+        REQUIRE(0 == ss.stats.num_error);
+
+        edio24_session_clean(&ss);
+        edio24d_client_clean(&cl);
+        edio24_loopback_clean(&lb);
+        free(dmn.rxbuf);
+    }
+}
+
+#endif /* CIUT_ENABLED */
@@ -0,0 +1,743 @@
+/**
+ * \file    edio24rec.c
+ * \brief   The compact recording of the samples of the devices
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ *
+ * A recording is a header followed by the chunks appended one by one. A chunk header keeps the
+ * number of the records and the time range, so a reader maps the file, walks the chunk headers
+ * to build the index, and decodes only the chunks of the time range it wants.
+ *
+ * The records of a chunk are encoded against the previous record of the chunk:
+ *   [flags][command, if the kind is EDIO24_REC_KIND_OTHER][time][device][value]
+ * - flags: bits 0-2 the kind of the command, bit 3 the device is the same, bit 4 the value is the same
+ * - time: the varint of the zigzag of the difference of the time deltas, 1 byte for a steady rate
+ * - device: the varint of the index of the device, omitted if it's the same as the previous record
+ * - value: the varint of the XOR (the difference for the counter) to the last value of the device and
+ *   the kind in the chunk, omitted if the value is not changed
+ * A sample of the polling of a device costs 2 bytes if the value is not changed.
+ * The state of the encoder is reset at the start of each chunk, so a chunk is decoded alone.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h> // memcpy()
+#include <assert.h>
+
+#include "edio24rec.h"
+
+// the kinds of the commands, bits 0-2 of the flags of a record
+#define EDIO24_REC_KIND_DIN     0
+#define EDIO24_REC_KIND_DOUT    1
+#define EDIO24_REC_KIND_DCONF   2
+#define EDIO24_REC_KIND_COUNTER 3
+#define EDIO24_REC_KIND_STATUS  4
+#define EDIO24_REC_KIND_OTHER   7 /**< followed by the command */
+#define EDIO24_REC_NUM_KINDS    8
+#define EDIO24_REC_FLAG_SAMEDEV 0x08
+#define EDIO24_REC_FLAG_SAMEVAL 0x10
+
+#define EDIO24_REC_RECORD_MAX   20 /**< the max byte size of an encoded record */
+
+static uint8_t
+edio24_rec_kind (uint8_t cmd)
+{
+    switch (cmd) {
+    case EDIO24_CMD_DIN_R:     return EDIO24_REC_KIND_DIN;
+    case EDIO24_CMD_DOUT_R:    return EDIO24_REC_KIND_DOUT;
+    case EDIO24_CMD_DCONF_R:   return EDIO24_REC_KIND_DCONF;
+    case EDIO24_CMD_COUNTER_R: return EDIO24_REC_KIND_COUNTER;
+    case EDIO24_CMD_STATUS:    return EDIO24_REC_KIND_STATUS;
+    }
+    return EDIO24_REC_KIND_OTHER;
+}
+
+static const uint8_t edio24_rec_kind_cmds[EDIO24_REC_NUM_KINDS] = {
+    EDIO24_CMD_DIN_R, EDIO24_CMD_DOUT_R, EDIO24_CMD_DCONF_R, EDIO24_CMD_COUNTER_R, EDIO24_CMD_STATUS, 0, 0, 0,
+};
+
+static size_t
+edio24_rec_put_varint (uint8_t * p, uint64_t val)
+{
+    size_t i = 0;
+    while (val >= 0x80) {
+        p[i ++] = (val & 0x7F) | 0x80;
+        val >>= 7;
+    }
+    p[i ++] = val;
+    return i;
+}
+
+/**
+ * \brief read a varint
+ * \return the byte size of the varint, 0 on error
+ */
+static size_t
+edio24_rec_get_varint (const uint8_t * p, size_t sz, uint64_t * pval)
+{
+    uint64_t val = 0;
+    size_t i;
+    for (i = 0; (i < sz) && (i < 10); i ++) {
+        val |= (uint64_t)(p[i] & 0x7F) << (7 * i);
+        if (0 == (p[i] & 0x80)) {
+            *pval = val;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+static void
+edio24_rec_put_u32 (uint8_t * p, uint32_t val)
+{
+    p[0] = val & 0xFF;
+    p[1] = (val >> 8) & 0xFF;
+    p[2] = (val >> 16) & 0xFF;
+    p[3] = (val >> 24) & 0xFF;
+}
+
+static uint32_t
+edio24_rec_get_u32 (const uint8_t * p)
+{
+    return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void
+edio24_rec_put_u64 (uint8_t * p, uint64_t val)
+{
+    edio24_rec_put_u32(p, val & 0xFFFFFFFF);
+    edio24_rec_put_u32(p + 4, val >> 32);
+}
+
+static uint64_t
+edio24_rec_get_u64 (const uint8_t * p)
+{
+    return edio24_rec_get_u32(p) | ((uint64_t)edio24_rec_get_u32(p + 4) << 32);
+}
+
+/** the FNV-1a hash of the records of a chunk */
+static uint32_t
+edio24_rec_hash (const uint8_t * p, size_t sz)
+{
+    uint32_t h = 2166136261U;
+    size_t i;
+    for (i = 0; i < sz; i ++) {
+        h = (h ^ p[i]) * 16777619U;
+    }
+    return h;
+}
+
+/**
+ * \brief write the header of a recording
+ * \param buf: the buffer
+ * \param sz: the byte size of the buffer
+ * \return the byte size of the header, <0 on error
+ */
+ssize_t
+edio24_rec_create_header (uint8_t * buf, size_t sz)
+{
+    if ((NULL == buf) || (sz < EDIO24_REC_HDR_SIZE)) {
+        return -1;
+    }
+    memset(buf, 0, EDIO24_REC_HDR_SIZE);
+    memcpy(buf, EDIO24_REC_MAGIC, 4);
+    buf[4] = EDIO24_REC_VERSION;
+    return EDIO24_REC_HDR_SIZE;
+}
+
+/*****************************************************************************/
+/**
+ * \brief initialize the encoder
+ * \param pw: the encoder
+ * \param sz_chunk: the max byte size of a chunk, 0 for EDIO24_REC_CHUNK_SIZE
+ * \return 0 on success, <0 on error
+ */
+int
+edio24_rec_writer_init (edio24_rec_writer_t * pw, size_t sz_chunk)
+{
+    if (NULL == pw) {
+        return -1;
+    }
+    if (0 == sz_chunk) {
+        sz_chunk = EDIO24_REC_CHUNK_SIZE;
+    }
+    if ((sz_chunk < EDIO24_REC_CHUNK_HDR_SIZE + EDIO24_REC_RECORD_MAX) || (sz_chunk > 0xFFFFFFFFUL)) {
+        return -1;
+    }
+    memset(pw, 0, sizeof(*pw));
+    pw->sz_chunk = sz_chunk;
+    pw->prev = (uint32_t *)malloc(sizeof(uint32_t) * EDIO24_REC_PREV_SIZE);
+    if (NULL == pw->prev) {
+        return -1;
+    }
+    return 0;
+}
+
+void
+edio24_rec_writer_clean (edio24_rec_writer_t * pw)
+{
+    if (NULL == pw) {
+        return;
+    }
+    free(pw->buf);
+    free(pw->prev);
+    pw->buf = NULL;
+    pw->prev = NULL;
+}
+
+/**
+ * \brief append a sample to the chunk
+ * \param pw: the encoder
+ * \param prec: the sample
+ * \return 0 on success, 1 if the sample should be in the next chunk: take the chunk by
+ *   edio24_rec_writer_take() and append the sample again, <0 on error
+ *
+ * A chunk ends when it's full or the time goes backward, so the records of a chunk are in time order.
+ */
+int
+edio24_rec_writer_append (edio24_rec_writer_t * pw, const edio24_rec_t * prec)
+{
+    uint64_t delta;
+    int64_t dod;
+    uint32_t * pprev;
+    uint32_t diff;
+    uint8_t * p;
+    uint8_t * pflags;
+    uint8_t kind;
+
+    if ((NULL == pw) || (NULL == pw->prev) || (NULL == prec) || (prec->device >= EDIO24_REC_DEVICES_MAX)) {
+        return -1;
+    }
+    if (NULL == pw->buf) {
+        pw->buf = (uint8_t *)malloc(pw->sz_chunk);
+        if (NULL == pw->buf) {
+            return -1;
+        }
+        pw->sz = EDIO24_REC_CHUNK_HDR_SIZE;
+        pw->num_records = 0;
+    }
+    if (pw->num_records > 0) {
+        if ((prec->time < pw->time_last) || (pw->sz + EDIO24_REC_RECORD_MAX > pw->sz_chunk)) {
+            return 1;
+        }
+    } else {
+        pw->time_first = prec->time;
+        pw->time_last = prec->time;
+        pw->delta = 0;
+        pw->device = 0;
+        memset(pw->prev, 0, sizeof(uint32_t) * EDIO24_REC_PREV_SIZE);
+    }
+    kind = edio24_rec_kind(prec->cmd);
+    delta = prec->time - pw->time_last;
+    dod = (int64_t)(delta - pw->delta);
+
+    p = pw->buf + pw->sz;
+    pflags = p ++;
+    *pflags = kind;
+    if (EDIO24_REC_KIND_OTHER == kind) {
+        *p ++ = prec->cmd;
+    }
+    p += edio24_rec_put_varint(p, ((uint64_t)dod << 1) ^ (uint64_t)(dod >> 63));
+    if (prec->device == pw->device) {
+        *pflags |= EDIO24_REC_FLAG_SAMEDEV;
+    } else {
+        p += edio24_rec_put_varint(p, prec->device);
+    }
+    pprev = &(pw->prev[prec->device * EDIO24_REC_NUM_KINDS + kind]);
+    diff = (EDIO24_REC_KIND_COUNTER == kind ? prec->value - *pprev : prec->value ^ *pprev);
+    if (0 == diff) {
+        *pflags |= EDIO24_REC_FLAG_SAMEVAL;
+    } else {
+        p += edio24_rec_put_varint(p, diff);
+    }
+    assert (p - (pw->buf + pw->sz) <= EDIO24_REC_RECORD_MAX);
+
+    *pprev = prec->value;
+    pw->sz = p - pw->buf;
+    pw->num_records ++;
+    pw->time_last = prec->time;
+    pw->delta = delta;
+    pw->device = prec->device;
+    return 0;
+}
+
+/**
+ * \brief finish the chunk and take it away, the next sample starts a new chunk
+ * \param pw: the encoder
+ * \param psz: return the byte size of the chunk
+ * \return the chunk, free() it after use; NULL if no sample
+ */
+uint8_t *
+edio24_rec_writer_take (edio24_rec_writer_t * pw, size_t * psz)
+{
+    uint8_t * p;
+
+    if ((NULL == pw) || (NULL == psz) || (NULL == pw->buf) || (pw->num_records < 1)) {
+        return NULL;
+    }
+    p = pw->buf;
+    memcpy(p, EDIO24_REC_CHUNK_MAGIC, 4);
+    edio24_rec_put_u32(p + 4, pw->sz - EDIO24_REC_CHUNK_HDR_SIZE);
+    edio24_rec_put_u32(p + 8, pw->num_records);
+    edio24_rec_put_u32(p + 12, edio24_rec_hash(p + EDIO24_REC_CHUNK_HDR_SIZE, pw->sz - EDIO24_REC_CHUNK_HDR_SIZE));
+    edio24_rec_put_u64(p + 16, pw->time_first);
+    edio24_rec_put_u64(p + 24, pw->time_last);
+    *psz = pw->sz;
+    pw->buf = NULL;
+    pw->sz = 0;
+    pw->num_records = 0;
+    return p;
+}
+
+/*****************************************************************************/
+/**
+ * \brief build the index of the chunks of a recording
+ * \param pr: the reader
+ * \param buf: the recording, usually mapped from the file; it's used until edio24_rec_reader_clean()
+ * \param sz: the byte size of the recording
+ * \return 0 on success, <0 if it's not a recording
+ *
+ * The index stops at the first chunk not whole, for example the one being written.
+ */
+int
+edio24_rec_reader_init (edio24_rec_reader_t * pr, const uint8_t * buf, size_t sz)
+{
+    edio24_rec_chunk_t * pchk;
+    size_t sz_max = 0;
+    size_t off;
+    uint32_t sz_data;
+
+    if ((NULL == pr) || (NULL == buf) || (sz < EDIO24_REC_HDR_SIZE)) {
+        return -1;
+    }
+    if ((0 != memcmp(buf, EDIO24_REC_MAGIC, 4)) || (EDIO24_REC_VERSION != buf[4])) {
+        return -1;
+    }
+    memset(pr, 0, sizeof(*pr));
+    pr->buf = buf;
+    pr->sz = sz;
+    pr->prev = (uint32_t *)malloc(sizeof(uint32_t) * EDIO24_REC_PREV_SIZE);
+    if (NULL == pr->prev) {
+        return -1;
+    }
+    for (off = EDIO24_REC_HDR_SIZE; off + EDIO24_REC_CHUNK_HDR_SIZE <= sz; off += EDIO24_REC_CHUNK_HDR_SIZE + sz_data) {
+        if (0 != memcmp(buf + off, EDIO24_REC_CHUNK_MAGIC, 4)) {
+            break;
+        }
+        sz_data = edio24_rec_get_u32(buf + off + 4);
+        if (sz_data > sz - off - EDIO24_REC_CHUNK_HDR_SIZE) {
+            break;
+        }
+        if (pr->num_chunks >= sz_max) {
+            sz_max = (sz_max < 64 ? 64 : sz_max * 2);
+            pchk = (edio24_rec_chunk_t *)realloc(pr->chunks, sz_max * sizeof(*pchk));
+            if (NULL == pchk) {
+                edio24_rec_reader_clean(pr);
+                return -1;
+            }
+            pr->chunks = pchk;
+        }
+        pchk = &(pr->chunks[pr->num_chunks ++]);
+        pchk->offset = off;
+        pchk->sz_data = sz_data;
+        pchk->num_records = edio24_rec_get_u32(buf + off + 8);
+        pchk->time_first = edio24_rec_get_u64(buf + off + 16);
+        pchk->time_last = edio24_rec_get_u64(buf + off + 24);
+    }
+    pr->sz_valid = off;
+    return 0;
+}
+
+void
+edio24_rec_reader_clean (edio24_rec_reader_t * pr)
+{
+    if (NULL == pr) {
+        return;
+    }
+    free(pr->chunks);
+    free(pr->prev);
+    pr->chunks = NULL;
+    pr->prev = NULL;
+    pr->num_chunks = 0;
+}
+
+/**
+ * \brief find the first chunk which may have the samples at or after a time
+ * \param pr: the reader
+ * \param time: the microseconds since the Epoch
+ * \return the index of the chunk, num_chunks if no chunk
+ *
+ * The chunks are searched by binary search, it assumes the chunks are appended in time order.
+ */
+size_t
+edio24_rec_reader_seek (const edio24_rec_reader_t * pr, uint64_t time)
+{
+    size_t lo = 0;
+    size_t hi;
+    size_t mid;
+
+    if (NULL == pr) {
+        return 0;
+    }
+    hi = pr->num_chunks;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (pr->chunks[mid].time_last < time) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * \brief decode the samples of a chunk, it can be called by several threads with their own states
+ * \param pr: the reader
+ * \param idx: the index of the chunk
+ * \param prev: the state of the decoder, EDIO24_REC_PREV_SIZE values
+ * \param recs: return the samples
+ * \param num: the max number of the samples, not less than the num_records of the chunk
+ * \return the number of the samples, <0 on error or the chunk is broken
+ */
+ssize_t
+edio24_rec_decode_chunk (const edio24_rec_reader_t * pr, size_t idx, uint32_t * prev, edio24_rec_t * recs, size_t num)
+{
+    const edio24_rec_chunk_t * pchk;
+    const uint8_t * p;
+    const uint8_t * pend;
+    uint32_t * pprev;
+    uint64_t time;
+    uint64_t delta = 0;
+    uint64_t val;
+    uint16_t device = 0;
+    uint8_t flags;
+    uint8_t kind;
+    uint8_t cmd;
+    size_t ret;
+    size_t i;
+
+    if ((NULL == pr) || (NULL == prev) || (NULL == recs) || (idx >= pr->num_chunks)) {
+        return -1;
+    }
+    pchk = &(pr->chunks[idx]);
+    if (num < pchk->num_records) {
+        return -1;
+    }
+    p = pr->buf + pchk->offset + EDIO24_REC_CHUNK_HDR_SIZE;
+    pend = p + pchk->sz_data;
+    if (edio24_rec_get_u32(pr->buf + pchk->offset + 12) != edio24_rec_hash(p, pchk->sz_data)) {
+        return -1;
+    }
+    memset(prev, 0, sizeof(uint32_t) * EDIO24_REC_PREV_SIZE);
+    time = pchk->time_first;
+    for (i = 0; i < pchk->num_records; i ++) {
+        if (p >= pend) {
+            return -1;
+        }
+        flags = *p ++;
+        kind = flags & 0x07;
+        cmd = edio24_rec_kind_cmds[kind];
+        if (EDIO24_REC_KIND_OTHER == kind) {
+            if (p >= pend) {
+                return -1;
+            }
+            cmd = *p ++;
+        }
+        ret = edio24_rec_get_varint(p, pend - p, &val);
+        if (ret < 1) {
+            return -1;
+        }
+        p += ret;
+        delta += (uint64_t)((int64_t)(val >> 1) ^ -(int64_t)(val & 0x01));
+        time += delta;
+        if (0 == (flags & EDIO24_REC_FLAG_SAMEDEV)) {
+            ret = edio24_rec_get_varint(p, pend - p, &val);
+            if ((ret < 1) || (val >= EDIO24_REC_DEVICES_MAX)) {
+                return -1;
+            }
+            p += ret;
+            device = val;
+        }
+        pprev = &(prev[device * EDIO24_REC_NUM_KINDS + kind]);
+        if (0 == (flags & EDIO24_REC_FLAG_SAMEVAL)) {
+            ret = edio24_rec_get_varint(p, pend - p, &val);
+            if (ret < 1) {
+                return -1;
+            }
+            p += ret;
+            *pprev = (EDIO24_REC_KIND_COUNTER == kind ? *pprev + (uint32_t)val : *pprev ^ (uint32_t)val);
+        }
+        recs[i].time = time;
+        recs[i].device = device;
+        recs[i].cmd = cmd;
+        recs[i].value = *pprev;
+    }
+    return i;
+}
+
+/**
+ * \brief decode the samples of a chunk by the state of the reader
+ * \return the number of the samples, <0 on error or the chunk is broken
+ */
+ssize_t
+edio24_rec_reader_decode (edio24_rec_reader_t * pr, size_t idx, edio24_rec_t * recs, size_t num)
+{
+    if (NULL == pr) {
+        return -1;
+    }
+    return edio24_rec_decode_chunk(pr, idx, pr->prev, recs, num);
+}
+
+/*****************************************************************************/
+/**
+ * \brief find the samples changed in the mask, for example the edges of the pins of DIn
+ * \param vals: the values of a device and a command in time order
+ * \param num: the number of the values
+ * \param prev: the value before vals[0]
+ * \param mask: the bits checked
+ * \param idx: return the indexes of the values changed
+ * \param max: the max number of the indexes
+ * \return the number of the indexes, the scan stops when idx is full
+ *
+ * The values are compared in blocks of 64 into a byte mask without branches, so the compiler
+ * vectorizes the comparison (check it by -fopt-info-vec); the blocks without a change are skipped
+ * and the mask of the others is packed into the indexes in a second pass.
+ */
+size_t
+edio24_rec_scan_changes (const uint32_t * vals, size_t num, uint32_t prev, uint32_t mask, uint32_t * idx, size_t max)
+{
+    uint8_t flags[64];
+    uint8_t any;
+    size_t num_idx = 0;
+    size_t base;
+    size_t i;
+    size_t n;
+
+    if ((NULL == vals) || (NULL == idx) || (num < 1) || (max < 1)) {
+        return 0;
+    }
+    // the first value is compared here, so the blocks compare vals[i] with vals[i - 1]
+    if ((vals[0] ^ prev) & mask) {
+        idx[num_idx ++] = 0;
+    }
+    for (base = 1; (base < num) && (num_idx < max); base += 64) {
+        n = (num - base < 64 ? num - base : 64);
+        any = 0;
+        if (64 == n) {
+            // the constant count lets -O2 vectorize it too, without the epilogue
+            for (i = 0; i < 64; i ++) {
+                flags[i] = (0 != ((vals[base + i] ^ vals[base + i - 1]) & mask));
+                any |= flags[i];
+            }
+        } else {
+            for (i = 0; i < n; i ++) {
+                flags[i] = (0 != ((vals[base + i] ^ vals[base + i - 1]) & mask));
+                any |= flags[i];
+            }
+        }
+        if (0 == any) {
+            continue;
+        }
+        for (i = 0; (i < n) && (num_idx < max); i ++) {
+            if (flags[i]) {
+                idx[num_idx ++] = base + i;
+            }
+        }
+    }
+    return num_idx;
+}
+
+#if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
+#include <ciut.h>
+#include <time.h> // clock_gettime()
+
+TEST_CASE( .name="edio24-rec", .description="test the recording of the samples.", .skip=0 ) {
+    edio24_rec_writer_t wr;
+    edio24_rec_reader_t rd;
+    edio24_rec_t rec;
+    edio24_rec_t recs[64];
+    uint8_t file[4096];
+    size_t sz_file;
+    uint8_t * pchk;
+    size_t sz;
+    size_t i;
+
+    SECTION("test the varint") {
+        uint8_t buf[10];
+        uint64_t val = 0;
+        REQUIRE(1 == edio24_rec_put_varint(buf, 0x7F));
+        REQUIRE(1 == edio24_rec_get_varint(buf, 1, &val));
+        REQUIRE(0x7F == val);
+        REQUIRE(2 == edio24_rec_put_varint(buf, 0x80));
+        REQUIRE(0 == edio24_rec_get_varint(buf, 1, &val));
+        REQUIRE(2 == edio24_rec_get_varint(buf, 2, &val));
+        REQUIRE(0x80 == val);
+        REQUIRE(10 == edio24_rec_put_varint(buf, 0xFFFFFFFFFFFFFFFFULL));
+        REQUIRE(10 == edio24_rec_get_varint(buf, 10, &val));
+        REQUIRE(0xFFFFFFFFFFFFFFFFULL == val);
+    }
+    SECTION("test encode and decode") {
+        edio24_rec_t samples[] = {
+            { 1000000, 0, EDIO24_CMD_DIN_R,     0x000001 },
+            { 1001000, 0, EDIO24_CMD_DIN_R,     0x000001 },
+            { 1002000, 0, EDIO24_CMD_DIN_R,     0x000003 },
+            { 1002000, 5, EDIO24_CMD_COUNTER_R, 100 },
+            { 1003001, 5, EDIO24_CMD_COUNTER_R, 107 },
+            { 1003001, 0, EDIO24_CMD_DIN_R,     0x800003 },
+            { 1003500, 1023, EDIO24_CMD_FIRMWARE, 0x0102 },
+            { 1003400, 1, EDIO24_CMD_DOUT_R,    0xFFFFFF }, // the time goes backward
+        };
+
+        REQUIRE(0 > edio24_rec_writer_init(&wr, 10));
+        REQUIRE(0 == edio24_rec_writer_init(&wr, 0));
+        REQUIRE(NULL == edio24_rec_writer_take(&wr, &sz));
+        rec = samples[0];
+        rec.device = EDIO24_REC_DEVICES_MAX;
+        REQUIRE(0 > edio24_rec_writer_append(&wr, &rec));
+
+        sz_file = edio24_rec_create_header(file, sizeof(file));
+        REQUIRE(EDIO24_REC_HDR_SIZE == sz_file);
+        for (i = 0; i < NUM_ARRAY(samples) - 1; i ++) {
+            REQUIRE(0 == edio24_rec_writer_append(&wr, &(samples[i])));
+        }
+        REQUIRE(1 == edio24_rec_writer_append(&wr, &(samples[i])));
+        // the repeated sample costs 2 bytes
+        REQUIRE(wr.sz < EDIO24_REC_CHUNK_HDR_SIZE + 7 * 6);
+        pchk = edio24_rec_writer_take(&wr, &sz);
+        REQUIRE(NULL != pchk);
+        memcpy(file + sz_file, pchk, sz);
+        sz_file += sz;
+        free(pchk);
+        REQUIRE(0 == edio24_rec_writer_append(&wr, &(samples[i])));
+        pchk = edio24_rec_writer_take(&wr, &sz);
+        REQUIRE(NULL != pchk);
+        memcpy(file + sz_file, pchk, sz);
+        sz_file += sz;
+        free(pchk);
+        edio24_rec_writer_clean(&wr);
+
+        REQUIRE(0 > edio24_rec_reader_init(&rd, file, 4));
+        // a chunk being written at the end
+        REQUIRE(0 == edio24_rec_reader_init(&rd, file, sz_file - 1));
+        REQUIRE(1 == rd.num_chunks);
+        REQUIRE(sz_file - sz == rd.sz_valid);
+        edio24_rec_reader_clean(&rd);
+
+        REQUIRE(0 == edio24_rec_reader_init(&rd, file, sz_file));
+        REQUIRE(2 == rd.num_chunks);
+        REQUIRE(sz_file == rd.sz_valid);
+        REQUIRE(7 == rd.chunks[0].num_records);
+        REQUIRE(1000000 == rd.chunks[0].time_first);
+        REQUIRE(1003500 == rd.chunks[0].time_last);
+        REQUIRE(0 > edio24_rec_reader_decode(&rd, 0, recs, 6));
+        REQUIRE(7 == edio24_rec_reader_decode(&rd, 0, recs, NUM_ARRAY(recs)));
+        for (i = 0; i < 7; i ++) {
+            REQUIRE(samples[i].time == recs[i].time);
+            REQUIRE(samples[i].device == recs[i].device);
+            REQUIRE(samples[i].cmd == recs[i].cmd);
+            REQUIRE(samples[i].value == recs[i].value);
+        }
+        REQUIRE(1 == edio24_rec_reader_decode(&rd, 1, recs, NUM_ARRAY(recs)));
+        REQUIRE(samples[7].value == recs[0].value);
+
+        REQUIRE(0 == edio24_rec_reader_seek(&rd, 0));
+        REQUIRE(0 == edio24_rec_reader_seek(&rd, 1003400));
+        REQUIRE(2 == edio24_rec_reader_seek(&rd, 1003501));
+
+        // a broken chunk
+        file[EDIO24_REC_HDR_SIZE + EDIO24_REC_CHUNK_HDR_SIZE + 1] ^= 0x01;
+        REQUIRE(0 > edio24_rec_reader_decode(&rd, 0, recs, NUM_ARRAY(recs)));
+        edio24_rec_reader_clean(&rd);
+    }
+    SECTION("test the size and the speed") {
+        struct timespec ts0;
+        struct timespec ts1;
+        uint8_t * buf;
+        size_t sz_max = 4 * 1024 * 1024;
+        size_t num = 1000000;
+        size_t num_read = 0;
+        char flg_same = 1;
+        uint64_t ns;
+        ssize_t ret;
+        edio24_rec_t * precs;
+
+        // 4 devices polled at 1 kHz with some jitter, the pins change sometimes
+        buf = (uint8_t *)malloc(sz_max);
+        precs = (edio24_rec_t *)malloc(EDIO24_REC_CHUNK_SIZE / 2 * sizeof(*precs));
+        REQUIRE(NULL != buf);
+        REQUIRE(NULL != precs);
+        sz_file = edio24_rec_create_header(buf, sz_max);
+        REQUIRE(0 == edio24_rec_writer_init(&wr, 0));
+        for (i = 0; i < num; i ++) {
+            rec.time = 1600000000000000ULL + (i / 4) * 1000 + (i % 4) * 10 + (i % 7);
+            rec.device = i % 4;
+            rec.cmd = EDIO24_CMD_DIN_R;
+            rec.value = (i / 1000) & 0xFFFFFF;
+            if (1 == edio24_rec_writer_append(&wr, &rec)) {
+                pchk = edio24_rec_writer_take(&wr, &sz);
+                memcpy(buf + sz_file, pchk, sz);
+                sz_file += sz;
+                free(pchk);
+                REQUIRE(0 == edio24_rec_writer_append(&wr, &rec));
+            }
+        }
+        pchk = edio24_rec_writer_take(&wr, &sz);
+        memcpy(buf + sz_file, pchk, sz);
+        sz_file += sz;
+        free(pchk);
+        edio24_rec_writer_clean(&wr);
+        CIUT_LOG("%" PRIuSZ " samples in %" PRIuSZ " bytes", num, sz_file);
+        REQUIRE(sz_file < num * 4);
+
+        clock_gettime(CLOCK_MONOTONIC, &ts0);
+        REQUIRE(0 == edio24_rec_reader_init(&rd, buf, sz_file));
+        for (i = edio24_rec_reader_seek(&rd, 0); i < rd.num_chunks; i ++) {
+            ret = edio24_rec_reader_decode(&rd, i, precs, EDIO24_REC_CHUNK_SIZE / 2);
+            REQUIRE(ret > 0);
+            if ((precs[0].device != num_read % 4) || (precs[0].value != ((num_read / 1000) & 0xFFFFFF))) {
+                flg_same = 0;
+            }
+            num_read += ret;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &ts1);
+        ns = (ts1.tv_sec - ts0.tv_sec) * 1000000000 + (ts1.tv_nsec - ts0.tv_nsec);
+        CIUT_LOG("decode %" PRIuSZ " samples of %" PRIuSZ " chunks in %" PRIu64 " nanoseconds", num_read, rd.num_chunks, ns);
+        REQUIRE(num == num_read);
+        REQUIRE(flg_same);
+        edio24_rec_reader_clean(&rd);
+        free(precs);
+        free(buf);
+    }
+    SECTION("test edio24_rec_scan_changes") {
+        uint32_t vals[300];
+        uint32_t idx[300];
+        uint32_t idx2[300];
+        size_t num_idx2 = 0;
+        uint32_t prev = 0x80;
+        uint32_t mask = 0x000080; // pin 7
+
+        for (i = 0; i < NUM_ARRAY(vals); i ++) {
+            vals[i] = ((i * 2654435761U) >> 8) & 0xFFFFFF;
+            if (i % 3) {
+                vals[i] = (i > 0 ? vals[i - 1] : prev);
+            }
+        }
+        for (i = 0; i < NUM_ARRAY(vals); i ++) {
+            if ((vals[i] ^ (i > 0 ? vals[i - 1] : prev)) & mask) {
+                idx2[num_idx2 ++] = i;
+            }
+        }
+        REQUIRE(num_idx2 > 10);
+        REQUIRE(0 == edio24_rec_scan_changes(vals, 0, prev, mask, idx, NUM_ARRAY(idx)));
+        REQUIRE(num_idx2 == edio24_rec_scan_changes(vals, NUM_ARRAY(vals), prev, mask, idx, NUM_ARRAY(idx)));
+        REQUIRE(0 == memcmp(idx, idx2, num_idx2 * sizeof(idx[0])));
+        // the scan stops when the indexes are full
+        REQUIRE(3 == edio24_rec_scan_changes(vals, NUM_ARRAY(vals), prev, mask, idx, 3));
+        REQUIRE(0 == memcmp(idx, idx2, 3 * sizeof(idx[0])));
+        // not changed
+        REQUIRE(0 == edio24_rec_scan_changes(vals, NUM_ARRAY(vals), prev, 0, idx, NUM_ARRAY(idx)));
+    }
+}
+
+#endif /* CIUT_ENABLED */
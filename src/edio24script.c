@@ -0,0 +1,604 @@
+/**
+ * \file    edio24script.c
+ * \brief   The parser of the E-DIO24 command script
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ *
+ * A line of the script is a keyword and its arguments separated by spaces, for example
+ * 'DOutW 0xFF 0x31'. The keyword is found by a hash table, and the arguments are parsed by
+ * the schema of the command in the table, the line is compiled to a record of a command stream.
+ * Empty lines and the lines start with '#' are skipped.
+ */
+
+#include <stdio.h>
+#include <string.h> // memcmp()
+#include <assert.h>
+
+#include "edio24script.h"
+
+#ifndef NUM_ARRAY
+#define NUM_ARRAY(a) (sizeof(a)/sizeof(a[0]))
+#endif
+
+#define EDIO24_SCRIPT_DATA_MAX 1022 /**< the max byte size of the data to write, 2 bytes of the data area are the address */
+
+#define ARG_MASK  { EDIO24_SCRIPT_ARG_HEX, 0xFFFFFF, "mask" }
+#define ARG_VALUE { EDIO24_SCRIPT_ARG_HEX, 0xFFFFFF, "value" }
+#define ARG_ADDR  { EDIO24_SCRIPT_ARG_HEX, 0xFFFF, "address" }
+#define ARG_COUNT { EDIO24_SCRIPT_ARG_HEX, 1024, "count" }
+#define ARG_DATA  { EDIO24_SCRIPT_ARG_BYTES, EDIO24_SCRIPT_DATA_MAX, "data" }
+#define CMD_PKT(keyword, cmd) keyword, sizeof(keyword) - 1, EDIO24_SCRIPT_PKT, cmd
+
+/** the commands, the index is stored in edio24_script_slots[] */
+static const edio24_script_cmd_t edio24_script_cmds[] = {
+    { CMD_PKT("DIn",               EDIO24_CMD_DIN_R),        0, { { 0 } }, "DIn" },
+    { CMD_PKT("DOutR",             EDIO24_CMD_DOUT_R),       0, { { 0 } }, "DOutR" },
+    { CMD_PKT("DOutW",             EDIO24_CMD_DOUT_W),       2, { ARG_MASK, ARG_VALUE }, "DOutW 0xFF 0x31" },
+    { CMD_PKT("DConfigR",          EDIO24_CMD_DCONF_R),      0, { { 0 } }, "DConfigR" },
+    { CMD_PKT("DConfigW",          EDIO24_CMD_DCONF_W),      2, { ARG_MASK, ARG_VALUE }, "DConfigW 0xFF 0x13" },
+    { CMD_PKT("CounterR",          EDIO24_CMD_COUNTER_R),    0, { { 0 } }, "CounterR" },
+    { CMD_PKT("CounterW",          EDIO24_CMD_COUNTER_W),    0, { { 0 } }, "CounterW" },
+    { CMD_PKT("BlinkLED",          EDIO24_CMD_BLINKLED),     1, { { EDIO24_SCRIPT_ARG_HEX, 0xFF, "count" } }, "BlinkLED 0x01" },
+    { CMD_PKT("Reset",             EDIO24_CMD_RESET),        0, { { 0 } }, "Reset" },
+    { CMD_PKT("Status",            EDIO24_CMD_STATUS),       0, { { 0 } }, "Status" },
+    { CMD_PKT("NetworkConfig",     EDIO24_CMD_NETWORK_CONF), 0, { { 0 } }, "NetworkConfig" },
+    { CMD_PKT("FirmwareUpgrade",   EDIO24_CMD_FIRMWARE),     0, { { 0 } }, "FirmwareUpgrade" },
+    { CMD_PKT("ConfigMemoryR",     EDIO24_CMD_CONF_MEM_R),   2, { ARG_ADDR, ARG_COUNT }, "ConfigMemoryR 0x1 0x5" },
+    { CMD_PKT("ConfigMemoryW",     EDIO24_CMD_CONF_MEM_W),   2, { ARG_ADDR, ARG_DATA }, "ConfigMemoryW 0x1 0x313924" },
+    { CMD_PKT("UserMemoryR",       EDIO24_CMD_USR_MEM_R),    2, { ARG_ADDR, ARG_COUNT }, "UserMemoryR 0x123 0x15" },
+    { CMD_PKT("UserMemoryW",       EDIO24_CMD_USR_MEM_W),    2, { ARG_ADDR, ARG_DATA }, "UserMemoryW 0x123 0x4987249dd9876af987695d07" },
+    { CMD_PKT("SettingsMemoryR",   EDIO24_CMD_SET_MEM_R),    2, { ARG_ADDR, ARG_COUNT }, "SettingsMemoryR 0x12 0x39" },
+    { CMD_PKT("SettingsMemoryW",   EDIO24_CMD_SET_MEM_W),    2, { ARG_ADDR, ARG_DATA }, "SettingsMemoryW 0x12 0xe932be9df8" },
+    /* the address of the bootloader is in the FLASH 0x1D000000 - 0x1FC01FFF, only the lower 16 bits are sent in the packet */
+    { CMD_PKT("BootloaderMemoryR", EDIO24_CMD_BOOT_MEM_R),   2, { { EDIO24_SCRIPT_ARG_HEX, 0xFFFFFFFF, "address" }, ARG_COUNT }, "BootloaderMemoryR 0x1D000000 0x122" },
+    { CMD_PKT("BootloaderMemoryW", EDIO24_CMD_BOOT_MEM_W),   2, { { EDIO24_SCRIPT_ARG_HEX, 0xFFFFFFFF, "address" }, ARG_DATA }, "BootloaderMemoryW 0x1D000000 0x9839234923134428379875109837" },
+    { "Sleep",   5, EDIO24_SCRIPT_SLEEP,   0, 1, { { EDIO24_SCRIPT_ARG_DEC, 0xFFFFFFFFFFFFULL, "microseconds" } }, "Sleep 10000" },
+    { "Barrier", 7, EDIO24_SCRIPT_BARRIER, 0, 0, { { 0 } }, "Barrier" },
+};
+
+/**
+ * the hash table of the keywords, the value is the index in edio24_script_cmds[], -1 if empty.
+ * A keyword is stored in the first empty slot from edio24_script_hash(), the table is built by edio24_script_init().
+ */
+#define EDIO24_SCRIPT_SLOTS 64
+#define edio24_script_hash(word, len) (((uint8_t)(word)[0] * 10 + (uint8_t)(word)[(len) - 1] * 60 + (len)) & (EDIO24_SCRIPT_SLOTS - 1))
+static int8_t edio24_script_slots[EDIO24_SCRIPT_SLOTS];
+static char edio24_script_flg_slots = 0; /**< 1 -- the table is built, -1 -- error */
+
+/**
+ * \brief find the slot of a keyword in a hash table
+ * \param cmds: the commands
+ * \param slots: the hash table of the indexes of the commands
+ * \param word: the keyword
+ * \param len: the length of the keyword
+ * \return the slot of the keyword, or the empty slot for it; <0 if not found and the table is full
+ */
+static int
+edio24_script_probe (const edio24_script_cmd_t * cmds, const int8_t * slots, const char * word, size_t len)
+{
+    const edio24_script_cmd_t * pcmd;
+    size_t h = edio24_script_hash(word, len);
+    size_t i;
+
+    for (i = 0; i < EDIO24_SCRIPT_SLOTS; i ++, h = (h + 1) & (EDIO24_SCRIPT_SLOTS - 1)) {
+        if (slots[h] < 0) {
+            return h;
+        }
+        pcmd = &(cmds[slots[h]]);
+        if ((pcmd->len == len) && (0 == memcmp(pcmd->keyword, word, len))) {
+            return h;
+        }
+    }
+    return -1;
+}
+
+/**
+ * \brief build the hash table of the commands
+ * \param cmds: the commands
+ * \param num: the number of the commands
+ * \param slots: the hash table, EDIO24_SCRIPT_SLOTS items
+ * \return the number of the collisions, <0 on error (a keyword is duplicated or the table is full)
+ */
+static int
+edio24_script_build_slots (const edio24_script_cmd_t * cmds, size_t num, int8_t * slots)
+{
+    int collisions = 0;
+    size_t i;
+    int h;
+
+    if (num >= EDIO24_SCRIPT_SLOTS) {
+        return -1;
+    }
+    memset(slots, -1, EDIO24_SCRIPT_SLOTS * sizeof(slots[0]));
+    for (i = 0; i < num; i ++) {
+        h = edio24_script_probe(cmds, slots, cmds[i].keyword, cmds[i].len);
+        if ((h < 0) || (slots[h] >= 0)) {
+            fprintf(stderr, "script error in the keyword '%s' of the table\n", cmds[i].keyword);
+            return -1;
+        }
+        if ((size_t)h != edio24_script_hash(cmds[i].keyword, cmds[i].len)) {
+            collisions ++;
+        }
+        slots[h] = (int8_t)i;
+    }
+    return collisions;
+}
+
+/**
+ * \brief build the hash table of the keywords
+ * \return 0 on success, <0 on error
+ *
+ * edio24_script_lookup() builds it at the first call; call it before the parser is used by several threads.
+ */
+int
+edio24_script_init (void)
+{
+    if (0 == edio24_script_flg_slots) {
+        edio24_script_flg_slots = (edio24_script_build_slots(edio24_script_cmds, NUM_ARRAY(edio24_script_cmds), edio24_script_slots) < 0 ? -1 : 1);
+    }
+    return (edio24_script_flg_slots > 0 ? 0 : -1);
+}
+
+/**
+ * \brief get the number of the commands in the table
+ */
+size_t
+edio24_script_num_cmds (void)
+{
+    return NUM_ARRAY(edio24_script_cmds);
+}
+
+/**
+ * \brief get a command in the table
+ * \param idx: the index, 0 to edio24_script_num_cmds() - 1
+ * \return the command, NULL if the index is out of range
+ */
+const edio24_script_cmd_t *
+edio24_script_cmd (size_t idx)
+{
+    if (idx >= NUM_ARRAY(edio24_script_cmds)) {
+        return NULL;
+    }
+    return &(edio24_script_cmds[idx]);
+}
+
+/**
+ * \brief find the command of a keyword
+ * \param word: the keyword, not need to be terminated
+ * \param len: the length of the keyword
+ * \return the command, NULL if not found
+ */
+const edio24_script_cmd_t *
+edio24_script_lookup (const char * word, size_t len)
+{
+    int h;
+    if ((NULL == word) || (len < 1) || (len > 0xFF)) {
+        return NULL;
+    }
+    if (edio24_script_init() < 0) {
+        return NULL;
+    }
+    h = edio24_script_probe(edio24_script_cmds, edio24_script_slots, word, len);
+    if ((h < 0) || (edio24_script_slots[h] < 0)) {
+        return NULL;
+    }
+    return &(edio24_script_cmds[edio24_script_slots[h]]);
+}
+
+#define IS_SPACE(c) (((c) == ' ') || ((c) == '\t') || ((c) == '\r') || ((c) == '\n'))
+
+/**
+ * \brief get the value of a hexadecimal digit
+ * \return the value, <0 if it is not a digit
+ */
+static int
+edio24_script_hexval (char c)
+{
+    if ((c >= '0') && (c <= '9')) {
+        return c - '0';
+    }
+    if ((c >= 'a') && (c <= 'f')) {
+        return c - 'a' + 10;
+    }
+    if ((c >= 'A') && (c <= 'F')) {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/**
+ * \brief parse a number token
+ * \param tok: the token
+ * \param len: the length of the token
+ * \param parg: the schema of the argument
+ * \param pval: return the value
+ * \param pcol: return the offset in the token of the error
+ * \return NULL on success, the error message on error
+ */
+static const char *
+edio24_script_parse_num (const char * tok, size_t len, const edio24_script_arg_t * parg, uint64_t * pval, size_t * pcol)
+{
+    uint64_t val = 0;
+    size_t i = 0;
+    int d;
+    int base = (EDIO24_SCRIPT_ARG_DEC == parg->type ? 10 : 16);
+
+    if ((16 == base) && (len >= 2) && (tok[0] == '0') && ((tok[1] == 'x') || (tok[1] == 'X'))) {
+        i = 2;
+    }
+    *pcol = i;
+    if (i >= len) {
+        return "expect digits";
+    }
+    for (; i < len; i ++) {
+        d = edio24_script_hexval(tok[i]);
+        if ((d < 0) || (d >= base)) {
+            *pcol = i;
+            return (16 == base ? "invalid hexadecimal digit" : "invalid decimal digit");
+        }
+        val = val * base + d;
+        if (val > parg->max) {
+            *pcol = 0;
+            return "value out of range";
+        }
+    }
+    *pval = val;
+    return NULL;
+}
+
+/**
+ * \brief parse a byte string token
+ * \param tok: the token
+ * \param len: the length of the token
+ * \param parg: the schema of the argument
+ * \param buf: the buffer of the bytes
+ * \param psz: return the number of bytes
+ * \param pcol: return the offset in the token of the error
+ * \return NULL on success, the error message on error
+ */
+static const char *
+edio24_script_parse_bytes (const char * tok, size_t len, const edio24_script_arg_t * parg, uint8_t * buf, size_t * psz, size_t * pcol)
+{
+    size_t i;
+    size_t sz = 0;
+    int d1;
+    int d2;
+
+    *pcol = 0;
+    if ((len < 2) || (tok[0] != '0') || ((tok[1] != 'x') && (tok[1] != 'X'))) {
+        return "expect 0x";
+    }
+    if ((len - 2) % 2 != 0) {
+        *pcol = len - 1;
+        return "odd number of hexadecimal digits";
+    }
+    if ((len - 2) / 2 > parg->max) {
+        return "too many bytes";
+    }
+    for (i = 2; i < len; i += 2) {
+        d1 = edio24_script_hexval(tok[i]);
+        d2 = edio24_script_hexval(tok[i + 1]);
+        if ((d1 < 0) || (d2 < 0)) {
+            *pcol = (d1 < 0 ? i : i + 1);
+            return "invalid hexadecimal digit";
+        }
+        buf[sz ++] = (d1 << 4) | d2;
+    }
+    *psz = sz;
+    return NULL;
+}
+
+/**
+ * \brief create the request packet of a command
+ * \param pcmd: the command
+ * \param vals: the values of the arguments
+ * \param data: the bytes of the argument EDIO24_SCRIPT_ARG_BYTES
+ * \param sz_data: the number of the bytes
+ * \param buffer: the buffer of the packet
+ * \param sz_buf: the size of the buffer
+ * \return the byte size of the packet, <0 on error
+ */
+static ssize_t
+edio24_script_create_pkt (const edio24_script_cmd_t * pcmd, const uint64_t * vals, uint8_t * data, size_t sz_data, uint8_t * buffer, size_t sz_buf)
+{
+    uint8_t frame = 0; /* the frame id is set when the packet is sent */
+    switch (pcmd->cmd) {
+    case EDIO24_CMD_DIN_R:        return edio24_pkt_create_cmd_dinr (buffer, sz_buf, &frame);
+    case EDIO24_CMD_DOUT_R:       return edio24_pkt_create_cmd_doutr (buffer, sz_buf, &frame);
+    case EDIO24_CMD_DOUT_W:       return edio24_pkt_create_cmd_doutw (buffer, sz_buf, &frame, vals[0], vals[1]);
+    case EDIO24_CMD_DCONF_R:      return edio24_pkt_create_cmd_dconfr (buffer, sz_buf, &frame);
+    case EDIO24_CMD_DCONF_W:      return edio24_pkt_create_cmd_dconfw (buffer, sz_buf, &frame, vals[0], vals[1]);
+    case EDIO24_CMD_COUNTER_R:    return edio24_pkt_create_cmd_dcounterr (buffer, sz_buf, &frame);
+    case EDIO24_CMD_COUNTER_W:    return edio24_pkt_create_cmd_dcounterw (buffer, sz_buf, &frame);
+    case EDIO24_CMD_BLINKLED:     return edio24_pkt_create_cmd_blinkled (buffer, sz_buf, &frame, vals[0]);
+    case EDIO24_CMD_RESET:        return edio24_pkt_create_cmd_reset (buffer, sz_buf, &frame);
+    case EDIO24_CMD_STATUS:       return edio24_pkt_create_cmd_status (buffer, sz_buf, &frame);
+    case EDIO24_CMD_NETWORK_CONF: return edio24_pkt_create_cmd_netconf (buffer, sz_buf, &frame);
+    case EDIO24_CMD_FIRMWARE:     return edio24_pkt_create_cmd_firmware (buffer, sz_buf, &frame);
+    case EDIO24_CMD_CONF_MEM_R:   return edio24_pkt_create_cmd_confmemr (buffer, sz_buf, &frame, vals[0], vals[1]);
+    case EDIO24_CMD_CONF_MEM_W:   return edio24_pkt_create_cmd_confmemw (buffer, sz_buf, &frame, vals[0], sz_data, data);
+    case EDIO24_CMD_USR_MEM_R:    return edio24_pkt_create_cmd_usermemr (buffer, sz_buf, &frame, vals[0], vals[1]);
+    case EDIO24_CMD_USR_MEM_W:    return edio24_pkt_create_cmd_usermemw (buffer, sz_buf, &frame, vals[0], sz_data, data);
+    case EDIO24_CMD_SET_MEM_R:    return edio24_pkt_create_cmd_setmemr (buffer, sz_buf, &frame, vals[0], vals[1]);
+    case EDIO24_CMD_SET_MEM_W:    return edio24_pkt_create_cmd_setmemw (buffer, sz_buf, &frame, vals[0], sz_data, data);
+    case EDIO24_CMD_BOOT_MEM_R:   return edio24_pkt_create_cmd_bootmemr (buffer, sz_buf, &frame, vals[0], vals[1]);
+    case EDIO24_CMD_BOOT_MEM_W:   return edio24_pkt_create_cmd_bootmemw (buffer, sz_buf, &frame, vals[0], sz_data, data);
+    }
+    return -1;
+}
+
+#define SCRIPT_ERROR(col, message, argname) do { if (NULL != perr) { perr->column = (col) + 1; perr->msg = (message); perr->arg = (argname); } return -1; } while (0)
+
+/**
+ * \brief compile a line of the script to the stream
+ * \param pcs: the stream
+ * \param line: the line, not need to be terminated
+ * \param len: the length of the line
+ * \param perr: return the column and the message of the error, it can be NULL
+ * \return 1 if a record is appended; 0 if the line is empty or a comment; <0 on error
+ */
+int
+edio24_script_compile_line (edio24_cmdstream_t * pcs, const char * line, size_t len, edio24_script_err_t * perr)
+{
+    const edio24_script_cmd_t * pcmd;
+    const char * msg;
+    uint64_t vals[EDIO24_SCRIPT_ARGS_MAX];
+    uint8_t data[EDIO24_SCRIPT_DATA_MAX];
+    uint8_t pkt[EDIO24_PKT_LENGTH_MIN + 1024];
+    size_t sz_data = 0;
+    size_t pos = 0;
+    size_t start;
+    size_t col;
+    ssize_t ret;
+    int i;
+
+    if ((NULL == pcs) || ((NULL == line) && (len > 0))) {
+        return -1;
+    }
+    while ((pos < len) && IS_SPACE(line[pos])) {
+        pos ++;
+    }
+    if ((pos >= len) || ('#' == line[pos])) {
+        return 0;
+    }
+    start = pos;
+    while ((pos < len) && (! IS_SPACE(line[pos]))) {
+        pos ++;
+    }
+    pcmd = edio24_script_lookup(line + start, pos - start);
+    if (NULL == pcmd) {
+        SCRIPT_ERROR(start, "unknown command", NULL);
+    }
+    memset(vals, 0, sizeof(vals));
+    for (i = 0; i < pcmd->num_args; i ++) {
+        const edio24_script_arg_t * parg = &(pcmd->args[i]);
+        while ((pos < len) && IS_SPACE(line[pos])) {
+            pos ++;
+        }
+        if ((pos >= len) || ('#' == line[pos])) {
+            SCRIPT_ERROR(pos, "missing argument", parg->name);
+        }
+        start = pos;
+        while ((pos < len) && (! IS_SPACE(line[pos]))) {
+            pos ++;
+        }
+        if (EDIO24_SCRIPT_ARG_BYTES == parg->type) {
+            msg = edio24_script_parse_bytes(line + start, pos - start, parg, data, &sz_data, &col);
+        } else {
+            msg = edio24_script_parse_num(line + start, pos - start, parg, &(vals[i]), &col);
+        }
+        if (NULL != msg) {
+            SCRIPT_ERROR(start + col, msg, parg->name);
+        }
+    }
+    while ((pos < len) && IS_SPACE(line[pos])) {
+        pos ++;
+    }
+    if ((pos < len) && ('#' != line[pos])) {
+        SCRIPT_ERROR(pos, "unexpected argument", NULL);
+    }
+
+    switch (pcmd->kind) {
+    case EDIO24_SCRIPT_SLEEP:
+        ret = edio24_cmdstream_add_sleep(pcs, vals[0]);
+        break;
+    case EDIO24_SCRIPT_BARRIER:
+        ret = edio24_cmdstream_add_barrier(pcs);
+        break;
+    default:
+        ret = edio24_script_create_pkt(pcmd, vals, data, sz_data, pkt, sizeof(pkt));
+        if (ret > 0) {
+            ret = edio24_cmdstream_add_pkt(pcs, pkt, ret);
+        }
+        break;
+    }
+    if (ret < 0) {
+        SCRIPT_ERROR(0, "out of memory", NULL);
+    }
+    return 1;
+}
+
+#if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
+#include <ciut.h>
+#include <time.h> // clock_gettime()
+
+TEST_CASE( .name="edio24-script", .description="test edio24 script parser.", .skip=0 ) {
+    edio24_cmdstream_t cs;
+    edio24_cmdrec_t rec;
+    edio24_script_err_t err;
+    const edio24_script_cmd_t * pcmd;
+    uint8_t pkt[EDIO24_PKT_LENGTH_MIN + 1024];
+    uint8_t pkt2[EDIO24_PKT_LENGTH_MIN + 1024];
+    uint8_t frame;
+    uint8_t frame2;
+    ssize_t ret;
+    size_t i;
+    int j;
+
+    SECTION("test the hash table of the keywords") {
+        int8_t slots[EDIO24_SCRIPT_SLOTS];
+        edio24_script_cmd_t dups[3];
+        REQUIRE(22 == edio24_script_num_cmds());
+        REQUIRE(NULL == edio24_script_cmd(edio24_script_num_cmds()));
+        REQUIRE(0 == edio24_script_init());
+        // no collision, each keyword is found at the first slot
+        REQUIRE(0 == edio24_script_build_slots(edio24_script_cmds, NUM_ARRAY(edio24_script_cmds), slots));
+        // the collisions are resolved, and a duplicated keyword is rejected
+        dups[0] = edio24_script_cmds[0];
+        dups[1] = edio24_script_cmds[1];
+        dups[1].keyword = "DXn";
+        dups[1].len = 3;
+        REQUIRE(edio24_script_hash(dups[0].keyword, dups[0].len) == edio24_script_hash(dups[1].keyword, dups[1].len));
+        REQUIRE(1 == edio24_script_build_slots(dups, 2, slots));
+        REQUIRE(1 == slots[edio24_script_probe(dups, slots, "DXn", 3)]);
+        REQUIRE(0 > slots[edio24_script_probe(dups, slots, "DYn", 3)]);
+        dups[2] = edio24_script_cmds[0];
+        REQUIRE(0 > edio24_script_build_slots(dups, 3, slots));
+        for (i = 0; i < edio24_script_num_cmds(); i ++) {
+            pcmd = edio24_script_cmd(i);
+            REQUIRE(strlen(pcmd->keyword) == pcmd->len);
+            REQUIRE(pcmd == edio24_script_lookup(pcmd->keyword, pcmd->len));
+            REQUIRE(NULL == edio24_script_lookup(pcmd->keyword, pcmd->len - 1));
+        }
+        /* all of the commands of the device */
+        for (j = 0; j < 256; j ++) {
+            if (0 == strcmp("UNKNOWN_CMD", edio24_val2cstr_cmd(j))) {
+                continue;
+            }
+            for (i = 0; i < edio24_script_num_cmds(); i ++) {
+                pcmd = edio24_script_cmd(i);
+                if ((EDIO24_SCRIPT_PKT == pcmd->kind) && (j == pcmd->cmd)) {
+                    break;
+                }
+            }
+            REQUIRE(i < edio24_script_num_cmds());
+        }
+        REQUIRE(NULL == edio24_script_lookup("DOutX", 5));
+        REQUIRE(NULL == edio24_script_lookup("dout", 4));
+        REQUIRE(NULL == edio24_script_lookup(NULL, 4));
+        REQUIRE(NULL == edio24_script_lookup("D", 0));
+    }
+    SECTION("test the examples in the table") {
+        REQUIRE(0 == edio24_cmdstream_init(&cs));
+        for (i = 0; i < edio24_script_num_cmds(); i ++) {
+            pcmd = edio24_script_cmd(i);
+            REQUIRE(1 == edio24_script_compile_line(&cs, pcmd->example, strlen(pcmd->example), &err));
+        }
+        REQUIRE(0 == edio24_script_compile_line(&cs, "", 0, &err));
+        REQUIRE(0 == edio24_script_compile_line(&cs, " \t\r\n", 4, &err));
+        REQUIRE(0 == edio24_script_compile_line(&cs, "# Status", 8, &err));
+        REQUIRE(1 == edio24_script_compile_line(&cs, "  DOutW ff 31 # comment\n", 24, &err));
+
+        /* compare to the packets created directly */
+        frame = frame2 = 0;
+        i = EDIO24_CMDSTREAM_HDR_SIZE;
+        ret = edio24_cmdstream_next(cs.buf, cs.sz, i, &rec);
+        REQUIRE(EDIO24_CMDSTREAM_OP_PKT == rec.op);
+        REQUIRE(rec.sz_pkt == edio24_cmdstream_emit(&rec, pkt, sizeof(pkt), &frame));
+        REQUIRE(rec.sz_pkt == edio24_pkt_create_cmd_dinr(pkt2, sizeof(pkt2), &frame2));
+        REQUIRE(0 == memcmp(pkt, pkt2, rec.sz_pkt));
+        for (j = 1; j < 8; j ++) {
+            i += ret;
+            ret = edio24_cmdstream_next(cs.buf, cs.sz, i, &rec);
+            REQUIRE(0 < edio24_cmdstream_emit(&rec, pkt, sizeof(pkt), &frame));
+        }
+        /* Reset */
+        i += ret;
+        ret = edio24_cmdstream_next(cs.buf, cs.sz, i, &rec);
+        REQUIRE(EDIO24_CMD_RESET == rec.pkt[1]);
+        for (j = 9; j < 15; j ++) {
+            i += ret;
+            ret = edio24_cmdstream_next(cs.buf, cs.sz, i, &rec);
+        }
+        /* UserMemoryW 0x123 0x4987249dd9876af987695d07 */
+        i += ret;
+        ret = edio24_cmdstream_next(cs.buf, cs.sz, i, &rec);
+        frame = frame2 = 3;
+        REQUIRE(0 < edio24_cmdstream_emit(&rec, pkt, sizeof(pkt), &frame));
+        {
+            uint8_t data[] = {0x49, 0x87, 0x24, 0x9d, 0xd9, 0x87, 0x6a, 0xf9, 0x87, 0x69, 0x5d, 0x07};
+            REQUIRE(rec.sz_pkt == edio24_pkt_create_cmd_usermemw(pkt2, sizeof(pkt2), &frame2, 0x123, sizeof(data), data));
+            REQUIRE(0 == memcmp(pkt, pkt2, rec.sz_pkt));
+        }
+        for (j = 16; j < 21; j ++) {
+            i += ret;
+            ret = edio24_cmdstream_next(cs.buf, cs.sz, i, &rec);
+        }
+        REQUIRE(EDIO24_CMDSTREAM_OP_SLEEP == rec.op);
+        REQUIRE(10000 == rec.sleep);
+        i += ret;
+        ret = edio24_cmdstream_next(cs.buf, cs.sz, i, &rec);
+        REQUIRE(EDIO24_CMDSTREAM_OP_BARRIER == rec.op);
+        i += ret;
+        ret = edio24_cmdstream_next(cs.buf, cs.sz, i, &rec);
+        REQUIRE(EDIO24_CMD_DOUT_W == rec.pkt[1]);
+        REQUIRE(0xFF == rec.pkt[EDIO24_PKT_OFFSET_DATA]);
+        REQUIRE(0x31 == rec.pkt[EDIO24_PKT_OFFSET_DATA + 3]);
+        i += ret;
+        REQUIRE(0 == edio24_cmdstream_next(cs.buf, cs.sz, i, &rec));
+        edio24_cmdstream_clean(&cs);
+    }
+    SECTION("test the errors and the columns") {
+        static const struct {
+            const char * line;
+            size_t column;
+        } errs[] = {
+            { "DOutX 0xFF 0x31", 1 },
+            { "  dout", 3 },
+            { "DOutW 0xFF", 11 },
+            { "DOutW 0xFF # 0x31", 12 },
+            { "DOutW 0xFG 0x31", 10 },
+            { "DOutW 0xFF 0x1000000", 12 },
+            { "DOutW 0x 0x31", 9 },
+            { "Status 1", 8 },
+            { "Sleep 0x10", 8 },
+            { "Sleep -1", 7 },
+            { "BlinkLED 0x100", 10 },
+            { "ConfigMemoryR 0x1 0x401", 19 },
+            { "ConfigMemoryW 0x1 0x12345", 25 },
+            { "ConfigMemoryW 0x1 12", 19 },
+            { "ConfigMemoryW 0x1 0x12z4", 23 },
+            { "UserMemoryW 0x10000 0x12", 13 },
+        };
+        REQUIRE(0 == edio24_cmdstream_init(&cs));
+        for (i = 0; i < NUM_ARRAY(errs); i ++) {
+            memset(&err, 0, sizeof(err));
+            CIUT_LOG("line '%s'", errs[i].line);
+            REQUIRE(0 > edio24_script_compile_line(&cs, errs[i].line, strlen(errs[i].line), &err));
+            CIUT_LOG("column %" PRIuSZ ": %s (%s)", err.column, err.msg, (NULL == err.arg ? "-" : err.arg));
+            REQUIRE(errs[i].column == err.column);
+            REQUIRE(NULL != err.msg);
+        }
+        REQUIRE(EDIO24_CMDSTREAM_HDR_SIZE == cs.sz);
+        REQUIRE(0 > edio24_script_compile_line(&cs, "DConfigW 0xFF", 13, &err));
+        REQUIRE(0 == strcmp("value", err.arg));
+        REQUIRE(0 > edio24_script_compile_line(&cs, "DConfig", 7, &err));
+        REQUIRE(NULL == err.arg);
+        REQUIRE(0 > edio24_script_compile_line(&cs, "DIn 1", 5, NULL));
+        REQUIRE(0 > edio24_script_compile_line(NULL, "DIn", 3, &err));
+        edio24_cmdstream_clean(&cs);
+    }
+    SECTION("test the speed of parsing") {
+        struct timespec ts0;
+        struct timespec ts1;
+        size_t num = 0;
+        uint64_t us;
+        REQUIRE(0 == edio24_cmdstream_init(&cs));
+        clock_gettime(CLOCK_MONOTONIC, &ts0);
+        for (j = 0; j < 2000; j ++) {
+            for (i = 0; i < edio24_script_num_cmds(); i ++) {
+                pcmd = edio24_script_cmd(i);
+                if (1 == edio24_script_compile_line(&cs, pcmd->example, strlen(pcmd->example), NULL)) {
+                    num ++;
+                }
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &ts1);
+        us = (ts1.tv_sec - ts0.tv_sec) * 1000000 + (ts1.tv_nsec - ts0.tv_nsec) / 1000;
+        REQUIRE(2000 * edio24_script_num_cmds() == num);
+        CIUT_LOG("parsed %" PRIuSZ " lines in %" PRIu64 " microseconds, %" PRIuSZ " bytes", num, us, cs.sz);
+        edio24_cmdstream_clean(&cs);
+    }
+}
+
+#endif /* CIUT_ENABLED */
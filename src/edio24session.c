@@ -0,0 +1,2152 @@
+/**
+ * \file    edio24session.c
+ * \brief   The client session and the transports of E-DIO24 commands
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ *
+ * A session sends the packets created by edio24_pkt_create_cmd_xxx() to a transport,
+ * and matches the responses to the requests by the frame id and the command.
+ * The transport can be a TCP connection driven by the user's loop, or a loopback
+ * which connects the session to a simulated device in the same process without syscalls.
+ */
+
+#include <stdio.h>
+#include <string.h> // memmove()
+#include <assert.h>
+
+#include "edio24session.h"
+
+#define EDIO24_PKT_LENGTH_MAX (EDIO24_PKT_LENGTH_MIN + 1024) /**< the count of data is not larger than 1024 */
+#ifndef EDIO24_PKT_OFFSET_FRAME
+#define EDIO24_PKT_OFFSET_FRAME 2 /**< the offset of the frame id in a edio24 packet */
+#endif
+
+/**
+ * \brief set the receiver of a transport
+ * \param ptr: the transport
+ * \param cb: the callback function
+ * \param userdata: the pointer passed to the callback
+ */
+void
+edio24_transport_set_receiver (edio24_transport_t * ptr, edio24_transport_recv_cb_t cb, void * userdata)
+{
+    assert (NULL != ptr);
+    ptr->cb_recv = cb;
+    ptr->userdata_recv = userdata;
+}
+
+/**
+ * \brief send data by a transport
+ * \param ptr: the transport
+ * \param buf: the data
+ * \param sz: the byte size of the data
+ * \return the bytes queued, <0 on error
+ */
+ssize_t
+edio24_transport_send (edio24_transport_t * ptr, const uint8_t * buf, size_t sz)
+{
+    if ((NULL == ptr) || (NULL == ptr->send)) {
+        return -1;
+    }
+    return ptr->send(ptr, buf, sz);
+}
+
+/**
+ * \brief append data to a receive buffer
+ * \param prxbuf: the pointer to the buffer
+ * \param psz_rxmax: the pointer to the size of the buffer
+ * \param psz_rx: the pointer to the byte size of data in the buffer
+ * \param buf: the data
+ * \param sz: the byte size of the data
+ * \return 0 on success, <0 on error
+ */
+int
+edio24_rxbuf_append (uint8_t ** prxbuf, size_t * psz_rxmax, size_t * psz_rx, const uint8_t * buf, size_t sz)
+{
+    if (*psz_rx + sz > *psz_rxmax) {
+        size_t sz_new = (*psz_rxmax < 64 ? 64 : *psz_rxmax);
+        uint8_t * p;
+        while (sz_new < *psz_rx + sz) {
+            sz_new *= 2;
+        }
+        p = (uint8_t *)realloc(*prxbuf, sz_new);
+        if (NULL == p) {
+            fprintf(stderr, "edio24 error: out of memory for receive buffer\n");
+            return -1;
+        }
+        *prxbuf = p;
+        *psz_rxmax = sz_new;
+    }
+    memmove (*prxbuf + *psz_rx, buf, sz);
+    *psz_rx += sz;
+    return 0;
+}
+
+/**
+ * \brief remove the data from the head of a receive buffer
+ * \param rxbuf: the buffer
+ * \param psz_rx: the pointer to the byte size of data in the buffer
+ * \param sz: the byte size to be removed
+ */
+void
+edio24_rxbuf_consume (uint8_t * rxbuf, size_t * psz_rx, size_t sz)
+{
+    assert (sz <= *psz_rx);
+    if (sz < *psz_rx) {
+        memmove (rxbuf, rxbuf + sz, *psz_rx - sz);
+    }
+    *psz_rx -= sz;
+}
+
+/*****************************************************************************/
+/**
+ * \brief initialize a ring buffer
+ * \param pr: the ring buffer
+ * \param sz_max: the initial size, rounded up to power of 2
+ * \return 0 on success, <0 on error
+ */
+int
+edio24_ring_init (edio24_ring_t * pr, size_t sz_max)
+{
+    size_t sz = 64;
+    if (NULL == pr) {
+        return -1;
+    }
+    while (sz < sz_max) {
+        sz *= 2;
+    }
+    memset(pr, 0, sizeof(*pr));
+    pr->buf = (uint8_t *)malloc(sz);
+    if (NULL == pr->buf) {
+        return -1;
+    }
+    pr->sz_max = sz;
+    return 0;
+}
+
+void
+edio24_ring_clean (edio24_ring_t * pr)
+{
+    if (NULL == pr) {
+        return;
+    }
+    free(pr->buf);
+    memset(pr, 0, sizeof(*pr));
+}
+
+/**
+ * \brief write data to a ring buffer
+ * \param pr: the ring buffer
+ * \param buf: the data
+ * \param sz: the byte size of the data
+ * \return the bytes written, <0 on error
+ */
+ssize_t
+edio24_ring_write (edio24_ring_t * pr, const uint8_t * buf, size_t sz)
+{
+    size_t used;
+    size_t off;
+    size_t sz1;
+
+    if ((NULL == pr) || ((NULL == buf) && (sz > 0))) {
+        return -1;
+    }
+    used = edio24_ring_used(pr);
+    if (used + sz > pr->sz_max) {
+        // grow, and move the data to the start of the new buffer
+        size_t sz_new = pr->sz_max * 2;
+        uint8_t * p;
+        while (sz_new < used + sz) {
+            sz_new *= 2;
+        }
+        p = (uint8_t *)malloc(sz_new);
+        if (NULL == p) {
+            fprintf(stderr, "edio24 error: out of memory for ring buffer\n");
+            return -1;
+        }
+        off = pr->head & (pr->sz_max - 1);
+        sz1 = pr->sz_max - off;
+        if (sz1 > used) {
+            sz1 = used;
+        }
+        memmove (p, pr->buf + off, sz1);
+        memmove (p + sz1, pr->buf, used - sz1);
+        free(pr->buf);
+        pr->buf = p;
+        pr->sz_max = sz_new;
+        pr->head = 0;
+        pr->tail = used;
+    }
+    off = pr->tail & (pr->sz_max - 1);
+    sz1 = pr->sz_max - off;
+    if (sz1 > sz) {
+        sz1 = sz;
+    }
+    memmove (pr->buf + off, buf, sz1);
+    memmove (pr->buf, buf + sz1, sz - sz1);
+    pr->tail += sz;
+    return sz;
+}
+
+/**
+ * \brief get the continuous data at the head of a ring buffer
+ * \param pr: the ring buffer
+ * \param pbuf: return the pointer to the data
+ * \return the byte size of the continuous data
+ */
+size_t
+edio24_ring_peek (edio24_ring_t * pr, uint8_t ** pbuf)
+{
+    size_t used;
+    size_t off;
+    assert (NULL != pr);
+    used = edio24_ring_used(pr);
+    off = pr->head & (pr->sz_max - 1);
+    if (off + used > pr->sz_max) {
+        used = pr->sz_max - off;
+    }
+    if (NULL != pbuf) {
+        *pbuf = pr->buf + off;
+    }
+    return used;
+}
+
+void
+edio24_ring_consume (edio24_ring_t * pr, size_t sz)
+{
+    assert (NULL != pr);
+    assert (sz <= edio24_ring_used(pr));
+    pr->head += sz;
+    if (pr->head == pr->tail) {
+        pr->head = pr->tail = 0;
+    }
+}
+
+/*****************************************************************************/
+static ssize_t
+edio24_loopback_send (edio24_transport_t * ptr, const uint8_t * buf, size_t sz)
+{
+    edio24_loopback_t * plb = (edio24_loopback_t *)(ptr->data);
+    ssize_t ret;
+    char flg_empty;
+
+    assert (NULL != plb);
+    assert ((ptr == &(plb->end[0])) || (ptr == &(plb->end[1])));
+    flg_empty = (0 == edio24_ring_used(&(plb->ring[0])) + edio24_ring_used(&(plb->ring[1])));
+    ret = edio24_ring_write(&(plb->ring[ptr - plb->end]), buf, sz);
+    if ((ret > 0) && flg_empty && (NULL != plb->cb_notify)) {
+        plb->cb_notify(plb, plb->userdata_notify);
+    }
+    return ret;
+}
+
+/**
+ * \brief initialize a loopback
+ * \param plb: the loopback
+ * \param sz_ring: the initial size of each ring buffer
+ * \return 0 on success, <0 on error
+ */
+int
+edio24_loopback_init (edio24_loopback_t * plb, size_t sz_ring)
+{
+    int i;
+    if (NULL == plb) {
+        return -1;
+    }
+    memset(plb, 0, sizeof(*plb));
+    for (i = 0; i < 2; i ++) {
+        if (edio24_ring_init(&(plb->ring[i]), sz_ring) < 0) {
+            edio24_loopback_clean(plb);
+            return -1;
+        }
+        plb->end[i].send = edio24_loopback_send;
+        plb->end[i].data = plb;
+    }
+    return 0;
+}
+
+void
+edio24_loopback_clean (edio24_loopback_t * plb)
+{
+    if (NULL == plb) {
+        return;
+    }
+    edio24_ring_clean(&(plb->ring[0]));
+    edio24_ring_clean(&(plb->ring[1]));
+}
+
+/**
+ * \brief set the callback function called when the data is queued to the empty loopback
+ * \param plb: the loopback
+ * \param cb: the callback function, NULL to disable
+ * \param userdata: the pointer passed to the callback
+ */
+void
+edio24_loopback_set_notify (edio24_loopback_t * plb, edio24_loopback_notify_cb_t cb, void * userdata)
+{
+    assert (NULL != plb);
+    plb->cb_notify = cb;
+    plb->userdata_notify = userdata;
+}
+
+/**
+ * \brief deliver the data in the ring buffers to the receivers, until both of them are empty
+ * \param plb: the loopback
+ * \return the bytes delivered
+ *
+ * The receivers may send more data in the callbacks, they are delivered in the same call.
+ */
+size_t
+edio24_loopback_pump (edio24_loopback_t * plb)
+{
+    size_t total = 0;
+    size_t sz;
+    uint8_t * buf;
+    int i;
+    char flg_more = 1;
+
+    assert (NULL != plb);
+    while (flg_more) {
+        flg_more = 0;
+        for (i = 0; i < 2; i ++) {
+            edio24_transport_t * pto = &(plb->end[1 - i]);
+            sz = edio24_ring_peek(&(plb->ring[i]), &buf);
+            if (sz < 1) {
+                continue;
+            }
+            flg_more = 1;
+            if (NULL != pto->cb_recv) {
+                // the receiver copies the data, and it can only write to the other ring
+                pto->cb_recv(pto->userdata_recv, buf, sz);
+            }
+            edio24_ring_consume(&(plb->ring[i]), sz);
+            plb->bytes[i] += sz;
+            total += sz;
+        }
+    }
+    return total;
+}
+
+/*****************************************************************************/
+static void
+edio24_session_on_recv (void * userdata, uint8_t * buf, size_t sz)
+{
+    edio24_session_recv((edio24_session_t *)userdata, buf, sz);
+}
+
+/*****************************************************************************/
+/** the read commands, the index is the bit of edio24_session_t.mask_read */
+#define EDIO24_SESSION_READ_DIN_R        0
+#define EDIO24_SESSION_READ_DOUT_R       1
+#define EDIO24_SESSION_READ_DCONF_R      2
+#define EDIO24_SESSION_READ_COUNTER_R    3
+#define EDIO24_SESSION_READ_CONF_MEM_R   4
+#define EDIO24_SESSION_READ_USR_MEM_R    5
+#define EDIO24_SESSION_READ_SET_MEM_R    6
+#define EDIO24_SESSION_READ_BOOT_MEM_R   7
+#define EDIO24_SESSION_READ_STATUS       8
+#define EDIO24_SESSION_READ_NETWORK_CONF 9
+#define EDIO24_SESSION_READ_BIT(cmd) (1 << EDIO24_SESSION_READ_##cmd)
+
+static const uint8_t edio24_session_read_cmds[EDIO24_SESSION_NUM_READS] = {
+    EDIO24_CMD_DIN_R,
+    EDIO24_CMD_DOUT_R,
+    EDIO24_CMD_DCONF_R,
+    EDIO24_CMD_COUNTER_R,
+    EDIO24_CMD_CONF_MEM_R,
+    EDIO24_CMD_USR_MEM_R,
+    EDIO24_CMD_SET_MEM_R,
+    EDIO24_CMD_BOOT_MEM_R,
+    EDIO24_CMD_STATUS,
+    EDIO24_CMD_NETWORK_CONF,
+};
+
+/**
+ * \brief get the reads whose results may be changed by a request
+ * \param cmd: the command which is not a read
+ * \return the bits of the indexes in edio24_session_read_cmds
+ */
+static uint32_t
+edio24_session_read_changed (uint8_t cmd)
+{
+    switch (cmd) {
+    case EDIO24_CMD_DOUT_W:
+        return EDIO24_SESSION_READ_BIT(DIN_R) | EDIO24_SESSION_READ_BIT(DOUT_R);
+    case EDIO24_CMD_DCONF_W:
+        return EDIO24_SESSION_READ_BIT(DIN_R) | EDIO24_SESSION_READ_BIT(DOUT_R) | EDIO24_SESSION_READ_BIT(DCONF_R);
+    case EDIO24_CMD_COUNTER_W:
+        return EDIO24_SESSION_READ_BIT(COUNTER_R);
+    case EDIO24_CMD_CONF_MEM_W:
+        return EDIO24_SESSION_READ_BIT(CONF_MEM_R);
+    case EDIO24_CMD_USR_MEM_W:
+        return EDIO24_SESSION_READ_BIT(USR_MEM_R);
+    case EDIO24_CMD_SET_MEM_W:
+        // the network settings are in the settings memory
+        return EDIO24_SESSION_READ_BIT(SET_MEM_R) | EDIO24_SESSION_READ_BIT(NETWORK_CONF);
+    case EDIO24_CMD_BOOT_MEM_W:
+        return EDIO24_SESSION_READ_BIT(BOOT_MEM_R);
+    case EDIO24_CMD_BLINKLED:
+        return 0;
+    }
+    // reset, firmware upgrade, and the unknown ones
+    return (1 << EDIO24_SESSION_NUM_READS) - 1;
+}
+
+/**
+ * \brief get the index of a read command
+ * \return the index in edio24_session_read_cmds, <0 if the command is not a read
+ */
+static int
+edio24_session_read_idx (uint8_t cmd)
+{
+    int i;
+    for (i = 0; i < EDIO24_SESSION_NUM_READS; i ++) {
+        if (edio24_session_read_cmds[i] == cmd) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * \brief fill the response of a packet verified
+ */
+static void
+edio24_session_parse (uint8_t * pkt, size_t sz, edio24_response_t * presp)
+{
+    presp->pkt = pkt;
+    presp->sz_pkt = sz;
+    presp->count = sz - EDIO24_PKT_LENGTH_MIN;
+    presp->data = pkt + EDIO24_PKT_OFFSET_DATA;
+    edio24_pkt_read_hdr_command(pkt, sz, &(presp->cmd));
+    presp->cmd &= ~EDIO24_PKT_REPLY;
+    edio24_pkt_read_hdr_frameid(pkt, sz, &(presp->frame));
+    edio24_pkt_read_hdr_status(pkt, sz, &(presp->status));
+}
+
+/**
+ * \brief copy a response to the request of another frame id
+ * \param src: the response
+ * \param pkt: the buffer of the copy
+ * \param frame: the frame id of the request
+ * \param presp: return the response of the copy
+ */
+static void
+edio24_session_copy_resp (const uint8_t * src, size_t sz, uint8_t * pkt, uint8_t frame, edio24_response_t * presp)
+{
+    memmove(pkt, src, sz);
+    // the checksum is 0xFF minus the sum of the bytes
+    pkt[sz - 1] += pkt[EDIO24_PKT_OFFSET_FRAME] - frame;
+    pkt[EDIO24_PKT_OFFSET_FRAME] = frame;
+    edio24_session_parse(pkt, sz, presp);
+}
+
+static void
+edio24_session_read_free (edio24_read_t * pr)
+{
+    free(pr->pkt);
+    free(pr->waiters);
+}
+
+/**
+ * \brief remove the responses cached which are expired or older than the last request other than the reads
+ */
+static void
+edio24_session_read_expire (edio24_session_t * pss, uint64_t now)
+{
+    edio24_read_t * pr;
+    size_t i = 0;
+    int idx;
+    while (i < pss->num_reads) {
+        pr = &(pss->reads[i]);
+        idx = edio24_session_read_idx(pr->cmd);
+        if ((! pr->flg_inflight) && ((pr->gen != pss->gen[idx]) || (now - pr->time >= pss->ttl[idx]))) {
+            edio24_session_read_free(pr);
+            pss->reads[i] = pss->reads[-- pss->num_reads];
+            continue;
+        }
+        i ++;
+    }
+}
+
+/**
+ * \brief return a read from the identical read in flight, or from the response cached
+ * \return 0 if the read is returned or waiting, 1 if the read should be sent, <0 on error
+ */
+static int
+edio24_session_read_join (edio24_session_t * pss, int idx, uint8_t frame, uint16_t count, const uint8_t * data, edio24_session_cb_t cb, void * userdata)
+{
+    uint8_t cmd = edio24_session_read_cmds[idx];
+    uint8_t pkt[EDIO24_PKT_LENGTH_MAX];
+    edio24_response_t resp;
+    edio24_read_t * pr;
+    size_t i;
+
+    edio24_session_read_expire(pss, (NULL == pss->pclk ? 0 : edio24_clock_now(pss->pclk)));
+    for (i = 0; i < pss->num_reads; i ++) {
+        pr = &(pss->reads[i]);
+        if ((pr->cmd != cmd) || (pr->gen != pss->gen[idx]) || (pr->count != count) || (0 != memcmp(pr->data, data, count))) {
+            continue;
+        }
+        if (! pr->flg_inflight) {
+            pss->stats.num_cached ++;
+            edio24_session_copy_resp(pr->pkt, pr->sz_pkt, pkt, frame, &resp);
+            if (NULL != cb) {
+                cb(pss, &resp, userdata);
+            }
+            return 0;
+        }
+        if (pr->num_waiters >= pr->sz_waiters) {
+            size_t sz_new = (pr->sz_waiters < 4 ? 4 : pr->sz_waiters * 2);
+            edio24_waiter_t * p = (edio24_waiter_t *)realloc(pr->waiters, sz_new * sizeof(*p));
+            if (NULL == p) {
+                return -1;
+            }
+            pr->waiters = p;
+            pr->sz_waiters = sz_new;
+        }
+        pr->waiters[pr->num_waiters].frame = frame;
+        pr->waiters[pr->num_waiters].cb = cb;
+        pr->waiters[pr->num_waiters].userdata = userdata;
+        pr->num_waiters ++;
+        pss->stats.num_coalesce ++;
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * \brief record a read sent, the identical reads wait for it
+ */
+static void
+edio24_session_read_add (edio24_session_t * pss, int idx, uint8_t frame, uint16_t count, const uint8_t * data)
+{
+    edio24_read_t * pr;
+
+    if (pss->num_reads >= pss->sz_reads) {
+        size_t sz_new = (pss->sz_reads < 4 ? 4 : pss->sz_reads * 2);
+        pr = (edio24_read_t *)realloc(pss->reads, sz_new * sizeof(*pr));
+        if (NULL == pr) {
+            return; // the read is not coalesced
+        }
+        pss->reads = pr;
+        pss->sz_reads = sz_new;
+    }
+    pr = &(pss->reads[pss->num_reads ++]);
+    memset(pr, 0, sizeof(*pr));
+    pr->cmd = edio24_session_read_cmds[idx];
+    pr->frame = frame;
+    pr->flg_inflight = 1;
+    pr->count = count;
+    memmove(pr->data, data, count);
+    pr->gen = pss->gen[idx];
+}
+
+/**
+ * \brief finish the read in flight of a response, the response is cached if the TTL of the command is not 0
+ * \param pss: the session
+ * \param presp: the response
+ * \param pnum_waiters: return the number of the waiters
+ * \return the waiters of the read, the caller frees it; NULL if no waiter
+ */
+static edio24_waiter_t *
+edio24_session_read_done (edio24_session_t * pss, const edio24_response_t * presp, size_t * pnum_waiters)
+{
+    edio24_waiter_t * waiters;
+    edio24_read_t * pr;
+    uint64_t ttl;
+    uint8_t * p;
+    size_t i;
+
+    *pnum_waiters = 0;
+    for (i = 0; i < pss->num_reads; i ++) {
+        pr = &(pss->reads[i]);
+        if (pr->flg_inflight && (pr->cmd == presp->cmd) && (pr->frame == presp->frame)) {
+            break;
+        }
+    }
+    if (i >= pss->num_reads) {
+        return NULL;
+    }
+    waiters = pr->waiters;
+    *pnum_waiters = pr->num_waiters;
+    pr->waiters = NULL;
+    pr->num_waiters = pr->sz_waiters = 0;
+
+    ttl = pss->ttl[edio24_session_read_idx(pr->cmd)];
+    p = NULL;
+    if ((ttl > 0) && (NULL != pss->pclk) && (EDIO24_STATUS_SUCCESS == presp->status)) {
+        p = (uint8_t *)malloc(presp->sz_pkt);
+    }
+    if (NULL == p) {
+        edio24_session_read_free(pr);
+        pss->reads[i] = pss->reads[-- pss->num_reads];
+        return waiters;
+    }
+    memmove(p, presp->pkt, presp->sz_pkt);
+    pr->pkt = p;
+    pr->sz_pkt = presp->sz_pkt;
+    pr->time = edio24_clock_now(pss->pclk);
+    pr->flg_inflight = 0;
+    return waiters;
+}
+
+/**
+ * \brief coalesce the identical reads of a command, and cache the response
+ * \param pss: the session
+ * \param pclk: the clock of the cache, can be NULL if ttl is 0
+ * \param cmd: the read command, EDIO24_CMD_xxx
+ * \param ttl: the microseconds the response returns the later reads, 0 -- only for the reads in flight
+ * \return 0 on success, <0 on error or the command is not a read
+ *
+ * A read identical to the one in flight is not sent, it gets the response of the one in flight.
+ * A write stops the reads it may change which are sent before it from being reused, so the result
+ * of a write is always read back. The callback of a read returned by the cache is called
+ * in edio24_session_send().
+ */
+int
+edio24_session_set_cache (edio24_session_t * pss, edio24_clock_t * pclk, uint8_t cmd, uint64_t ttl)
+{
+    int idx;
+
+    idx = edio24_session_read_idx(cmd);
+    if ((NULL == pss) || (idx < 0) || ((ttl > 0) && (NULL == pclk))) {
+        return -1;
+    }
+    if (NULL != pclk) {
+        pss->pclk = pclk;
+    }
+    pss->mask_read |= (1 << idx);
+    pss->ttl[idx] = ttl;
+    return 0;
+}
+
+/**
+ * \brief adapt the max number of requests in flight to the device
+ * \param pss: the session
+ * \param pclk: the clock to measure the RTT
+ * \param win_min: the min size of the window, >0
+ * \param win_max: the max size of the window, not less than win_min
+ * \return 0 on success, <0 on error
+ *
+ * The session doesn't hold the requests, the sender checks edio24_session_window() before it sends.
+ * The window starts from win_min, grows by one for each response until the first backoff, then
+ * by one for each window of responses. It is halved, no more than once for the requests in flight,
+ * if the device returns busy, not ready or timeout, or if the RTT is inflated by the queue of the device,
+ * that is larger than twice the min RTT plus EDIO24_SESSION_RTT_SLACK.
+ */
+int
+edio24_session_set_window (edio24_session_t * pss, edio24_clock_t * pclk, size_t win_min, size_t win_max)
+{
+    if ((NULL == pss) || (NULL == pclk) || (win_min < 1) || (win_max < win_min)) {
+        return -1;
+    }
+    pss->pclk = pclk;
+    pss->win_min = win_min;
+    pss->win_max = win_max;
+    pss->ssthresh = win_max;
+    pss->num_acked = 0;
+    pss->seq_backoff = pss->stats.num_request;
+    pss->num_rtt = 0;
+    pss->stats.window = win_min;
+    return 0;
+}
+
+/**
+ * \brief update the adaptive window by the response of a request
+ * \param pss: the session
+ * \param preq: the request
+ * \param status: the status of the response
+ */
+static void
+edio24_session_window_update (edio24_session_t * pss, const edio24_request_t * preq, uint8_t status)
+{
+    edio24_session_stats_t * pst = &(pss->stats);
+    uint64_t now;
+    uint64_t rtt;
+    char flg_busy;
+
+    if (pss->win_min < 1) {
+        return;
+    }
+    now = edio24_clock_now(pss->pclk);
+    rtt = (now > preq->time ? now - preq->time : 0);
+    if (0 == pss->num_rtt ++) {
+        pst->rtt_min = pst->rtt_avg = rtt;
+    } else {
+        if (rtt < pst->rtt_min) {
+            pst->rtt_min = rtt;
+        }
+        pst->rtt_avg = (pst->rtt_avg * 7 + rtt) / 8;
+    }
+
+    flg_busy = ((EDIO24_STATUS_ERROR_BUSY == status) || (EDIO24_STATUS_ERROR_READY == status) || (EDIO24_STATUS_ERROR_TIMEOUT == status));
+    if (flg_busy || (rtt > pst->rtt_min * 2 + EDIO24_SESSION_RTT_SLACK)) {
+        if (preq->seq < pss->seq_backoff) {
+            // sent before the last backoff, it's the same congestion
+            return;
+        }
+        pst->window = (pst->window / 2 < pss->win_min ? pss->win_min : pst->window / 2);
+        pss->ssthresh = pst->window;
+        pss->num_acked = 0;
+        pss->seq_backoff = pst->num_request;
+        if (flg_busy) {
+            pst->num_backoff_busy ++;
+        } else {
+            pst->num_backoff_rtt ++;
+        }
+        return;
+    }
+    if (pst->window >= pss->win_max) {
+        return;
+    }
+    if (pst->window < pss->ssthresh) {
+        pst->window ++;
+        return;
+    }
+    pss->num_acked ++;
+    if (pss->num_acked >= pst->window) {
+        pss->num_acked = 0;
+        pst->window ++;
+    }
+}
+
+/**
+ * \brief check if a request can be sent again without changing the result
+ * \param cmd: the command
+ * \return 1 if the command is a read, a masked write of absolute values, or a write of the memory at a fixed address
+ *
+ * The reset, the firmware upgrade, the reset of the counter, the blink of LED and the write of
+ * the bootloader memory are never sent again.
+ */
+static char
+edio24_session_retryable (uint8_t cmd)
+{
+    if (edio24_session_read_idx(cmd) >= 0) {
+        return 1;
+    }
+    switch (cmd) {
+    case EDIO24_CMD_DOUT_W:
+    case EDIO24_CMD_DCONF_W:
+    case EDIO24_CMD_CONF_MEM_W:
+    case EDIO24_CMD_USR_MEM_W:
+    case EDIO24_CMD_SET_MEM_W:
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * \brief send the failed requests again on the transient errors
+ * \param pss: the session
+ * \param pclk: the clock of the backoff, can be NULL if backoff is 0
+ * \param backoff: the microseconds before the first retry, doubled by each retry, 0 -- no retry
+ * \param budget: the max microseconds from the first send of a request to its last retry
+ * \return 0 on success, <0 on error
+ *
+ * A request which can be repeated safely is sent again with the same frame id if the device returns
+ * busy, timeout or protocol error (the packet is broken on the way). The delay is a random value
+ * between the half and the whole of the backoff. The callback only gets the last response.
+ */
+int
+edio24_session_set_retry (edio24_session_t * pss, edio24_clock_t * pclk, uint64_t backoff, uint64_t budget)
+{
+    if ((NULL == pss) || ((backoff > 0) && (NULL == pclk))) {
+        return -1;
+    }
+    if (NULL != pclk) {
+        pss->pclk = pclk;
+    }
+    pss->retry_backoff = backoff;
+    pss->retry_budget = budget;
+    return 0;
+}
+
+static int edio24_session_push (edio24_session_t * pss, const uint8_t * pkt, size_t sz, const edio24_request_t * preq);
+static void edio24_session_arm (edio24_session_t * pss);
+
+/**
+ * \brief fail the read in flight of a request which is not sent again, the waiters get NULL response
+ * \param pss: the session
+ * \param preq: the request
+ */
+static void
+edio24_session_read_fail (edio24_session_t * pss, const edio24_request_t * preq)
+{
+    edio24_response_t resp;
+    edio24_waiter_t * waiters;
+    size_t num_waiters;
+    size_t i;
+
+    memset(&resp, 0, sizeof(resp));
+    resp.cmd = preq->cmd;
+    resp.frame = preq->frame;
+    resp.status = EDIO24_STATUS_ERROR_OTHER;
+    waiters = edio24_session_read_done(pss, &resp, &num_waiters);
+    for (i = 0; i < num_waiters; i ++) {
+        if (NULL != waiters[i].cb) {
+            waiters[i].cb(pss, NULL, waiters[i].userdata);
+        }
+    }
+    free(waiters);
+}
+
+/**
+ * \brief the backoff of a failed request is over, send it again
+ */
+static void
+edio24_session_on_retry (edio24_timer_t * ptm, void * userdata)
+{
+    edio24_retry_t * prt = (edio24_retry_t *)userdata;
+    edio24_session_t * pss = prt->pss;
+    edio24_retry_t ** pp;
+    edio24_request_t req = prt->req;
+
+    for (pp = &(pss->retries); *pp != prt; pp = &((*pp)->next));
+    *pp = prt->next;
+    pss->num_retrying --;
+    free(prt);
+    if (edio24_session_push(pss, req.pkt, req.sz_pkt, &req) < 0) {
+        free(req.pkt);
+        edio24_session_read_fail(pss, &req);
+        if (NULL != req.cb) {
+            req.cb(pss, NULL, req.userdata);
+        }
+        return;
+    }
+    pss->stats.num_retry ++;
+}
+
+/**
+ * \brief schedule a failed request to be sent again
+ * \param pss: the session
+ * \param preq: the request, with the copy of the packet
+ * \param status: the status of the response
+ * \return 0 if the request is sent again later, <0 if the response is the final one
+ */
+static int
+edio24_session_retry (edio24_session_t * pss, const edio24_request_t * preq, uint8_t status)
+{
+    edio24_retry_t * prt;
+    uint64_t backoff;
+    uint64_t delay;
+
+    if ((EDIO24_STATUS_ERROR_BUSY != status) && (EDIO24_STATUS_ERROR_TIMEOUT != status) && (EDIO24_STATUS_ERROR_PROTOCOL != status)) {
+        return -1;
+    }
+    backoff = pss->retry_backoff << (preq->num_retries < 16 ? preq->num_retries : 16);
+    // the random half keeps the devices failed together from retrying together
+    delay = backoff / 2 + (uint64_t)rand() % (backoff / 2 + 1);
+    if (edio24_clock_now(pss->pclk) + delay > preq->deadline) {
+        pss->stats.num_giveup ++;
+        return -1;
+    }
+    prt = (edio24_retry_t *)malloc(sizeof(*prt));
+    if (NULL == prt) {
+        return -1;
+    }
+    prt->pss = pss;
+    prt->req = *preq;
+    prt->req.num_retries ++;
+    prt->next = pss->retries;
+    pss->retries = prt;
+    pss->num_retrying ++;
+    edio24_timer_init(&(prt->tm));
+    edio24_timer_start(pss->pclk, &(prt->tm), delay, edio24_session_on_retry, prt);
+    return 0;
+}
+
+/**
+ * \brief initialize a client session
+ * \param pss: the session
+ * \param ptr: the transport, the receiver of it is set to the session
+ * \return 0 on success, <0 on error
+ */
+int
+edio24_session_init (edio24_session_t * pss, edio24_transport_t * ptr)
+{
+    if ((NULL == pss) || (NULL == ptr)) {
+        return -1;
+    }
+    memset(pss, 0, sizeof(*pss));
+    pss->ptr = ptr;
+    edio24_timer_init(&(pss->tm_timeout));
+    edio24_transport_set_receiver(ptr, edio24_session_on_recv, pss);
+    return 0;
+}
+
+/**
+ * \brief release the resources of a session
+ * \param pss: the session
+ *
+ * The callbacks of the pending requests, and the reads waiting for them, are called with NULL response.
+ */
+void
+edio24_session_clean (edio24_session_t * pss)
+{
+    edio24_request_t req;
+    edio24_read_t * reads;
+    size_t num_reads;
+    size_t i;
+    size_t j;
+    if (NULL == pss) {
+        return;
+    }
+    reads = pss->reads;
+    num_reads = pss->num_reads;
+    pss->reads = NULL;
+    pss->num_reads = pss->sz_reads = 0;
+    if (edio24_timer_is_active(&(pss->tm_timeout))) {
+        edio24_timer_stop(pss->pclk, &(pss->tm_timeout));
+    }
+    pss->timeout = 0;
+    while (NULL != pss->retries) {
+        edio24_retry_t * prt = pss->retries;
+        pss->retries = prt->next;
+        pss->num_retrying --;
+        edio24_timer_stop(pss->pclk, &(prt->tm));
+        req = prt->req;
+        free(prt);
+        free(req.pkt);
+        if (NULL != req.cb) {
+            req.cb(pss, NULL, req.userdata);
+        }
+    }
+    while (pss->num > 0) {
+        req = pss->pending[pss->head];
+        pss->head = (pss->head + 1) & (pss->sz_max - 1);
+        pss->num --;
+        free(req.pkt);
+        if (NULL != req.cb) {
+            req.cb(pss, NULL, req.userdata);
+        }
+    }
+    for (i = 0; i < num_reads; i ++) {
+        for (j = 0; j < reads[i].num_waiters; j ++) {
+            if (NULL != reads[i].waiters[j].cb) {
+                reads[i].waiters[j].cb(pss, NULL, reads[i].waiters[j].userdata);
+            }
+        }
+        edio24_session_read_free(&(reads[i]));
+    }
+    free(reads);
+    for (i = 0; i < pss->num_reads; i ++) {
+        edio24_session_read_free(&(pss->reads[i]));
+    }
+    free(pss->reads);
+    pss->reads = NULL;
+    pss->num_reads = pss->sz_reads = 0;
+    if ((NULL != pss->ptr) && (pss->ptr->userdata_recv == pss)) {
+        edio24_transport_set_receiver(pss->ptr, NULL, NULL);
+    }
+    free(pss->pending);
+    free(pss->rxbuf);
+    pss->pending = NULL;
+    pss->rxbuf = NULL;
+    pss->sz_max = pss->sz_rxmax = 0;
+    pss->sz_rx = 0;
+}
+
+/**
+ * \brief set the callback function for the responses not matched to any request
+ * \param pss: the session
+ * \param cb: the callback function
+ * \param userdata: the pointer passed to the callback
+ */
+void
+edio24_session_set_default (edio24_session_t * pss, edio24_session_cb_t cb, void * userdata)
+{
+    assert (NULL != pss);
+    pss->cb_default = cb;
+    pss->userdata_default = userdata;
+}
+
+/**
+ * \brief send a packet, and append its request to the queue
+ * \param pss: the session
+ * \param pkt: the packet
+ * \param sz: the byte size of the packet
+ * \param preq: the request of the packet
+ * \return 0 on success, <0 on error
+ */
+static int
+edio24_session_push (edio24_session_t * pss, const uint8_t * pkt, size_t sz, const edio24_request_t * preq)
+{
+    edio24_request_t * p;
+
+    if (pss->num >= pss->sz_max) {
+        // grow the queue, keep the requests in order
+        size_t sz_new = (pss->sz_max < 8 ? 8 : pss->sz_max * 2);
+        size_t i;
+        p = (edio24_request_t *)malloc(sz_new * sizeof(edio24_request_t));
+        if (NULL == p) {
+            fprintf(stderr, "edio24 error: out of memory for requests\n");
+            return -1;
+        }
+        for (i = 0; i < pss->num; i ++) {
+            p[i] = pss->pending[(pss->head + i) & (pss->sz_max - 1)];
+        }
+        free(pss->pending);
+        pss->pending = p;
+        pss->sz_max = sz_new;
+        pss->head = 0;
+    }
+    if (edio24_transport_send(pss->ptr, pkt, sz) < 0) {
+        return -1;
+    }
+    p = &(pss->pending[(pss->head + pss->num) & (pss->sz_max - 1)]);
+    *p = *preq;
+    p->seq = pss->stats.num_request;
+    p->time = (NULL != pss->pclk ? edio24_clock_now(pss->pclk) : 0);
+    pss->num ++;
+    pss->stats.bytes_out += sz;
+    if (1 == pss->num) {
+        edio24_session_arm(pss);
+    }
+    return 0;
+}
+
+/**
+ * \brief send a request
+ * \param pss: the session
+ * \param pkt: the packet created by edio24_pkt_create_cmd_xxx(..., &(pss->frame), ...)
+ * \param sz: the byte size of the packet
+ * \param cb: the callback function for the response, can be NULL
+ * \param userdata: the pointer passed to the callback
+ * \return 0 on success, <0 on error
+ *
+ * The reads set by edio24_session_set_cache() may be returned without sending.
+ * The requests which can be repeated safely are sent again on the transient errors, see edio24_session_set_retry().
+ */
+int
+edio24_session_send (edio24_session_t * pss, const uint8_t * pkt, size_t sz, edio24_session_cb_t cb, void * userdata)
+{
+    edio24_request_t req;
+    uint8_t cmd = 0;
+    uint8_t frame = 0;
+    uint16_t count = 0;
+    char flg_read = 0;
+    ssize_t ret;
+    int idx;
+
+    if ((NULL == pss) || (NULL == pkt) || (sz < EDIO24_PKT_LENGTH_MIN)) {
+        return -1;
+    }
+    edio24_pkt_read_hdr_command((uint8_t *)pkt, sz, &cmd);
+    edio24_pkt_read_hdr_frameid((uint8_t *)pkt, sz, &frame);
+    edio24_pkt_read_hdr_count((uint8_t *)pkt, sz, &count);
+    idx = edio24_session_read_idx(cmd);
+    if ((idx >= 0) && (pss->mask_read & (1 << idx)) && (count <= EDIO24_SESSION_READ_DATA_MAX) && (EDIO24_PKT_LENGTH_MIN + count <= sz)) {
+        ret = edio24_session_read_join(pss, idx, frame, count, pkt + EDIO24_PKT_OFFSET_DATA, cb, userdata);
+        if (ret <= 0) {
+            return ret;
+        }
+        flg_read = 1;
+    }
+    memset(&req, 0, sizeof(req));
+    req.cmd = cmd;
+    req.frame = frame;
+    req.cb = cb;
+    req.userdata = userdata;
+    if ((pss->retry_backoff > 0) && edio24_session_retryable(cmd)) {
+        req.pkt = (uint8_t *)malloc(sz);
+        if (NULL == req.pkt) {
+            fprintf(stderr, "edio24 error: out of memory for requests\n");
+            return -1;
+        }
+        memmove(req.pkt, pkt, sz);
+        req.sz_pkt = sz;
+        req.deadline = edio24_clock_now(pss->pclk) + pss->retry_budget;
+    }
+    if (edio24_session_push(pss, pkt, sz, &req) < 0) {
+        free(req.pkt);
+        return -1;
+    }
+    pss->stats.num_request ++;
+    if (flg_read) {
+        edio24_session_read_add(pss, idx, frame, count, pkt + EDIO24_PKT_OFFSET_DATA);
+    } else if (idx < 0) {
+        uint32_t mask = edio24_session_read_changed(cmd);
+        for (idx = 0; idx < EDIO24_SESSION_NUM_READS; idx ++) {
+            if (mask & (1 << idx)) {
+                pss->gen[idx] ++;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * \brief find and remove the request of a response
+ * \param pss: the session
+ * \param presp: the response
+ * \param preq: return the request
+ * \return 0 on found, <0 on not found
+ */
+static int
+edio24_session_match (edio24_session_t * pss, const edio24_response_t * presp, edio24_request_t * preq)
+{
+    size_t i;
+    size_t mask = pss->sz_max - 1;
+    for (i = 0; i < pss->num; i ++) {
+        edio24_request_t * p = &(pss->pending[(pss->head + i) & mask]);
+        if ((p->frame == presp->frame) && (p->cmd == presp->cmd)) {
+            break;
+        }
+    }
+    if (i >= pss->num) {
+        return -1;
+    }
+    *preq = pss->pending[(pss->head + i) & mask];
+    if (0 == i) {
+        pss->head = (pss->head + 1) & mask;
+    } else {
+        // the responses are out of order, it's rare
+        for (; i + 1 < pss->num; i ++) {
+            pss->pending[(pss->head + i) & mask] = pss->pending[(pss->head + i + 1) & mask];
+        }
+    }
+    pss->num --;
+    return 0;
+}
+
+/**
+ * \brief pass the response to the callbacks of its request and the reads waiting for it
+ * \param pss: the session
+ * \param preq: the request removed from the queue
+ * \param presp: the response, received or the timeout of the request
+ */
+static void
+edio24_session_respond (edio24_session_t * pss, edio24_request_t * preq, const edio24_response_t * presp)
+{
+    uint8_t pkt_waiter[EDIO24_PKT_LENGTH_MAX];
+    edio24_response_t resp_waiter;
+    edio24_waiter_t * waiters;
+    size_t num_waiters;
+    size_t i;
+
+    edio24_session_window_update(pss, preq, presp->status);
+    if ((NULL != preq->pkt) && (EDIO24_STATUS_SUCCESS != presp->status) && (edio24_session_retry(pss, preq, presp->status) >= 0)) {
+        // the waiters of the read keep waiting for the one sent again
+        return;
+    }
+    free(preq->pkt);
+    waiters = edio24_session_read_done(pss, presp, &num_waiters);
+    if (NULL != preq->cb) {
+        preq->cb(pss, presp, preq->userdata);
+    }
+    for (i = 0; i < num_waiters; i ++) {
+        edio24_session_copy_resp(presp->pkt, presp->sz_pkt, pkt_waiter, waiters[i].frame, &resp_waiter);
+        if (NULL != waiters[i].cb) {
+            waiters[i].cb(pss, &resp_waiter, waiters[i].userdata);
+        }
+    }
+    free(waiters);
+}
+
+/**
+ * \brief the oldest requests are not responded in time, return the timeout to them
+ */
+static void
+edio24_session_on_timeout (edio24_timer_t * ptm, void * userdata)
+{
+    edio24_session_t * pss = (edio24_session_t *)userdata;
+    uint8_t pkt[EDIO24_PKT_LENGTH_MAX];
+    edio24_response_t resp;
+    edio24_request_t req;
+    uint64_t now;
+    ssize_t ret;
+
+    assert (ptm == &(pss->tm_timeout));
+    now = edio24_clock_now(pss->pclk);
+    // the queue is in the order of sending, the expired ones are at the head
+    while ((pss->timeout > 0) && (pss->num > 0) && (pss->pending[pss->head].time + pss->timeout <= now)) {
+        req = pss->pending[pss->head];
+        pss->head = (pss->head + 1) & (pss->sz_max - 1);
+        pss->num --;
+        pss->stats.num_timeout ++;
+        ret = edio24_pkt_create_respond(pkt, sizeof(pkt), req.cmd, req.frame, EDIO24_STATUS_ERROR_TIMEOUT, 0, NULL);
+        assert (ret > 0);
+        edio24_session_parse(pkt, ret, &resp);
+        edio24_session_respond(pss, &req, &resp);
+    }
+    edio24_session_arm(pss);
+}
+
+/**
+ * \brief arm the timer of the session to the deadline of the oldest request
+ * \param pss: the session
+ */
+static void
+edio24_session_arm (edio24_session_t * pss)
+{
+    uint64_t deadline;
+
+    if (pss->timeout < 1) {
+        return;
+    }
+    if (pss->num < 1) {
+        if (edio24_timer_is_active(&(pss->tm_timeout))) {
+            edio24_timer_stop(pss->pclk, &(pss->tm_timeout));
+        }
+        return;
+    }
+    deadline = pss->pending[pss->head].time + pss->timeout;
+    if (edio24_timer_is_active(&(pss->tm_timeout)) && (deadline == pss->tm_timeout.deadline)) {
+        return;
+    }
+    edio24_timer_start_at(pss->pclk, &(pss->tm_timeout), deadline, edio24_session_on_timeout, pss);
+}
+
+/**
+ * \brief set the max time to wait for the response of a request
+ * \param pss: the session
+ * \param pclk: the clock of the session
+ * \param timeout: the microseconds to wait, 0 -- wait forever
+ * \return 0 on success, <0 on error
+ *
+ * A request not responded in time gets a response of EDIO24_STATUS_ERROR_TIMEOUT, which is retried
+ * as the one from the device, see edio24_session_set_retry(). Only one timer of the clock is used
+ * for all of the requests in flight, it is moved to the next request when the oldest one is responded.
+ * A response arriving after the timeout is passed to the default callback.
+ */
+int
+edio24_session_set_timeout (edio24_session_t * pss, edio24_clock_t * pclk, uint64_t timeout)
+{
+    if ((NULL == pss) || ((timeout > 0) && (NULL == pclk))) {
+        return -1;
+    }
+    if (edio24_timer_is_active(&(pss->tm_timeout))) {
+        edio24_timer_stop(pss->pclk, &(pss->tm_timeout));
+    }
+    if (NULL != pclk) {
+        pss->pclk = pclk;
+    }
+    pss->timeout = timeout;
+    edio24_session_arm(pss);
+    return 0;
+}
+
+/**
+ * \brief process the data received from the transport
+ * \param pss: the session
+ * \param buf: the data
+ * \param sz: the byte size of the data
+ * \return the number of responses processed, <0 on error
+ *
+ * The packets may be split or merged in any way.
+ * The illegal bytes are skipped until the next start of packet.
+ */
+int
+edio24_session_recv (edio24_session_t * pss, uint8_t * buf, size_t sz)
+{
+    uint8_t pkt[EDIO24_PKT_LENGTH_MAX];
+    edio24_response_t resp;
+    edio24_request_t req;
+    uint16_t count;
+    int cnt = 0;
+
+    if ((NULL == pss) || ((NULL == buf) && (sz > 0))) {
+        return -1;
+    }
+    if (edio24_rxbuf_append(&(pss->rxbuf), &(pss->sz_rxmax), &(pss->sz_rx), buf, sz) < 0) {
+        return -1;
+    }
+    pss->stats.bytes_in += sz;
+
+    while (pss->sz_rx >= EDIO24_PKT_LENGTH_MIN) {
+        if (EDIO24_PKT_START != pss->rxbuf[0]) {
+            uint8_t * p = (uint8_t *)memchr(pss->rxbuf + 1, EDIO24_PKT_START, pss->sz_rx - 1);
+            pss->stats.num_error ++;
+            edio24_rxbuf_consume(pss->rxbuf, &(pss->sz_rx), (NULL == p ? pss->sz_rx : (size_t)(p - pss->rxbuf)));
+            continue;
+        }
+        edio24_pkt_read_hdr_count(pss->rxbuf, pss->sz_rx, &count);
+        if (EDIO24_PKT_LENGTH_MIN + count > EDIO24_PKT_LENGTH_MAX) {
+            pss->stats.num_error ++;
+            edio24_rxbuf_consume(pss->rxbuf, &(pss->sz_rx), 1);
+            continue;
+        }
+        if (EDIO24_PKT_LENGTH_MIN + count > pss->sz_rx) {
+            break; // need more data
+        }
+        if (0 != edio24_pkt_verify(pss->rxbuf, EDIO24_PKT_LENGTH_MIN + count)) {
+            pss->stats.num_error ++;
+            edio24_rxbuf_consume(pss->rxbuf, &(pss->sz_rx), 1);
+            continue;
+        }
+        // copy out the packet, the callback may send or receive more data
+        memmove (pkt, pss->rxbuf, EDIO24_PKT_LENGTH_MIN + count);
+        edio24_rxbuf_consume(pss->rxbuf, &(pss->sz_rx), EDIO24_PKT_LENGTH_MIN + count);
+        edio24_session_parse(pkt, EDIO24_PKT_LENGTH_MIN + count, &resp);
+        cnt ++;
+
+        if (0 == edio24_session_match(pss, &resp, &req)) {
+            pss->stats.num_respond ++;
+            edio24_session_arm(pss);
+            edio24_session_respond(pss, &req, &resp);
+        } else {
+            pss->stats.num_error ++;
+            if (NULL != pss->cb_default) {
+                pss->cb_default(pss, &resp, pss->userdata_default);
+            }
+        }
+    }
+    return cnt;
+}
+
+#if defined(USE_EDIO24_SERVER) && (USE_EDIO24_SERVER == 1)
+/*****************************************************************************/
+static void
+edio24_svrsession_on_recv (void * userdata, uint8_t * buf, size_t sz)
+{
+    edio24_svrsession_recv((edio24_svrsession_t *)userdata, buf, sz);
+}
+
+/**
+ * \brief initialize the device side of a transport
+ * \param psvr: the device session
+ * \param ptr: the transport, the receiver of it is set to the device session
+ * \param flg_randfail: 1 -- send out fail message randomly on requests
+ * \return 0 on success, <0 on error
+ */
+int
+edio24_svrsession_init (edio24_svrsession_t * psvr, edio24_transport_t * ptr, char flg_randfail)
+{
+    if ((NULL == psvr) || (NULL == ptr)) {
+        return -1;
+    }
+    memset(psvr, 0, sizeof(*psvr));
+    psvr->ptr = ptr;
+    psvr->flg_randfail = flg_randfail;
+    edio24_transport_set_receiver(ptr, edio24_svrsession_on_recv, psvr);
+    return 0;
+}
+
+void
+edio24_svrsession_clean (edio24_svrsession_t * psvr)
+{
+    if (NULL == psvr) {
+        return;
+    }
+    if ((NULL != psvr->ptr) && (psvr->ptr->userdata_recv == psvr)) {
+        edio24_transport_set_receiver(psvr->ptr, NULL, NULL);
+    }
+    free(psvr->rxbuf);
+    psvr->rxbuf = NULL;
+    psvr->sz_rxmax = psvr->sz_rx = 0;
+}
+
+/**
+ * \brief set the processor of the requests
+ * \param psvr: the device session
+ * \param cb: the callback, NULL -- use the stateless edio24_svr_process_tcp()
+ * \param userdata: the pointer passed to the callback
+ */
+void
+edio24_svrsession_set_process (edio24_svrsession_t * psvr, edio24_svr_process_cb_t cb, void * userdata)
+{
+    assert (NULL != psvr);
+    psvr->cb_process = cb;
+    psvr->userdata_process = userdata;
+}
+
+/**
+ * \brief process the requests received from the transport, and send back the responses
+ * \param psvr: the device session
+ * \param buf: the data
+ * \param sz: the byte size of the data
+ * \return the number of requests processed, <0 on error
+ */
+int
+edio24_svrsession_recv (edio24_svrsession_t * psvr, uint8_t * buf, size_t sz)
+{
+    uint8_t buffer_out[EDIO24_PKT_LENGTH_MAX];
+    size_t sz_out;
+    size_t sz_processed;
+    size_t sz_needed_in;
+    size_t sz_needed_out;
+    uint16_t count;
+    char flg_randfail;
+    int ret;
+    int cnt = 0;
+
+    if ((NULL == psvr) || ((NULL == buf) && (sz > 0))) {
+        return -1;
+    }
+    if (edio24_rxbuf_append(&(psvr->rxbuf), &(psvr->sz_rxmax), &(psvr->sz_rx), buf, sz) < 0) {
+        return -1;
+    }
+    while (psvr->sz_rx >= EDIO24_PKT_LENGTH_MIN) {
+        flg_randfail = 0;
+        if (psvr->flg_randfail) {
+            if (rand() % 100 < 50) {
+                flg_randfail = 1;
+            }
+        }
+        sz_out = sizeof(buffer_out);
+        sz_processed = 0;
+        sz_needed_in = 0;
+        sz_needed_out = 0;
+        if (NULL != psvr->cb_process) {
+            ret = psvr->cb_process(psvr->userdata_process, flg_randfail, psvr->rxbuf, psvr->sz_rx, buffer_out, &sz_out,
+                                 &sz_processed, &sz_needed_in, &sz_needed_out);
+        } else {
+            ret = edio24_svr_process_tcp(flg_randfail, psvr->rxbuf, psvr->sz_rx, buffer_out, &sz_out,
+                                 &sz_processed, &sz_needed_in, &sz_needed_out);
+        }
+        if (sz_needed_in > 0) {
+            break;
+        }
+        if ((0 != ret) || (sz_processed < 1)) {
+            // drop the illegal packet, or the one can't be processed
+            count = 0;
+            edio24_pkt_read_hdr_count(psvr->rxbuf, psvr->sz_rx, &count);
+            sz_processed = ((ret < 0) && (EDIO24_PKT_LENGTH_MIN + count <= psvr->sz_rx) ? EDIO24_PKT_LENGTH_MIN + count : 1);
+            sz_out = 0;
+        } else {
+            psvr->num_request ++;
+            cnt ++;
+        }
+        edio24_rxbuf_consume(psvr->rxbuf, &(psvr->sz_rx), sz_processed);
+        if (sz_out > 0) {
+            if (edio24_transport_send(psvr->ptr, buffer_out, sz_out) >= 0) {
+                psvr->num_respond ++;
+            }
+        }
+    }
+    return cnt;
+}
+#endif // USE_EDIO24_SERVER
+
+#if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
+#include <ciut.h>
+
+typedef struct _test_session_log_t {
+    int cnt;
+    int cnt_cancel;
+    uint8_t cmd[16];
+    uint8_t status[16];
+    uint16_t count[16];
+    uint8_t data0[16];
+    uint8_t frame[16];
+} test_session_log_t;
+
+static void
+test_session_cb (edio24_session_t * pss, const edio24_response_t * presp, void * userdata)
+{
+    test_session_log_t * plog = (test_session_log_t *)userdata;
+    if (NULL == presp) {
+        plog->cnt_cancel ++;
+        return;
+    }
+    plog->cmd[plog->cnt] = presp->cmd;
+    plog->status[plog->cnt] = presp->status;
+    plog->count[plog->cnt] = presp->count;
+    plog->data0[plog->cnt] = (presp->count > 0 ? presp->data[0] : 0);
+    plog->frame[plog->cnt] = presp->frame;
+    plog->cnt ++;
+}
+
+static void
+test_session_chain_cb (edio24_session_t * pss, const edio24_response_t * presp, void * userdata)
+{
+    uint8_t pkt[EDIO24_PKT_LENGTH_MAX];
+    ssize_t ret;
+    int * pcnt = (int *)userdata;
+    (*pcnt) ++;
+    if (*pcnt < 100) {
+        // send the next request in the callback
+        ret = edio24_pkt_create_cmd_doutr(pkt, sizeof(pkt), &(pss->frame));
+        edio24_session_send(pss, pkt, ret, test_session_chain_cb, userdata);
+    }
+}
+
+TEST_CASE( .name="edio24-session", .description="test edio24 session on the loopback transport.", .skip=0 ) {
+    edio24_ring_t ring;
+    edio24_loopback_t lb;
+    edio24_session_t ss;
+    edio24_svrsession_t svr;
+    test_session_log_t log;
+    uint8_t pkt[EDIO24_PKT_LENGTH_MAX];
+    uint8_t * p;
+    ssize_t ret;
+    size_t i;
+
+    SECTION("test edio24_ring_xxx") {
+        uint8_t data[300];
+        for (i = 0; i < sizeof(data); i ++) {
+            data[i] = i & 0xFF;
+        }
+        REQUIRE(0 > edio24_ring_init(NULL, 10));
+        REQUIRE(0 == edio24_ring_init(&ring, 10));
+        REQUIRE(64 == ring.sz_max);
+        REQUIRE(0 > edio24_ring_write(NULL, data, 10));
+        REQUIRE(0 > edio24_ring_write(&ring, NULL, 10));
+        REQUIRE(40 == edio24_ring_write(&ring, data, 40));
+        REQUIRE(40 == edio24_ring_peek(&ring, &p));
+        edio24_ring_consume(&ring, 30);
+        // wrap around
+        REQUIRE(40 == edio24_ring_write(&ring, data + 40, 40));
+        REQUIRE(50 == edio24_ring_used(&ring));
+        REQUIRE(34 == edio24_ring_peek(&ring, &p));
+        REQUIRE(30 == p[0]);
+        edio24_ring_consume(&ring, 34);
+        REQUIRE(16 == edio24_ring_peek(&ring, &p));
+        REQUIRE(64 == p[0]);
+        // grow with the data wrapped
+        REQUIRE(200 == edio24_ring_write(&ring, data + 80, 200));
+        REQUIRE(256 == ring.sz_max);
+        REQUIRE(216 == edio24_ring_peek(&ring, &p));
+        for (i = 0; i < 216; i ++) {
+            REQUIRE(((64 + i) & 0xFF) == p[i]);
+        }
+        edio24_ring_consume(&ring, 216);
+        REQUIRE(0 == edio24_ring_used(&ring));
+        edio24_ring_clean(&ring);
+    }
+    SECTION("test the session with a device on the loopback") {
+        memset(&log, 0, sizeof(log));
+        REQUIRE(0 == edio24_loopback_init(&lb, 16));
+        REQUIRE(0 > edio24_session_init(NULL, edio24_loopback_client(&lb)));
+        REQUIRE(0 == edio24_session_init(&ss, edio24_loopback_client(&lb)));
+        REQUIRE(0 == edio24_svrsession_init(&svr, edio24_loopback_device(&lb), 0));
+
+        REQUIRE(0 > edio24_session_send(&ss, NULL, 10, test_session_cb, &log));
+        REQUIRE(0 > edio24_session_send(&ss, pkt, 3, test_session_cb, &log));
+        ret = edio24_pkt_create_cmd_dconfw(pkt, sizeof(pkt), &(ss.frame), 0xFFFFFF, 0);
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        ret = edio24_pkt_create_cmd_doutw(pkt, sizeof(pkt), &(ss.frame), 0xFFFFFF, 0x123456);
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        ret = edio24_pkt_create_cmd_status(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        ret = edio24_pkt_create_cmd_usermemr(pkt, sizeof(pkt), &(ss.frame), 0x10, 300);
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        REQUIRE(4 == edio24_session_inflight(&ss));
+        REQUIRE(4 == ss.frame);
+        REQUIRE(0 == log.cnt);
+
+        REQUIRE(0 < edio24_loopback_pump(&lb));
+        REQUIRE(0 == edio24_session_inflight(&ss));
+        REQUIRE(4 == log.cnt);
+        REQUIRE(0x05 == log.cmd[0]);
+        REQUIRE(0x03 == log.cmd[1]);
+        REQUIRE(0x52 == log.cmd[2]);
+        REQUIRE(2 == log.count[2]);
+        REQUIRE(0x42 == log.cmd[3]);
+        REQUIRE(300 == log.count[3]);
+        REQUIRE(1 == log.data0[3]);
+        for (i = 0; i < 4; i ++) {
+            REQUIRE(0 == log.status[i]);
+        }
+        REQUIRE(4 == ss.stats.num_request);
+        REQUIRE(4 == ss.stats.num_respond);
+        REQUIRE(0 == ss.stats.num_error);
+        REQUIRE(4 == svr.num_request);
+        REQUIRE(4 == svr.num_respond);
+        REQUIRE(lb.bytes[0] == ss.stats.bytes_out);
+        REQUIRE(lb.bytes[1] == ss.stats.bytes_in);
+        REQUIRE(0 == edio24_loopback_pump(&lb));
+
+        edio24_svrsession_clean(&svr);
+        edio24_session_clean(&ss);
+        edio24_loopback_clean(&lb);
+    }
+    SECTION("test the requests sent in the callback") {
+        int cnt = 0;
+        REQUIRE(0 == edio24_loopback_init(&lb, 16));
+        REQUIRE(0 == edio24_session_init(&ss, edio24_loopback_client(&lb)));
+        REQUIRE(0 == edio24_svrsession_init(&svr, edio24_loopback_device(&lb), 0));
+        ret = edio24_pkt_create_cmd_dinr(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_chain_cb, &cnt));
+        edio24_loopback_pump(&lb);
+        REQUIRE(100 == cnt);
+        REQUIRE(100 == ss.stats.num_respond);
+        REQUIRE(0 == edio24_session_inflight(&ss));
+        edio24_svrsession_clean(&svr);
+        edio24_session_clean(&ss);
+        edio24_loopback_clean(&lb);
+    }
+    SECTION("test the split and illegal data") {
+        uint8_t resp[64];
+        size_t sz_resp = 0;
+        memset(&log, 0, sizeof(log));
+        REQUIRE(0 == edio24_loopback_init(&lb, 16));
+        REQUIRE(0 == edio24_session_init(&ss, edio24_loopback_client(&lb)));
+        edio24_session_set_default(&ss, test_session_cb, &log);
+        // no device on the other end, the requests stay in the ring
+        ret = edio24_pkt_create_cmd_status(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        ret = edio24_pkt_create_cmd_blinkled(pkt, sizeof(pkt), &(ss.frame), 3);
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+
+        // the responses: garbage, status, the broken blinkled, blinkled, the unexpected doutw
+        resp[sz_resp ++] = 0x00;
+        resp[sz_resp ++] = 0x11;
+        ret = edio24_pkt_create_respond(resp + sz_resp, sizeof(resp) - sz_resp, 0x52, 0, 0, 2, pkt);
+        REQUIRE(9 == ret);
+        sz_resp += ret;
+        ret = edio24_pkt_create_respond(resp + sz_resp, sizeof(resp) - sz_resp, 0x50, 1, 0, 0, NULL);
+        resp[sz_resp + ret - 1] ++;
+        sz_resp += ret;
+        ret = edio24_pkt_create_respond(resp + sz_resp, sizeof(resp) - sz_resp, 0x50, 1, 3, 0, NULL);
+        sz_resp += ret;
+        ret = edio24_pkt_create_respond(resp + sz_resp, sizeof(resp) - sz_resp, 0x03, 9, 0, 0, NULL);
+        sz_resp += ret;
+        for (i = 0; i < sz_resp; i ++) {
+            REQUIRE(0 <= edio24_session_recv(&ss, resp + i, 1));
+        }
+        REQUIRE(3 == log.cnt);
+        REQUIRE(0x52 == log.cmd[0]);
+        REQUIRE(0x50 == log.cmd[1]);
+        REQUIRE(3 == log.status[1]);
+        REQUIRE(0x03 == log.cmd[2]);
+        REQUIRE(2 == ss.stats.num_respond);
+        REQUIRE(ss.stats.num_error >= 3);
+        REQUIRE(0 == edio24_session_inflight(&ss));
+        REQUIRE(0 == ss.sz_rx);
+
+        // cancel the pending requests
+        ret = edio24_pkt_create_cmd_status(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        REQUIRE(1 == edio24_session_inflight(&ss));
+        edio24_session_clean(&ss);
+        REQUIRE(1 == log.cnt_cancel);
+        edio24_loopback_clean(&lb);
+    }
+}
+
+TEST_CASE( .name="edio24-session-cache", .description="test the coalesced and cached reads of edio24 session.", .skip=0 ) {
+    edio24_clock_t clk;
+    edio24_loopback_t lb;
+    edio24_session_t ss;
+    edio24_svrsession_t svr;
+    test_session_log_t log;
+    uint8_t pkt[EDIO24_PKT_LENGTH_MAX];
+    ssize_t ret;
+    int i;
+
+    SECTION("test the identical reads in flight") {
+        memset(&log, 0, sizeof(log));
+        REQUIRE(0 == edio24_loopback_init(&lb, 16));
+        REQUIRE(0 == edio24_session_init(&ss, edio24_loopback_client(&lb)));
+        REQUIRE(0 == edio24_svrsession_init(&svr, edio24_loopback_device(&lb), 0));
+        REQUIRE(0 > edio24_session_set_cache(NULL, NULL, EDIO24_CMD_DIN_R, 0));
+        REQUIRE(0 > edio24_session_set_cache(&ss, NULL, EDIO24_CMD_DOUT_W, 0));
+        REQUIRE(0 > edio24_session_set_cache(&ss, NULL, EDIO24_CMD_DIN_R, 1000));
+        REQUIRE(0 == edio24_session_set_cache(&ss, NULL, EDIO24_CMD_DIN_R, 0));
+        for (i = 0; i < 3; i ++) {
+            ret = edio24_pkt_create_cmd_dinr(pkt, sizeof(pkt), &(ss.frame));
+            REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        }
+        REQUIRE(1 == edio24_session_inflight(&ss));
+        REQUIRE(2 == ss.stats.num_coalesce);
+        edio24_loopback_pump(&lb);
+        REQUIRE(1 == svr.num_request);
+        REQUIRE(3 == log.cnt);
+        for (i = 0; i < 3; i ++) {
+            REQUIRE(EDIO24_CMD_DIN_R == log.cmd[i]);
+            REQUIRE(i == log.frame[i]);
+            REQUIRE(3 == log.count[i]);
+        }
+        REQUIRE(0 == ss.num_reads);
+
+        // the read after a write is sent
+        ret = edio24_pkt_create_cmd_dinr(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        ret = edio24_pkt_create_cmd_doutw(pkt, sizeof(pkt), &(ss.frame), 0xFF, 0x01);
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        ret = edio24_pkt_create_cmd_dinr(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        REQUIRE(3 == edio24_session_inflight(&ss));
+        REQUIRE(2 == ss.stats.num_coalesce);
+        edio24_loopback_pump(&lb);
+        REQUIRE(4 == svr.num_request);
+        REQUIRE(6 == log.cnt);
+        REQUIRE(EDIO24_CMD_DIN_R == log.cmd[5]);
+        REQUIRE(5 == log.frame[5]);
+
+        // the waiters are cancelled with the request
+        for (i = 0; i < 2; i ++) {
+            ret = edio24_pkt_create_cmd_dinr(pkt, sizeof(pkt), &(ss.frame));
+            REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        }
+        REQUIRE(1 == edio24_session_inflight(&ss));
+        edio24_session_clean(&ss);
+        REQUIRE(2 == log.cnt_cancel);
+        edio24_svrsession_clean(&svr);
+        edio24_session_clean(&ss);
+        edio24_loopback_clean(&lb);
+    }
+    SECTION("test the responses cached") {
+        memset(&log, 0, sizeof(log));
+        REQUIRE(0 == edio24_clock_init(&clk, 1));
+        REQUIRE(0 == edio24_loopback_init(&lb, 16));
+        REQUIRE(0 == edio24_session_init(&ss, edio24_loopback_client(&lb)));
+        REQUIRE(0 == edio24_svrsession_init(&svr, edio24_loopback_device(&lb), 0));
+        REQUIRE(0 == edio24_session_set_cache(&ss, &clk, EDIO24_CMD_NETWORK_CONF, 1000));
+        ret = edio24_pkt_create_cmd_netconf(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        edio24_loopback_pump(&lb);
+        REQUIRE(1 == log.cnt);
+        REQUIRE(1 == ss.num_reads);
+
+        // returned in the send, with the frame id of the request
+        ret = edio24_pkt_create_cmd_netconf(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        REQUIRE(2 == log.cnt);
+        REQUIRE(EDIO24_CMD_NETWORK_CONF == log.cmd[1]);
+        REQUIRE(1 == log.frame[1]);
+        REQUIRE(log.count[0] == log.count[1]);
+        REQUIRE(log.data0[0] == log.data0[1]);
+        REQUIRE(0 == edio24_session_inflight(&ss));
+        REQUIRE(1 == ss.stats.num_cached);
+
+        // the other reads keep the cache
+        ret = edio24_pkt_create_cmd_status(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        ret = edio24_pkt_create_cmd_netconf(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        REQUIRE(2 == ss.stats.num_cached);
+        edio24_loopback_pump(&lb);
+        REQUIRE(4 == log.cnt);
+        REQUIRE(2 == svr.num_request);
+
+        // expired
+        edio24_clock_forward(&clk, 1000);
+        ret = edio24_pkt_create_cmd_netconf(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        REQUIRE(1 == edio24_session_inflight(&ss));
+        edio24_loopback_pump(&lb);
+        REQUIRE(3 == svr.num_request);
+
+        // the write of the settings discards the cache, the others don't
+        ret = edio24_pkt_create_cmd_dconfw(pkt, sizeof(pkt), &(ss.frame), 0xFF, 0);
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        ret = edio24_pkt_create_cmd_netconf(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        REQUIRE(3 == ss.stats.num_cached);
+        ret = edio24_pkt_create_cmd_setmemw(pkt, sizeof(pkt), &(ss.frame), 0x10, 1, (uint8_t *)"A");
+        REQUIRE(0 < ret);
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        ret = edio24_pkt_create_cmd_netconf(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        REQUIRE(3 == edio24_session_inflight(&ss));
+        REQUIRE(3 == ss.stats.num_cached);
+        edio24_loopback_pump(&lb);
+        REQUIRE(6 == svr.num_request);
+        REQUIRE(9 == log.cnt);
+        edio24_svrsession_clean(&svr);
+        edio24_session_clean(&ss);
+        edio24_loopback_clean(&lb);
+        edio24_clock_clean(&clk);
+    }
+}
+
+/* the device returns the status set to the requests, see edio24_svrsession_set_process() */
+static int
+test_session_status_process (void * userdata, char flg_force_fail, uint8_t * buffer_in, size_t sz_in, uint8_t * buffer_out, size_t *sz_out, size_t * sz_processed, size_t * sz_needed_in, size_t * sz_needed_out)
+{
+    uint8_t * pstatus = (uint8_t *)userdata;
+    uint8_t sum = 0;
+    size_t i;
+    int ret;
+
+    ret = edio24_svr_process_tcp(0, buffer_in, sz_in, buffer_out, sz_out, sz_processed, sz_needed_in, sz_needed_out);
+    if ((0 == ret) && (*sz_out >= EDIO24_PKT_LENGTH_MIN) && (EDIO24_STATUS_SUCCESS != *pstatus)) {
+        buffer_out[3] = *pstatus;
+        for (i = 0; i + 1 < *sz_out; i ++) {
+            sum += buffer_out[i];
+        }
+        buffer_out[*sz_out - 1] = 0xFF - sum;
+    }
+    return ret;
+}
+
+/* send a window of requests, and receive the responses after the RTT */
+static void
+test_session_window_round (edio24_session_t * pss, edio24_loopback_t * plb, edio24_clock_t * pclk, uint64_t rtt)
+{
+    uint8_t pkt[EDIO24_PKT_LENGTH_MAX];
+    ssize_t ret;
+    size_t i;
+    size_t num = edio24_session_window(pss);
+    for (i = 0; i < num; i ++) {
+        ret = edio24_pkt_create_cmd_doutr(pkt, sizeof(pkt), &(pss->frame));
+        REQUIRE(0 == edio24_session_send(pss, pkt, ret, NULL, NULL));
+    }
+    REQUIRE(num == edio24_session_inflight(pss));
+    edio24_clock_forward(pclk, rtt);
+    edio24_loopback_pump(plb);
+    REQUIRE(0 == edio24_session_inflight(pss));
+}
+
+TEST_CASE( .name="edio24-session-window", .description="test the adaptive window of edio24 session.", .skip=0 ) {
+    edio24_clock_t clk;
+    edio24_loopback_t lb;
+    edio24_session_t ss;
+    edio24_svrsession_t svr;
+    uint8_t status = EDIO24_STATUS_SUCCESS;
+
+    SECTION("test the window grows and shrinks") {
+        REQUIRE(0 == edio24_clock_init(&clk, 1));
+        REQUIRE(0 == edio24_loopback_init(&lb, 16));
+        REQUIRE(0 == edio24_session_init(&ss, edio24_loopback_client(&lb)));
+        REQUIRE(0 == edio24_svrsession_init(&svr, edio24_loopback_device(&lb), 0));
+        edio24_svrsession_set_process(&svr, test_session_status_process, &status);
+        REQUIRE(0 == edio24_session_window(&ss));
+        REQUIRE(0 > edio24_session_set_window(&ss, NULL, 1, 8));
+        REQUIRE(0 > edio24_session_set_window(&ss, &clk, 0, 8));
+        REQUIRE(0 > edio24_session_set_window(&ss, &clk, 4, 2));
+        REQUIRE(0 == edio24_session_set_window(&ss, &clk, 1, 8));
+        REQUIRE(1 == edio24_session_window(&ss));
+
+        // doubled by each round until the max
+        test_session_window_round(&ss, &lb, &clk, 100);
+        REQUIRE(2 == edio24_session_window(&ss));
+        test_session_window_round(&ss, &lb, &clk, 100);
+        REQUIRE(4 == edio24_session_window(&ss));
+        test_session_window_round(&ss, &lb, &clk, 100);
+        REQUIRE(8 == edio24_session_window(&ss));
+        test_session_window_round(&ss, &lb, &clk, 100);
+        REQUIRE(8 == edio24_session_window(&ss));
+        REQUIRE(100 == ss.stats.rtt_min);
+        REQUIRE(100 == ss.stats.rtt_avg);
+
+        // halved once by the busy responses of a window
+        status = EDIO24_STATUS_ERROR_BUSY;
+        test_session_window_round(&ss, &lb, &clk, 100);
+        REQUIRE(4 == edio24_session_window(&ss));
+        REQUIRE(1 == ss.stats.num_backoff_busy);
+
+        // grows by one for a window of the responses
+        status = EDIO24_STATUS_SUCCESS;
+        test_session_window_round(&ss, &lb, &clk, 100);
+        REQUIRE(5 == edio24_session_window(&ss));
+        test_session_window_round(&ss, &lb, &clk, 100);
+        REQUIRE(6 == edio24_session_window(&ss));
+
+        // halved by the RTT inflated
+        test_session_window_round(&ss, &lb, &clk, 100 * 2 + EDIO24_SESSION_RTT_SLACK);
+        REQUIRE(7 == edio24_session_window(&ss));
+        test_session_window_round(&ss, &lb, &clk, 100 * 2 + EDIO24_SESSION_RTT_SLACK + 1);
+        REQUIRE(3 == edio24_session_window(&ss));
+        REQUIRE(1 == ss.stats.num_backoff_rtt);
+        REQUIRE(100 == ss.stats.rtt_min);
+        REQUIRE(100 < ss.stats.rtt_avg);
+
+        // not less than the min
+        status = EDIO24_STATUS_ERROR_TIMEOUT;
+        test_session_window_round(&ss, &lb, &clk, 100);
+        REQUIRE(1 == edio24_session_window(&ss));
+        status = EDIO24_STATUS_ERROR_READY;
+        test_session_window_round(&ss, &lb, &clk, 100);
+        REQUIRE(1 == edio24_session_window(&ss));
+        REQUIRE(3 == ss.stats.num_backoff_busy);
+
+        // the other errors are not congestion
+        status = EDIO24_STATUS_ERROR_PARAMETER;
+        test_session_window_round(&ss, &lb, &clk, 100);
+        REQUIRE(2 == edio24_session_window(&ss));
+        REQUIRE(3 == ss.stats.num_backoff_busy);
+        edio24_svrsession_clean(&svr);
+        edio24_session_clean(&ss);
+        edio24_loopback_clean(&lb);
+        edio24_clock_clean(&clk);
+    }
+}
+
+TEST_CASE( .name="edio24-session-retry", .description="test the requests of edio24 session sent again on the transient errors.", .skip=0 ) {
+    edio24_clock_t clk;
+    edio24_loopback_t lb;
+    edio24_session_t ss;
+    edio24_svrsession_t svr;
+    test_session_log_t log;
+    uint8_t pkt[EDIO24_PKT_LENGTH_MAX];
+    uint8_t status = EDIO24_STATUS_SUCCESS;
+    ssize_t (* send_saved)(edio24_transport_t * ptr, const uint8_t * buf, size_t sz);
+    ssize_t ret;
+    int i;
+
+    SECTION("test the commands can be repeated") {
+        REQUIRE(1 == edio24_session_retryable(EDIO24_CMD_DIN_R));
+        REQUIRE(1 == edio24_session_retryable(EDIO24_CMD_NETWORK_CONF));
+        REQUIRE(1 == edio24_session_retryable(EDIO24_CMD_DOUT_W));
+        REQUIRE(1 == edio24_session_retryable(EDIO24_CMD_DCONF_W));
+        REQUIRE(1 == edio24_session_retryable(EDIO24_CMD_USR_MEM_W));
+        REQUIRE(0 == edio24_session_retryable(EDIO24_CMD_RESET));
+        REQUIRE(0 == edio24_session_retryable(EDIO24_CMD_FIRMWARE));
+        REQUIRE(0 == edio24_session_retryable(EDIO24_CMD_COUNTER_W));
+        REQUIRE(0 == edio24_session_retryable(EDIO24_CMD_BLINKLED));
+        REQUIRE(0 == edio24_session_retryable(EDIO24_CMD_BOOT_MEM_W));
+    }
+    SECTION("test the failed requests sent again") {
+        memset(&log, 0, sizeof(log));
+        status = EDIO24_STATUS_ERROR_BUSY;
+        REQUIRE(0 == edio24_clock_init(&clk, 1));
+        REQUIRE(0 == edio24_loopback_init(&lb, 16));
+        REQUIRE(0 == edio24_session_init(&ss, edio24_loopback_client(&lb)));
+        REQUIRE(0 == edio24_svrsession_init(&svr, edio24_loopback_device(&lb), 0));
+        edio24_svrsession_set_process(&svr, test_session_status_process, &status);
+        REQUIRE(0 > edio24_session_set_retry(NULL, &clk, 100, 1000));
+        REQUIRE(0 > edio24_session_set_retry(&ss, NULL, 100, 1000));
+        REQUIRE(0 == edio24_session_set_retry(&ss, &clk, 100, 1000));
+
+        // not repeated
+        ret = edio24_pkt_create_cmd_dcounterw(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        edio24_loopback_pump(&lb);
+        REQUIRE(1 == log.cnt);
+        REQUIRE(EDIO24_STATUS_ERROR_BUSY == log.status[0]);
+        REQUIRE(0 == edio24_session_inflight(&ss));
+
+        // the response after the retry, with the frame id of the request
+        ret = edio24_pkt_create_cmd_doutr(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        edio24_loopback_pump(&lb);
+        REQUIRE(1 == log.cnt);
+        REQUIRE(1 == edio24_session_inflight(&ss));
+        status = EDIO24_STATUS_SUCCESS;
+        edio24_clock_forward(&clk, 49);
+        REQUIRE(0 == ss.stats.num_retry);
+        edio24_clock_forward(&clk, 51);
+        REQUIRE(1 == ss.stats.num_retry);
+        edio24_loopback_pump(&lb);
+        REQUIRE(2 == log.cnt);
+        REQUIRE(EDIO24_STATUS_SUCCESS == log.status[1]);
+        REQUIRE(EDIO24_CMD_DOUT_R == log.cmd[1]);
+        REQUIRE(1 == log.frame[1]);
+        REQUIRE(0 == edio24_session_inflight(&ss));
+        REQUIRE(3 == svr.num_request);
+
+        // the deadline
+        status = EDIO24_STATUS_ERROR_TIMEOUT;
+        ret = edio24_pkt_create_cmd_doutw(pkt, sizeof(pkt), &(ss.frame), 0xFF, 0x01);
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        for (i = 0; (i < 100) && (edio24_session_inflight(&ss) > 0); i ++) {
+            edio24_loopback_pump(&lb);
+            edio24_clock_forward(&clk, 10);
+        }
+        REQUIRE(0 == edio24_session_inflight(&ss));
+        REQUIRE(3 == log.cnt);
+        REQUIRE(EDIO24_STATUS_ERROR_TIMEOUT == log.status[2]);
+        REQUIRE(1 == ss.stats.num_giveup);
+        REQUIRE(3 <= ss.stats.num_retry);
+        REQUIRE(5 >= ss.stats.num_retry);
+
+        // the other errors are returned
+        status = EDIO24_STATUS_ERROR_PARAMETER;
+        ret = edio24_pkt_create_cmd_dinr(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        edio24_loopback_pump(&lb);
+        REQUIRE(4 == log.cnt);
+        REQUIRE(EDIO24_STATUS_ERROR_PARAMETER == log.status[3]);
+
+        // the coalesced reads fail together if the request can't be sent again
+        REQUIRE(0 == edio24_session_set_cache(&ss, &clk, EDIO24_CMD_DIN_R, 0));
+        status = EDIO24_STATUS_ERROR_BUSY;
+        ret = edio24_pkt_create_cmd_dinr(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        ret = edio24_pkt_create_cmd_dinr(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        REQUIRE(1 == ss.num_reads);
+        edio24_loopback_pump(&lb);
+        REQUIRE(1 == edio24_session_inflight(&ss));
+        send_saved = ss.ptr->send;
+        ss.ptr->send = NULL;
+        for (i = 0; (i < 100) && (edio24_session_inflight(&ss) > 0); i ++) {
+            edio24_clock_forward(&clk, 10);
+        }
+        ss.ptr->send = send_saved;
+        REQUIRE(0 == edio24_session_inflight(&ss));
+        REQUIRE(2 == log.cnt_cancel);
+        REQUIRE(0 == ss.num_reads);
+        // the next read is sent, not joined to the failed one
+        status = EDIO24_STATUS_SUCCESS;
+        ret = edio24_pkt_create_cmd_dinr(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        edio24_loopback_pump(&lb);
+        REQUIRE(5 == log.cnt);
+        REQUIRE(EDIO24_STATUS_SUCCESS == log.status[4]);
+
+        // cancelled while waiting for the backoff
+        status = EDIO24_STATUS_ERROR_BUSY;
+        ret = edio24_pkt_create_cmd_dinr(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        edio24_loopback_pump(&lb);
+        REQUIRE(1 == edio24_session_inflight(&ss));
+        edio24_session_clean(&ss);
+        REQUIRE(3 == log.cnt_cancel);
+        REQUIRE(0 == edio24_session_inflight(&ss));
+        edio24_svrsession_clean(&svr);
+        edio24_session_clean(&ss);
+        edio24_loopback_clean(&lb);
+        edio24_clock_clean(&clk);
+    }
+}
+
+/* drop the responses of the first requests, as they are lost */
+static int
+test_session_drop_process (void * userdata, char flg_force_fail, uint8_t * buffer_in, size_t sz_in, uint8_t * buffer_out, size_t *sz_out, size_t * sz_processed, size_t * sz_needed_in, size_t * sz_needed_out)
+{
+    size_t * pnum_drop = (size_t *)userdata;
+    int ret;
+
+    ret = edio24_svr_process_tcp(0, buffer_in, sz_in, buffer_out, sz_out, sz_processed, sz_needed_in, sz_needed_out);
+    if ((0 == ret) && (*sz_out > 0) && (*pnum_drop > 0)) {
+        (*pnum_drop) --;
+        *sz_out = 0;
+    }
+    return ret;
+}
+
+typedef struct _test_session_deadline_t {
+    edio24_clock_t * pclk;
+    uint64_t timeout;
+    uint64_t interval; /**< the requests are sent one by one at this interval since the time 0 */
+    size_t cnt;
+    size_t cnt_wrong;  /**< the timeouts not at the deadline of the request */
+} test_session_deadline_t;
+
+static void
+test_session_deadline_cb (edio24_session_t * pss, const edio24_response_t * presp, void * userdata)
+{
+    test_session_deadline_t * pdl = (test_session_deadline_t *)userdata;
+    if ((NULL == presp) || (EDIO24_STATUS_ERROR_TIMEOUT != presp->status)
+        || (edio24_clock_now(pdl->pclk) != pdl->cnt * pdl->interval + pdl->timeout)) {
+        pdl->cnt_wrong ++;
+    }
+    pdl->cnt ++;
+}
+
+TEST_CASE( .name="edio24-session-timeout", .description="test the deadlines of the requests of edio24 session.", .skip=0 ) {
+    edio24_clock_t clk;
+    edio24_loopback_t lb;
+    edio24_session_t ss;
+    edio24_svrsession_t svr;
+    test_session_log_t log;
+    test_session_deadline_t dl;
+    uint8_t pkt[EDIO24_PKT_LENGTH_MAX];
+    size_t num_drop = 0;
+    ssize_t ret;
+    int i;
+
+    SECTION("test the requests not responded in time") {
+        memset(&log, 0, sizeof(log));
+        REQUIRE(0 == edio24_clock_init(&clk, 1));
+        REQUIRE(0 == edio24_loopback_init(&lb, 16));
+        REQUIRE(0 == edio24_session_init(&ss, edio24_loopback_client(&lb)));
+        REQUIRE(0 == edio24_svrsession_init(&svr, edio24_loopback_device(&lb), 0));
+        edio24_svrsession_set_process(&svr, test_session_drop_process, &num_drop);
+        REQUIRE(0 > edio24_session_set_timeout(NULL, &clk, 1000));
+        REQUIRE(0 > edio24_session_set_timeout(&ss, NULL, 1000));
+        REQUIRE(0 == edio24_session_set_timeout(&ss, &clk, 1000));
+        REQUIRE(0 == edio24_timer_is_active(&(ss.tm_timeout)));
+
+        // the first one is lost, the second one is responded
+        num_drop = 1;
+        ret = edio24_pkt_create_cmd_dinr(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        REQUIRE(1 == edio24_timer_is_active(&(ss.tm_timeout)));
+        edio24_clock_forward(&clk, 500);
+        ret = edio24_pkt_create_cmd_doutr(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        edio24_loopback_pump(&lb);
+        REQUIRE(1 == log.cnt);
+        REQUIRE(EDIO24_CMD_DOUT_R == log.cmd[0]);
+        REQUIRE(1 == edio24_session_inflight(&ss));
+        edio24_clock_forward(&clk, 499);
+        REQUIRE(1 == log.cnt);
+        edio24_clock_forward(&clk, 1);
+        REQUIRE(2 == log.cnt);
+        REQUIRE(EDIO24_CMD_DIN_R == log.cmd[1]);
+        REQUIRE(EDIO24_STATUS_ERROR_TIMEOUT == log.status[1]);
+        REQUIRE(0 == log.frame[1]);
+        REQUIRE(1 == ss.stats.num_timeout);
+        REQUIRE(0 == edio24_session_inflight(&ss));
+        REQUIRE(0 == edio24_timer_is_active(&(ss.tm_timeout)));
+
+        // the timer is cancelled by the responses
+        for (i = 0; i < 3; i ++) {
+            ret = edio24_pkt_create_cmd_dinr(pkt, sizeof(pkt), &(ss.frame));
+            REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        }
+        edio24_loopback_pump(&lb);
+        REQUIRE(5 == log.cnt);
+        REQUIRE(0 == edio24_timer_is_active(&(ss.tm_timeout)));
+        edio24_clock_forward(&clk, 2000);
+        REQUIRE(5 == log.cnt);
+        REQUIRE(1 == ss.stats.num_timeout);
+
+        // the response after the timeout is not matched
+        ret = edio24_pkt_create_cmd_dinr(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        edio24_clock_forward(&clk, 1000);
+        REQUIRE(6 == log.cnt);
+        REQUIRE(EDIO24_STATUS_ERROR_TIMEOUT == log.status[5]);
+        REQUIRE(0 == ss.stats.num_error);
+        edio24_loopback_pump(&lb);
+        REQUIRE(6 == log.cnt);
+        REQUIRE(1 == ss.stats.num_error);
+
+        // the lost request is sent again
+        REQUIRE(0 == edio24_session_set_retry(&ss, &clk, 100, 10000));
+        num_drop = 1;
+        ret = edio24_pkt_create_cmd_dinr(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        edio24_loopback_pump(&lb);
+        edio24_clock_forward(&clk, 1000);
+        REQUIRE(6 == log.cnt);
+        REQUIRE(1 == edio24_session_inflight(&ss));
+        edio24_clock_forward(&clk, 100);
+        REQUIRE(1 == ss.stats.num_retry);
+        edio24_loopback_pump(&lb);
+        REQUIRE(7 == log.cnt);
+        REQUIRE(EDIO24_STATUS_SUCCESS == log.status[6]);
+        REQUIRE(0 == edio24_session_inflight(&ss));
+        REQUIRE(0 == edio24_timer_is_active(&(ss.tm_timeout)));
+
+        // cancelled
+        ret = edio24_pkt_create_cmd_dinr(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_cb, &log));
+        edio24_session_clean(&ss);
+        REQUIRE(1 == log.cnt_cancel);
+        REQUIRE(0 == edio24_timer_is_active(&(ss.tm_timeout)));
+        edio24_svrsession_clean(&svr);
+        edio24_loopback_clean(&lb);
+        edio24_clock_clean(&clk);
+    }
+    SECTION("test each of the requests in flight times out at its own deadline") {
+        memset(&dl, 0, sizeof(dl));
+        dl.pclk = &clk;
+        dl.timeout = 1000;
+        dl.interval = 3;
+        REQUIRE(0 == edio24_clock_init(&clk, 1));
+        REQUIRE(0 == edio24_loopback_init(&lb, 16));
+        REQUIRE(0 == edio24_session_init(&ss, edio24_loopback_client(&lb)));
+        REQUIRE(0 == edio24_svrsession_init(&svr, edio24_loopback_device(&lb), 0));
+        edio24_svrsession_set_process(&svr, test_session_drop_process, &num_drop);
+        REQUIRE(0 == edio24_session_set_timeout(&ss, &clk, dl.timeout));
+        num_drop = 3000;
+        for (i = 0; i < 3000; i ++) {
+            ret = edio24_pkt_create_cmd_dinr(pkt, sizeof(pkt), &(ss.frame));
+            REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_session_deadline_cb, &dl));
+            edio24_loopback_pump(&lb);
+            edio24_clock_forward(&clk, dl.interval);
+        }
+        REQUIRE(0 == dl.cnt_wrong);
+        for (i = 0; (i < 10000) && (edio24_session_inflight(&ss) > 0); i ++) {
+            edio24_clock_forward(&clk, 1);
+        }
+        REQUIRE(3000 == dl.cnt);
+        REQUIRE(0 == dl.cnt_wrong);
+        REQUIRE(3000 == ss.stats.num_timeout);
+        REQUIRE(0 == edio24_timer_is_active(&(ss.tm_timeout)));
+        edio24_svrsession_clean(&svr);
+        edio24_session_clean(&ss);
+        edio24_loopback_clean(&lb);
+        edio24_clock_clean(&clk);
+    }
+}
+
+#endif /* CIUT_ENABLED */
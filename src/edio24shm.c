@@ -0,0 +1,787 @@
+/**
+ * \file    edio24shm.c
+ * \brief   The latest states of the devices in a POSIX shared memory
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ *
+ * The publisher (edio24d) decodes the responses of the devices, and writes the states to a slot
+ * of each device in the shared memory. A slot is protected by a sequence lock: the sequence is odd
+ * while the publisher writes the state, and the readers copy the state and retry if the sequence
+ * changed. So the readers never block the publisher, and a snapshot costs a few loads
+ * without any system call once the memory is mapped.
+ *
+ * The ring of the samples keeps every value read from the devices, not only the latest one.
+ * The publisher writes the samples in order and never waits, each reader keeps its own cursor
+ * (the position of the next sample), and finds the samples it missed when the publisher
+ * overwrote them before they were read.
+ */
+
+#include <stdio.h>
+#include <string.h> // memmove()
+#include <assert.h>
+#include <fcntl.h>    // O_RDONLY
+#include <unistd.h>   // ftruncate()
+#include <sys/mman.h> // shm_open()
+#include <sys/stat.h>
+
+#include "edio24shm.h"
+
+/** the byte size of a slot, a slot is not shared by the cache lines of the other devices */
+#define EDIO24_SHM_SLOT_SIZE ((sizeof(edio24_shm_slot_t) + 63) / 64 * 64)
+
+#define SHM_SLOT(pshm, idx) ((edio24_shm_slot_t *)((uint8_t *)((pshm)->hdr) + (size_t)((pshm)->hdr->sz_slot) * ((idx) + 1)))
+
+#define EDIO24_SHM_RING_OFFSET 64 /**< the offset of the first entry of the ring */
+#define SHM_ENTRY(pring, pos) ((edio24_shm_entry_t *)((uint8_t *)((pring)->hdr) + EDIO24_SHM_RING_OFFSET + (size_t)((pring)->hdr->sz_entry) * ((pos) & ((pring)->hdr->num_entries - 1))))
+
+/**
+ * \brief update the state by a response of the device
+ * \param pst: the state
+ * \param pkt: the response packet
+ * \param sz: the byte size of the packet
+ * \param now: the microseconds since the Epoch
+ * \return 1 if the state is updated, 0 if the packet is not a state, <0 on error
+ */
+int
+edio24_shm_state_update (edio24_shm_state_t * pst, const uint8_t * pkt, size_t sz, uint64_t now)
+{
+    uint32_t flag;
+    uint32_t * pval;
+    uint32_t val = 0;
+    int ret;
+
+    if ((NULL == pst) || (NULL == pkt) || (sz < EDIO24_PKT_LENGTH_MIN)) {
+        return -1;
+    }
+    if ((EDIO24_PKT_START != pkt[0]) || (0 == (pkt[1] & EDIO24_PKT_REPLY)) || (EDIO24_STATUS_SUCCESS != pkt[3])) {
+        return 0;
+    }
+    switch (pkt[1] & ~EDIO24_PKT_REPLY) {
+    case EDIO24_CMD_DIN_R:
+        flag = EDIO24_SHM_DIN;
+        pval = &(pst->din);
+        ret = edio24_pkt_read_ret_dinr((uint8_t *)pkt, sz, &val);
+        break;
+    case EDIO24_CMD_DOUT_R:
+        flag = EDIO24_SHM_DOUT;
+        pval = &(pst->dout);
+        ret = edio24_pkt_read_ret_doutr((uint8_t *)pkt, sz, &val);
+        break;
+    case EDIO24_CMD_DCONF_R:
+        flag = EDIO24_SHM_DCONF;
+        pval = &(pst->dconf);
+        ret = edio24_pkt_read_ret_dconfr((uint8_t *)pkt, sz, &val);
+        break;
+    case EDIO24_CMD_COUNTER_R:
+        flag = EDIO24_SHM_COUNTER;
+        pval = &(pst->counter);
+        ret = edio24_pkt_read_ret_counterr((uint8_t *)pkt, sz, &val);
+        break;
+    case EDIO24_CMD_STATUS:
+        flag = EDIO24_SHM_STATUS;
+        pval = &(pst->status);
+        ret = edio24_pkt_read_ret_status((uint8_t *)pkt, sz, &val);
+        break;
+    default:
+        return 0;
+    }
+    if (ret < 0) {
+        return -1;
+    }
+    *pval = val;
+    pst->flags |= flag;
+    pst->time = now;
+    pst->num_update ++;
+    return 1;
+}
+
+/**
+ * \brief get a value of the state
+ * \param pst: the state
+ * \param cmd: the read command of the value, EDIO24_CMD_DIN_R etc.
+ * \param pval: return the value
+ * \return 0 on success, <0 if the value is not read yet or the command is not a state
+ */
+int
+edio24_shm_state_value (const edio24_shm_state_t * pst, uint8_t cmd, uint32_t * pval)
+{
+    uint32_t flag;
+    uint32_t val;
+
+    if ((NULL == pst) || (NULL == pval)) {
+        return -1;
+    }
+    switch (cmd) {
+    case EDIO24_CMD_DIN_R:     flag = EDIO24_SHM_DIN;     val = pst->din;     break;
+    case EDIO24_CMD_DOUT_R:    flag = EDIO24_SHM_DOUT;    val = pst->dout;    break;
+    case EDIO24_CMD_DCONF_R:   flag = EDIO24_SHM_DCONF;   val = pst->dconf;   break;
+    case EDIO24_CMD_COUNTER_R: flag = EDIO24_SHM_COUNTER; val = pst->counter; break;
+    case EDIO24_CMD_STATUS:    flag = EDIO24_SHM_STATUS;  val = pst->status;  break;
+    default:
+        return -1;
+    }
+    if (0 == (pst->flags & flag)) {
+        return -1;
+    }
+    *pval = val;
+    return 0;
+}
+
+/**
+ * \brief create a shared memory filled by 0, it's removed on error
+ * \return the file descriptor, <0 on error
+ */
+static int
+edio24_shm_create_fd (const char * name, size_t size)
+{
+    int fd;
+    fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "edio24 error in create shared memory '%s'\n", name);
+        return -1;
+    }
+    if (0 != ftruncate(fd, size)) {
+        close(fd);
+        shm_unlink(name);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * \brief map a shared memory
+ * \return 0 on success, <0 on error
+ */
+static int
+edio24_shm_map (edio24_shm_t * pshm, const char * name, int fd, size_t size, char flg_owner)
+{
+    void * p;
+    p = mmap(NULL, size, (flg_owner ? PROT_READ | PROT_WRITE : PROT_READ), MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == p) {
+        return -1;
+    }
+    pshm->hdr = (edio24_shm_hdr_t *)p;
+    pshm->size = size;
+    pshm->flg_owner = flg_owner;
+    snprintf(pshm->name, sizeof(pshm->name), "%s", name);
+    return 0;
+}
+
+/**
+ * \brief create the shared memory of the publisher, the states of the devices are cleared
+ * \param pshm: the shared memory
+ * \param name: the name of the shared memory, for example EDIO24_SHM_NAME
+ * \param num_devs: the number of the devices
+ * \return 0 on success, <0 on error
+ */
+int
+edio24_shm_create (edio24_shm_t * pshm, const char * name, size_t num_devs)
+{
+    size_t size;
+    int fd;
+
+    if ((NULL == pshm) || (NULL == name) || (num_devs < 1) || (strlen(name) >= sizeof(pshm->name))) {
+        return -1;
+    }
+    memset(pshm, 0, sizeof(*pshm));
+    size = EDIO24_SHM_SLOT_SIZE * (num_devs + 1);
+    fd = edio24_shm_create_fd(name, size);
+    if (fd < 0) {
+        return -1;
+    }
+    if (edio24_shm_map(pshm, name, fd, size, 1) < 0) {
+        shm_unlink(name);
+        return -1;
+    }
+    // the memory is filled by 0 by ftruncate()
+    pshm->hdr->version = EDIO24_SHM_VERSION;
+    pshm->hdr->num_devs = num_devs;
+    pshm->hdr->sz_slot = EDIO24_SHM_SLOT_SIZE;
+    __atomic_store_n(&(pshm->hdr->magic), EDIO24_SHM_MAGIC, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * \brief map the shared memory of the publisher for reading
+ * \param pshm: the shared memory
+ * \param name: the name of the shared memory
+ * \return 0 on success, <0 on error or the version is not supported
+ */
+int
+edio24_shm_open (edio24_shm_t * pshm, const char * name)
+{
+    struct stat st;
+    int fd;
+
+    if ((NULL == pshm) || (NULL == name) || (strlen(name) >= sizeof(pshm->name))) {
+        return -1;
+    }
+    memset(pshm, 0, sizeof(*pshm));
+    fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if ((0 != fstat(fd, &st)) || ((size_t)st.st_size < sizeof(edio24_shm_hdr_t))) {
+        close(fd);
+        return -1;
+    }
+    if (edio24_shm_map(pshm, name, fd, st.st_size, 0) < 0) {
+        return -1;
+    }
+    if ((EDIO24_SHM_MAGIC != __atomic_load_n(&(pshm->hdr->magic), __ATOMIC_ACQUIRE))
+        || (EDIO24_SHM_VERSION != pshm->hdr->version)
+        || (pshm->hdr->sz_slot < sizeof(edio24_shm_slot_t))
+        || ((size_t)(pshm->hdr->num_devs) + 1 > pshm->size / pshm->hdr->sz_slot)) {
+        fprintf(stderr, "edio24 error: unsupported shared memory '%s'\n", name);
+        edio24_shm_close(pshm);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * \brief unmap the shared memory, it's removed if it's created by edio24_shm_create()
+ */
+void
+edio24_shm_close (edio24_shm_t * pshm)
+{
+    if ((NULL == pshm) || (NULL == pshm->hdr)) {
+        return;
+    }
+    munmap(pshm->hdr, pshm->size);
+    if (pshm->flg_owner) {
+        shm_unlink(pshm->name);
+    }
+    pshm->hdr = NULL;
+    pshm->size = 0;
+}
+
+/**
+ * \brief write the state of a device, by the only one publisher
+ * \param pshm: the shared memory created by edio24_shm_create()
+ * \param idx: the index of the device
+ * \param pst: the state
+ * \return 0 on success, <0 on error
+ */
+int
+edio24_shm_publish (edio24_shm_t * pshm, size_t idx, const edio24_shm_state_t * pst)
+{
+    edio24_shm_slot_t * pslot;
+    uint32_t seq;
+
+    if ((NULL == pshm) || (NULL == pshm->hdr) || (! pshm->flg_owner) || (NULL == pst) || (idx >= pshm->hdr->num_devs)) {
+        return -1;
+    }
+    pslot = SHM_SLOT(pshm, idx);
+    seq = pslot->seq;
+    __atomic_store_n(&(pslot->seq), seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&(pslot->state.flags),      pst->flags,      __ATOMIC_RELAXED);
+    __atomic_store_n(&(pslot->state.din),        pst->din,        __ATOMIC_RELAXED);
+    __atomic_store_n(&(pslot->state.dout),       pst->dout,       __ATOMIC_RELAXED);
+    __atomic_store_n(&(pslot->state.dconf),      pst->dconf,      __ATOMIC_RELAXED);
+    __atomic_store_n(&(pslot->state.counter),    pst->counter,    __ATOMIC_RELAXED);
+    __atomic_store_n(&(pslot->state.status),     pst->status,     __ATOMIC_RELAXED);
+    __atomic_store_n(&(pslot->state.time),       pst->time,       __ATOMIC_RELAXED);
+    __atomic_store_n(&(pslot->state.num_update), pst->num_update, __ATOMIC_RELAXED);
+    __atomic_store_n(&(pslot->seq), seq + 2, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * \brief read a consistent snapshot of the state of a device
+ * \param pshm: the shared memory
+ * \param idx: the index of the device
+ * \param pst: return the state
+ * \return 0 on success, <0 on error or the slot is being written for too long
+ */
+int
+edio24_shm_read (const edio24_shm_t * pshm, size_t idx, edio24_shm_state_t * pst)
+{
+    edio24_shm_slot_t * pslot;
+    uint32_t seq;
+    size_t i;
+
+    if ((NULL == pshm) || (NULL == pshm->hdr) || (NULL == pst) || (idx >= pshm->hdr->num_devs)) {
+        return -1;
+    }
+    pslot = SHM_SLOT(pshm, idx);
+    for (i = 0; i < EDIO24_SHM_READ_RETRY; i ++) {
+        seq = __atomic_load_n(&(pslot->seq), __ATOMIC_ACQUIRE);
+        if (seq & 0x01) {
+            continue;
+        }
+        pst->flags      = __atomic_load_n(&(pslot->state.flags),      __ATOMIC_RELAXED);
+        pst->din        = __atomic_load_n(&(pslot->state.din),        __ATOMIC_RELAXED);
+        pst->dout       = __atomic_load_n(&(pslot->state.dout),       __ATOMIC_RELAXED);
+        pst->dconf      = __atomic_load_n(&(pslot->state.dconf),      __ATOMIC_RELAXED);
+        pst->counter    = __atomic_load_n(&(pslot->state.counter),    __ATOMIC_RELAXED);
+        pst->status     = __atomic_load_n(&(pslot->state.status),     __ATOMIC_RELAXED);
+        pst->time       = __atomic_load_n(&(pslot->state.time),       __ATOMIC_RELAXED);
+        pst->num_update = __atomic_load_n(&(pslot->state.num_update), __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (seq == __atomic_load_n(&(pslot->seq), __ATOMIC_RELAXED)) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*****************************************************************************/
+/**
+ * \brief create the ring of the samples of the publisher
+ * \param pring: the ring
+ * \param name: the name of the shared memory
+ * \param num_entries: the number of the samples kept, rounded up to a power of 2
+ * \return 0 on success, <0 on error
+ */
+int
+edio24_shm_ring_create (edio24_shm_ring_t * pring, const char * name, size_t num_entries)
+{
+    size_t num = 1;
+    size_t size;
+    void * p;
+    int fd;
+
+    if ((NULL == pring) || (NULL == name) || (num_entries < 1) || (num_entries > 0x80000000UL) || (strlen(name) >= sizeof(pring->name))) {
+        return -1;
+    }
+    memset(pring, 0, sizeof(*pring));
+    while (num < num_entries) {
+        num <<= 1;
+    }
+    size = EDIO24_SHM_RING_OFFSET + sizeof(edio24_shm_entry_t) * num;
+    fd = edio24_shm_create_fd(name, size);
+    if (fd < 0) {
+        return -1;
+    }
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == p) {
+        shm_unlink(name);
+        return -1;
+    }
+    pring->hdr = (edio24_shm_ring_hdr_t *)p;
+    pring->size = size;
+    pring->flg_owner = 1;
+    snprintf(pring->name, sizeof(pring->name), "%s", name);
+    pring->hdr->version = EDIO24_SHM_RING_VERSION;
+    pring->hdr->num_entries = num;
+    pring->hdr->sz_entry = sizeof(edio24_shm_entry_t);
+    __atomic_store_n(&(pring->hdr->magic), EDIO24_SHM_RING_MAGIC, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * \brief map the ring of the publisher for reading
+ * \param pring: the ring
+ * \param name: the name of the shared memory
+ * \return 0 on success, <0 on error or the version is not supported
+ */
+int
+edio24_shm_ring_open (edio24_shm_ring_t * pring, const char * name)
+{
+    struct stat st;
+    void * p;
+    uint32_t num;
+    int fd;
+
+    if ((NULL == pring) || (NULL == name) || (strlen(name) >= sizeof(pring->name))) {
+        return -1;
+    }
+    memset(pring, 0, sizeof(*pring));
+    fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if ((0 != fstat(fd, &st)) || ((size_t)st.st_size < EDIO24_SHM_RING_OFFSET)) {
+        close(fd);
+        return -1;
+    }
+    p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == p) {
+        return -1;
+    }
+    pring->hdr = (edio24_shm_ring_hdr_t *)p;
+    pring->size = st.st_size;
+    snprintf(pring->name, sizeof(pring->name), "%s", name);
+    num = pring->hdr->num_entries;
+    if ((EDIO24_SHM_RING_MAGIC != __atomic_load_n(&(pring->hdr->magic), __ATOMIC_ACQUIRE))
+        || (EDIO24_SHM_RING_VERSION != pring->hdr->version)
+        || (pring->hdr->sz_entry < sizeof(edio24_shm_entry_t))
+        || (num < 1) || (0 != (num & (num - 1)))
+        || (EDIO24_SHM_RING_OFFSET + (size_t)(pring->hdr->sz_entry) * num > pring->size)) {
+        fprintf(stderr, "edio24 error: unsupported shared memory '%s'\n", name);
+        edio24_shm_ring_close(pring);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * \brief unmap the ring, it's removed if it's created by edio24_shm_ring_create()
+ */
+void
+edio24_shm_ring_close (edio24_shm_ring_t * pring)
+{
+    if ((NULL == pring) || (NULL == pring->hdr)) {
+        return;
+    }
+    munmap(pring->hdr, pring->size);
+    if (pring->flg_owner) {
+        shm_unlink(pring->name);
+    }
+    pring->hdr = NULL;
+    pring->size = 0;
+}
+
+/**
+ * \brief append a sample to the ring by the only one publisher, the oldest sample is overwritten
+ * \param pring: the ring created by edio24_shm_ring_create()
+ * \param psample: the sample
+ * \return 0 on success, <0 on error
+ */
+int
+edio24_shm_ring_push (edio24_shm_ring_t * pring, const edio24_shm_sample_t * psample)
+{
+    edio24_shm_entry_t * pent;
+    uint64_t pos;
+
+    if ((NULL == pring) || (NULL == pring->hdr) || (! pring->flg_owner) || (NULL == psample)) {
+        return -1;
+    }
+    pos = pring->hdr->head;
+    pent = SHM_ENTRY(pring, pos);
+    __atomic_store_n(&(pent->seq), 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&(pent->sample.time),   psample->time,   __ATOMIC_RELAXED);
+    __atomic_store_n(&(pent->sample.device), psample->device, __ATOMIC_RELAXED);
+    __atomic_store_n(&(pent->sample.cmd),    psample->cmd,    __ATOMIC_RELAXED);
+    __atomic_store_n(&(pent->sample.value),  psample->value,  __ATOMIC_RELAXED);
+    __atomic_store_n(&(pent->seq), pos + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&(pring->hdr->head), pos + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * \brief the position of the next sample to be written
+ *
+ * A new reader starts from here to get the new samples only,
+ * or from 0 to get all of the samples still in the ring.
+ */
+uint64_t
+edio24_shm_ring_head (const edio24_shm_ring_t * pring)
+{
+    if ((NULL == pring) || (NULL == pring->hdr)) {
+        return 0;
+    }
+    return __atomic_load_n(&(pring->hdr->head), __ATOMIC_ACQUIRE);
+}
+
+/**
+ * \brief read the samples from the cursor of a reader
+ * \param pring: the ring
+ * \param pcursor: the position of the next sample of the reader, it's moved after the samples read
+ * \param samples: return the samples
+ * \param num: the max number of the samples
+ * \param num_lost: add the number of the samples overwritten before they were read, can be NULL
+ * \return the number of the samples read, 0 if no new sample, <0 on error
+ */
+ssize_t
+edio24_shm_ring_read (const edio24_shm_ring_t * pring, uint64_t * pcursor, edio24_shm_sample_t * samples, size_t num, uint64_t * num_lost)
+{
+    edio24_shm_entry_t * pent;
+    uint64_t lost = 0;
+    uint64_t head;
+    uint64_t pos;
+    uint64_t seq;
+    size_t i = 0;
+
+    if ((NULL == pring) || (NULL == pring->hdr) || (NULL == pcursor) || (NULL == samples)) {
+        return -1;
+    }
+    pos = *pcursor;
+    head = __atomic_load_n(&(pring->hdr->head), __ATOMIC_ACQUIRE);
+    if (pos > head) {
+        return -1; // the ring is created again by the publisher
+    }
+    while ((i < num) && (pos < head)) {
+        if (head - pos > pring->hdr->num_entries) {
+            lost += head - pos - pring->hdr->num_entries;
+            pos = head - pring->hdr->num_entries;
+        }
+        pent = SHM_ENTRY(pring, pos);
+        seq = __atomic_load_n(&(pent->seq), __ATOMIC_ACQUIRE);
+        samples[i].time     = __atomic_load_n(&(pent->sample.time),   __ATOMIC_RELAXED);
+        samples[i].device   = __atomic_load_n(&(pent->sample.device), __ATOMIC_RELAXED);
+        samples[i].cmd      = __atomic_load_n(&(pent->sample.cmd),    __ATOMIC_RELAXED);
+        samples[i].reserved = 0;
+        samples[i].value    = __atomic_load_n(&(pent->sample.value),  __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if ((pos + 1 == seq) && (seq == __atomic_load_n(&(pent->seq), __ATOMIC_RELAXED))) {
+            i ++;
+        } else {
+            // overwritten by the publisher while being read
+            lost ++;
+        }
+        pos ++;
+        if (pos >= head) {
+            head = __atomic_load_n(&(pring->hdr->head), __ATOMIC_ACQUIRE);
+        }
+    }
+    *pcursor = pos;
+    if (NULL != num_lost) {
+        *num_lost += lost;
+    }
+    return i;
+}
+
+#if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
+#include <ciut.h>
+#include <time.h> // clock_gettime()
+#include <sys/wait.h> // waitpid()
+
+TEST_CASE( .name="edio24-shm", .description="test the states of the devices in the shared memory.", .skip=0 ) {
+    edio24_shm_t pub;
+    edio24_shm_t sub;
+    edio24_shm_state_t st;
+    edio24_shm_state_t st2;
+    uint8_t pkt[EDIO24_PKT_LENGTH_MIN + 4];
+    uint8_t data[4] = { 0x01, 0x02, 0x03, 0x04 };
+    uint8_t frame = 0;
+    char name[64];
+    ssize_t ret;
+
+    snprintf(name, sizeof(name), "/edio24-test-%d", (int)getpid());
+
+    SECTION("test edio24_shm_state_update") {
+        memset(&st, 0, sizeof(st));
+        memset(pkt, 0, sizeof(pkt));
+        REQUIRE(0 > edio24_shm_state_update(NULL, pkt, sizeof(pkt), 0));
+        REQUIRE(0 > edio24_shm_state_update(&st, NULL, sizeof(pkt), 0));
+        ret = edio24_pkt_create_respond(pkt, sizeof(pkt), EDIO24_CMD_DIN_R, 5, 0, 3, data);
+        REQUIRE(ret > 0);
+        REQUIRE(0 > edio24_shm_state_update(&st, pkt, 3, 0));
+        REQUIRE(1 == edio24_shm_state_update(&st, pkt, ret, 100));
+        REQUIRE(EDIO24_SHM_DIN == st.flags);
+        REQUIRE(0x030201 == st.din);
+        REQUIRE(100 == st.time);
+        ret = edio24_pkt_create_respond(pkt, sizeof(pkt), EDIO24_CMD_COUNTER_R, 6, 0, 4, data);
+        REQUIRE(1 == edio24_shm_state_update(&st, pkt, ret, 200));
+        REQUIRE(0x04030201 == st.counter);
+        REQUIRE((EDIO24_SHM_DIN | EDIO24_SHM_COUNTER) == st.flags);
+        REQUIRE(2 == st.num_update);
+        // the failed responses, the writes and the requests are not the states
+        ret = edio24_pkt_create_respond(pkt, sizeof(pkt), EDIO24_CMD_DOUT_R, 7, EDIO24_STATUS_ERROR_BUSY, 3, data);
+        REQUIRE(0 == edio24_shm_state_update(&st, pkt, ret, 300));
+        ret = edio24_pkt_create_respond(pkt, sizeof(pkt), EDIO24_CMD_DOUT_W, 8, 0, 0, NULL);
+        REQUIRE(0 == edio24_shm_state_update(&st, pkt, ret, 300));
+        ret = edio24_pkt_create_cmd_dinr(pkt, sizeof(pkt), &frame);
+        REQUIRE(0 == edio24_shm_state_update(&st, pkt, ret, 300));
+        REQUIRE(2 == st.num_update);
+    }
+    SECTION("test publish and read") {
+        REQUIRE(0 > edio24_shm_create(&pub, name, 0));
+        REQUIRE(0 > edio24_shm_open(&sub, name));
+        REQUIRE(0 == edio24_shm_create(&pub, name, 3));
+        REQUIRE(0 == edio24_shm_open(&sub, name));
+        REQUIRE(3 == edio24_shm_num_devs(&sub));
+        REQUIRE(0 == (sub.hdr->sz_slot % 64));
+
+        REQUIRE(0 == edio24_shm_read(&sub, 2, &st2));
+        REQUIRE(0 == st2.flags);
+        REQUIRE(0 > edio24_shm_read(&sub, 3, &st2));
+        memset(&st, 0, sizeof(st));
+        st.flags = EDIO24_SHM_CONNECTED | EDIO24_SHM_DOUT;
+        st.dout = 0x123456;
+        st.time = 0x1122334455667788ULL;
+        st.num_update = 9;
+        REQUIRE(0 > edio24_shm_publish(&sub, 2, &st));
+        REQUIRE(0 > edio24_shm_publish(&pub, 3, &st));
+        REQUIRE(0 == edio24_shm_publish(&pub, 2, &st));
+        REQUIRE(0 == edio24_shm_read(&sub, 2, &st2));
+        REQUIRE(0 == memcmp(&st, &st2, sizeof(st)));
+        REQUIRE(0 == edio24_shm_read(&sub, 1, &st2));
+        REQUIRE(0 == st2.flags);
+
+        // the slot being written
+        SHM_SLOT(&pub, 2)->seq ++;
+        REQUIRE(0 > edio24_shm_read(&sub, 2, &st2));
+        SHM_SLOT(&pub, 2)->seq ++;
+        REQUIRE(0 == edio24_shm_read(&sub, 2, &st2));
+
+        edio24_shm_close(&sub);
+        edio24_shm_close(&pub);
+        REQUIRE(0 > edio24_shm_open(&sub, name));
+    }
+    SECTION("test the speed of edio24_shm_read") {
+        struct timespec ts0;
+        struct timespec ts1;
+        size_t i;
+        size_t num = 0;
+        uint64_t ns;
+
+        REQUIRE(0 == edio24_shm_create(&pub, name, 1));
+        REQUIRE(0 == edio24_shm_open(&sub, name));
+        memset(&st, 0, sizeof(st));
+        st.din = 1;
+        REQUIRE(0 == edio24_shm_publish(&pub, 0, &st));
+        clock_gettime(CLOCK_MONOTONIC, &ts0);
+        for (i = 0; i < 10000000; i ++) {
+            if ((0 == edio24_shm_read(&sub, 0, &st2)) && (1 == st2.din)) {
+                num ++;
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &ts1);
+        ns = (ts1.tv_sec - ts0.tv_sec) * 1000000000 + (ts1.tv_nsec - ts0.tv_nsec);
+        REQUIRE(10000000 == num);
+        CIUT_LOG("read %" PRIuSZ " snapshots in %" PRIu64 " nanoseconds", num, ns);
+        edio24_shm_close(&sub);
+        edio24_shm_close(&pub);
+    }
+}
+
+TEST_CASE( .name="edio24-shm-ring", .description="test the ring of the samples in the shared memory.", .skip=0 ) {
+    edio24_shm_ring_t pub;
+    edio24_shm_ring_t sub;
+    edio24_shm_sample_t sample;
+    edio24_shm_sample_t samples[8];
+    edio24_shm_state_t st;
+    uint64_t cursor;
+    uint64_t cursor2;
+    uint64_t lost;
+    uint32_t val;
+    char name[64];
+    size_t i;
+
+    snprintf(name, sizeof(name), "/edio24-test-ring-%d", (int)getpid());
+    memset(&sample, 0, sizeof(sample));
+
+    SECTION("test edio24_shm_state_value") {
+        memset(&st, 0, sizeof(st));
+        REQUIRE(0 > edio24_shm_state_value(&st, EDIO24_CMD_DIN_R, &val));
+        st.flags = EDIO24_SHM_DIN | EDIO24_SHM_COUNTER;
+        st.din = 0x12;
+        st.counter = 0x34;
+        REQUIRE(0 == edio24_shm_state_value(&st, EDIO24_CMD_DIN_R, &val));
+        REQUIRE(0x12 == val);
+        REQUIRE(0 == edio24_shm_state_value(&st, EDIO24_CMD_COUNTER_R, &val));
+        REQUIRE(0x34 == val);
+        REQUIRE(0 > edio24_shm_state_value(&st, EDIO24_CMD_DOUT_R, &val));
+        REQUIRE(0 > edio24_shm_state_value(&st, EDIO24_CMD_DOUT_W, &val));
+    }
+    SECTION("test push and read") {
+        REQUIRE(0 > edio24_shm_ring_create(&pub, name, 0));
+        REQUIRE(0 > edio24_shm_ring_open(&sub, name));
+        REQUIRE(0 == edio24_shm_ring_create(&pub, name, 5));
+        REQUIRE(8 == pub.hdr->num_entries);
+        REQUIRE(0 == edio24_shm_ring_open(&sub, name));
+        REQUIRE(0 > edio24_shm_ring_push(&sub, &sample));
+
+        cursor = edio24_shm_ring_head(&sub);
+        REQUIRE(0 == cursor);
+        REQUIRE(0 == edio24_shm_ring_read(&sub, &cursor, samples, NUM_ARRAY(samples), NULL));
+        for (i = 0; i < 3; i ++) {
+            sample.time = 1000 + i;
+            sample.device = i;
+            sample.cmd = EDIO24_CMD_DIN_R;
+            sample.value = 0x100 + i;
+            REQUIRE(0 == edio24_shm_ring_push(&pub, &sample));
+        }
+        // the readers have their own cursors
+        cursor2 = 1;
+        REQUIRE(2 == edio24_shm_ring_read(&sub, &cursor, samples, 2, NULL));
+        REQUIRE(2 == cursor);
+        REQUIRE(1000 == samples[0].time);
+        REQUIRE(1 == samples[1].device);
+        REQUIRE(0x101 == samples[1].value);
+        REQUIRE(EDIO24_CMD_DIN_R == samples[1].cmd);
+        REQUIRE(1 == edio24_shm_ring_read(&sub, &cursor, samples, NUM_ARRAY(samples), NULL));
+        REQUIRE(0x102 == samples[0].value);
+        REQUIRE(0 == edio24_shm_ring_read(&sub, &cursor, samples, NUM_ARRAY(samples), NULL));
+        REQUIRE(2 == edio24_shm_ring_read(&sub, &cursor2, samples, NUM_ARRAY(samples), NULL));
+        REQUIRE(0x101 == samples[0].value);
+        REQUIRE(3 == edio24_shm_ring_head(&sub));
+
+        // a cursor ahead of the publisher
+        cursor2 = 4;
+        REQUIRE(0 > edio24_shm_ring_read(&sub, &cursor2, samples, NUM_ARRAY(samples), NULL));
+
+        edio24_shm_ring_close(&sub);
+        edio24_shm_ring_close(&pub);
+        REQUIRE(0 > edio24_shm_ring_open(&sub, name));
+    }
+    SECTION("test the overrun") {
+        REQUIRE(0 == edio24_shm_ring_create(&pub, name, 8));
+        REQUIRE(0 == edio24_shm_ring_open(&sub, name));
+        cursor = 0;
+        for (i = 0; i < 20; i ++) {
+            sample.value = i;
+            REQUIRE(0 == edio24_shm_ring_push(&pub, &sample));
+        }
+        lost = 0;
+        REQUIRE(3 == edio24_shm_ring_read(&sub, &cursor, samples, 3, &lost));
+        REQUIRE(12 == lost);
+        REQUIRE(12 == samples[0].value);
+        REQUIRE(14 == samples[2].value);
+        REQUIRE(15 == cursor);
+        REQUIRE(5 == edio24_shm_ring_read(&sub, &cursor, samples, NUM_ARRAY(samples), &lost));
+        REQUIRE(19 == samples[4].value);
+        REQUIRE(12 == lost);
+
+        // the entry being overwritten
+        cursor = 19;
+        SHM_ENTRY(&pub, 19)->seq = 0;
+        REQUIRE(0 == edio24_shm_ring_read(&sub, &cursor, samples, NUM_ARRAY(samples), &lost));
+        REQUIRE(13 == lost);
+        REQUIRE(20 == cursor);
+        edio24_shm_ring_close(&sub);
+        edio24_shm_ring_close(&pub);
+    }
+    SECTION("test a reader process") {
+        pid_t pid;
+        int status = -1;
+        uint64_t num = 0;
+        uint64_t num_total = 2000000;
+        uint32_t last = 0;
+        char flg_order = 1;
+        ssize_t ret;
+
+        REQUIRE(0 == edio24_shm_ring_create(&pub, name, 1024));
+        REQUIRE(0 == edio24_shm_ring_open(&sub, name));
+        pid = fork();
+        REQUIRE(pid >= 0);
+        if (0 == pid) {
+            for (i = 1; i <= num_total; i ++) {
+                sample.value = i;
+                edio24_shm_ring_push(&pub, &sample);
+            }
+            _exit(0);
+        }
+        cursor = 0;
+        lost = 0;
+        while (cursor < num_total) {
+            ret = edio24_shm_ring_read(&sub, &cursor, samples, NUM_ARRAY(samples), &lost);
+            for (i = 0; (ret > 0) && (i < (size_t)ret); i ++) {
+                if (samples[i].value <= last) {
+                    flg_order = 0;
+                }
+                last = samples[i].value;
+            }
+            if (ret > 0) {
+                num += ret;
+            }
+        }
+        waitpid(pid, &status, 0);
+        REQUIRE(0 == status);
+        REQUIRE(flg_order);
+        REQUIRE(num_total == num + lost);
+        CIUT_LOG("read %" PRIu64 " samples, lost %" PRIu64, num, lost);
+        edio24_shm_ring_close(&sub);
+        edio24_shm_ring_close(&pub);
+    }
+}
+
+#endif /* CIUT_ENABLED */
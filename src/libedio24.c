@@ -28,39 +28,39 @@
 #endif
 
 // Digital I/O Commands
-#define CMD_DIN_R            (0x00)  // Read DIO pins
-#define CMD_DOUT_R           (0x02)  // Read DIO latch value
-#define CMD_DOUT_W           (0x03)  // Write DIO latch value
-#define CMD_DCONF_R          (0x04)  // Read DIO configuration value
-#define CMD_DCONF_W          (0x05)  // Write DIO Configuration value
+#define CMD_DIN_R            EDIO24_CMD_DIN_R               // Read DIO pins
+#define CMD_DOUT_R           EDIO24_CMD_DOUT_R              // Read DIO latch value
+#define CMD_DOUT_W           EDIO24_CMD_DOUT_W              // Write DIO latch value
+#define CMD_DCONF_R          EDIO24_CMD_DCONF_R             // Read DIO configuration value
+#define CMD_DCONF_W          EDIO24_CMD_DCONF_W             // Write DIO Configuration value
 // Counter Commands
-#define CMD_COUNTER_R        (0x30)  // Read event counter
-#define CMD_COUNTER_W        (0x31)  // Reset event counter
+#define CMD_COUNTER_R        EDIO24_CMD_COUNTER_R           // Read event counter
+#define CMD_COUNTER_W        EDIO24_CMD_COUNTER_W           // Reset event counter
 // Memory Commands
-#define CMD_CONF_MEM_R       (0x40)  // Read configuration memeory
-#define CMD_CONF_MEM_W       (0x41)  // Write configuration memory
-#define CMD_USR_MEM_R        (0x42)  // Read user memory
-#define CMD_USR_MEM_W        (0x43)  // Write user memory
-#define CMD_SET_MEM_R        (0x44)  // Read settings memory
-#define CMD_SET_MEM_W        (0x45)  // Write settings memory
-#define CMD_BOOT_MEM_R       (0x46)  // Read bootloader memory
-#define CMD_BOOT_MEM_W       (0x47)  // Write bootloader memory
+#define CMD_CONF_MEM_R       EDIO24_CMD_CONF_MEM_R          // Read configuration memeory
+#define CMD_CONF_MEM_W       EDIO24_CMD_CONF_MEM_W          // Write configuration memory
+#define CMD_USR_MEM_R        EDIO24_CMD_USR_MEM_R           // Read user memory
+#define CMD_USR_MEM_W        EDIO24_CMD_USR_MEM_W           // Write user memory
+#define CMD_SET_MEM_R        EDIO24_CMD_SET_MEM_R           // Read settings memory
+#define CMD_SET_MEM_W        EDIO24_CMD_SET_MEM_W           // Write settings memory
+#define CMD_BOOT_MEM_R       EDIO24_CMD_BOOT_MEM_R          // Read bootloader memory
+#define CMD_BOOT_MEM_W       EDIO24_CMD_BOOT_MEM_W          // Write bootloader memory
 // Miscellaneous Commands
-#define CMD_BLINKLED         (0x50)  // Blink the LED
-#define CMD_RESET            (0x51)  // Reset the device
-#define CMD_STATUS           (0x52)  // Read the device status
-#define CMD_NETWORK_CONF     (0x54)  // Read device network configuration
-#define CMD_FIRMWARE         (0x60)  // Enter bootloader for firmware upgrade
-
-#define MSG_SUCCESS         0   // Command succeeded
-#define MSG_ERROR_PROTOCOL  1   // Command failed due to improper protocol
+#define CMD_BLINKLED         EDIO24_CMD_BLINKLED            // Blink the LED
+#define CMD_RESET            EDIO24_CMD_RESET               // Reset the device
+#define CMD_STATUS           EDIO24_CMD_STATUS              // Read the device status
+#define CMD_NETWORK_CONF     EDIO24_CMD_NETWORK_CONF        // Read device network configuration
+#define CMD_FIRMWARE         EDIO24_CMD_FIRMWARE            // Enter bootloader for firmware upgrade
+
+#define MSG_SUCCESS          EDIO24_STATUS_SUCCESS          // Command succeeded
+#define MSG_ERROR_PROTOCOL   EDIO24_STATUS_ERROR_PROTOCOL   // Command failed due to improper protocol
 // (number of expected data bytes did not match protocol definition)
-#define MSG_ERROR_PARAMETER 2   // Command failed due to invalid parameters
+#define MSG_ERROR_PARAMETER  EDIO24_STATUS_ERROR_PARAMETER  // Command failed due to invalid parameters
 // (the data contents were incorrect)
-#define MSG_ERROR_BUSY      3   // Command failed because resource was busy
-#define MSG_ERROR_READY     4   // Command failed because the resource was not ready
-#define MSG_ERROR_TIMEOUT   5   // Command failed due to a resource timeout
-#define MSG_ERROR_OTHER     6   // Command failed due to some other error
+#define MSG_ERROR_BUSY       EDIO24_STATUS_ERROR_BUSY       // Command failed because resource was busy
+#define MSG_ERROR_READY      EDIO24_STATUS_ERROR_READY      // Command failed because the resource was not ready
+#define MSG_ERROR_TIMEOUT    EDIO24_STATUS_ERROR_TIMEOUT    // Command failed due to a resource timeout
+#define MSG_ERROR_OTHER      EDIO24_STATUS_ERROR_OTHER      // Command failed due to some other error
 
 #define MSG_HEADER_SIZE     6
 #define MSG_CHECKSUM_SIZE   1
@@ -792,6 +792,49 @@ edio24_pkt_create_cmd_dconfw (uint8_t *buffer, size_t sz_buf, uint8_t * frame_id
     return ret;
 }
 
+/**
+ * \brief retrive a byte form the packet header
+ * \param buffer:   the buffer contains the packet
+ * \param sz_buf:   the byte size of the packet
+ * \param idx:      the index of the byte
+ * \param value:    the content of the byte
+ * \return <0 on fail, =0 success
+ */
+static int
+edio24_pkt_read_hdr_byte (uint8_t *buffer, size_t sz_buf, size_t idx, uint8_t * value)
+{
+    if (NULL == buffer) {
+        return -1;
+    }
+    if (idx >= sz_buf) {
+        return -1;
+    }
+    if (NULL == value) {
+        return -1;
+    }
+    assert (NULL != buffer);
+    *value = buffer[idx];
+    return 0;
+}
+
+int
+edio24_pkt_read_hdr_start (uint8_t *buffer, size_t sz_buf, uint8_t * value)
+{
+    return edio24_pkt_read_hdr_byte (buffer, sz_buf, MSG_INDEX_START, value);
+}
+
+int
+edio24_pkt_read_hdr_frameid (uint8_t *buffer, size_t sz_buf, uint8_t * value)
+{
+    return edio24_pkt_read_hdr_byte (buffer, sz_buf, MSG_INDEX_FRAME, value);
+}
+
+int
+edio24_pkt_read_hdr_status (uint8_t *buffer, size_t sz_buf, uint8_t * value)
+{
+    return edio24_pkt_read_hdr_byte (buffer, sz_buf, MSG_INDEX_STATUS, value);
+}
+
 int
 edio24_pkt_read_hdr_command (uint8_t *buffer, size_t sz_buf, uint8_t * value)
 {
@@ -1310,6 +1353,8 @@ edio24_cli_verify_tcp(uint8_t * buffer_in, size_t sz_in, size_t * sz_processed,
     case CMD_USR_MEM_W:
     case CMD_SET_MEM_W:
     case CMD_BOOT_MEM_W:
+    case CMD_RESET:
+    case CMD_FIRMWARE:
         break;
     case CMD_COUNTER_R:
     {
@@ -1485,6 +1530,8 @@ edio24_svr_process_tcp(char flg_force_fail, uint8_t * buffer_in, size_t sz_in,
     case CMD_USR_MEM_W:
     case CMD_SET_MEM_W:
     case CMD_BOOT_MEM_W:
+    case CMD_RESET:
+    case CMD_FIRMWARE:
         break;
     case CMD_COUNTER_R:
         len_data = 4;
@@ -1573,7 +1620,7 @@ edio24_svr_process_tcp(char flg_force_fail, uint8_t * buffer_in, size_t sz_in,
     for (i = 0; i < len_data; i ++) {
         buffer_out[MSG_INDEX_DATA + i] = (1 + i) & 0xFF;
     }
-    edio24_pkt_create_respond (buffer_out, sizeof(buffer_out), cmd, buffer_in[MSG_INDEX_FRAME], status, len_data, buffer_out);
+    edio24_pkt_create_respond (buffer_out, *sz_out, cmd, buffer_in[MSG_INDEX_FRAME], status, len_data, buffer_out + MSG_INDEX_DATA);
 
     assert (NULL != sz_processed);
     assert (NULL != sz_out);
@@ -2221,6 +2268,45 @@ TEST_CASE( .name="edio24-svr-process", .description="test edio24_svr_process_xxx
         REQUIRE(0 == sz_needed_out);
         REQUIRE(0 == sz_out);
     }
+    SECTION("test the tcp responses with data") {
+        uint8_t buffer_out[100];
+        uint8_t frame_id = 0x35;
+        uint8_t val8 = 0;
+        size_t sz_out;
+        size_t sz_processed;
+        size_t sz_needed_in;
+        size_t sz_needed_out;
+
+        ret = edio24_pkt_create_cmd_status(buffer, sizeof(buffer), &frame_id);
+        REQUIRE(0 < ret);
+        sz_out = sizeof(buffer_out);
+        REQUIRE(0 == edio24_svr_process_tcp(0, buffer, ret, buffer_out, &sz_out, &sz_processed, &sz_needed_in, &sz_needed_out));
+        REQUIRE(ret == sz_processed);
+        REQUIRE(EDIO24_PKT_LENGTH_MIN + 2 == sz_out);
+        REQUIRE(0 == edio24_pkt_verify(buffer_out, sz_out));
+        REQUIRE(0 == edio24_pkt_read_hdr_start(buffer_out, sz_out, &val8));
+        REQUIRE(EDIO24_PKT_START == val8);
+        REQUIRE(0 == edio24_pkt_read_hdr_command(buffer_out, sz_out, &val8));
+        REQUIRE((CMD_STATUS | EDIO24_PKT_REPLY) == val8);
+        REQUIRE(0 == edio24_pkt_read_hdr_frameid(buffer_out, sz_out, &val8));
+        REQUIRE(0x35 == val8);
+        REQUIRE(0 == edio24_pkt_read_hdr_status(buffer_out, sz_out, &val8));
+        REQUIRE(MSG_SUCCESS == val8);
+        REQUIRE(0 == edio24_cli_verify_tcp(buffer_out, sz_out, &sz_processed, &sz_needed_in));
+        REQUIRE(sz_out == sz_processed);
+
+        ret = edio24_pkt_create_cmd_netconf(buffer, sizeof(buffer), &frame_id);
+        REQUIRE(0 < ret);
+        sz_out = sizeof(buffer_out);
+        REQUIRE(0 == edio24_svr_process_tcp(0, buffer, ret, buffer_out, &sz_out, &sz_processed, &sz_needed_in, &sz_needed_out));
+        REQUIRE(EDIO24_PKT_LENGTH_MIN + 12 == sz_out);
+        REQUIRE(0 == edio24_pkt_verify(buffer_out, sz_out));
+        REQUIRE(1 == buffer_out[EDIO24_PKT_OFFSET_DATA]);
+        REQUIRE(12 == buffer_out[EDIO24_PKT_OFFSET_DATA + 11]);
+        REQUIRE(0 > edio24_pkt_read_hdr_frameid(NULL, sz_out, &val8));
+        REQUIRE(0 > edio24_pkt_read_hdr_frameid(buffer_out, 2, &val8));
+        REQUIRE(0 > edio24_pkt_read_hdr_status(buffer_out, sz_out, NULL));
+    }
 }
 
 #endif /* CIUT_ENABLED */
@@ -0,0 +1,815 @@
+/**
+ * \file    libedio24sim.c
+ * \brief   The embeddable E-DIO24 simulator, a fleet of simulated devices on a libuv loop
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ *
+ * Each device of a fleet keeps its own state (edio24_device_t), and is reached
+ * either by the UDP/TCP ports opened by edio24sim_listen(), or by a transport
+ * attached by edio24sim_attach(), for example the device end of a loopback.
+ * All of the handles belong to the loop passed by the caller, no global is used,
+ * so a test or a benchmark can run many fleets in the same process.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h> // memmove()
+#include <assert.h>
+
+#if ! defined(_WIN32)
+#include <sys/socket.h> // setsockopt(), SO_REUSEPORT
+#endif
+
+#include "libedio24sim.h"
+
+#define EDIO24SIM_BACKLOG 128
+
+/** a response to be sent */
+typedef struct _edio24sim_wbuf_t {
+    uv_write_t req; // should be the first item to bring by the argument
+    uv_buf_t buf;
+
+    edio24sim_dev_t * pdev;
+    edio24_timer_t tm; /**< the timer of the simulated latency */
+    struct _edio24sim_wbuf_t * next; /**< the next one in edio24sim_dev_t.pending */
+} edio24sim_wbuf_t;
+
+static void
+edio24sim_wbuf_free (edio24sim_wbuf_t * wr)
+{
+    free(wr->buf.base);
+    free(wr);
+}
+
+static void
+on_edio24sim_alloc (uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf)
+{
+    buf->base = malloc(suggested_size);
+    buf->len = (NULL == buf->base ? 0 : suggested_size);
+}
+
+/*****************************************************************************/
+static void
+on_edio24sim_write (uv_write_t* req, int status)
+{
+    edio24sim_wbuf_t * wr = (edio24sim_wbuf_t *)req;
+    if (status) {
+        fprintf(stderr, "edio24sim %d write error %s\n", wr->pdev->dev.id, uv_strerror(status));
+    } else {
+        wr->pdev->stats.num_respond ++;
+        wr->pdev->stats.bytes_out += wr->buf.len;
+    }
+    edio24sim_wbuf_free(wr);
+}
+
+/**
+ * \brief send a response to the TCP client or the attached transport
+ * \param pdev: the device
+ * \param wr: the response, it's released by this function
+ * \return 0 on success, <0 on error
+ */
+static int
+edio24sim_dev_output (edio24sim_dev_t * pdev, edio24sim_wbuf_t * wr)
+{
+    int r;
+
+    if ((NULL != pdev->client) && (! uv_is_closing((uv_handle_t *)(pdev->client)))) {
+        r = uv_write((uv_write_t *)wr, (uv_stream_t *)(pdev->client), &(wr->buf), 1, on_edio24sim_write);
+        if (r) {
+            fprintf(stderr, "edio24sim %d error in write() %s\n", pdev->dev.id, uv_strerror(r));
+            edio24sim_wbuf_free(wr);
+            return -1;
+        }
+        return 0;
+    }
+    if (NULL != pdev->peer) {
+        if (edio24_transport_send(pdev->peer, (uint8_t *)(wr->buf.base), wr->buf.len) >= 0) {
+            pdev->stats.num_respond ++;
+            pdev->stats.bytes_out += wr->buf.len;
+        }
+        edio24sim_wbuf_free(wr);
+        return 0;
+    }
+    edio24sim_wbuf_free(wr);
+    return -1;
+}
+
+static void
+on_edio24sim_latency (edio24_timer_t * ptm, void * userdata)
+{
+    edio24sim_wbuf_t * wr = (edio24sim_wbuf_t *)userdata;
+    edio24sim_dev_t * pdev = wr->pdev;
+    edio24sim_wbuf_t ** pp;
+
+    for (pp = &(pdev->pending); NULL != *pp; pp = &((*pp)->next)) {
+        if (*pp == wr) {
+            *pp = wr->next;
+            break;
+        }
+    }
+    edio24sim_dev_output(pdev, wr);
+}
+
+/**
+ * \brief the send function of the transport of a device
+ *
+ * The response is sent after the latency of the device.
+ * A virtual clock moves forward by the latency immediately,
+ * so the response and the timers before it are fired in order without waiting.
+ */
+static ssize_t
+edio24sim_dev_send (edio24_transport_t * ptr, const uint8_t * buf, size_t sz)
+{
+    edio24sim_dev_t * pdev = (edio24sim_dev_t *)(ptr->data);
+    edio24_clock_t * pclk = pdev->psim->clock;
+    edio24sim_wbuf_t * wr;
+    edio24sim_wbuf_t ** pp;
+
+    wr = (edio24sim_wbuf_t *)malloc(sizeof(*wr));
+    if (NULL == wr) {
+        return -1;
+    }
+    wr->buf.base = (char *)malloc(sz);
+    if (NULL == wr->buf.base) {
+        free(wr);
+        return -1;
+    }
+    memmove(wr->buf.base, buf, sz);
+    wr->buf.len = sz;
+    wr->pdev = pdev;
+    wr->next = NULL;
+    edio24_timer_init(&(wr->tm));
+
+    if ((pdev->latency < 1) || (NULL == pclk)) {
+        if (edio24sim_dev_output(pdev, wr) < 0) {
+            return -1;
+        }
+        return sz;
+    }
+    for (pp = &(pdev->pending); NULL != *pp; pp = &((*pp)->next)) {
+    }
+    *pp = wr;
+    edio24_timer_start(pclk, &(wr->tm), pdev->latency, on_edio24sim_latency, wr);
+    if (pclk->flg_virtual) {
+        edio24_clock_forward(pclk, pdev->latency);
+    }
+    return sz;
+}
+
+/**
+ * \brief drop the responses not sent yet
+ * \param pdev: the device
+ */
+static void
+edio24sim_dev_drop_pending (edio24sim_dev_t * pdev)
+{
+    edio24sim_wbuf_t * wr;
+    while (NULL != pdev->pending) {
+        wr = pdev->pending;
+        pdev->pending = wr->next;
+        if (NULL != pdev->psim->clock) {
+            edio24_timer_stop(pdev->psim->clock, &(wr->tm));
+        }
+        edio24sim_wbuf_free(wr);
+    }
+}
+
+/**
+ * \brief start a new device session for a new connection
+ * \param pdev: the device
+ */
+static void
+edio24sim_dev_restart (edio24sim_dev_t * pdev)
+{
+    edio24sim_dev_drop_pending(pdev);
+    edio24_svrsession_clean(&(pdev->svr));
+    edio24_svrsession_init(&(pdev->svr), &(pdev->transport), pdev->flg_randfail);
+    edio24_device_attach(&(pdev->dev), &(pdev->svr));
+}
+
+/**
+ * \brief process the requests received by a device
+ * \param pdev: the device
+ * \param buf: the data
+ * \param sz: the byte size of the data
+ * \return the number of requests processed, <0 on error
+ */
+static int
+edio24sim_dev_recv (edio24sim_dev_t * pdev, uint8_t * buf, size_t sz)
+{
+    int ret;
+
+    pdev->stats.bytes_in += sz;
+    pdev->svr.flg_randfail = pdev->flg_randfail;
+    ret = edio24_svrsession_recv(&(pdev->svr), buf, sz);
+    if (ret > 0) {
+        pdev->stats.num_request += ret;
+    }
+    return ret;
+}
+
+/*****************************************************************************/
+static void
+on_edio24sim_client_close (uv_handle_t* handle)
+{
+    edio24sim_dev_t * pdev = (edio24sim_dev_t *)(handle->data);
+    if ((NULL != pdev) && (pdev->client == (uv_tcp_t *)handle)) {
+        pdev->client = NULL;
+    }
+    free(handle);
+}
+
+/**
+ * \brief close the TCP connection of a device
+ * \param pdev: the device
+ */
+static void
+edio24sim_dev_disconnect (edio24sim_dev_t * pdev)
+{
+    edio24sim_dev_drop_pending(pdev);
+    if ((NULL != pdev->client) && (! uv_is_closing((uv_handle_t *)(pdev->client)))) {
+        uv_close((uv_handle_t *)(pdev->client), on_edio24sim_client_close);
+    }
+}
+
+static void
+on_edio24sim_tcp_read (uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf)
+{
+    edio24sim_dev_t * pdev = (edio24sim_dev_t *)(stream->data);
+
+    if (nread > 0) {
+        if (edio24sim_dev_recv(pdev, (uint8_t *)(buf->base), nread) < 0) {
+            fprintf(stderr, "edio24sim %d error in process the data\n", pdev->dev.id);
+            edio24sim_dev_disconnect(pdev);
+        }
+    } else if (nread < 0) {
+        if (nread != UV_EOF) {
+            fprintf(stderr, "edio24sim %d read error %s\n", pdev->dev.id, uv_err_name(nread));
+        }
+        edio24sim_dev_disconnect(pdev);
+    }
+    free(buf->base);
+}
+
+static void
+on_edio24sim_tcp_accept (uv_stream_t *server, int status)
+{
+    edio24sim_dev_t * pdev = (edio24sim_dev_t *)(server->data);
+    uv_tcp_t *client;
+    int r;
+
+    if (status < 0) {
+        fprintf(stderr, "edio24sim %d new connection error %s\n", pdev->dev.id, uv_strerror(status));
+        return;
+    }
+    client = (uv_tcp_t *)malloc(sizeof(uv_tcp_t));
+    if (NULL == client) {
+        return;
+    }
+    uv_tcp_init(server->loop, client);
+    client->data = NULL;
+    if (0 != uv_accept(server, (uv_stream_t *)client)) {
+        fprintf(stderr, "edio24sim %d failed at accept, close client socket\n", pdev->dev.id);
+        uv_close((uv_handle_t *)client, on_edio24sim_client_close);
+        return;
+    }
+    if ((NULL != pdev->client) || (NULL != pdev->peer)) {
+        // only one connect were allowed
+        fprintf(stderr, "edio24sim %d device busy\n", pdev->dev.id);
+        pdev->stats.num_reject ++;
+        uv_close((uv_handle_t *)client, on_edio24sim_client_close);
+        return;
+    }
+    pdev->stats.num_accept ++;
+    client->data = pdev;
+    pdev->client = client;
+    edio24sim_dev_restart(pdev);
+    r = uv_read_start((uv_stream_t *)client, on_edio24sim_alloc, on_edio24sim_tcp_read);
+    if (r) {
+        fprintf(stderr, "edio24sim %d read start error %s\n", pdev->dev.id, uv_strerror(r));
+        edio24sim_dev_disconnect(pdev);
+    }
+}
+
+/*****************************************************************************/
+typedef struct {
+    uv_udp_send_t req; // should be the first item to bring by the argument
+    uv_buf_t buf;
+} edio24sim_udp_send_t;
+
+static void
+on_edio24sim_udp_write (uv_udp_send_t *req, int status)
+{
+    edio24sim_udp_send_t * wr = (edio24sim_udp_send_t *)req;
+    if (status) {
+        fprintf(stderr, "edio24sim udp write error %s\n", uv_strerror(status));
+    }
+    free(wr->buf.base);
+    free(wr);
+}
+
+static void
+on_edio24sim_udp_read (uv_udp_t *handle, ssize_t nread, const uv_buf_t *buf, const struct sockaddr *addr, unsigned flags)
+{
+    edio24sim_dev_t * pdev = (edio24sim_dev_t *)(handle->data);
+    edio24sim_udp_send_t * wr;
+    uint8_t * pin = (uint8_t *)(buf->base);
+    size_t sz_out = 0;
+    size_t sz_needed_out = 0;
+    char flg_randfail = 0;
+    int r;
+
+    if (nread < 0) {
+        fprintf(stderr, "edio24sim %d udp read error %s\n", pdev->dev.id, uv_err_name(nread));
+    }
+    if ((nread <= 0) || (NULL == addr) || (NULL == buf->base)) {
+        free(buf->base);
+        return;
+    }
+    pdev->stats.num_udp ++;
+    if (pdev->flg_randfail) {
+        if (rand() % 100 < 50) {
+            flg_randfail = 1;
+        }
+    }
+    if ((nread == 1) && ('D' == pin[0]) && (buf->len >= 64)) {
+        /// discovery message
+        sz_out = 64;
+        edio24_svr_process_udp(flg_randfail, pin, nread, pin, &sz_out, &sz_needed_out);
+    } else if ((nread == 5) && ('C' == pin[0])) {
+        /// start of new command session
+        pin[0] = 'C';
+        pin[1] = ((NULL != pdev->client) || (NULL != pdev->peer) || flg_randfail) ? 1 : 0;
+        sz_out = 2;
+    } else {
+        fprintf(stderr, "edio24sim %d udp ignore the packet size %" PRIiSZ "\n", pdev->dev.id, nread);
+    }
+    if (sz_out < 1) {
+        free(buf->base);
+        return;
+    }
+    wr = (edio24sim_udp_send_t *)malloc(sizeof(*wr));
+    if (NULL == wr) {
+        free(buf->base);
+        return;
+    }
+    wr->buf = uv_buf_init(buf->base, sz_out);
+    r = uv_udp_send((uv_udp_send_t *)wr, handle, &(wr->buf), 1, addr, on_edio24sim_udp_write);
+    if (r) {
+        fprintf(stderr, "edio24sim %d udp error in send() %s\n", pdev->dev.id, uv_strerror(r));
+        free(wr->buf.base);
+        free(wr);
+    }
+}
+
+/**
+ * \brief set SO_REUSEPORT to the socket of a libuv handle
+ * \param handle: the handle which socket have been created
+ *
+ * \return 0 on successs, <0 on error
+ *
+ * The kernel will balance the TCP connections and the UDP packets
+ * across all of the sockets bound with this option to the same port.
+ */
+static int
+edio24sim_set_reuseport (uv_handle_t * handle)
+{
+#if defined(SO_REUSEPORT)
+    uv_os_fd_t fd;
+    int on = 1;
+    int r;
+
+    r = uv_fileno(handle, &fd);
+    if (r) {
+        return r;
+    }
+    if (0 != setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, (const void *)&on, sizeof(on))) {
+        return -1;
+    }
+    return 0;
+#else
+    return UV_ENOTSUP;
+#endif
+}
+
+/*****************************************************************************/
+/**
+ * \brief initialize a fleet of simulated devices
+ * \param psim: the fleet
+ * \param loop: the loop of the caller, all of the handles of the fleet are created in it
+ * \param num: the number of devices
+ * \param clock: the clock of the latency, the caller drives it (for example by uvclock_t); NULL -- no latency
+ * \return 0 on success, <0 on error
+ */
+int
+edio24sim_init (edio24sim_t * psim, uv_loop_t * loop, size_t num, edio24_clock_t * clock)
+{
+    edio24sim_dev_t * pdev;
+    size_t i;
+
+    if ((NULL == psim) || (NULL == loop) || (num < 1)) {
+        return -1;
+    }
+    memset(psim, 0, sizeof(*psim));
+    psim->devs = (edio24sim_dev_t *)calloc(num, sizeof(edio24sim_dev_t));
+    if (NULL == psim->devs) {
+        return -1;
+    }
+    psim->loop = loop;
+    psim->clock = clock;
+    psim->num = num;
+    for (i = 0; i < num; i ++) {
+        pdev = &(psim->devs[i]);
+        pdev->psim = psim;
+        edio24_device_init(&(pdev->dev), i);
+        pdev->transport.send = edio24sim_dev_send;
+        pdev->transport.data = pdev;
+        edio24sim_dev_restart(pdev);
+    }
+    return 0;
+}
+
+/**
+ * \brief close all of the connections and the ports of a fleet
+ * \param psim: the fleet
+ *
+ * The handles are closed by the loop, call edio24sim_clean() after the loop ends.
+ */
+void
+edio24sim_close (edio24sim_t * psim)
+{
+    edio24sim_dev_t * pdev;
+    size_t i;
+
+    assert (NULL != psim);
+    for (i = 0; i < psim->num; i ++) {
+        pdev = &(psim->devs[i]);
+        edio24sim_detach(psim, i);
+        edio24sim_dev_disconnect(pdev);
+        if (pdev->flg_listen) {
+            uv_close((uv_handle_t *)&(pdev->uvudp), NULL);
+            uv_close((uv_handle_t *)&(pdev->uvtcp), NULL);
+            pdev->flg_listen = 0;
+        }
+    }
+}
+
+/**
+ * \brief release a fleet
+ * \param psim: the fleet, it should be closed and the loop should have finished the close callbacks
+ */
+void
+edio24sim_clean (edio24sim_t * psim)
+{
+    size_t i;
+
+    assert (NULL != psim);
+    for (i = 0; i < psim->num; i ++) {
+        edio24sim_dev_drop_pending(&(psim->devs[i]));
+        edio24_svrsession_clean(&(psim->devs[i].svr));
+    }
+    free(psim->devs);
+    psim->devs = NULL;
+    psim->num = 0;
+}
+
+/**
+ * \brief get a device of a fleet
+ * \param psim: the fleet
+ * \param idx: the index of the device
+ * \return the device, NULL on error
+ *
+ * The state of the device is pdev->dev, query and poke it by edio24_device_xxx().
+ */
+edio24sim_dev_t *
+edio24sim_dev (edio24sim_t * psim, size_t idx)
+{
+    if ((NULL == psim) || (idx >= psim->num)) {
+        return NULL;
+    }
+    return &(psim->devs[idx]);
+}
+
+/**
+ * \brief open the UDP discover port and the TCP command port of a device
+ * \param psim: the fleet
+ * \param idx: the index of the device
+ * \param host: the address to bind
+ * \param port_udp: the UDP port, 0 -- any port
+ * \param port_tcp: the TCP port, 0 -- any port
+ * \param flg_reuseport: 1 -- bind the ports with SO_REUSEPORT, so the devices in the other loops can share them
+ *
+ * \return 0 on successs, <0 on error
+ */
+int
+edio24sim_listen (edio24sim_t * psim, size_t idx, const char * host, int port_udp, int port_tcp, char flg_reuseport)
+{
+    edio24sim_dev_t * pdev;
+    struct sockaddr_in addr_udp;
+    struct sockaddr_in addr_tcp;
+    int r;
+
+    pdev = edio24sim_dev(psim, idx);
+    if ((NULL == pdev) || (NULL == host) || pdev->flg_listen) {
+        return -1;
+    }
+    uv_ip4_addr(host, port_udp, &addr_udp);
+    uv_ip4_addr(host, port_tcp, &addr_tcp);
+    uv_udp_init_ex(psim->loop, &(pdev->uvudp), AF_INET);
+    uv_tcp_init_ex(psim->loop, &(pdev->uvtcp), AF_INET);
+    pdev->uvudp.data = pdev;
+    pdev->uvtcp.data = pdev;
+    pdev->flg_listen = 1;
+
+    // setup the UDP listen port
+    if (flg_reuseport) {
+        r = edio24sim_set_reuseport ((uv_handle_t *)&(pdev->uvudp));
+        if (r) {
+            fprintf(stderr, "edio24sim %d udp set SO_REUSEPORT error %d\n", pdev->dev.id, r);
+            return -1;
+        }
+    }
+    r = uv_udp_bind(&(pdev->uvudp), (const struct sockaddr *)&addr_udp, UV_UDP_REUSEADDR);
+    if (r) {
+        fprintf(stderr, "edio24sim %d udp bind error %s\n", pdev->dev.id, uv_strerror(r));
+        return -1;
+    }
+    uv_udp_recv_start(&(pdev->uvudp), on_edio24sim_alloc, on_edio24sim_udp_read);
+
+    // setup the TCP listen port
+    if (flg_reuseport) {
+        r = edio24sim_set_reuseport ((uv_handle_t *)&(pdev->uvtcp));
+        if (r) {
+            fprintf(stderr, "edio24sim %d tcp set SO_REUSEPORT error %d\n", pdev->dev.id, r);
+            return -1;
+        }
+    }
+    r = uv_tcp_bind(&(pdev->uvtcp), (const struct sockaddr*)&addr_tcp, 0);
+    if (r) {
+        fprintf(stderr, "edio24sim %d tcp bind error %s\n", pdev->dev.id, uv_strerror(r));
+        return -1;
+    }
+    r = uv_listen((uv_stream_t *)&(pdev->uvtcp), EDIO24SIM_BACKLOG, on_edio24sim_tcp_accept);
+    if (r) {
+        fprintf(stderr, "edio24sim %d tcp listen error %s\n", pdev->dev.id, uv_strerror(r));
+        return -1;
+    }
+    return 0;
+}
+
+static void
+on_edio24sim_peer_recv (void * userdata, uint8_t * buf, size_t sz)
+{
+    edio24sim_dev_recv((edio24sim_dev_t *)userdata, buf, sz);
+}
+
+/**
+ * \brief connect a device to a transport, for example the device end of a loopback
+ * \param psim: the fleet
+ * \param idx: the index of the device
+ * \param ptr: the transport
+ * \return 0 on success, <0 on error or the device is busy
+ */
+int
+edio24sim_attach (edio24sim_t * psim, size_t idx, edio24_transport_t * ptr)
+{
+    edio24sim_dev_t * pdev;
+
+    pdev = edio24sim_dev(psim, idx);
+    if ((NULL == pdev) || (NULL == ptr)) {
+        return -1;
+    }
+    if ((NULL != pdev->client) || (NULL != pdev->peer)) {
+        pdev->stats.num_reject ++;
+        return -1;
+    }
+    pdev->stats.num_accept ++;
+    pdev->peer = ptr;
+    edio24sim_dev_restart(pdev);
+    edio24_transport_set_receiver(ptr, on_edio24sim_peer_recv, pdev);
+    return 0;
+}
+
+/**
+ * \brief disconnect a device from the transport attached
+ * \param psim: the fleet
+ * \param idx: the index of the device
+ */
+void
+edio24sim_detach (edio24sim_t * psim, size_t idx)
+{
+    edio24sim_dev_t * pdev;
+
+    pdev = edio24sim_dev(psim, idx);
+    if ((NULL == pdev) || (NULL == pdev->peer)) {
+        return;
+    }
+    edio24sim_dev_drop_pending(pdev);
+    if (pdev->peer->userdata_recv == pdev) {
+        edio24_transport_set_receiver(pdev->peer, NULL, NULL);
+    }
+    pdev->peer = NULL;
+}
+
+#if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
+#include <ciut.h>
+
+typedef struct _test_sim_log_t {
+    int cnt;
+    uint8_t cmd;
+    uint8_t status;
+    uint32_t value;
+    uint64_t time;
+} test_sim_log_t;
+
+static void
+test_sim_cb (edio24_session_t * pss, const edio24_response_t * presp, void * userdata)
+{
+    test_sim_log_t * plog = (test_sim_log_t *)userdata;
+    if (NULL == presp) {
+        return;
+    }
+    plog->cnt ++;
+    plog->cmd = presp->cmd;
+    plog->status = presp->status;
+    plog->value = 0;
+    if (presp->count >= 3) {
+        plog->value = presp->data[0] | (presp->data[1] << 8) | (presp->data[2] << 16);
+    }
+}
+
+typedef struct _test_sim_tcp_t {
+    edio24sim_t * psim;
+    uv_tcp_t client;
+    uv_connect_t req_connect;
+    uv_write_t req_write;
+    uint8_t pkt[EDIO24_PKT_LENGTH_MIN + 6];
+    size_t sz_rx;
+    uint8_t rx[64];
+} test_sim_tcp_t;
+
+static void
+test_sim_tcp_read (uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf)
+{
+    test_sim_tcp_t * pt = (test_sim_tcp_t *)(stream->data);
+    if ((nread > 0) && (pt->sz_rx + nread <= sizeof(pt->rx))) {
+        memmove(pt->rx + pt->sz_rx, buf->base, nread);
+        pt->sz_rx += nread;
+    }
+    free(buf->base);
+    if ((nread < 0) || (pt->sz_rx >= EDIO24_PKT_LENGTH_MIN + 3)) {
+        // got the response, shutdown all
+        uv_close((uv_handle_t *)stream, NULL);
+        edio24sim_close(pt->psim);
+    }
+}
+
+static void
+test_sim_tcp_connect (uv_connect_t *req, int status)
+{
+    test_sim_tcp_t * pt = (test_sim_tcp_t *)(req->handle->data);
+    uv_buf_t buf;
+    uint8_t frame = 3;
+    if (status < 0) {
+        uv_close((uv_handle_t *)(req->handle), NULL);
+        edio24sim_close(pt->psim);
+        return;
+    }
+    buf.base = (char *)(pt->pkt);
+    buf.len = edio24_pkt_create_cmd_doutr(pt->pkt, sizeof(pt->pkt), &frame);
+    uv_write(&(pt->req_write), req->handle, &buf, 1, NULL);
+    uv_read_start(req->handle, on_edio24sim_alloc, test_sim_tcp_read);
+}
+
+static int
+test_sim_on_request (edio24_device_t * pdev, uint8_t cmd, const uint8_t * pkt, size_t sz, void * userdata)
+{
+    if (EDIO24_CMD_STATUS == cmd) {
+        return EDIO24_STATUS_ERROR_BUSY;
+    }
+    return 0;
+}
+
+static void
+test_sim_on_change (edio24_device_t * pdev, uint8_t cmd, void * userdata)
+{
+    (*(int *)userdata) ++;
+}
+
+TEST_CASE( .name="edio24-sim", .description="test the simulated fleet.", .skip=0 ) {
+    uv_loop_t loop;
+    edio24sim_t sim;
+    edio24_clock_t clk;
+    edio24_loopback_t lb;
+    edio24_session_t ss;
+    test_sim_log_t log;
+    uint8_t pkt[EDIO24_PKT_LENGTH_MIN + 16];
+    ssize_t ret;
+
+    REQUIRE(0 == uv_loop_init(&loop));
+
+    SECTION("test the parameters") {
+        REQUIRE(0 > edio24sim_init(NULL, &loop, 1, NULL));
+        REQUIRE(0 > edio24sim_init(&sim, NULL, 1, NULL));
+        REQUIRE(0 > edio24sim_init(&sim, &loop, 0, NULL));
+        REQUIRE(0 == edio24sim_init(&sim, &loop, 2, NULL));
+        REQUIRE(NULL == edio24sim_dev(&sim, 2));
+        REQUIRE(NULL != edio24sim_dev(&sim, 1));
+        REQUIRE(1 == edio24sim_dev(&sim, 1)->dev.id);
+        REQUIRE(0 > edio24sim_attach(&sim, 2, edio24_loopback_device(&lb)));
+        REQUIRE(0 > edio24sim_attach(&sim, 0, NULL));
+        edio24sim_close(&sim);
+        edio24sim_clean(&sim);
+    }
+    SECTION("test the devices on the loopback with the virtual latency") {
+        edio24sim_dev_t * pdev;
+        int cnt_change = 0;
+        edio24_device_hooks_t hooks = { test_sim_on_request, test_sim_on_change, &cnt_change };
+
+        memset(&log, 0, sizeof(log));
+        REQUIRE(0 == edio24_clock_init(&clk, 1));
+        REQUIRE(0 == edio24sim_init(&sim, &loop, 3, &clk));
+        REQUIRE(0 == edio24_loopback_init(&lb, 0));
+        REQUIRE(0 == edio24_session_init(&ss, edio24_loopback_client(&lb)));
+        pdev = edio24sim_dev(&sim, 1);
+        pdev->latency = 1000;
+        edio24_device_set_hooks(&(pdev->dev), &hooks);
+        REQUIRE(0 == edio24sim_attach(&sim, 1, edio24_loopback_device(&lb)));
+        // only one connection
+        REQUIRE(0 > edio24sim_attach(&sim, 1, edio24_loopback_device(&lb)));
+
+        // the state is kept by the device
+        ret = edio24_pkt_create_cmd_dconfw(pkt, sizeof(pkt), &(ss.frame), 0x0000FF, 0);
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_sim_cb, &log));
+        ret = edio24_pkt_create_cmd_doutw(pkt, sizeof(pkt), &(ss.frame), 0x00FFFF, 0x00A5A5);
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_sim_cb, &log));
+        ret = edio24_pkt_create_cmd_doutr(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_sim_cb, &log));
+        edio24_loopback_pump(&lb);
+        REQUIRE(3 == log.cnt);
+        REQUIRE(EDIO24_CMD_DOUT_R == log.cmd);
+        REQUIRE(0x00A5A5 == log.value);
+        REQUIRE(3000 == edio24_clock_now(&clk));
+        REQUIRE(2 == cnt_change);
+
+        // poke the input pins, the outputs read back the latch
+        edio24_device_set_input(&(pdev->dev), EDIO24_DEVICE_PINS, 0xFFFF00);
+        REQUIRE(3 == cnt_change);
+        ret = edio24_pkt_create_cmd_dinr(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_sim_cb, &log));
+        edio24_loopback_pump(&lb);
+        REQUIRE(4 == log.cnt);
+        REQUIRE(0xFFFFA5 == log.value);
+        REQUIRE(1 == pdev->dev.counter);
+
+        // the hook fails the status request
+        ret = edio24_pkt_create_cmd_status(pkt, sizeof(pkt), &(ss.frame));
+        REQUIRE(0 == edio24_session_send(&ss, pkt, ret, test_sim_cb, &log));
+        edio24_loopback_pump(&lb);
+        REQUIRE(5 == log.cnt);
+        REQUIRE(EDIO24_STATUS_ERROR_BUSY == log.status);
+
+        REQUIRE(5 == pdev->stats.num_request);
+        REQUIRE(5 == pdev->stats.num_respond);
+        REQUIRE(0 == sim.devs[0].stats.num_request);
+
+        edio24sim_close(&sim);
+        REQUIRE(NULL == pdev->peer);
+        edio24sim_clean(&sim);
+        edio24_session_clean(&ss);
+        edio24_loopback_clean(&lb);
+        edio24_clock_clean(&clk);
+    }
+    SECTION("test the device on TCP of the caller's loop") {
+        test_sim_tcp_t tcp;
+        struct sockaddr_storage addr;
+        int namelen = sizeof(addr);
+        edio24sim_dev_t * pdev;
+
+        memset(&tcp, 0, sizeof(tcp));
+        REQUIRE(0 == edio24sim_init(&sim, &loop, 1, NULL));
+        pdev = edio24sim_dev(&sim, 0);
+        edio24_device_set_output(&(pdev->dev), EDIO24_DEVICE_PINS, 0x123456);
+        REQUIRE(0 == edio24sim_listen(&sim, 0, "127.0.0.1", 0, 0, 0));
+        REQUIRE(0 > edio24sim_listen(&sim, 0, "127.0.0.1", 0, 0, 0));
+        REQUIRE(0 == uv_tcp_getsockname(&(pdev->uvtcp), (struct sockaddr *)&addr, &namelen));
+
+        tcp.psim = &sim;
+        uv_tcp_init(&loop, &(tcp.client));
+        tcp.client.data = &tcp;
+        REQUIRE(0 == uv_tcp_connect(&(tcp.req_connect), &(tcp.client), (const struct sockaddr *)&addr, test_sim_tcp_connect));
+        REQUIRE(0 == uv_run(&loop, UV_RUN_DEFAULT));
+        REQUIRE(EDIO24_PKT_LENGTH_MIN + 3 == tcp.sz_rx);
+        REQUIRE((EDIO24_CMD_DOUT_R | EDIO24_PKT_REPLY) == tcp.rx[1]);
+        REQUIRE(3 == tcp.rx[2]);
+        REQUIRE(0x56 == tcp.rx[EDIO24_PKT_OFFSET_DATA]);
+        REQUIRE(0x12 == tcp.rx[EDIO24_PKT_OFFSET_DATA + 2]);
+        REQUIRE(1 == pdev->stats.num_accept);
+        REQUIRE(1 == pdev->stats.num_request);
+        REQUIRE(NULL == pdev->client);
+        edio24sim_clean(&sim);
+    }
+    uv_run(&loop, UV_RUN_DEFAULT);
+    REQUIRE(0 == uv_loop_close(&loop));
+}
+#endif /* CIUT_ENABLED */
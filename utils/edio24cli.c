@@ -11,7 +11,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h> // memmove()
-#include <unistd.h> // STDERR_FILENO, usleep()
+#include <unistd.h> // STDERR_FILENO
+#include <fcntl.h> // open()
+#include <sys/stat.h> // fstat()
+#include <sys/mman.h> // mmap()
 #include <libgen.h> // basename()
 #include <getopt.h>
 
@@ -20,7 +23,12 @@
 #include <uv.h>
 
 #include "libedio24.h"
+#include "edio24cmdstream.h"
+#include "edio24script.h"
+#include "edio24dmsg.h"
 #include "utils.h"
+#include "uvclock.h"
+#include "uvtransport.h"
 
 #if DEBUG
 #include "hexdump.h"
@@ -34,22 +42,54 @@
 
 uv_loop_t * loop = NULL; /**< this have to be global variable, since it needs to access in on_xxxx() when service new connections */
 
-typedef struct _edio24cli_t {
-    uint8_t frame; /**< the sequence number */
+static char flg_has_error = 0;
 
+typedef struct _edio24cli_t {
     const char * fn_conf; /**< the file name of execute file */
 
     struct sockaddr_in addr_tcp;  /**< thep socket addr for commands (TCP) */
     uv_tcp_t uvtcp;
     uv_connect_t connect;
-    // TODO: a list of remote commands load from file?
+    uvtransport_t transport; /**< the transport on uvtcp */
+    char flg_loopback; /**< 1 -- the commands are sent to a simulated device in the process */
+    uvloopback_t uvlb; /**< the transport to the simulated device */
+    const char * path_daemon; /**< the socket of edio24d, NULL -- connect to the device */
+    uint16_t device;          /**< the index of the device in the daemon */
+    uv_pipe_t uvpipe;
+    edio24d_client_t dcl; /**< the transport to the device through the daemon, on uvpipe */
+    edio24_svrsession_t svr; /**< the simulated device */
+    edio24_session_t session; /**< the session to the device, frame id is session.frame */
+    char flg_verbose; /**< 1 -- show the timing of each job */
+    char flg_scheduling; /**< 1 -- not all of the records of the script are sent */
+    char flg_done; /**< 1 -- all of the responses have been received */
+    edio24_cmdstream_t cmds; /**< the script compiled from the text lines */
+    size_t num_lines;     /**< the number of the text lines compiled */
+    size_t num_errors;    /**< the number of the lines can't be compiled */
+    uint8_t * map;        /**< the precompiled script mapped from the file, NULL if compiled from the text */
+    size_t sz_map;
+    const uint8_t * stream; /**< the binary script being sent, cmds.buf or map */
+    size_t sz_stream;
+    size_t num_pkts;      /**< the number of packets in the script */
+    size_t off_next;      /**< the offset of the next record in the stream */
+    uint64_t offset_next; /**< the requested time of the next record, in microseconds from the start of the script */
+    char flg_held;        /**< 1 -- the next record was due but held by the window or the barrier */
+    uint64_t time_start;  /**< the time of the clock when the first record is released */
+    size_t window;        /**< the max number of requests waiting for the responses, 0 -- no limit */
+    char flg_adaptive;    /**< 1 -- the window is adapted to the device by the session */
+    uint64_t retry_budget; /**< the max microseconds to send a failed request again, 0 -- no retry */
+    uint64_t deadline;    /**< the max microseconds to wait for the response of a request, 0 -- no limit */
+    size_t num_waits;     /**< the number of times a due record waits for the window or a barrier */
+    size_t num_sent;      /**< the number of packets sent by the scheduler */
+    uint64_t late_sum;    /**< the sum of the achieved time minus the requested time of the packets sent */
+    uint64_t late_max;
+    size_t pos_max;       /**< the offset of the record which is the latest */
+    edio24_timer_t tm_job; /**< release the next record */
     size_t num_requests; /**< the total number of requests sent */
     size_t num_responds; /**< the total number of responds received */
-    time_t starttime;
-    time_t timeout;
-
-    size_t sz_data; /**< the lenght of data in the buffer */
-    uint8_t buffer[EDIO24_PKT_LENGTH_MIN + 1024]; /**< the buffer to cache the received packets */
+    size_t num_failed;   /**< the number of the requests done without a response, the retry can't be sent or it's cancelled */
+    time_t timeout; /**< the seconds of timeout */
+    uvclock_t uvclk; /**< the real or virtual clock for Sleep and timeout */
+    edio24_timer_t tm_timeout;
 } edio24cli_t;
 
 edio24cli_t g_edio24cli;
@@ -68,18 +108,6 @@ udp_send_buf_free (udp_send_buf_t *wr)
     free(wr);
 }
 
-typedef struct {
-    uv_write_t req;
-    uv_buf_t buf;
-} write_buf_t;
-
-void
-write_buf_free (write_buf_t *wr)
-{
-    free(wr->buf.base);
-    free(wr);
-}
-
 void
 alloc_buffer(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf)
 {
@@ -88,118 +116,86 @@ alloc_buffer(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf)
 }
 
 /*****************************************************************************/
+void
+on_tcp_cli_close(uv_handle_t* handle)
+{
+    fprintf(stderr, "tcp cli closed.\n");
+}
+
 /**
- * \brief process response packet in the buffer of edio24cli_t
- * \param ped: the edio24cli with buffer
- * \param stream: the libuv socket
- *
- * \return 0 on successs
- *
- * process the data in the buffer, until there's no more data can be processed in one round
+ * \brief stop the client if all of the responses have been received
  */
-ssize_t
-edio24cli_process_data (edio24cli_t * ped, uv_stream_t *stream)
+static void
+edio24cli_check_done (void)
 {
-    uint8_t * buffer_in = NULL;
-    size_t sz_in;
-    size_t sz_processed;
-    size_t sz_needed_in;
-
-    //int flg_again = 0;
-    int ret;
-
-    assert (NULL != ped);
-    assert (NULL != stream);
-
-    fprintf(stderr,"tcp cli edio24cli_process_data() BEGIN\n");
-    while(1) { // while (ped->sz_data > 0) {
-        buffer_in = ped->buffer;
-        sz_in = ped->sz_data;
-        //flg_again = 0;
-        sz_processed = 0;
-        sz_needed_in = 0;
-
-        fprintf(stderr,"tcp cli edio24cli_process_data() ped->sz_data=%" PRIuSZ "\n", ped->sz_data);
-        assert (NULL != buffer_in);
-        assert (sz_in >= 0);
-        fprintf(stderr,"tcp cli edio24cli_process_data() call edio24_cli_verify\n");
-        ret = edio24_cli_verify_tcp(buffer_in, sz_in, &sz_processed, &sz_needed_in);
-        if (sz_processed > 0) {
-            // remove the head of data of size sz_processed
-            size_t sz_rest;
-            assert (sz_processed <= ped->sz_data);
-            sz_rest = ped->sz_data - sz_processed;
-            if (sz_rest > 0) {
-                memmove (ped->buffer, &(ped->buffer[sz_processed]), sz_rest);
-            }
-            ped->sz_data = sz_rest;
+    if (g_edio24cli.flg_scheduling || g_edio24cli.flg_done) {
+        return;
+    }
+    if (g_edio24cli.num_responds + g_edio24cli.num_failed >= g_edio24cli.num_requests) {
+        fprintf(stderr,"tcp cli received responses(%" PRIuSZ ") exceed requests(%" PRIuSZ ")!\n", g_edio24cli.num_responds, g_edio24cli.num_requests);
+        if (g_edio24cli.num_failed > 0) {
+            fprintf(stderr,"tcp cli %" PRIuSZ " request(s) failed without response\n", g_edio24cli.num_failed);
         }
-        if (sz_needed_in > 0) {
-            fprintf(stderr, "need more data: %" PRIuSZ "\n", sz_needed_in);
-            break;
+        g_edio24cli.flg_done = 1;
+        if (NULL != g_edio24cli.path_daemon) {
+            if (! uv_is_closing((uv_handle_t*)&(g_edio24cli.uvpipe))) {
+                uv_close((uv_handle_t*)&(g_edio24cli.uvpipe), on_tcp_cli_close);
+            }
+        } else if ((! g_edio24cli.flg_loopback) && (! uv_is_closing((uv_handle_t*)&(g_edio24cli.uvtcp)))) {
+            uv_close((uv_handle_t*)&(g_edio24cli.uvtcp), on_tcp_cli_close);
         }
-        if (ret < 0) {
-            break;
-        } else if (ret == 0) {
-            //flg_again = 1;
-            g_edio24cli.num_responds ++;
-        } else if (ret == 1) {
-            //flg_again = 1;
-        } else if (ret == 2) {
-            break;
+        raise(SIGINT); // send signal and handle by uv_signal_cb
+    }
+}
+
+static void edio24cli_sched_run (void);
+
+/**
+ * \brief the callback of the session for the responses
+ * \param pss: the session
+ * \param presp: the response, NULL if the request is cancelled
+ * \param userdata: not used
+ */
+static void
+on_cli_respond (edio24_session_t * pss, const edio24_response_t * presp, void * userdata)
+{
+    size_t sz_processed = 0;
+    size_t sz_needed_in = 0;
+
+    if (NULL == presp) {
+        g_edio24cli.num_failed ++;
+        if (g_edio24cli.flg_done) {
+            // cancelled by edio24_session_clean()
+            return;
         }
+    } else if (0 == edio24_cli_verify_tcp(presp->pkt, presp->sz_pkt, &sz_processed, &sz_needed_in)) {
+        g_edio24cli.num_responds ++;
     }
-    return 0;
+    if (g_edio24cli.flg_scheduling) {
+        /* a slot of the window is freed */
+        edio24cli_sched_run();
+        return;
+    }
+    edio24cli_check_done();
 }
 
-/*****************************************************************************/
-void
-on_tcp_cli_close(uv_handle_t* handle)
+/**
+ * \brief the callback of the session for the responses not matched to any request
+ */
+static void
+on_cli_respond_unknown (edio24_session_t * pss, const edio24_response_t * presp, void * userdata)
 {
-    fprintf(stderr, "tcp cli closed.\n");
+    fprintf(stderr, "tcp cli unexpected response: cmd=%s(0x%02X), frame=%d\n", edio24_val2cstr_cmd(presp->cmd), presp->cmd, presp->frame);
 }
 
 void
 on_tcp_cli_read(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf)
 {
     if(nread > 0) {
-        // push the content to a center buffer for this TCP connection
-        // and fetch the cmd to fetch appriate length of data as a packet
-        // to process
-        size_t sz_copy;
-        size_t sz_processed;
-
         fprintf(stderr,"tcp cli read block, size=%" PRIiSZ ":\n", nread);
         hex_dump_to_fd(STDERR_FILENO, (opaque_t *)(buf->base), nread);
-
-        fprintf(stderr, "tcp cli process data 1\n");
-        edio24cli_process_data (&g_edio24cli, stream);
-        sz_processed = 0;
-        while (sz_processed < nread) {
-            sz_copy = nread - sz_processed;
-            assert (sizeof(g_edio24cli.buffer) >= g_edio24cli.sz_data);
-            if (sz_copy + g_edio24cli.sz_data > sizeof(g_edio24cli.buffer)) {
-                sz_copy = sizeof(g_edio24cli.buffer) - g_edio24cli.sz_data;
-            }
-            fprintf(stderr, "tcp cli push received data size=%" PRIuSZ ", processed=%" PRIuSZ "\n", sz_copy, sz_processed);
-            if (sz_copy > 0) {
-                memmove (g_edio24cli.buffer + g_edio24cli.sz_data, buf->base + sz_processed, sz_copy);
-                sz_processed += sz_copy;
-                g_edio24cli.sz_data += sz_copy;
-            } else {
-                // error? full?
-                fprintf(stderr, "tcp cli no more received data to be push\n");
-                break;
-            }
-            fprintf(stderr, "tcp cli process data 2\n");
-            edio24cli_process_data (&g_edio24cli, stream);
-        }
-        if (sz_processed < nread) {
-            // we're stalled here, because the content can't be processed by the function edio24cli_process_data()
-            // error
-            fprintf(stderr, "tcp cli data stalled\n");
-            //uv_close((uv_handle_t *)stream, on_tcp_cli_close);
-        }
+        // the session caches the data, and calls on_cli_respond() for each response
+        uvtransport_recv(&(g_edio24cli.transport), (uint8_t *)(buf->base), nread);
     }
     if (nread == 0) {
         fprintf(stderr,"tcp cli read zero!\n");
@@ -207,189 +203,324 @@ on_tcp_cli_read(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf)
     if (nread < 0) {
         //we got an EOF
         fprintf(stderr,"tcp cli read EOF!\n");
-        uv_close((uv_handle_t*)stream, on_tcp_cli_close);
+        if (! uv_is_closing((uv_handle_t*)stream)) {
+            uv_close((uv_handle_t*)stream, on_tcp_cli_close);
+        }
     }
 
     free(buf->base);
-    if (g_edio24cli.num_responds >= g_edio24cli.num_requests) {
-        fprintf(stderr,"tcp cli received responses(%" PRIuSZ ") exceed requests(%" PRIuSZ ")!\n", g_edio24cli.num_responds, g_edio24cli.num_requests);
-        uv_close((uv_handle_t*)stream, on_tcp_cli_close);
-        raise(SIGINT); // send signal and handle by uv_signal_cb
-    }
 }
 
-void
-on_tcp_cli_write_end(uv_write_t* req, int status)
+/**
+ * \brief parse the lines in the buffer and compile the commands to the stream
+ * \param pos: the position in the file
+ * \param buf: the buffer
+ * \param size: the size of buffer
+ * \param userdata: the stream, edio24_cmdstream_t
+ *
+ * \return 0 on successs, <0 on error
+ *
+ * The keywords and the arguments are defined by the table in edio24script.c.
+ * The frame ids of the packets are set when they are sent.
+ * A Sleep line moves the time of the following commands, it does not block.
+ * A Barrier line holds the following commands until all of the previous requests are responded.
+ */
+int
+process_command(off_t pos, char * buf, size_t size, void *userdata)
 {
-    if (status) {
-        fprintf(stderr, "tcp cli write error %s.\n", uv_strerror(status));
-        uv_close(req->handle, on_tcp_cli_close);
-        return;
-    } else {
-        fprintf(stderr, "tcp cli write successfull.\n");
+    edio24_cmdstream_t * pcs = (edio24_cmdstream_t *)userdata;
+    edio24_script_err_t err;
+    size_t len;
+
+    g_edio24cli.num_lines ++;
+    if (edio24_script_compile_line(pcs, buf, size, &err) >= 0) {
+        return 0;
     }
-    write_buf_free(req);
+    g_edio24cli.num_errors ++;
+    for (len = size; (len > 0) && (('\n' == buf[len - 1]) || ('\r' == buf[len - 1])); len --);
+    fprintf(stderr, "%s:%" PRIuSZ ":%" PRIuSZ ": error: %s%s%s%s\n", (NULL == g_edio24cli.fn_conf ? "<stdin>" : g_edio24cli.fn_conf), g_edio24cli.num_lines, err.column, err.msg,
+        (NULL == err.arg ? "" : " ("), (NULL == err.arg ? "" : err.arg), (NULL == err.arg ? "" : ")"));
+    fprintf(stderr, "%.*s\n%*s^\n", (int)len, buf, (int)(err.column - 1), "");
+    return -1;
 }
 
-void
-send_buffer(uv_stream_t* stream, uint8_t *buffer1, size_t szbuf)
+/**
+ * \brief show the requested and the achieved time of the packets sent
+ */
+static void
+edio24cli_sched_report (void)
 {
-    int r;
-    write_buf_t * wbuf = NULL;
-
-    wbuf = malloc (sizeof(*wbuf));
-    assert (NULL != wbuf);
-    memset(wbuf, 0, sizeof(*wbuf));
-    alloc_buffer(NULL, szbuf, &(wbuf->buf));
-    memmove (wbuf->buf.base, buffer1, szbuf);
-    assert (NULL != wbuf->buf.base);
-    assert (wbuf->buf.len >= szbuf);
-    r = uv_write(wbuf, stream, &(wbuf->buf), 1, on_tcp_cli_write_end);
-    if (r) {
-        /* error */
-        fprintf(stderr, "tcp cli error in write() %s\n", uv_strerror(r));
+    fprintf(stderr, "tcp cli schedule: jobs=%" PRIuSZ "/%" PRIuSZ ", late avg=%" PRIu64 ", max=%" PRIu64 " microseconds at pos(%" PRIuSZ "), window=%" PRIuSZ ", waits=%" PRIuSZ "\n"
+        , g_edio24cli.num_sent, g_edio24cli.num_pkts
+        , (g_edio24cli.num_sent > 0 ? g_edio24cli.late_sum / g_edio24cli.num_sent : 0)
+        , g_edio24cli.late_max, g_edio24cli.pos_max, g_edio24cli.window, g_edio24cli.num_waits);
+    if (g_edio24cli.flg_adaptive) {
+        edio24_session_stats_t * pst = &(g_edio24cli.session.stats);
+        fprintf(stderr, "tcp cli adaptive window=%" PRIuSZ ", rtt min=%" PRIu64 ", avg=%" PRIu64 " microseconds, backoff busy=%" PRIuSZ ", rtt=%" PRIuSZ "\n"
+            , edio24_session_window(&(g_edio24cli.session)), pst->rtt_min, pst->rtt_avg, pst->num_backoff_busy, pst->num_backoff_rtt);
+    }
+    if ((g_edio24cli.session.stats.num_retry > 0) || (g_edio24cli.session.stats.num_giveup > 0) || (g_edio24cli.session.stats.num_timeout > 0)) {
+        fprintf(stderr, "tcp cli retry=%" PRIuSZ ", giveup=%" PRIuSZ ", timeout=%" PRIuSZ "\n", g_edio24cli.session.stats.num_retry, g_edio24cli.session.stats.num_giveup, g_edio24cli.session.stats.num_timeout);
     }
 }
 
-#define STRCMP_STATIC(buf, static_str) strncmp(buf, static_str, sizeof(static_str)-1)
+static void
+on_cli_job (edio24_timer_t * ptm, void * userdata)
+{
+    edio24cli_sched_run();
+}
 
 /**
- * \brief parse the lines in the buffer and send out packets base on the command
- * \param pos: the position in the file
- * \param buf: the buffer
- * \param size: the size of buffer
- * \param userdata: the pointer passed by the user
+ * \brief send the records which are due, and arm the timer to the next one
  *
- * \return 0 on successs, <0 on error
+ * The time of a record is relative to the start of the script, not to the previous one,
+ * so the delay of a callback is not accumulated.
+ * A virtual clock is moved forward to the next record, the timers crossed (the timeout) are fired in order.
+ * A record due is held if the window of the requests is full or it is a barrier and there are requests in flight.
+ */
+static void
+edio24cli_sched_run (void)
+{
+    edio24_clock_t * pclk = &(g_edio24cli.uvclk.clock);
+    edio24_cmdrec_t rec;
+    uint8_t pkt[EDIO24_PKT_LENGTH_MIN + 1024];
+    ssize_t ret;
+    ssize_t sz_pkt;
+    uint64_t target;
+    uint64_t now;
+    uint64_t late;
+    size_t window;
+
+    while (! flg_has_error) {
+        ret = edio24_cmdstream_next(g_edio24cli.stream, g_edio24cli.sz_stream, g_edio24cli.off_next, &rec);
+        if (ret < 0) {
+            fprintf(stderr, "tcp cli error in the script at pos(%" PRIuSZ ")\n", g_edio24cli.off_next);
+            break;
+        }
+        if ((ret > 0) && (EDIO24_CMDSTREAM_OP_SLEEP == rec.op)) {
+            g_edio24cli.offset_next += rec.sleep;
+            g_edio24cli.off_next += ret;
+            continue;
+        }
+        /* a packet, a barrier, or the end after the trailing Sleep */
+        target = g_edio24cli.time_start + g_edio24cli.offset_next;
+        now = edio24_clock_now(pclk);
+        if (target > now) {
+            if (pclk->flg_virtual) {
+                edio24_clock_forward(pclk, target - now);
+                continue;
+            }
+            edio24_timer_start_at(pclk, &(g_edio24cli.tm_job), target, on_cli_job, NULL);
+            return;
+        }
+        if (ret == 0) {
+            break;
+        }
+        window = (g_edio24cli.flg_adaptive ? edio24_session_window(&(g_edio24cli.session)) : g_edio24cli.window);
+        if (((EDIO24_CMDSTREAM_OP_BARRIER == rec.op) && (edio24_session_inflight(&(g_edio24cli.session)) > 0))
+            || ((EDIO24_CMDSTREAM_OP_PKT == rec.op) && (window > 0) && (edio24_session_inflight(&(g_edio24cli.session)) >= window))) {
+            /* sent by on_cli_respond() when a response frees a slot */
+            if (! g_edio24cli.flg_held) {
+                g_edio24cli.flg_held = 1;
+                g_edio24cli.num_waits ++;
+            }
+            return;
+        }
+        g_edio24cli.flg_held = 0;
+        g_edio24cli.off_next += ret;
+        if (EDIO24_CMDSTREAM_OP_PKT != rec.op) {
+            continue;
+        }
+        sz_pkt = edio24_cmdstream_emit(&rec, pkt, sizeof(pkt), &(g_edio24cli.session.frame));
+        if ((sz_pkt < 0) || (edio24_session_send(&(g_edio24cli.session), pkt, sz_pkt, on_cli_respond, NULL) < 0)) {
+            fprintf(stderr, "tcp cli error in send the packet at pos(%" PRIuSZ ")\n", rec.pos);
+            continue;
+        }
+        g_edio24cli.num_requests ++;
+
+        late = now - target;
+        if (g_edio24cli.flg_verbose) {
+            fprintf(stderr, "tcp cli job pos(%" PRIuSZ "): requested=%" PRIu64 ", achieved=%" PRIu64 ", late=%" PRIu64 " microseconds\n"
+                , rec.pos, g_edio24cli.offset_next, now - g_edio24cli.time_start, late);
+        }
+        g_edio24cli.num_sent ++;
+        g_edio24cli.late_sum += late;
+        if (late >= g_edio24cli.late_max) {
+            g_edio24cli.late_max = late;
+            g_edio24cli.pos_max = rec.pos;
+        }
+    }
+    if (g_edio24cli.flg_scheduling) {
+        g_edio24cli.flg_scheduling = 0;
+        edio24cli_sched_report();
+    }
+    edio24cli_check_done();
+}
+
+/**
+ * \brief map a precompiled script
+ * \param fn_conf: the file name
+ * \return 0 on success, <0 if it is not a precompiled script
+ */
+static int
+edio24cli_map_script (const char * fn_conf)
+{
+    struct stat st;
+    void * p;
+    int fd;
+
+    fd = open(fn_conf, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    if ((fstat(fd, &st) < 0) || (st.st_size < EDIO24_CMDSTREAM_HDR_SIZE)) {
+        close(fd);
+        return -1;
+    }
+    p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == p) {
+        return -1;
+    }
+    if (edio24_cmdstream_check((const uint8_t *)p, st.st_size) < 0) {
+        munmap(p, st.st_size);
+        return -1;
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+#endif
+    g_edio24cli.map = (uint8_t *)p;
+    g_edio24cli.sz_map = st.st_size;
+    return 0;
+}
+
+/**
+ * \brief load the script, either a precompiled one or the text lines
+ * \return 0 on success, <0 on error
  *
- * TODO: add command 'sleep' to support delay between commands.
+ * The records are checked once here, so a broken file stops the client before any packet is sent.
  */
-int
-process_command(off_t pos, char * buf, size_t size, void *userdata)
+static int
+edio24cli_load_script (void)
 {
-    uv_stream_t* stream = (uv_stream_t *)userdata;
-    ssize_t ret = -1;
-    uint8_t buffer1[100];
-    uint8_t buffer2[100];
-    uint32_t address = 0xFF;
-    ssize_t count = sizeof(buffer2);
-    char * endptr = NULL;
-
-    fprintf(stderr, "edio24cli process line: '%s'\n", buf);
-
-    if (0 == STRCMP_STATIC (buf, "DOutW")) {
-        uint32_t mask = 0xFF;
-        uint32_t value = 0;
-        char * endptr = NULL;
-        // long int strtol(const char *str, char **endptr, int base);
-        mask = strtol(buf + 6, &endptr, 16);
-        value = strtol(endptr + 1, &endptr, 16);
-        ret = edio24_pkt_create_cmd_doutw (buffer1, sizeof(buffer1), &(g_edio24cli.frame), mask, value);
-
-    } else if (0 == STRCMP_STATIC (buf, "DConfigW")) {
-        uint32_t mask = 0xFF;
-        uint32_t value = 0;
-        mask = strtol(buf + 9, &endptr, 16);
-        value = strtol(endptr + 1, &endptr, 16);
-        ret = edio24_pkt_create_cmd_dconfw (buffer1, sizeof(buffer1), &(g_edio24cli.frame), mask, value);
-
-    } else if (0 == STRCMP_STATIC (buf, "DIn")) {
-        ret = edio24_pkt_create_cmd_dinr (buffer1, sizeof(buffer1), &(g_edio24cli.frame));
-
-    } else if (0 == STRCMP_STATIC (buf, "DOutR")) {
-        ret = edio24_pkt_create_cmd_doutr (buffer1, sizeof(buffer1), &(g_edio24cli.frame));
-
-    } else if (0 == STRCMP_STATIC (buf, "DConfigR")) {
-        ret = edio24_pkt_create_cmd_dconfr (buffer1, sizeof(buffer1), &(g_edio24cli.frame));
-
-    } else if (0 == STRCMP_STATIC (buf, "CounterR")) {
-        ret = edio24_pkt_create_cmd_dcounterr (buffer1, sizeof(buffer1), &(g_edio24cli.frame));
-
-    } else if (0 == STRCMP_STATIC (buf, "CounterW")) {
-        ret = edio24_pkt_create_cmd_dcounterw (buffer1, sizeof(buffer1), &(g_edio24cli.frame));
-
-    } else if (0 == STRCMP_STATIC (buf, "BlinkLED")) {
-        address = strtol(buf + 9, &endptr, 16);
-        ret = edio24_pkt_create_cmd_blinkled (buffer1, sizeof(buffer1), &(g_edio24cli.frame), address);
-
-    } else if (0 == STRCMP_STATIC (buf, "Reset")) {
-        ret = edio24_pkt_create_cmd_status (buffer1, sizeof(buffer1), &(g_edio24cli.frame));
-
-    } else if (0 == STRCMP_STATIC (buf, "Status")) {
-        ret = edio24_pkt_create_cmd_status (buffer1, sizeof(buffer1), &(g_edio24cli.frame));
-
-    } else if (0 == STRCMP_STATIC (buf, "NetworkConfig")) {
-        ret = edio24_pkt_create_cmd_netconf (buffer1, sizeof(buffer1), &(g_edio24cli.frame));
-
-    } else if (0 == STRCMP_STATIC (buf, "FirmwareUpgrade")) {
-        ret = edio24_pkt_create_cmd_firmware (buffer1, sizeof(buffer1), &(g_edio24cli.frame));
-
-    } else if (0 == STRCMP_STATIC (buf, "BootloaderMemoryR")) {
-        address = strtol(buf + 14, &endptr, 16);
-        count = strtol(endptr + 1, &endptr, 16);
-        ret = edio24_pkt_create_cmd_bootmemr (buffer1, sizeof(buffer1), &(g_edio24cli.frame), address, count);
-    } else if (0 == STRCMP_STATIC (buf, "SettingsMemoryR")) {
-        address = strtol(buf + 14, &endptr, 16);
-        count = strtol(endptr + 1, &endptr, 16);
-        ret = edio24_pkt_create_cmd_setmemr (buffer1, sizeof(buffer1), &(g_edio24cli.frame), address, count);
-    } else if (0 == STRCMP_STATIC (buf, "ConfigMemoryR")) {
-        address = strtol(buf + 14, &endptr, 16);
-        count = strtol(endptr + 1, &endptr, 16);
-        ret = edio24_pkt_create_cmd_confmemr (buffer1, sizeof(buffer1), &(g_edio24cli.frame), address, count);
-
-#define CSTR_CUR_COMMAND "ConfigMemoryW"
-    } else if (0 == STRCMP_STATIC (buf, CSTR_CUR_COMMAND)) {
-        address = strtol(buf + sizeof(CSTR_CUR_COMMAND), &endptr, 16);
-        count = parse_hex_buf(endptr + 1, strlen(endptr + 1), buffer2, sizeof(buffer2));
-        if (count < 0) {
-            fprintf(stderr, "Error in parse " CSTR_CUR_COMMAND ", tcp cli ret=%" PRIiSZ ".\n", count);
-        } else {
-            fprintf(stderr, "dump of parameter of " CSTR_CUR_COMMAND ", size=%" PRIiSZ ":\n", count);
-            hex_dump_to_fd(STDERR_FILENO, (opaque_t *)(buffer2), count);
-            ret = edio24_pkt_create_cmd_confmemw (buffer1, sizeof(buffer1), &(g_edio24cli.frame), address, count, buffer2);
+    edio24_cmdrec_t rec;
+    ssize_t ret;
+    size_t off;
+
+    if ((NULL != g_edio24cli.fn_conf) && (0 == edio24cli_map_script(g_edio24cli.fn_conf))) {
+        g_edio24cli.stream = g_edio24cli.map;
+        g_edio24cli.sz_stream = g_edio24cli.sz_map;
+    } else {
+        if (edio24_cmdstream_init(&(g_edio24cli.cmds)) < 0) {
+            return -1;
         }
-#undef CSTR_CUR_COMMAND
-#define CSTR_CUR_COMMAND "SettingsMemoryW"
-    } else if (0 == STRCMP_STATIC (buf, CSTR_CUR_COMMAND)) {
-        address = strtol(buf + sizeof(CSTR_CUR_COMMAND), &endptr, 16);
-        count = parse_hex_buf(endptr + 1, strlen(endptr + 1), buffer2, sizeof(buffer2));
-        if (count < 0) {
-            fprintf(stderr, "Error in parse " CSTR_CUR_COMMAND ", tcp cli ret=%" PRIiSZ ".\n", count);
-        } else {
-            fprintf(stderr, "dump of parameter of " CSTR_CUR_COMMAND ", size=%" PRIiSZ ":\n", count);
-            hex_dump_to_fd(STDERR_FILENO, (opaque_t *)(buffer2), count);
-            ret = edio24_pkt_create_cmd_setmemw (buffer1, sizeof(buffer1), &(g_edio24cli.frame), address, count, buffer2);
+        g_edio24cli.num_lines = 0;
+        g_edio24cli.num_errors = 0;
+        if (read_file_lines (g_edio24cli.fn_conf, &(g_edio24cli.cmds), process_command) < 0) {
+            return -1;
         }
-#undef CSTR_CUR_COMMAND
-#define CSTR_CUR_COMMAND "BootloaderMemoryW"
-    } else if (0 == STRCMP_STATIC (buf, CSTR_CUR_COMMAND)) {
-        address = strtol(buf + sizeof(CSTR_CUR_COMMAND), &endptr, 16);
-        count = parse_hex_buf(endptr + 1, strlen(endptr + 1), buffer2, sizeof(buffer2));
-        if (count < 0) {
-            fprintf(stderr, "Error in parse " CSTR_CUR_COMMAND ", tcp cli ret=%" PRIiSZ ".\n", count);
-        } else {
-            fprintf(stderr, "dump of parameter of " CSTR_CUR_COMMAND ", size=%" PRIiSZ ":\n", count);
-            hex_dump_to_fd(STDERR_FILENO, (opaque_t *)(buffer2), count);
-            ret = edio24_pkt_create_cmd_bootmemw (buffer1, sizeof(buffer1), &(g_edio24cli.frame), address, count, buffer2);
+        if (g_edio24cli.num_errors > 0) {
+            fprintf(stderr, "tcp cli %" PRIuSZ " error(s) in the script\n", g_edio24cli.num_errors);
+            return -1;
+        }
+        g_edio24cli.stream = g_edio24cli.cmds.buf;
+        g_edio24cli.sz_stream = g_edio24cli.cmds.sz;
+    }
+    g_edio24cli.num_pkts = 0;
+    for (off = EDIO24_CMDSTREAM_HDR_SIZE; (ret = edio24_cmdstream_next(g_edio24cli.stream, g_edio24cli.sz_stream, off, &rec)) > 0; off += ret) {
+        if (EDIO24_CMDSTREAM_OP_PKT == rec.op) {
+            g_edio24cli.num_pkts ++;
         }
-#undef CSTR_CUR_COMMAND
-#define CSTR_CUR_COMMAND "Sleep"
-    } else if (0 == STRCMP_STATIC (buf, CSTR_CUR_COMMAND)) {
-        count = strtol(buf + sizeof(CSTR_CUR_COMMAND), &endptr, 10);
-        fprintf(stderr, "tcp cli sleep %" PRIiSZ " microseconds ...\n", count);
-        usleep (count); /* Yes, I know we should use libuv's timeout callback here */
-        ret = 0;
-#undef CSTR_CUR_COMMAND
     }
     if (ret < 0) {
-        fprintf(stderr, "tcp cli ignore line at pos(%ld): %s\n", pos, buf);
-        return 0;
+        fprintf(stderr, "tcp cli error in the script at pos(%" PRIuSZ ")\n", off);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * \brief release the script
+ */
+static void
+edio24cli_unload_script (void)
+{
+    if (NULL != g_edio24cli.map) {
+        munmap(g_edio24cli.map, g_edio24cli.sz_map);
+        g_edio24cli.map = NULL;
+    }
+    edio24_cmdstream_clean(&(g_edio24cli.cmds));
+    g_edio24cli.stream = NULL;
+    g_edio24cli.sz_stream = 0;
+}
+
+/**
+ * \brief compile the text lines to a precompiled script
+ * \param fn_conf: the text file, NULL for stdin
+ * \param fn_out: the output file
+ * \return 0 on success, <0 on error
+ */
+static int
+edio24cli_compile (const char * fn_conf, const char * fn_out)
+{
+    FILE * fp;
+    int ret = 0;
+
+    memset (&g_edio24cli, 0, sizeof (g_edio24cli));
+    g_edio24cli.fn_conf = fn_conf;
+    if (edio24cli_load_script() < 0) {
+        edio24cli_unload_script();
+        return -1;
+    }
+    fp = fopen(fn_out, "wb");
+    if (NULL == fp) {
+        fprintf(stderr, "error in open file: '%s'.\n", fn_out);
+        edio24cli_unload_script();
+        return -1;
+    }
+    if (fwrite(g_edio24cli.stream, 1, g_edio24cli.sz_stream, fp) != g_edio24cli.sz_stream) {
+        fprintf(stderr, "error in write file: '%s'.\n", fn_out);
+        ret = -1;
+    }
+    if (0 != fclose(fp)) {
+        ret = -1;
+    }
+    fprintf(stderr, "compiled %" PRIuSZ " packets, %" PRIuSZ " bytes to '%s'\n", g_edio24cli.num_pkts, g_edio24cli.sz_stream, fn_out);
+    edio24cli_unload_script();
+    return ret;
+}
+
+/**
+ * \brief load the script and start to send its records to the session at their time
+ * \return 0 on success, <0 on error
+ *
+ * The script is loaded only when the session is ready to run it, so the discovery never reads it (or stdin).
+ */
+static int
+edio24cli_run_script (void)
+{
+    if (edio24cli_load_script() < 0) {
+        edio24cli_unload_script();
+        return -1;
+    }
+    g_edio24cli.flg_scheduling = 1;
+    g_edio24cli.off_next = EDIO24_CMDSTREAM_HDR_SIZE;
+    g_edio24cli.offset_next = 0;
+    edio24_timer_init(&(g_edio24cli.tm_job));
+    g_edio24cli.time_start = edio24_clock_now(&(g_edio24cli.uvclk.clock));
+    if (g_edio24cli.flg_adaptive) {
+        edio24_session_set_window(&(g_edio24cli.session), &(g_edio24cli.uvclk.clock), 1, EDIO24_SESSION_WINDOW_MAX);
+    }
+    if (! g_edio24cli.uvclk.clock.flg_virtual) {
+        // the virtual time doesn't move while waiting for the device, the backoff would never end
+        if (g_edio24cli.retry_budget > 0) {
+            edio24_session_set_retry(&(g_edio24cli.session), &(g_edio24cli.uvclk.clock), EDIO24_SESSION_RETRY_BACKOFF, g_edio24cli.retry_budget);
+        }
+        if (g_edio24cli.deadline > 0) {
+            edio24_session_set_timeout(&(g_edio24cli.session), &(g_edio24cli.uvclk.clock), g_edio24cli.deadline);
+        }
     }
-    fprintf(stderr, "tcp cli created packet size=%" PRIiSZ ":\n", ret);
-    hex_dump_to_fd(STDERR_FILENO, (opaque_t *)(buffer1), ret);
-    assert (ret <= sizeof(buffer1));
-    send_buffer(stream, buffer1, ret);
-    g_edio24cli.num_requests ++;
+    edio24cli_sched_run();
     return 0;
 }
 
@@ -398,9 +529,48 @@ on_tcp_cli_connect(uv_connect_t* connection, int status)
 {
     uv_stream_t* stream = connection->handle;
 
+    if (status < 0) {
+        fprintf(stderr, "tcp cli connect error %s\n", uv_strerror(status));
+        flg_has_error = 1;
+        raise(SIGINT);
+        return;
+    }
     fprintf(stderr, "tcp cli connected.\n");
 
-    read_file_lines (g_edio24cli.fn_conf, (void *)stream, process_command);
+    uvtransport_init(&(g_edio24cli.transport), stream);
+    edio24_session_init(&(g_edio24cli.session), &(g_edio24cli.transport.base));
+    edio24_session_set_default(&(g_edio24cli.session), on_cli_respond_unknown, NULL);
+    if (edio24cli_run_script() < 0) {
+        flg_has_error = 1;
+        raise(SIGINT);
+        return;
+    }
+    uv_read_start(stream, alloc_buffer, on_tcp_cli_read);
+}
+
+void
+on_pipe_cli_connect(uv_connect_t* connection, int status)
+{
+    uv_stream_t* stream = connection->handle;
+
+    if (status < 0) {
+        fprintf(stderr, "tcp cli connect to the daemon '%s' error %s\n", g_edio24cli.path_daemon, uv_strerror(status));
+        flg_has_error = 1;
+        raise(SIGINT);
+        return;
+    }
+    fprintf(stderr, "tcp cli connected to the daemon.\n");
+
+    // the packets are wrapped by the messages of the daemon
+    uvtransport_init(&(g_edio24cli.transport), stream);
+    edio24d_client_init(&(g_edio24cli.dcl), &(g_edio24cli.transport.base), g_edio24cli.device);
+    edio24_session_init(&(g_edio24cli.session), &(g_edio24cli.dcl.base));
+    edio24_session_set_default(&(g_edio24cli.session), on_cli_respond_unknown, NULL);
+    if (edio24cli_run_script() < 0) {
+        flg_has_error = 1;
+        raise(SIGINT);
+        return;
+    }
     uv_read_start(stream, alloc_buffer, on_tcp_cli_read);
 }
 
@@ -466,19 +636,13 @@ on_udp_cli_send(uv_udp_send_t *req, int status)
     uv_udp_recv_start(req->handle, alloc_buffer, on_udp_cli_read);
 }
 
-static char flg_has_error = 0;
-
 static void
-idle_cb (uv_idle_t *handle)
+on_timeout (edio24_timer_t * ptm, void * userdata)
 {
-    time_t curtime;
-    time(&curtime);
-    if (g_edio24cli.starttime + g_edio24cli.timeout <= curtime) {
-        flg_has_error = 1;
-        uv_idle_stop(handle);
-        uv_stop(uv_default_loop());
-        fprintf(stderr, "timeout: %d\n", (int)g_edio24cli.timeout);
-    }
+    flg_has_error = 1;
+    edio24_timer_stop(&(g_edio24cli.uvclk.clock), &(g_edio24cli.tm_job));
+    uv_stop(uv_default_loop());
+    fprintf(stderr, "timeout: %d\n", (int)g_edio24cli.timeout);
 }
 
 static void
@@ -505,22 +669,28 @@ on_sigint_received(uv_signal_t *handle, int signum)
 }
 
 int
-main_cli(const char * host, int port_udp, int port_tcp, time_t timeout, char flg_discovery, const char * fn_conf)
+main_cli(const char * host, int port_udp, int port_tcp, time_t timeout, char flg_discovery, const char * fn_conf, char flg_virtual, char flg_loopback, char flg_verbose, size_t window, char flg_adaptive, time_t retry, time_t deadline, const char * path_daemon, int device)
 {
     int ret = 0;
     struct sockaddr_in broadcast_addr;
     struct sockaddr_in addr_udp;
     uv_udp_t uvudp;
     uint32_t connect_code = 0;
-    uv_idle_t idler;
     uv_signal_t sigint;
 
     // setup service related info
     memset (&g_edio24cli, 0, sizeof (g_edio24cli));
-    g_edio24cli.frame = 0;
-    g_edio24cli.sz_data = 0;
+    g_edio24cli.flg_loopback = flg_loopback;
+    g_edio24cli.path_daemon = path_daemon;
+    g_edio24cli.device = device;
+    g_edio24cli.flg_verbose = flg_verbose;
+    g_edio24cli.window = window;
+    g_edio24cli.flg_adaptive = flg_adaptive;
+    g_edio24cli.retry_budget = (uint64_t)retry * 1000;
+    g_edio24cli.deadline = (uint64_t)deadline * 1000;
     g_edio24cli.num_requests = 0;
     g_edio24cli.num_responds = 0;
+    g_edio24cli.num_failed = 0;
     g_edio24cli.fn_conf = fn_conf;
     uv_ip4_addr(host, port_tcp, &(g_edio24cli.addr_tcp));
 
@@ -529,37 +699,80 @@ main_cli(const char * host, int port_udp, int port_tcp, time_t timeout, char flg
 
     uv_signal_init(loop, &sigint);
     uv_signal_start(&sigint, on_sigint_received, SIGINT);
+    if (uvclock_init(loop, &(g_edio24cli.uvclk), flg_virtual) < 0) {
+        return -1;
+    }
+    edio24_timer_init(&(g_edio24cli.tm_timeout));
+    edio24_timer_init(&(g_edio24cli.tm_job));
     if (timeout > 0) {
-        uv_idle_init(loop, &idler);
-        uv_idle_start(&idler, idle_cb);
+        edio24_timer_start(&(g_edio24cli.uvclk.clock), &(g_edio24cli.tm_timeout), (uint64_t)timeout * 1000000, on_timeout, NULL);
     }
-    time (&(g_edio24cli.starttime));
     g_edio24cli.timeout = timeout;
 
-    uv_tcp_init(loop, &(g_edio24cli.uvtcp));
-    uv_tcp_keepalive(&(g_edio24cli.uvtcp), 1, 60);
-
-    // setup the UDP client
-    uv_ip4_addr(host, port_udp, &(addr_udp));
-    uv_udp_init(loop, &uvudp);
-
-    // support broadcast addresses
-    uv_ip4_addr("0.0.0.0", 0, &broadcast_addr);
-    uv_udp_bind(&uvudp, (const struct sockaddr *)&broadcast_addr, 0);
-    uv_udp_set_broadcast(&uvudp, 1);
+    if (flg_loopback) {
+        // the simulated device on the other end of a loopback, no socket
+        uvloopback_init(loop, &(g_edio24cli.uvlb), 0);
+        edio24_svrsession_init(&(g_edio24cli.svr), edio24_loopback_device(&(g_edio24cli.uvlb.lb)), 0);
+        edio24_session_init(&(g_edio24cli.session), edio24_loopback_client(&(g_edio24cli.uvlb.lb)));
+        edio24_session_set_default(&(g_edio24cli.session), on_cli_respond_unknown, NULL);
+        if (edio24cli_run_script() < 0) {
+            flg_has_error = 1;
+        } else {
+            ret = uv_run(loop, UV_RUN_DEFAULT);
+        }
+        fprintf(stderr, "loopback: request=%" PRIuSZ ", respond=%" PRIuSZ ", bytes_out=%" PRIuSZ ", bytes_in=%" PRIuSZ "\n"
+            , g_edio24cli.session.stats.num_request, g_edio24cli.session.stats.num_respond
+            , g_edio24cli.session.stats.bytes_out, g_edio24cli.session.stats.bytes_in);
+        g_edio24cli.flg_done = 1; // the requests cancelled are not scheduled again
+        edio24_session_clean(&(g_edio24cli.session));
+        edio24_svrsession_clean(&(g_edio24cli.svr));
+        uvloopback_clean(&(g_edio24cli.uvlb));
+        uvclock_clean(&(g_edio24cli.uvclk));
+        edio24cli_unload_script();
+        if (ret != 0) {
+            return ret;
+        }
+        return (flg_has_error ? 1 : 0);
+    }
 
-    uv_udp_send_t send_req;
-    uv_buf_t msg;
-    alloc_buffer((uv_handle_t*)&send_req, 5, &msg);
-    if (flg_discovery) {
-        msg.len = edio24_pkt_create_discoverydev((uint8_t *)(msg.base), msg.len);
+    if (NULL != path_daemon) {
+        // the daemon keeps the device opened, no UDP and TCP handshakes
+        uv_pipe_init(loop, &(g_edio24cli.uvpipe), 0);
+        uv_pipe_connect(&(g_edio24cli.connect), &(g_edio24cli.uvpipe), path_daemon, on_pipe_cli_connect);
     } else {
-        edio24_pkt_create_opendev((uint8_t *)(msg.base), msg.len, connect_code);
+        uv_tcp_init(loop, &(g_edio24cli.uvtcp));
+        uv_tcp_keepalive(&(g_edio24cli.uvtcp), 1, 60);
+
+        // setup the UDP client
+        uv_ip4_addr(host, port_udp, &(addr_udp));
+        uv_udp_init(loop, &uvudp);
+
+        // support broadcast addresses
+        uv_ip4_addr("0.0.0.0", 0, &broadcast_addr);
+        uv_udp_bind(&uvudp, (const struct sockaddr *)&broadcast_addr, 0);
+        uv_udp_set_broadcast(&uvudp, 1);
+
+        uv_udp_send_t send_req;
+        uv_buf_t msg;
+        alloc_buffer((uv_handle_t*)&send_req, 5, &msg);
+        if (flg_discovery) {
+            msg.len = edio24_pkt_create_discoverydev((uint8_t *)(msg.base), msg.len);
+        } else {
+            edio24_pkt_create_opendev((uint8_t *)(msg.base), msg.len, connect_code);
+        }
+        uv_udp_send(&send_req, &uvudp, &msg, 1, (const struct sockaddr *)&addr_udp, on_udp_cli_send);
     }
-    uv_udp_send(&send_req, &uvudp, &msg, 1, (const struct sockaddr *)&addr_udp, on_udp_cli_send);
 
     ret = uv_run(loop, UV_RUN_DEFAULT);
     // uv_signal_stop(&sigint);
+    if (flg_virtual) {
+        fprintf(stderr, "tcp cli virtual time elapsed: %" PRIu64 " microseconds\n", edio24_clock_now(&(g_edio24cli.uvclk.clock)));
+    }
+    g_edio24cli.flg_done = 1; // the requests cancelled are not scheduled again
+    edio24_session_clean(&(g_edio24cli.session));
+    edio24d_client_clean(&(g_edio24cli.dcl));
+    uvclock_clean(&(g_edio24cli.uvclk));
+    edio24cli_unload_script();
     if (ret != 0) {
         return ret;
     }
@@ -579,6 +792,7 @@ version (void)
 static void
 help(const char * progname)
 {
+    size_t i;
     printf ("Usage: \n"
             "\t%s [-h] [-v] [-d] [-t <TCP port>] [-u <UDP port>] [-a '<bind addr>']\n"
             , basename(progname));
@@ -586,11 +800,23 @@ help(const char * progname)
     printf ("\t-r <addr>\tE-DIO24 device address\n");
     printf ("\t-t <port>\tE-DIO24 command (TCP) listen port\n");
     printf ("\t-u <port>\tE-DIO24 discover (UDP) listen port\n");
-    printf ("\t-e <cmd file>\tExecute the command lines in the file\n");
+    printf ("\t-e <cmd file>\tExecute the command lines in the file, or a file compiled by -c\n");
+    printf ("\t-c <out file>\tCompile the command lines to a binary file and exit\n");
     printf ("\t-m <time>\tthe seconds of timeout\n");
+    printf ("\t-w <num>\tthe max number of requests waiting for the responses, 0 -- no limit (default), 'auto' -- adapted to the device\n");
+    printf ("\t-R <time>\tthe milliseconds to send again the failed reads and writes of absolute values on busy, timeout or protocol error, 0 -- no retry, default %d\n", EDIO24_SESSION_RETRY_BUDGET / 1000);
+    printf ("\t-D <time>\tthe milliseconds to wait for the response of a request before it is taken as a timeout, 0 -- no limit (default)\n");
+    printf ("\t-s\tUse the virtual time, Sleep and timeout advance without waiting\n");
     printf ("\t-d\tDiscovery devices\n");
+    printf ("\t-k\tExecute the commands on a simulated device in the process (loopback)\n");
+    printf ("\t-p <path>\tSend the commands through the daemon edio24d listening on the UNIX domain socket\n");
+    printf ("\t-n <num>\tthe index of the device in the daemon, default 0\n");
     printf ("\t-h\tPrint this message.\n");
-    printf ("\t-v\tVerbose information.\n");
+    printf ("\t-v\tVerbose information, show the requested and the achieved time of each command.\n");
+    printf ("\nCommands:\n");
+    for (i = 0; i < edio24_script_num_cmds(); i ++) {
+        printf ("\t%s\n", edio24_script_cmd(i)->example);
+    }
 }
 
 static void
@@ -605,11 +831,20 @@ main(int argc, char * argv[])
 {
     char flg_verbose = 0;
     char flg_discovery = 0;
+    char flg_virtual = 0;
+    char flg_loopback = 0;
     const char * host = "127.0.0.1";
     int port_udp = EDIO24_PORT_DISCOVER;
     int port_tcp = EDIO24_PORT_COMMAND;
     const char * fn_conf = NULL;
+    const char * fn_compile = NULL;
     time_t timeout = 0;
+    size_t window = 0;
+    char flg_adaptive = 0;
+    time_t retry = EDIO24_SESSION_RETRY_BUDGET / 1000;
+    time_t deadline = 0;
+    const char * path_daemon = NULL;
+    int device = 0;
 
     int c;
     struct option longopts[]  = {
@@ -617,26 +852,61 @@ main(int argc, char * argv[])
         { "portudp",      1, 0, 'u' },
         { "porttcp",      1, 0, 't' },
         { "execute",      1, 0, 'e' },
+        { "compile",      1, 0, 'c' },
         { "discovery",    0, 0, 'd' },
         { "timeout",      1, 0, 'm' },
+        { "virtualtime",  0, 0, 's' },
+        { "loopback",     0, 0, 'k' },
+        { "window",       1, 0, 'w' },
+        { "retry",        1, 0, 'R' },
+        { "deadline",     1, 0, 'D' },
+        { "daemon",       1, 0, 'p' },
+        { "device",       1, 0, 'n' },
 
         { "help",         0, 0, 'h' },
         { "verbose",      0, 0, 'v' },
         { 0,              0, 0,  0  },
     };
 
-    while ((c = getopt_long( argc, argv, "r:u:t:e:m:dhv", longopts, NULL )) != EOF) {
+    while ((c = getopt_long( argc, argv, "r:u:t:e:c:m:w:R:D:p:n:skdhv", longopts, NULL )) != EOF) {
         switch (c) {
             case 'm':
                 if (strlen (optarg) > 0) {
                     timeout = atoi(optarg);
                 }
                 break;
+            case 'w':
+                if (0 == strcmp(optarg, "auto")) {
+                    flg_adaptive = 1;
+                } else if (strlen (optarg) > 0) {
+                    window = atoi(optarg);
+                }
+                break;
+            case 'R':
+                if (strlen (optarg) > 0) {
+                    retry = atoi(optarg);
+                }
+                break;
+            case 'D':
+                if (strlen (optarg) > 0) {
+                    deadline = atoi(optarg);
+                }
+                break;
             case 'r':
                 if (strlen (optarg) > 0) {
                     host = optarg;
                 }
                 break;
+            case 'p':
+                if (strlen (optarg) > 0) {
+                    path_daemon = optarg;
+                }
+                break;
+            case 'n':
+                if (strlen (optarg) > 0) {
+                    device = atoi(optarg);
+                }
+                break;
             case 't':
                 if (strlen (optarg) > 0) {
                     port_tcp = atoi(optarg);
@@ -652,9 +922,20 @@ main(int argc, char * argv[])
                     fn_conf = optarg;
                 }
                 break;
+            case 'c':
+                if (strlen (optarg) > 0) {
+                    fn_compile = optarg;
+                }
+                break;
             case 'd':
                 flg_discovery = 1;
                 break;
+            case 's':
+                flg_virtual = 1;
+                break;
+            case 'k':
+                flg_loopback = 1;
+                break;
 
             case 'h':
                 usage (argv[0]);
@@ -670,7 +951,9 @@ main(int argc, char * argv[])
                 break;
         }
     }
-    (void)flg_verbose;
 
-    return main_cli(host, port_udp, port_tcp, timeout, flg_discovery, fn_conf);
+    if (NULL != fn_compile) {
+        return (edio24cli_compile(fn_conf, fn_compile) < 0 ? 1 : 0);
+    }
+    return main_cli(host, port_udp, port_tcp, timeout, flg_discovery, fn_conf, flg_virtual, flg_loopback, flg_verbose, window, flg_adaptive, retry, deadline, path_daemon, device);
 }
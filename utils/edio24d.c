@@ -0,0 +1,1583 @@
+/**
+ * \file    edio24d.c
+ * \brief   a daemon keeping the sessions to the E-DIO24 devices
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ *
+ * The daemon opens every device of the fleet list once ('open device' by UDP, then the TCP
+ * connection), and keeps the sessions. The clients send the requests to the daemon by a
+ * UNIX domain socket (edio24dmsg.h), so a command costs one round trip to the device
+ * instead of the UDP and TCP handshakes, and the clients share the device which accepts
+ * only one connection. A lost connection is opened again with an increasing delay.
+ *
+ * The daemon can also be a proxy of the native E-DIO24 protocol ('-l <port>'): the device i
+ * of the fleet is served on the TCP and UDP port (port + i), so the unmodified tools connect
+ * to the proxy as a device, and any number of them share the single connection to the device.
+ * The frame ids of the requests of all of the clients are rewritten to the ones of the daemon.
+ *
+ * The sessions coalesce the identical reads in flight to a device, and cache the responses
+ * of the commands given by '-c <command>=<milliseconds>' (edio24_session_set_cache()).
+ *
+ * The latest states of the devices are published to a POSIX shared memory by '-s <name>'
+ * (edio24shm.h), the local processes read them without any request to the daemon. The states
+ * are taken from the responses to the clients, and from the reads sent by the daemon every
+ * '-i <milliseconds>'. Every value read is also appended to a ring of the samples in a shared
+ * memory by '-b <name>', so the local readers get all of the samples, not only the latest ones.
+ * The samples can be recorded to a file by '-w <file>' (edio24rec.h), the chunks are written
+ * by the thread pool of libuv, so the loop never waits for the disk.
+ */
+
+#define EDIO24D_MAIN  1
+#define EDIO24D_MINOR 0
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h> // unlink()
+#include <fcntl.h>  // open()
+#include <sys/mman.h> // mmap()
+#include <sys/stat.h>
+#include <libgen.h> // basename()
+#include <string.h> // memmove
+#include <sys/time.h> // gettimeofday()
+#include <time.h> // clock_gettime()
+#include <getopt.h>
+#include <assert.h>
+#include <uv.h>
+
+#include "libedio24.h"
+#include "edio24dmsg.h"
+#include "edio24script.h"
+#include "edio24shm.h"
+#include "edio24rec.h"
+#include "utils.h"
+#include "uvclock.h"
+#include "uvtransport.h"
+
+#define EDIO24D_MAX_DEVICES 1024
+#define EDIO24D_RETRY_MIN    100000 /**< the microseconds to wait before opening a device again */
+#define EDIO24D_RETRY_MAX   5000000
+#define EDIO24D_OPEN_TIMEOUT 1000000 /**< the microseconds to wait for the reply of 'open device' */
+#define EDIO24D_POLL_INTERVAL 100    /**< the default milliseconds between the reads of the published states */
+#define EDIO24D_REC_FLUSH   1000000 /**< the microseconds to write the chunk of the recording not full */
+
+/** a device of the fleet */
+typedef struct _edio24d_dev_t {
+    size_t idx;
+    struct sockaddr_in addr_udp;
+    struct sockaddr_in addr_tcp;
+    char state;         /**< EDIO24D_DEV_xxx */
+    char flg_loopback;  /**< 1 -- a simulated device in the process */
+
+    uv_udp_t udp;
+    uv_udp_send_t req_udp;
+    uint8_t buf_udp[8]; /**< the 'open device' packet */
+    uv_tcp_t tcp;
+    uv_connect_t connect;
+    uvtransport_t transport; /**< the transport on tcp */
+    uvloopback_t uvlb;       /**< the transport to the simulated device */
+    edio24_svrsession_t svr; /**< the simulated device */
+    edio24_session_t session;
+
+    edio24_timer_t tm_retry; /**< open the device again, or the timeout of 'open device' */
+    uint64_t backoff;        /**< the microseconds to wait before the next retry */
+
+    edio24_shm_state_t shm_state; /**< the state published to the shared memory */
+    edio24_timer_t tm_poll;  /**< read the state of the device */
+    size_t num_poll;         /**< the number of the reads of the state waiting for the responses */
+
+    uv_tcp_t proxy_tcp; /**< the native protocol port of the proxy */
+    uv_udp_t proxy_udp;
+
+    size_t num_open;    /**< the number of the sessions opened */
+    size_t num_request; /**< the number of the requests sent to the device */
+    size_t num_respond; /**< the number of the responses returned to the clients */
+    size_t num_reject;  /**< the number of the requests rejected because the device is not ready */
+    size_t num_coalesce; /**< the number of the reads returned by the response of an identical read */
+    size_t num_cached;  /**< the number of the reads returned by the cache */
+} edio24d_dev_t;
+
+/** a client connected to the UNIX domain socket, or to the native protocol port of a device */
+typedef struct _edio24d_conn_t {
+    union {
+        uv_stream_t stream;
+        uv_pipe_t pipe;  /**< the UNIX domain socket */
+        uv_tcp_t tcp;    /**< the native protocol */
+    } h;
+    uvtransport_t transport;
+    size_t sz_rxmax;
+    size_t sz_rx;
+    uint8_t * rxbuf;
+    char flg_native;    /**< 1 -- the client talks the native protocol to the device of the port */
+    uint16_t device;    /**< the device of the native protocol port */
+    edio24_svrsession_t svr; /**< the splitter of the native requests */
+    size_t num_pending; /**< the number of the requests waiting for the responses */
+    char flg_closed;    /**< 1 -- the connection is closing, no more message is sent */
+    char flg_released;  /**< 1 -- the handle is closed, the connection is freed by the last response */
+    struct _edio24d_conn_t * prev; /**< the list of the connections not closed */
+    struct _edio24d_conn_t * next;
+} edio24d_conn_t;
+
+/** a request forwarded to a device */
+typedef struct _edio24d_req_t {
+    edio24d_conn_t * pconn;
+    uint16_t device;
+    uint8_t cmd;
+    uint8_t frame; /**< the frame id of the client */
+} edio24d_req_t;
+
+/** a chunk of the recording waiting to be written */
+typedef struct _edio24d_chunk_t {
+    struct _edio24d_chunk_t * next;
+    uint8_t * buf;
+    size_t sz;
+} edio24d_chunk_t;
+
+typedef struct _edio24d_t {
+    const char * path;      /**< the path of the UNIX domain socket */
+    uv_pipe_t server;
+    edio24d_conn_t * conns; /**< the connections of the clients */
+    edio24d_dev_t * devs;
+    size_t num_devs;
+    size_t sz_devs;
+    int port_udp;           /**< the default ports of the fleet list */
+    int port_tcp;
+    char flg_verbose;
+    char flg_has_error;
+    char flg_closing;
+    size_t num_conns;       /**< the number of the clients accepted */
+    time_t timeout;
+    size_t num_caches;      /**< the TTLs of the commands set by '-c' */
+    uint8_t cache_cmd[EDIO24_SESSION_NUM_READS];
+    uint64_t cache_ttl[EDIO24_SESSION_NUM_READS];
+    char flg_shm;           /**< 1 -- the states are published to shm */
+    edio24_shm_t shm;
+    char flg_ring;          /**< 1 -- the samples are appended to ring */
+    edio24_shm_ring_t ring;
+    char flg_rec;           /**< 1 -- the samples are recorded to fd_rec */
+    char flg_rec_writing;   /**< 1 -- the first chunk of the queue is being written */
+    edio24_rec_writer_t rec;
+    uv_file fd_rec;
+    uv_fs_t req_rec;
+    edio24d_chunk_t * rec_head; /**< the chunks to be written in order */
+    edio24d_chunk_t * rec_tail;
+    edio24_timer_t tm_rec;  /**< write the chunk not full */
+    uint64_t poll;          /**< the microseconds between the reads of the states, 0 -- no read */
+    uvclock_t uvclk;
+    edio24_timer_t tm_timeout;
+} edio24d_t;
+
+static edio24d_t g_edio24d;
+
+static void edio24d_dev_open (edio24d_dev_t * pdev);
+static void edio24d_dev_update (edio24d_dev_t * pdev, const edio24_response_t * presp);
+
+static void
+alloc_buffer(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf)
+{
+    buf->base = malloc(suggested_size);
+    buf->len = suggested_size;
+}
+
+/*****************************************************************************/
+/**
+ * \brief send a message to a client
+ * \param pconn: the client
+ * \param type: EDIO24D_MSG_xxx
+ * \param device: the index of the device
+ * \param payload: the payload
+ * \param sz: the byte size of the payload
+ *
+ * The clients of the native protocol get the packets only.
+ */
+static void
+edio24d_conn_send (edio24d_conn_t * pconn, uint8_t type, uint16_t device, const uint8_t * payload, size_t sz)
+{
+    uint8_t msg[EDIO24D_MSG_HDR_SIZE + EDIO24D_MSG_PAYLOAD_MAX];
+    ssize_t ret;
+
+    if (pconn->flg_closed) {
+        return;
+    }
+    if (pconn->flg_native) {
+        if (EDIO24D_MSG_PKT == type) {
+            edio24_transport_send(&(pconn->transport.base), payload, sz);
+        }
+        return;
+    }
+    ret = edio24d_msg_create(msg, sizeof(msg), type, device, payload, sz);
+    if (ret > 0) {
+        edio24_transport_send(&(pconn->transport.base), msg, ret);
+    }
+}
+
+/**
+ * \brief return a response without data to a client, for the requests not sent to the device
+ */
+static void
+edio24d_conn_reply_status (edio24d_conn_t * pconn, uint16_t device, uint8_t cmd, uint8_t frame, uint8_t status)
+{
+    uint8_t pkt[EDIO24_PKT_LENGTH_MIN];
+    if (edio24_pkt_create_respond(pkt, sizeof(pkt), cmd, frame, status, 0, NULL) > 0) {
+        edio24d_conn_send(pconn, EDIO24D_MSG_PKT, device, pkt, sizeof(pkt));
+    }
+}
+
+static void
+edio24d_conn_free (edio24d_conn_t * pconn)
+{
+    if (pconn->flg_native) {
+        edio24_svrsession_clean(&(pconn->svr));
+    }
+    free(pconn->rxbuf);
+    free(pconn);
+}
+
+static void
+on_conn_close (uv_handle_t * handle)
+{
+    edio24d_conn_t * pconn = (edio24d_conn_t *)(handle->data);
+    assert (NULL != pconn);
+    if (NULL != pconn->prev) {
+        pconn->prev->next = pconn->next;
+    } else if (g_edio24d.conns == pconn) {
+        g_edio24d.conns = pconn->next;
+    }
+    if (NULL != pconn->next) {
+        pconn->next->prev = pconn->prev;
+    }
+    if (pconn->num_pending > 0) {
+        pconn->flg_released = 1; // freed by the last response
+        return;
+    }
+    edio24d_conn_free(pconn);
+}
+
+static void
+edio24d_conn_close (edio24d_conn_t * pconn)
+{
+    if (pconn->flg_closed) {
+        return;
+    }
+    pconn->flg_closed = 1;
+    if (! uv_is_closing((uv_handle_t *)&(pconn->h.stream))) {
+        uv_close((uv_handle_t *)&(pconn->h.stream), on_conn_close);
+    }
+}
+
+/**
+ * \brief the callback of the session of a device, return the response to the client
+ */
+static void
+on_dev_respond (edio24_session_t * pss, const edio24_response_t * presp, void * userdata)
+{
+    edio24d_req_t * preq = (edio24d_req_t *)userdata;
+    edio24d_conn_t * pconn = preq->pconn;
+    uint8_t pkt[EDIO24D_MSG_PAYLOAD_MAX];
+
+    if (NULL == presp) {
+        edio24d_conn_reply_status(pconn, preq->device, preq->cmd, preq->frame, EDIO24_STATUS_ERROR_OTHER);
+    } else {
+        g_edio24d.devs[preq->device].num_respond ++;
+        edio24d_dev_update(&(g_edio24d.devs[preq->device]), presp);
+        memmove(pkt, presp->pkt, presp->sz_pkt);
+        edio24d_pkt_reframe(pkt, presp->sz_pkt, preq->frame);
+        edio24d_conn_send(pconn, EDIO24D_MSG_PKT, preq->device, pkt, presp->sz_pkt);
+    }
+    pconn->num_pending --;
+    if (pconn->flg_released && (0 == pconn->num_pending)) {
+        edio24d_conn_free(pconn);
+    }
+    free(preq);
+}
+
+/**
+ * \brief check a request packet from a client
+ * \return 0 if the packet is a whole request, <0 on error
+ */
+static int
+edio24d_check_request (const uint8_t * pkt, size_t sz)
+{
+    uint16_t count;
+    if ((sz < EDIO24_PKT_LENGTH_MIN) || (EDIO24_PKT_START != pkt[0])) {
+        return -1;
+    }
+    count = pkt[4] | ((uint16_t)pkt[5] << 8);
+    if (EDIO24_PKT_LENGTH_MIN + count != sz) {
+        return -1;
+    }
+    return edio24_pkt_verify((uint8_t *)pkt, sz);
+}
+
+/**
+ * \brief forward a request packet of a client to the device
+ */
+static void
+edio24d_forward (edio24d_conn_t * pconn, uint16_t device, const uint8_t * payload, size_t sz)
+{
+    uint8_t pkt[EDIO24D_MSG_PAYLOAD_MAX];
+    edio24d_dev_t * pdev;
+    edio24d_req_t * preq;
+
+    if (edio24d_check_request(payload, sz) < 0) {
+        fprintf(stderr, "edio24d drop an illegal request of device %d\n", device);
+        return;
+    }
+    if (device >= g_edio24d.num_devs) {
+        edio24d_conn_reply_status(pconn, device, payload[1], payload[2], EDIO24_STATUS_ERROR_PARAMETER);
+        return;
+    }
+    pdev = &(g_edio24d.devs[device]);
+    if (EDIO24D_DEV_READY != pdev->state) {
+        pdev->num_reject ++;
+        edio24d_conn_reply_status(pconn, device, payload[1], payload[2], EDIO24_STATUS_ERROR_READY);
+        return;
+    }
+    preq = (edio24d_req_t *)malloc(sizeof(*preq));
+    if (NULL == preq) {
+        edio24d_conn_reply_status(pconn, device, payload[1], payload[2], EDIO24_STATUS_ERROR_BUSY);
+        return;
+    }
+    memmove(pkt, payload, sz);
+    preq->pconn = pconn;
+    preq->device = device;
+    preq->cmd = pkt[1];
+    // the frame ids of the device are assigned by the daemon, the clients may use the same ones
+    preq->frame = edio24d_pkt_reframe(pkt, sz, pdev->session.frame ++);
+    pconn->num_pending ++;
+    if (edio24_session_send(&(pdev->session), pkt, sz, on_dev_respond, preq) < 0) {
+        pconn->num_pending --;
+        edio24d_conn_reply_status(pconn, device, preq->cmd, preq->frame, EDIO24_STATUS_ERROR_BUSY);
+        free(preq);
+        return;
+    }
+    pdev->num_request ++;
+}
+
+/**
+ * \brief return the states of the devices
+ */
+static void
+edio24d_list (edio24d_conn_t * pconn)
+{
+    uint8_t payload[EDIO24D_MSG_PAYLOAD_MAX];
+    uint8_t * p;
+    uint16_t port;
+    size_t i;
+
+    for (i = 0; (i < g_edio24d.num_devs) && ((i + 1) * EDIO24D_LIST_ENTRY_SIZE <= sizeof(payload)); i ++) {
+        p = payload + i * EDIO24D_LIST_ENTRY_SIZE;
+        p[0] = g_edio24d.devs[i].state;
+        p[1] = 0;
+        memmove(p + 2, &(g_edio24d.devs[i].addr_tcp.sin_addr.s_addr), 4);
+        port = ntohs(g_edio24d.devs[i].addr_tcp.sin_port);
+        p[6] = port & 0xFF;
+        p[7] = (port >> 8) & 0xFF;
+    }
+    edio24d_conn_send(pconn, EDIO24D_MSG_LIST, i, payload, i * EDIO24D_LIST_ENTRY_SIZE);
+}
+
+/**
+ * \brief the receiver of the transport of a client
+ */
+static void
+edio24d_conn_recv (void * userdata, uint8_t * buf, size_t sz)
+{
+    edio24d_conn_t * pconn = (edio24d_conn_t *)userdata;
+    uint8_t payload[EDIO24D_MSG_PAYLOAD_MAX];
+    edio24d_msg_t msg;
+    ssize_t ret;
+
+    if (edio24_rxbuf_append(&(pconn->rxbuf), &(pconn->sz_rxmax), &(pconn->sz_rx), buf, sz) < 0) {
+        edio24d_conn_close(pconn);
+        return;
+    }
+    while ((! pconn->flg_closed) && (pconn->sz_rx > 0)) {
+        ret = edio24d_msg_read(pconn->rxbuf, pconn->sz_rx, &msg);
+        if (ret == 0) {
+            break; // need more data
+        }
+        if (ret < 0) {
+            fprintf(stderr, "edio24d close the client for an illegal message\n");
+            edio24d_conn_close(pconn);
+            break;
+        }
+        memmove(payload, msg.payload, msg.sz_payload);
+        edio24_rxbuf_consume(pconn->rxbuf, &(pconn->sz_rx), ret);
+        switch (msg.type) {
+        case EDIO24D_MSG_PKT:
+            edio24d_forward(pconn, msg.device, payload, msg.sz_payload);
+            break;
+        case EDIO24D_MSG_LIST:
+            edio24d_list(pconn);
+            break;
+        default:
+            fprintf(stderr, "edio24d ignore the message type 0x%02X\n", msg.type);
+            break;
+        }
+    }
+}
+
+/**
+ * \brief the processor of the device session of a native client, forward the requests to the device
+ *
+ * The arguments and the return value are the same as edio24_svr_process_tcp(),
+ * the responses are sent later by on_dev_respond().
+ */
+static int
+edio24d_proxy_process (void * userdata, char flg_force_fail, uint8_t * buffer_in, size_t sz_in, uint8_t * buffer_out, size_t *sz_out, size_t * sz_processed, size_t * sz_needed_in, size_t * sz_needed_out)
+{
+    edio24d_conn_t * pconn = (edio24d_conn_t *)userdata;
+    uint16_t count = 0;
+
+    *sz_out = 0;
+    if (EDIO24_PKT_START != buffer_in[0]) {
+        return -1;
+    }
+    if (edio24_pkt_read_hdr_count(buffer_in, sz_in, &count) < 0) {
+        *sz_needed_in = EDIO24_PKT_LENGTH_MIN - sz_in;
+        return 0;
+    }
+    if (EDIO24_PKT_LENGTH_MIN + count > EDIO24D_MSG_PAYLOAD_MAX) {
+        return -1;
+    }
+    if (EDIO24_PKT_LENGTH_MIN + count > sz_in) {
+        *sz_needed_in = EDIO24_PKT_LENGTH_MIN + count - sz_in;
+        return 0;
+    }
+    *sz_processed = EDIO24_PKT_LENGTH_MIN + count;
+    edio24d_forward(pconn, pconn->device, buffer_in, *sz_processed);
+    return 0;
+}
+
+static void
+on_conn_read (uv_stream_t * stream, ssize_t nread, const uv_buf_t * buf)
+{
+    edio24d_conn_t * pconn = (edio24d_conn_t *)(stream->data);
+    if (nread > 0) {
+        uvtransport_recv(&(pconn->transport), (uint8_t *)(buf->base), nread);
+    }
+    if (nread < 0) {
+        edio24d_conn_close(pconn);
+    }
+    free(buf->base);
+}
+
+/**
+ * \brief accept a client on the UNIX domain socket, or on the native protocol port of a device
+ * \param server: the listening handle
+ * \param pdev: the device of the native protocol port, NULL for the UNIX domain socket
+ */
+static void
+edio24d_accept (uv_stream_t * server, edio24d_dev_t * pdev)
+{
+    edio24d_conn_t * pconn;
+
+    pconn = (edio24d_conn_t *)calloc(1, sizeof(*pconn));
+    if (NULL == pconn) {
+        return;
+    }
+    if (NULL == pdev) {
+        uv_pipe_init(server->loop, &(pconn->h.pipe), 0);
+    } else {
+        uv_tcp_init(server->loop, &(pconn->h.tcp));
+        pconn->flg_native = 1;
+        pconn->device = pdev->idx;
+    }
+    pconn->h.stream.data = pconn;
+    pconn->next = g_edio24d.conns;
+    if (NULL != pconn->next) {
+        pconn->next->prev = pconn;
+    }
+    g_edio24d.conns = pconn;
+    if (0 != uv_accept(server, &(pconn->h.stream))) {
+        pconn->flg_closed = 1;
+        uv_close((uv_handle_t *)&(pconn->h.stream), on_conn_close);
+        return;
+    }
+    g_edio24d.num_conns ++;
+    uvtransport_init(&(pconn->transport), &(pconn->h.stream));
+    if (pconn->flg_native) {
+        uv_tcp_nodelay(&(pconn->h.tcp), 1);
+        edio24_svrsession_init(&(pconn->svr), &(pconn->transport.base), 0);
+        edio24_svrsession_set_process(&(pconn->svr), edio24d_proxy_process, pconn);
+    } else {
+        edio24_transport_set_receiver(&(pconn->transport.base), edio24d_conn_recv, pconn);
+    }
+    uv_read_start(&(pconn->h.stream), alloc_buffer, on_conn_read);
+}
+
+static void
+on_server_connection (uv_stream_t * server, int status)
+{
+    if (status < 0) {
+        fprintf(stderr, "edio24d connection error %s\n", uv_strerror(status));
+        return;
+    }
+    edio24d_accept(server, NULL);
+}
+
+static void
+on_proxy_connection (uv_stream_t * server, int status)
+{
+    if (status < 0) {
+        fprintf(stderr, "edio24d connection error %s\n", uv_strerror(status));
+        return;
+    }
+    edio24d_accept(server, (edio24d_dev_t *)(server->data));
+}
+
+/** a reply of the UDP port of the proxy */
+typedef struct _edio24d_udp_send_t {
+    uv_udp_send_t req; // should be the first item to bring by the argument
+    uv_buf_t buf;
+} edio24d_udp_send_t;
+
+static void
+on_proxy_udp_send (uv_udp_send_t * req, int status)
+{
+    edio24d_udp_send_t * wr = (edio24d_udp_send_t *)req;
+    if (status) {
+        fprintf(stderr, "edio24d udp write error %s\n", uv_strerror(status));
+    }
+    free(wr->buf.base);
+    free(wr);
+}
+
+/**
+ * \brief reply the discover and 'open device' of the native clients, the device is opened if it is ready
+ */
+static void
+on_proxy_udp_read (uv_udp_t * handle, ssize_t nread, const uv_buf_t * buf, const struct sockaddr * addr, unsigned flags)
+{
+    edio24d_dev_t * pdev = (edio24d_dev_t *)(handle->data);
+    edio24d_udp_send_t * wr;
+    uint8_t * pin = (uint8_t *)(buf->base);
+    size_t sz_out = 0;
+    size_t sz_needed_out = 0;
+
+    if ((nread == 1) && ('D' == pin[0]) && (buf->len >= 64)) {
+        sz_out = 64;
+        edio24_svr_process_udp(0, pin, nread, pin, &sz_out, &sz_needed_out);
+    } else if ((nread == 5) && ('C' == pin[0])) {
+        pin[1] = (EDIO24D_DEV_READY == pdev->state ? 0 : 1);
+        sz_out = 2;
+    }
+    if ((sz_out < 1) || (NULL == addr)) {
+        free(buf->base);
+        return;
+    }
+    wr = (edio24d_udp_send_t *)malloc(sizeof(*wr));
+    if (NULL == wr) {
+        free(buf->base);
+        return;
+    }
+    wr->buf = uv_buf_init(buf->base, sz_out);
+    if (0 != uv_udp_send(&(wr->req), handle, &(wr->buf), 1, addr, on_proxy_udp_send)) {
+        free(wr->buf.base);
+        free(wr);
+    }
+}
+
+/**
+ * \brief listen on the native protocol ports of a device
+ * \param pdev: the device
+ * \param host: the bind address
+ * \param port: the TCP and UDP port
+ * \return 0 on success, <0 on error
+ */
+static int
+edio24d_proxy_listen (edio24d_dev_t * pdev, uv_loop_t * loop, const char * host, int port)
+{
+    struct sockaddr_in addr;
+    int ret;
+
+    if (0 != uv_ip4_addr(host, port, &addr)) {
+        fprintf(stderr, "edio24d illegal IPv4 address: '%s'\n", host);
+        return -1;
+    }
+    uv_udp_init(loop, &(pdev->proxy_udp));
+    uv_tcp_init(loop, &(pdev->proxy_tcp));
+    pdev->proxy_udp.data = pdev;
+    pdev->proxy_tcp.data = pdev;
+    ret = uv_udp_bind(&(pdev->proxy_udp), (const struct sockaddr *)&addr, UV_UDP_REUSEADDR);
+    if (0 == ret) {
+        ret = uv_udp_recv_start(&(pdev->proxy_udp), alloc_buffer, on_proxy_udp_read);
+    }
+    if (0 == ret) {
+        ret = uv_tcp_bind(&(pdev->proxy_tcp), (const struct sockaddr *)&addr, 0);
+    }
+    if (0 == ret) {
+        ret = uv_listen((uv_stream_t *)&(pdev->proxy_tcp), 128, on_proxy_connection);
+    }
+    if (0 != ret) {
+        fprintf(stderr, "edio24d device %d: error in listen %s:%d: %s\n", (int)pdev->idx, host, port, uv_strerror(ret));
+        return -1;
+    }
+    return 0;
+}
+
+/*****************************************************************************/
+/**
+ * \brief start the session of a device on a transport, the reads are coalesced and cached
+ * \return 0 on success, <0 on error
+ */
+static int
+edio24d_session_init (edio24d_dev_t * pdev, edio24_transport_t * ptr)
+{
+    size_t i;
+
+    if (edio24_session_init(&(pdev->session), ptr) < 0) {
+        return -1;
+    }
+    // coalesce all of the reads, the other commands are refused by edio24_session_set_cache()
+    for (i = 0; i < edio24_script_num_cmds(); i ++) {
+        if (EDIO24_SCRIPT_PKT == edio24_script_cmd(i)->kind) {
+            edio24_session_set_cache(&(pdev->session), NULL, edio24_script_cmd(i)->cmd, 0);
+        }
+    }
+    for (i = 0; i < g_edio24d.num_caches; i ++) {
+        edio24_session_set_cache(&(pdev->session), &(g_edio24d.uvclk.clock), g_edio24d.cache_cmd[i], g_edio24d.cache_ttl[i]);
+    }
+    return 0;
+}
+
+/**
+ * \brief close the session of a device, the requests waiting for the responses are failed
+ */
+static void
+edio24d_session_clean (edio24d_dev_t * pdev)
+{
+    pdev->num_coalesce += pdev->session.stats.num_coalesce;
+    pdev->num_cached += pdev->session.stats.num_cached;
+    edio24_session_clean(&(pdev->session));
+    memset(&(pdev->session.stats), 0, sizeof(pdev->session.stats));
+}
+
+/**
+ * \brief set the TTL of the responses of a read command: '<command>=<milliseconds>'
+ * \param arg: the argument of '-c', the command is a keyword of the script, for example 'NetworkConfig=60000'
+ * \return 0 on success, <0 on error
+ */
+static int
+edio24d_parse_cache (const char * arg)
+{
+    const edio24_script_cmd_t * pcmd;
+    edio24_session_t ss;
+    const char * p;
+    char * endptr;
+    unsigned long msec;
+
+    p = strchr(arg, '=');
+    if (NULL == p) {
+        return -1;
+    }
+    pcmd = edio24_script_lookup(arg, p - arg);
+    msec = strtoul(p + 1, &endptr, 10);
+    if ((NULL == pcmd) || (EDIO24_SCRIPT_PKT != pcmd->kind) || (p[1] == 0) || (*endptr != 0)) {
+        return -1;
+    }
+    // check if it's a read command
+    memset(&ss, 0, sizeof(ss));
+    if ((edio24_session_set_cache(&ss, NULL, pcmd->cmd, 0) < 0) || (g_edio24d.num_caches >= EDIO24_SESSION_NUM_READS)) {
+        return -1;
+    }
+    g_edio24d.cache_cmd[g_edio24d.num_caches] = pcmd->cmd;
+    g_edio24d.cache_ttl[g_edio24d.num_caches] = (uint64_t)msec * 1000;
+    g_edio24d.num_caches ++;
+    return 0;
+}
+
+/*****************************************************************************/
+static void edio24d_rec_write (void);
+
+static void
+on_rec_write (uv_fs_t * req)
+{
+    edio24d_chunk_t * pchk = g_edio24d.rec_head;
+
+    assert (NULL != pchk);
+    if ((req->result < 0) || ((size_t)(req->result) != pchk->sz)) {
+        fprintf(stderr, "edio24d error in write the recording: %s\n", (req->result < 0 ? uv_strerror(req->result) : "short write"));
+    }
+    uv_fs_req_cleanup(req);
+    g_edio24d.rec_head = pchk->next;
+    if (NULL == g_edio24d.rec_head) {
+        g_edio24d.rec_tail = NULL;
+    }
+    free(pchk->buf);
+    free(pchk);
+    g_edio24d.flg_rec_writing = 0;
+    edio24d_rec_write();
+}
+
+/**
+ * \brief write the first chunk of the queue, one write at a time to keep the order
+ */
+static void
+edio24d_rec_write (void)
+{
+    uv_buf_t buf;
+
+    if (g_edio24d.flg_rec_writing || (NULL == g_edio24d.rec_head)) {
+        return;
+    }
+    buf = uv_buf_init((char *)(g_edio24d.rec_head->buf), g_edio24d.rec_head->sz);
+    g_edio24d.flg_rec_writing = 1;
+    if (0 != uv_fs_write(uv_default_loop(), &(g_edio24d.req_rec), g_edio24d.fd_rec, &buf, 1, -1, on_rec_write)) {
+        g_edio24d.req_rec.result = -1;
+        on_rec_write(&(g_edio24d.req_rec));
+    }
+}
+
+/**
+ * \brief queue a chunk to be written, the buffer is freed after it's written
+ */
+static void
+edio24d_rec_queue (uint8_t * buf, size_t sz)
+{
+    edio24d_chunk_t * pchk;
+
+    pchk = (edio24d_chunk_t *)malloc(sizeof(*pchk));
+    if (NULL == pchk) {
+        free(buf);
+        return;
+    }
+    pchk->next = NULL;
+    pchk->buf = buf;
+    pchk->sz = sz;
+    if (NULL == g_edio24d.rec_tail) {
+        g_edio24d.rec_head = pchk;
+    } else {
+        g_edio24d.rec_tail->next = pchk;
+    }
+    g_edio24d.rec_tail = pchk;
+    edio24d_rec_write();
+}
+
+/**
+ * \brief queue the chunk being encoded
+ */
+static void
+edio24d_rec_flush (void)
+{
+    uint8_t * buf;
+    size_t sz;
+
+    buf = edio24_rec_writer_take(&(g_edio24d.rec), &sz);
+    if (NULL != buf) {
+        edio24d_rec_queue(buf, sz);
+    }
+}
+
+static void
+on_rec_flush (edio24_timer_t * ptm, void * userdata)
+{
+    edio24d_rec_flush();
+    edio24_timer_start(&(g_edio24d.uvclk.clock), &(g_edio24d.tm_rec), EDIO24D_REC_FLUSH, on_rec_flush, NULL);
+}
+
+/**
+ * \brief append a sample to the recording
+ */
+static void
+edio24d_rec_append (const edio24_rec_t * prec)
+{
+    if (1 == edio24_rec_writer_append(&(g_edio24d.rec), prec)) {
+        edio24d_rec_flush();
+        edio24_rec_writer_append(&(g_edio24d.rec), prec);
+    }
+}
+
+/**
+ * \brief open the recording to append, the incomplete chunk left by the last run is removed
+ * \param fn: the file name
+ * \return 0 on success, <0 on error
+ */
+static int
+edio24d_rec_open (const char * fn)
+{
+    edio24_rec_reader_t rd;
+    struct stat st;
+    uint8_t * buf;
+    ssize_t ret;
+    void * p;
+    int fd;
+
+    fd = open(fn, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return -1;
+    }
+    if (st.st_size > 0) {
+        p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if ((MAP_FAILED == p) || (edio24_rec_reader_init(&rd, (const uint8_t *)p, st.st_size) < 0)) {
+            fprintf(stderr, "edio24d not a recording: '%s'\n", fn);
+            if (MAP_FAILED != p) {
+                munmap(p, st.st_size);
+            }
+            close(fd);
+            return -1;
+        }
+        ret = 0;
+        if (rd.sz_valid < (size_t)st.st_size) {
+            fprintf(stderr, "edio24d remove the incomplete tail of %" PRIuSZ " bytes of '%s'\n", (size_t)st.st_size - rd.sz_valid, fn);
+            ret = ftruncate(fd, rd.sz_valid);
+        }
+        edio24_rec_reader_clean(&rd);
+        munmap(p, st.st_size);
+        if (0 != ret) {
+            close(fd);
+            return -1;
+        }
+    }
+    if (edio24_rec_writer_init(&(g_edio24d.rec), 0) < 0) {
+        close(fd);
+        return -1;
+    }
+    g_edio24d.fd_rec = fd;
+    g_edio24d.flg_rec = 1;
+    if (0 == st.st_size) {
+        buf = (uint8_t *)malloc(EDIO24_REC_HDR_SIZE);
+        if (NULL != buf) {
+            edio24d_rec_queue(buf, edio24_rec_create_header(buf, EDIO24_REC_HDR_SIZE));
+        }
+    }
+    return 0;
+}
+
+/**
+ * \brief publish the state of a device to the shared memory
+ */
+static void
+edio24d_dev_publish (edio24d_dev_t * pdev)
+{
+    if (g_edio24d.flg_shm) {
+        edio24_shm_publish(&(g_edio24d.shm), pdev->idx, &(pdev->shm_state));
+    }
+}
+
+/**
+ * \brief update the state of a device by a response, publish it and append the value to the ring
+ */
+static void
+edio24d_dev_update (edio24d_dev_t * pdev, const edio24_response_t * presp)
+{
+    edio24_shm_sample_t sample;
+    edio24_rec_t rec;
+    struct timeval tv;
+    struct timespec ts;
+    uint8_t cmd;
+    uint32_t val = 0;
+
+    if ((! (g_edio24d.flg_shm || g_edio24d.flg_ring || g_edio24d.flg_rec)) || (NULL == presp)) {
+        return;
+    }
+    gettimeofday(&tv, NULL);
+    if (edio24_shm_state_update(&(pdev->shm_state), presp->pkt, presp->sz_pkt, (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec) < 1) {
+        return;
+    }
+    edio24d_dev_publish(pdev);
+    cmd = presp->pkt[1] & ~EDIO24_PKT_REPLY;
+    edio24_shm_state_value(&(pdev->shm_state), cmd, &val);
+    if (g_edio24d.flg_ring) {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        memset(&sample, 0, sizeof(sample));
+        sample.time = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+        sample.device = pdev->idx;
+        sample.cmd = cmd;
+        sample.value = val;
+        edio24_shm_ring_push(&(g_edio24d.ring), &sample);
+    }
+    if (g_edio24d.flg_rec) {
+        rec.time = pdev->shm_state.time;
+        rec.device = pdev->idx;
+        rec.cmd = cmd;
+        rec.value = val;
+        edio24d_rec_append(&rec);
+    }
+}
+
+static void
+on_dev_poll_respond (edio24_session_t * pss, const edio24_response_t * presp, void * userdata)
+{
+    edio24d_dev_t * pdev = (edio24d_dev_t *)userdata;
+    pdev->num_poll --;
+    edio24d_dev_update(pdev, presp);
+}
+
+/**
+ * \brief read the state of a device, the reads are coalesced with the ones of the clients
+ */
+static void
+on_dev_poll (edio24_timer_t * ptm, void * userdata)
+{
+    edio24d_dev_t * pdev = (edio24d_dev_t *)userdata;
+    uint8_t pkt[EDIO24_PKT_LENGTH_MIN];
+    ssize_t (* creates[])(uint8_t *, size_t, uint8_t *) = {
+        edio24_pkt_create_cmd_dinr,
+        edio24_pkt_create_cmd_doutr,
+        edio24_pkt_create_cmd_dconfr,
+        edio24_pkt_create_cmd_dcounterr,
+    };
+    size_t num_poll = pdev->num_poll;
+    ssize_t ret;
+    size_t i;
+
+    if (EDIO24D_DEV_READY != pdev->state) {
+        return;
+    }
+    // skip a round if the device is slower than the interval
+    for (i = 0; (0 == num_poll) && (i < NUM_ARRAY(creates)); i ++) {
+        ret = creates[i](pkt, sizeof(pkt), &(pdev->session.frame));
+        assert (ret > 0);
+        pdev->num_poll ++;
+        if (edio24_session_send(&(pdev->session), pkt, ret, on_dev_poll_respond, pdev) < 0) {
+            pdev->num_poll --;
+            break;
+        }
+    }
+    edio24_timer_start(&(g_edio24d.uvclk.clock), &(pdev->tm_poll), g_edio24d.poll, on_dev_poll, pdev);
+}
+
+/**
+ * \brief the session of a device is ready for the requests
+ */
+static void
+edio24d_dev_ready (edio24d_dev_t * pdev)
+{
+    pdev->state = EDIO24D_DEV_READY;
+    pdev->num_open ++;
+    if (! (g_edio24d.flg_shm || g_edio24d.flg_ring || g_edio24d.flg_rec)) {
+        return;
+    }
+    pdev->shm_state.flags |= EDIO24_SHM_CONNECTED;
+    edio24d_dev_publish(pdev);
+    if (g_edio24d.poll > 0) {
+        on_dev_poll(&(pdev->tm_poll), pdev);
+    }
+}
+
+/**
+ * \brief the session of a device is closed, the values of the state are kept
+ */
+static void
+edio24d_dev_down (edio24d_dev_t * pdev)
+{
+    edio24_timer_stop(&(g_edio24d.uvclk.clock), &(pdev->tm_poll));
+    pdev->state = EDIO24D_DEV_IDLE;
+    pdev->shm_state.flags &= ~EDIO24_SHM_CONNECTED;
+    edio24d_dev_publish(pdev);
+}
+
+static void
+on_dev_retry (edio24_timer_t * ptm, void * userdata)
+{
+    edio24d_dev_t * pdev = (edio24d_dev_t *)userdata;
+    if (EDIO24D_DEV_OPENING == pdev->state) {
+        fprintf(stderr, "edio24d device %d: no reply of 'open device'\n", (int)pdev->idx);
+        pdev->state = EDIO24D_DEV_IDLE;
+    }
+    edio24d_dev_open(pdev);
+}
+
+/**
+ * \brief open the device later, the delay doubles on each failure
+ */
+static void
+edio24d_dev_retry (edio24d_dev_t * pdev)
+{
+    pdev->state = EDIO24D_DEV_IDLE;
+    if (g_edio24d.flg_closing) {
+        return;
+    }
+    edio24_timer_start(&(g_edio24d.uvclk.clock), &(pdev->tm_retry), pdev->backoff, on_dev_retry, pdev);
+    pdev->backoff *= 2;
+    if (pdev->backoff > EDIO24D_RETRY_MAX) {
+        pdev->backoff = EDIO24D_RETRY_MAX;
+    }
+}
+
+static void
+on_dev_tcp_close (uv_handle_t * handle)
+{
+    edio24d_dev_retry((edio24d_dev_t *)(handle->data));
+}
+
+/**
+ * \brief close the connection to the device, the requests waiting for the responses are failed
+ */
+static void
+edio24d_dev_lost (edio24d_dev_t * pdev)
+{
+    if (EDIO24D_DEV_READY == pdev->state) {
+        fprintf(stderr, "edio24d device %d: connection lost, %" PRIuSZ " request(s) failed\n", (int)pdev->idx, edio24_session_inflight(&(pdev->session)));
+        edio24d_session_clean(pdev);
+    }
+    edio24d_dev_down(pdev);
+    if (! uv_is_closing((uv_handle_t *)&(pdev->tcp))) {
+        uv_close((uv_handle_t *)&(pdev->tcp), on_dev_tcp_close);
+    }
+}
+
+static void
+on_dev_tcp_read (uv_stream_t * stream, ssize_t nread, const uv_buf_t * buf)
+{
+    edio24d_dev_t * pdev = (edio24d_dev_t *)(stream->data);
+    if (nread > 0) {
+        uvtransport_recv(&(pdev->transport), (uint8_t *)(buf->base), nread);
+    }
+    if (nread < 0) {
+        edio24d_dev_lost(pdev);
+    }
+    free(buf->base);
+}
+
+static void
+on_dev_tcp_connect (uv_connect_t * connection, int status)
+{
+    edio24d_dev_t * pdev = (edio24d_dev_t *)(connection->data);
+
+    if (status < 0) {
+        fprintf(stderr, "edio24d device %d: connect error %s\n", (int)pdev->idx, uv_strerror(status));
+        edio24d_dev_lost(pdev);
+        return;
+    }
+    uvtransport_init(&(pdev->transport), (uv_stream_t *)&(pdev->tcp));
+    if (edio24d_session_init(pdev, &(pdev->transport.base)) < 0) {
+        edio24d_dev_lost(pdev);
+        return;
+    }
+    pdev->backoff = EDIO24D_RETRY_MIN;
+    if (g_edio24d.flg_verbose) {
+        fprintf(stderr, "edio24d device %d: ready\n", (int)pdev->idx);
+    }
+    uv_read_start((uv_stream_t *)&(pdev->tcp), alloc_buffer, on_dev_tcp_read);
+    edio24d_dev_ready(pdev);
+}
+
+static void
+on_dev_udp_read (uv_udp_t * handle, ssize_t nread, const uv_buf_t * buf, const struct sockaddr * addr, unsigned flags)
+{
+    edio24d_dev_t * pdev = (edio24d_dev_t *)(handle->data);
+
+    if ((nread == 2) && (buf->base[0] == 'C') && (EDIO24D_DEV_OPENING == pdev->state)) {
+        edio24_timer_stop(&(g_edio24d.uvclk.clock), &(pdev->tm_retry));
+        if (buf->base[1] == 0) {
+            pdev->state = EDIO24D_DEV_CONNECTING;
+            uv_tcp_init(handle->loop, &(pdev->tcp));
+            pdev->tcp.data = pdev;
+            pdev->connect.data = pdev;
+            uv_tcp_nodelay(&(pdev->tcp), 1);
+            uv_tcp_keepalive(&(pdev->tcp), 1, 60);
+            uv_tcp_connect(&(pdev->connect), &(pdev->tcp), (const struct sockaddr *)&(pdev->addr_tcp), on_dev_tcp_connect);
+        } else {
+            fprintf(stderr, "edio24d device %d: 'open device' failed: %s\n", (int)pdev->idx, edio24_val2cstr_status(buf->base[1]));
+            edio24d_dev_retry(pdev);
+        }
+    }
+    free(buf->base);
+}
+
+static void
+on_dev_udp_send (uv_udp_send_t * req, int status)
+{
+    if (status) {
+        fprintf(stderr, "edio24d send error %s\n", uv_strerror(status));
+    }
+}
+
+/**
+ * \brief send 'open device' to the device, the TCP connection is started by the reply
+ */
+static void
+edio24d_dev_open (edio24d_dev_t * pdev)
+{
+    uv_buf_t msg;
+    ssize_t ret;
+
+    if (g_edio24d.flg_closing || pdev->flg_loopback) {
+        return;
+    }
+    ret = edio24_pkt_create_opendev(pdev->buf_udp, sizeof(pdev->buf_udp), 0);
+    assert (ret > 0);
+    msg = uv_buf_init((char *)(pdev->buf_udp), ret);
+    pdev->state = EDIO24D_DEV_OPENING;
+    if (0 != uv_udp_send(&(pdev->req_udp), &(pdev->udp), &msg, 1, (const struct sockaddr *)&(pdev->addr_udp), on_dev_udp_send)) {
+        edio24d_dev_retry(pdev);
+        return;
+    }
+    edio24_timer_start(&(g_edio24d.uvclk.clock), &(pdev->tm_retry), EDIO24D_OPEN_TIMEOUT, on_dev_retry, pdev);
+}
+
+/**
+ * \brief add a device to the fleet
+ * \param host: the IPv4 address of the device, NULL for a simulated device in the process
+ * \param port_tcp: the command port
+ * \param port_udp: the discover port
+ * \return 0 on success, <0 on error
+ */
+static int
+edio24d_add_device (const char * host, int port_tcp, int port_udp)
+{
+    edio24d_dev_t * pdev;
+
+    if (g_edio24d.num_devs >= EDIO24D_MAX_DEVICES) {
+        fprintf(stderr, "edio24d too many devices, the max is %d\n", EDIO24D_MAX_DEVICES);
+        return -1;
+    }
+    if (g_edio24d.num_devs >= g_edio24d.sz_devs) {
+        size_t sz_new = (g_edio24d.sz_devs < 8 ? 8 : g_edio24d.sz_devs * 2);
+        pdev = (edio24d_dev_t *)realloc(g_edio24d.devs, sz_new * sizeof(*pdev));
+        if (NULL == pdev) {
+            return -1;
+        }
+        g_edio24d.devs = pdev;
+        g_edio24d.sz_devs = sz_new;
+    }
+    pdev = &(g_edio24d.devs[g_edio24d.num_devs]);
+    memset(pdev, 0, sizeof(*pdev));
+    pdev->idx = g_edio24d.num_devs;
+    pdev->backoff = EDIO24D_RETRY_MIN;
+    edio24_timer_init(&(pdev->tm_retry));
+    edio24_timer_init(&(pdev->tm_poll));
+    if (NULL == host) {
+        pdev->flg_loopback = 1;
+    } else if ((0 != uv_ip4_addr(host, port_tcp, &(pdev->addr_tcp))) || (0 != uv_ip4_addr(host, port_udp, &(pdev->addr_udp)))) {
+        fprintf(stderr, "edio24d illegal IPv4 address: '%s'\n", host);
+        return -1;
+    }
+    g_edio24d.num_devs ++;
+    return 0;
+}
+
+/**
+ * \brief add a device of a line of the fleet list: '<IPv4 address> [<TCP port> [<UDP port>]]'
+ */
+static int
+process_fleet_line (off_t pos, char * buf, size_t size, void * userdata)
+{
+    char host[64];
+    int port_tcp = g_edio24d.port_tcp;
+    int port_udp = g_edio24d.port_udp;
+    int ret;
+
+    ret = sscanf(buf, "%63s %d %d", host, &port_tcp, &port_udp);
+    if ((ret < 1) || ('#' == host[0])) {
+        return 0;
+    }
+    if (edio24d_add_device(host, port_tcp, port_udp) < 0) {
+        g_edio24d.flg_has_error = 1;
+        return -1;
+    }
+    return 0;
+}
+
+/*****************************************************************************/
+static void
+on_uv_close(uv_handle_t* handle)
+{
+    if (handle != NULL) {
+        //delete handle;
+    }
+}
+
+static void
+on_uv_walk(uv_handle_t* handle, void* arg)
+{
+    if (! uv_is_closing(handle)) {
+        uv_close(handle, on_uv_close);
+    }
+}
+
+/**
+ * \brief close the sessions and all of the handles, the loop returns when they are closed
+ */
+static void
+edio24d_close (uv_loop_t * loop)
+{
+    edio24d_conn_t * pconn;
+    size_t i;
+    g_edio24d.flg_closing = 1;
+    // the clients are freed in their close callback
+    for (pconn = g_edio24d.conns; NULL != pconn; pconn = pconn->next) {
+        edio24d_conn_close(pconn);
+    }
+    for (i = 0; i < g_edio24d.num_devs; i ++) {
+        edio24_timer_stop(&(g_edio24d.uvclk.clock), &(g_edio24d.devs[i].tm_retry));
+        if (EDIO24D_DEV_READY == g_edio24d.devs[i].state) {
+            edio24d_session_clean(&(g_edio24d.devs[i]));
+            edio24d_dev_down(&(g_edio24d.devs[i]));
+        }
+    }
+    if (g_edio24d.flg_rec) {
+        // the loop returns after the chunks are written
+        edio24_timer_stop(&(g_edio24d.uvclk.clock), &(g_edio24d.tm_rec));
+        edio24d_rec_flush();
+    }
+    uv_walk(loop, on_uv_walk, NULL);
+}
+
+static void
+on_timeout (edio24_timer_t * ptm, void * userdata)
+{
+    fprintf(stderr, "timeout: %d\n", (int)g_edio24d.timeout);
+    edio24d_close(uv_default_loop());
+}
+
+static void
+on_sigint_received(uv_signal_t *handle, int signum)
+{
+    edio24d_close(handle->loop);
+}
+
+int
+main_daemon(const char * path, const char * fn_fleet, const char ** hosts, size_t num_hosts, int port_udp, int port_tcp, size_t num_sims, const char * host_proxy, int port_proxy, const char ** caches, size_t num_caches, const char * name_shm, const char * name_ring, size_t num_ring, const char * fn_rec, unsigned long interval, time_t timeout, char flg_verbose)
+{
+    uv_loop_t * loop;
+    uv_signal_t sigint;
+    edio24d_dev_t * pdev;
+    char flg_listen;
+    int ret = 0;
+    size_t i;
+
+    memset (&g_edio24d, 0, sizeof (g_edio24d));
+    g_edio24d.path = path;
+    g_edio24d.port_udp = port_udp;
+    g_edio24d.port_tcp = port_tcp;
+    g_edio24d.flg_verbose = flg_verbose;
+    g_edio24d.timeout = timeout;
+    g_edio24d.poll = (uint64_t)interval * 1000;
+    for (i = 0; i < num_caches; i ++) {
+        if (edio24d_parse_cache(caches[i]) < 0) {
+            fprintf(stderr, "edio24d illegal cache '%s', use '<read command>=<milliseconds>'\n", caches[i]);
+            return 1;
+        }
+    }
+    if (NULL != fn_fleet) {
+        read_file_lines(fn_fleet, NULL, process_fleet_line);
+    }
+    for (i = 0; i < num_hosts; i ++) {
+        if (edio24d_add_device(hosts[i], port_tcp, port_udp) < 0) {
+            g_edio24d.flg_has_error = 1;
+        }
+    }
+    for (i = 0; i < num_sims; i ++) {
+        if (edio24d_add_device(NULL, 0, 0) < 0) {
+            g_edio24d.flg_has_error = 1;
+        }
+    }
+    if (g_edio24d.flg_has_error || (g_edio24d.num_devs < 1)) {
+        fprintf(stderr, "edio24d no device in the fleet\n");
+        free(g_edio24d.devs);
+        return 1;
+    }
+    if (NULL != name_shm) {
+        if (edio24_shm_create(&(g_edio24d.shm), name_shm, g_edio24d.num_devs) < 0) {
+            fprintf(stderr, "edio24d error in create the shared memory '%s'\n", name_shm);
+            free(g_edio24d.devs);
+            return 1;
+        }
+        g_edio24d.flg_shm = 1;
+    }
+    if (NULL != name_ring) {
+        if (edio24_shm_ring_create(&(g_edio24d.ring), name_ring, num_ring) < 0) {
+            fprintf(stderr, "edio24d error in create the ring '%s'\n", name_ring);
+            if (g_edio24d.flg_shm) {
+                edio24_shm_close(&(g_edio24d.shm));
+            }
+            free(g_edio24d.devs);
+            return 1;
+        }
+        g_edio24d.flg_ring = 1;
+    }
+    edio24_timer_init(&(g_edio24d.tm_rec));
+    if ((NULL != fn_rec) && (edio24d_rec_open(fn_rec) < 0)) {
+        fprintf(stderr, "edio24d error in open the recording '%s'\n", fn_rec);
+        if (g_edio24d.flg_ring) {
+            edio24_shm_ring_close(&(g_edio24d.ring));
+        }
+        if (g_edio24d.flg_shm) {
+            edio24_shm_close(&(g_edio24d.shm));
+        }
+        free(g_edio24d.devs);
+        return 1;
+    }
+
+    loop = uv_default_loop();
+    uv_signal_init(loop, &sigint);
+    uv_signal_start(&sigint, on_sigint_received, SIGINT);
+    if (uvclock_init(loop, &(g_edio24d.uvclk), 0) < 0) {
+        return 1;
+    }
+    if (g_edio24d.flg_rec) {
+        edio24_timer_start(&(g_edio24d.uvclk.clock), &(g_edio24d.tm_rec), EDIO24D_REC_FLUSH, on_rec_flush, NULL);
+    }
+    edio24_timer_init(&(g_edio24d.tm_timeout));
+    if (timeout > 0) {
+        edio24_timer_start(&(g_edio24d.uvclk.clock), &(g_edio24d.tm_timeout), (uint64_t)timeout * 1000000, on_timeout, NULL);
+    }
+
+    uv_pipe_init(loop, &(g_edio24d.server), 0);
+    unlink(path); // the socket left by the last run
+    ret = uv_pipe_bind(&(g_edio24d.server), path);
+    if (0 == ret) {
+        ret = uv_listen((uv_stream_t *)&(g_edio24d.server), 128, on_server_connection);
+    }
+    if (0 != ret) {
+        fprintf(stderr, "edio24d error in listen '%s': %s\n", path, uv_strerror(ret));
+        g_edio24d.flg_has_error = 1;
+        edio24d_close(loop);
+    }
+
+    for (i = 0; (0 == ret) && (i < g_edio24d.num_devs); i ++) {
+        pdev = &(g_edio24d.devs[i]);
+        if ((port_proxy > 0) && (edio24d_proxy_listen(pdev, loop, host_proxy, port_proxy + i) < 0)) {
+            g_edio24d.flg_has_error = 1;
+            edio24d_close(loop);
+            break;
+        }
+        if (pdev->flg_loopback) {
+            uvloopback_init(loop, &(pdev->uvlb), 0);
+            edio24_svrsession_init(&(pdev->svr), edio24_loopback_device(&(pdev->uvlb.lb)), 0);
+            edio24d_session_init(pdev, edio24_loopback_client(&(pdev->uvlb.lb)));
+            edio24d_dev_ready(pdev);
+            continue;
+        }
+        uv_udp_init(loop, &(pdev->udp));
+        pdev->udp.data = pdev;
+        uv_udp_recv_start(&(pdev->udp), alloc_buffer, on_dev_udp_read);
+        edio24d_dev_open(pdev);
+    }
+    if ((0 == ret) && (! g_edio24d.flg_closing)) {
+        fprintf(stderr, "edio24d listen on '%s', %" PRIuSZ " device(s)\n", path, g_edio24d.num_devs);
+        if (port_proxy > 0) {
+            fprintf(stderr, "edio24d proxy on %s, port %d to %d\n", host_proxy, port_proxy, port_proxy + (int)g_edio24d.num_devs - 1);
+        }
+        if (g_edio24d.flg_shm) {
+            fprintf(stderr, "edio24d publish the states to '%s'\n", name_shm);
+        }
+        if (g_edio24d.flg_ring) {
+            fprintf(stderr, "edio24d append the samples to '%s', %" PRIu32 " entries\n", name_ring, g_edio24d.ring.hdr->num_entries);
+        }
+        if (g_edio24d.flg_rec) {
+            fprintf(stderr, "edio24d record the samples to '%s'\n", fn_rec);
+        }
+    }
+
+    flg_listen = (0 == ret);
+    ret = uv_run(loop, UV_RUN_DEFAULT);
+    if (flg_listen) {
+        unlink(path);
+    }
+    for (i = 0; i < g_edio24d.num_devs; i ++) {
+        pdev = &(g_edio24d.devs[i]);
+        fprintf(stderr, "edio24d device %d: open=%" PRIuSZ ", request=%" PRIuSZ ", respond=%" PRIuSZ ", reject=%" PRIuSZ ", coalesce=%" PRIuSZ ", cached=%" PRIuSZ "\n"
+            , (int)i, pdev->num_open, pdev->num_request, pdev->num_respond, pdev->num_reject, pdev->num_coalesce, pdev->num_cached);
+        if (pdev->flg_loopback && (pdev->num_open > 0)) {
+            edio24d_session_clean(pdev);
+            edio24_svrsession_clean(&(pdev->svr));
+            uvloopback_clean(&(pdev->uvlb));
+        }
+    }
+    fprintf(stderr, "edio24d clients: %" PRIuSZ "\n", g_edio24d.num_conns);
+    if (g_edio24d.flg_shm) {
+        edio24_shm_close(&(g_edio24d.shm));
+    }
+    if (g_edio24d.flg_ring) {
+        edio24_shm_ring_close(&(g_edio24d.ring));
+    }
+    if (g_edio24d.flg_rec) {
+        edio24_rec_writer_clean(&(g_edio24d.rec));
+        close(g_edio24d.fd_rec);
+    }
+    uvclock_clean(&(g_edio24d.uvclk));
+    free(g_edio24d.devs);
+    if (ret != 0) {
+        return ret;
+    }
+    return (g_edio24d.flg_has_error ? 1 : 0);
+}
+
+/*****************************************************************************/
+static void
+version (void)
+{
+    printf ("E-DIO24 daemon v%d.%d\n", EDIO24D_MAIN, EDIO24D_MINOR);
+}
+
+static void
+help(char * progname)
+{
+    printf ("Usage: \n"
+            "\t%s [-h] [-v] [-p <socket>] [-l <proxy port>] [-f <fleet file>] [-r <addr>] ...\n"
+            , basename(progname));
+    printf ("\nOptions:\n");
+    printf ("\t-p <path>\tthe UNIX domain socket of the clients, default %s\n", EDIO24D_SOCKET_PATH);
+    printf ("\t-f <file>\tthe fleet list, a line of '<addr> [<TCP port> [<UDP port>]]' for each device\n");
+    printf ("\t-r <addr>\tadd a E-DIO24 device address, it can be used more than once\n");
+    printf ("\t-t <port>\tE-DIO24 command (TCP) port of the devices\n");
+    printf ("\t-u <port>\tE-DIO24 discover (UDP) port of the devices\n");
+    printf ("\t-k <num>\tadd the simulated devices in the process (loopback)\n");
+    printf ("\t-l <port>\tthe proxy of the native protocol, the device i is served on the TCP and UDP port (port + i)\n");
+    printf ("\t-a <addr>\tthe bind address of the proxy, default 127.0.0.1\n");
+    printf ("\t-s <name>\tpublish the states of the devices to the POSIX shared memory, for example %s\n", EDIO24_SHM_NAME);
+    printf ("\t-b <name>\tappend every value read to the ring of the samples in the POSIX shared memory\n");
+    printf ("\t-n <num>\tthe number of the samples in the ring, default %d\n", EDIO24_SHM_RING_ENTRIES);
+    printf ("\t-w <file>\trecord every value read to the file, query it by edio24rec\n");
+    printf ("\t-i <msec>\tthe milliseconds between the reads of the published states, 0 -- no read, default %d\n", EDIO24D_POLL_INTERVAL);
+    printf ("\t-c <cmd>=<msec>\tcache the responses of a read command, for example 'NetworkConfig=60000', it can be used more than once\n");
+    printf ("\t-m <time>\tthe seconds of timeout\n");
+    printf ("\t-h\tPrint this message.\n");
+    printf ("\t-v\tVerbose information.\n");
+}
+
+static void
+usage (char *progname)
+{
+    version ();
+    help (progname);
+}
+
+int
+main(int argc, char * argv[])
+{
+    char flg_verbose = 0;
+    const char * path = EDIO24D_SOCKET_PATH;
+    const char * fn_fleet = NULL;
+    const char * hosts[EDIO24D_MAX_DEVICES];
+    size_t num_hosts = 0;
+    size_t num_sims = 0;
+    const char * host_proxy = "127.0.0.1";
+    const char * caches[EDIO24_SESSION_NUM_READS];
+    size_t num_caches = 0;
+    const char * name_shm = NULL;
+    const char * name_ring = NULL;
+    size_t num_ring = EDIO24_SHM_RING_ENTRIES;
+    const char * fn_rec = NULL;
+    unsigned long interval = EDIO24D_POLL_INTERVAL;
+    int port_proxy = 0;
+    int port_udp = EDIO24_PORT_DISCOVER;
+    int port_tcp = EDIO24_PORT_COMMAND;
+    time_t timeout = 0;
+
+    int c;
+    struct option longopts[]  = {
+        { "socket",       1, 0, 'p' },
+        { "fleet",        1, 0, 'f' },
+        { "address",      1, 0, 'r' },
+        { "portudp",      1, 0, 'u' },
+        { "porttcp",      1, 0, 't' },
+        { "loopback",     1, 0, 'k' },
+        { "proxy",        1, 0, 'l' },
+        { "bindaddr",     1, 0, 'a' },
+        { "cache",        1, 0, 'c' },
+        { "shm",          1, 0, 's' },
+        { "ring",         1, 0, 'b' },
+        { "ringsize",     1, 0, 'n' },
+        { "record",       1, 0, 'w' },
+        { "interval",     1, 0, 'i' },
+        { "timeout",      1, 0, 'm' },
+
+        { "help",         0, 0, 'h' },
+        { "verbose",      0, 0, 'v' },
+        { 0,              0, 0,  0  },
+    };
+
+    while ((c = getopt_long( argc, argv, "p:f:r:u:t:k:l:a:c:s:b:n:w:i:m:hv", longopts, NULL )) != EOF) {
+        switch (c) {
+            case 'p':
+                if (strlen (optarg) > 0) {
+                    path = optarg;
+                }
+                break;
+            case 'f':
+                if (strlen (optarg) > 0) {
+                    fn_fleet = optarg;
+                }
+                break;
+            case 'r':
+                if ((strlen (optarg) > 0) && (num_hosts < NUM_ARRAY(hosts))) {
+                    hosts[num_hosts ++] = optarg;
+                }
+                break;
+            case 't':
+                if (strlen (optarg) > 0) {
+                    port_tcp = atoi(optarg);
+                }
+                break;
+            case 'u':
+                if (strlen (optarg) > 0) {
+                    port_udp = atoi(optarg);
+                }
+                break;
+            case 'k':
+                if (strlen (optarg) > 0) {
+                    num_sims = atoi(optarg);
+                }
+                break;
+            case 'l':
+                if (strlen (optarg) > 0) {
+                    port_proxy = atoi(optarg);
+                }
+                break;
+            case 'a':
+                if (strlen (optarg) > 0) {
+                    host_proxy = optarg;
+                }
+                break;
+            case 'c':
+                if ((strlen (optarg) > 0) && (num_caches < NUM_ARRAY(caches))) {
+                    caches[num_caches ++] = optarg;
+                }
+                break;
+            case 's':
+                if (strlen (optarg) > 0) {
+                    name_shm = optarg;
+                }
+                break;
+            case 'b':
+                if (strlen (optarg) > 0) {
+                    name_ring = optarg;
+                }
+                break;
+            case 'n':
+                if (strlen (optarg) > 0) {
+                    num_ring = strtoul(optarg, NULL, 10);
+                }
+                break;
+            case 'w':
+                if (strlen (optarg) > 0) {
+                    fn_rec = optarg;
+                }
+                break;
+            case 'i':
+                if (strlen (optarg) > 0) {
+                    interval = strtoul(optarg, NULL, 10);
+                }
+                break;
+            case 'm':
+                if (strlen (optarg) > 0) {
+                    timeout = atoi(optarg);
+                }
+                break;
+
+            case 'h':
+                usage (argv[0]);
+                exit (0);
+                break;
+            case 'v':
+                flg_verbose = 1;
+                break;
+            default:
+                fprintf (stderr, "Unknown parameter: '%c'.\n", c);
+                fprintf (stderr, "Use '%s -h' for more information.\n", basename(argv[0]));
+                exit (-1);
+                break;
+        }
+    }
+
+    return main_daemon(path, fn_fleet, hosts, num_hosts, port_udp, port_tcp, num_sims, host_proxy, port_proxy, caches, num_caches, name_shm, name_ring, num_ring, fn_rec, interval, timeout, flg_verbose);
+}
@@ -0,0 +1,560 @@
+/**
+ * \file    edio24rec.c
+ * \brief   query the recording of the samples of the E-DIO24 devices
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ *
+ * The recording written by 'edio24d -w <file>' is mapped, the chunks of the time range
+ * are found by the index of the chunk headers, and only those chunks are decoded.
+ *
+ * The queries of the edges and the pulses of the pins ('-q') decode and scan the chunks
+ * in parallel on the thread pool of libuv, then the results of the chunks are joined in order:
+ * the edges between two chunks are found by the last value of the previous chunk.
+ */
+
+#define EDIO24REC_MAIN  1
+#define EDIO24REC_MINOR 0
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <libgen.h> // basename()
+#include <string.h>
+#include <getopt.h>
+#include <fcntl.h>    // open()
+#include <sys/mman.h> // mmap()
+#include <sys/stat.h>
+#include <time.h> // clock_gettime()
+#include <uv.h>
+
+#include "libedio24.h"
+#include "edio24rec.h"
+#include "edio24script.h"
+#include "utils.h" // NUM_ARRAY()
+
+// the queries of '-q'
+#define EDIO24REC_LIST      0 /**< print the samples */
+#define EDIO24REC_EDGES     1 /**< the rising and falling edges of the pins */
+#define EDIO24REC_RISING    2
+#define EDIO24REC_FALLING   3
+#define EDIO24REC_PULSES    4 /**< the pulses between two edges of a pin */
+#define EDIO24REC_HISTOGRAM 5 /**< the histogram of the widths of the pulses */
+
+#define EDIO24REC_NUM_PINS    24
+#define EDIO24REC_NUM_BUCKETS 64 /**< the bucket i of the histogram has the widths in [2^i, 2^(i+1)) microseconds */
+
+/** the changes of the values in a chunk */
+typedef struct _edio24rec_edge_t {
+    uint64_t time;
+    uint32_t changed; /**< the pins changed in the mask */
+    uint32_t value;   /**< the value after the change */
+} edio24rec_edge_t;
+
+/** the scan of a chunk on the thread pool */
+typedef struct _edio24rec_job_t {
+    uv_work_t req;
+    size_t idx;       /**< the index of the chunk */
+    int ret;          /**< <0 -- the chunk is broken */
+    size_t num_samples; /**< the number of the samples of the device in the range */
+    uint32_t first;   /**< the first value */
+    uint32_t last;    /**< the last value */
+    uint64_t time_first;
+    edio24rec_edge_t * edges; /**< the changes in the chunk, not including the first sample */
+    size_t num_edges;
+} edio24rec_job_t;
+
+typedef struct _edio24rec_t {
+    edio24_rec_reader_t rd;
+    uint64_t time_begin;
+    uint64_t time_end;
+    int device;
+    int cmd;
+    uint32_t mask;    /**< the pins */
+    int query;        /**< EDIO24REC_xxx */
+    char flg_binary;  /**< 1 -- the binary output */
+
+    // the state of the join
+    char flg_has_last;
+    uint32_t last;
+    uint64_t time_edge[EDIO24REC_NUM_PINS]; /**< the time of the last edge of a pin */
+    char flg_edge[EDIO24REC_NUM_PINS];      /**< 1 -- time_edge is valid */
+    size_t num_out;
+    uint64_t hist[EDIO24REC_NUM_PINS][2][EDIO24REC_NUM_BUCKETS];
+} edio24rec_t;
+
+static edio24rec_t g_edio24rec;
+
+static void
+edio24rec_put_u64 (uint8_t * p, uint64_t val)
+{
+    size_t i;
+    for (i = 0; i < 8; i ++) {
+        p[i] = (val >> (8 * i)) & 0xFF;
+    }
+}
+
+/**
+ * \brief decode a chunk and find the changes of the values of the device, in a thread of the pool
+ */
+static void
+on_job_work (uv_work_t * req)
+{
+    edio24rec_job_t * pjob = (edio24rec_job_t *)(req->data);
+    const edio24_rec_chunk_t * pchk = &(g_edio24rec.rd.chunks[pjob->idx]);
+    edio24_rec_t * recs;
+    uint32_t * prev;
+    uint32_t * vals;
+    uint64_t * times;
+    uint32_t * idx;
+    ssize_t ret;
+    size_t num;
+    size_t i;
+    size_t n = 0;
+
+    prev = (uint32_t *)malloc(sizeof(uint32_t) * EDIO24_REC_PREV_SIZE);
+    recs = (edio24_rec_t *)malloc(sizeof(*recs) * pchk->num_records);
+    vals = (uint32_t *)malloc(sizeof(*vals) * pchk->num_records);
+    times = (uint64_t *)malloc(sizeof(*times) * pchk->num_records);
+    idx = (uint32_t *)malloc(sizeof(*idx) * pchk->num_records);
+    pjob->ret = -1;
+    if ((NULL == prev) || (NULL == recs) || (NULL == vals) || (NULL == times) || (NULL == idx)) {
+        goto end_job;
+    }
+    ret = edio24_rec_decode_chunk(&(g_edio24rec.rd), pjob->idx, prev, recs, pchk->num_records);
+    if (ret < 0) {
+        goto end_job;
+    }
+    // the values of the device in the range
+    for (i = 0; i < (size_t)ret; i ++) {
+        if ((recs[i].device == g_edio24rec.device) && (recs[i].cmd == g_edio24rec.cmd)
+            && (recs[i].time >= g_edio24rec.time_begin) && (recs[i].time < g_edio24rec.time_end)) {
+            vals[n] = recs[i].value;
+            times[n] = recs[i].time;
+            n ++;
+        }
+    }
+    pjob->ret = 0;
+    pjob->num_samples = n;
+    if (n < 1) {
+        goto end_job;
+    }
+    pjob->first = vals[0];
+    pjob->last = vals[n - 1];
+    pjob->time_first = times[0];
+    num = edio24_rec_scan_changes(vals, n, vals[0], g_edio24rec.mask, idx, n);
+    pjob->edges = (edio24rec_edge_t *)malloc(sizeof(*(pjob->edges)) * (num > 0 ? num : 1));
+    if (NULL == pjob->edges) {
+        pjob->ret = -1;
+        goto end_job;
+    }
+    for (i = 0; i < num; i ++) {
+        pjob->edges[i].time = times[idx[i]];
+        pjob->edges[i].changed = (vals[idx[i]] ^ vals[idx[i] - 1]) & g_edio24rec.mask;
+        pjob->edges[i].value = vals[idx[i]];
+    }
+    pjob->num_edges = num;
+end_job:
+    free(prev);
+    free(recs);
+    free(vals);
+    free(times);
+    free(idx);
+}
+
+static void
+on_job_done (uv_work_t * req, int status)
+{
+}
+
+/**
+ * \brief output a change of the pins in time order
+ */
+static void
+edio24rec_edge (uint64_t time, uint32_t changed, uint32_t value)
+{
+    uint8_t buf[20];
+    uint64_t width;
+    int bucket;
+    int level;
+    int pin;
+
+    for (pin = 0; pin < EDIO24REC_NUM_PINS; pin ++) {
+        if (0 == (changed & (1UL << pin))) {
+            continue;
+        }
+        level = (value >> pin) & 0x01;
+        switch (g_edio24rec.query) {
+        case EDIO24REC_RISING:
+        case EDIO24REC_FALLING:
+            if (level != (EDIO24REC_RISING == g_edio24rec.query)) {
+                break;
+            }
+            // fall through
+        case EDIO24REC_EDGES:
+            g_edio24rec.num_out ++;
+            if (g_edio24rec.flg_binary) {
+                edio24rec_put_u64(buf, time);
+                buf[8] = g_edio24rec.device & 0xFF;
+                buf[9] = (g_edio24rec.device >> 8) & 0xFF;
+                buf[10] = pin;
+                buf[11] = level;
+                fwrite(buf, 1, 12, stdout);
+            } else {
+                printf("%" PRIu64 ",%d,%d,%d\n", time, g_edio24rec.device, pin, level);
+            }
+            break;
+        case EDIO24REC_PULSES:
+        case EDIO24REC_HISTOGRAM:
+            if (g_edio24rec.flg_edge[pin]) {
+                // the pulse ends at this edge, its level is the one before the edge
+                width = time - g_edio24rec.time_edge[pin];
+                if (EDIO24REC_HISTOGRAM == g_edio24rec.query) {
+                    bucket = (width > 0 ? 63 - __builtin_clzll(width) : 0);
+                    g_edio24rec.hist[pin][! level][bucket] ++;
+                } else if (g_edio24rec.flg_binary) {
+                    edio24rec_put_u64(buf, g_edio24rec.time_edge[pin]);
+                    edio24rec_put_u64(buf + 8, width);
+                    buf[16] = g_edio24rec.device & 0xFF;
+                    buf[17] = (g_edio24rec.device >> 8) & 0xFF;
+                    buf[18] = pin;
+                    buf[19] = ! level;
+                    fwrite(buf, 1, 20, stdout);
+                } else {
+                    printf("%" PRIu64 ",%" PRIu64 ",%d,%d,%d\n", g_edio24rec.time_edge[pin], width, g_edio24rec.device, pin, ! level);
+                }
+                g_edio24rec.num_out ++;
+            }
+            g_edio24rec.time_edge[pin] = time;
+            g_edio24rec.flg_edge[pin] = 1;
+            break;
+        }
+    }
+}
+
+/**
+ * \brief find the edges or the pulses of the pins in a time range
+ * \param num_chunks: return the number of the chunks scanned
+ * \return 0 on success, <0 on error
+ */
+static int
+edio24rec_query_edges (size_t * num_chunks)
+{
+    edio24rec_job_t * jobs;
+    edio24rec_job_t * pjob;
+    uv_loop_t * loop;
+    size_t begin;
+    size_t num = 0;
+    size_t i;
+    size_t j;
+    int pin;
+    int level;
+    int b;
+
+    begin = edio24_rec_reader_seek(&(g_edio24rec.rd), g_edio24rec.time_begin);
+    while ((begin + num < g_edio24rec.rd.num_chunks) && (g_edio24rec.rd.chunks[begin + num].time_first < g_edio24rec.time_end)) {
+        num ++;
+    }
+    *num_chunks = num;
+    jobs = (edio24rec_job_t *)calloc(num + 1, sizeof(*jobs));
+    if (NULL == jobs) {
+        return -1;
+    }
+    loop = uv_default_loop();
+    for (i = 0; i < num; i ++) {
+        jobs[i].idx = begin + i;
+        jobs[i].req.data = &(jobs[i]);
+        uv_queue_work(loop, &(jobs[i].req), on_job_work, on_job_done);
+    }
+    uv_run(loop, UV_RUN_DEFAULT);
+
+    if (EDIO24REC_HISTOGRAM != g_edio24rec.query) {
+        if (EDIO24REC_PULSES == g_edio24rec.query) {
+            if (! g_edio24rec.flg_binary) {
+                printf("start,width,device,pin,level\n");
+            }
+        } else if (! g_edio24rec.flg_binary) {
+            printf("time,device,pin,level\n");
+        }
+    }
+    for (i = 0; i < num; i ++) {
+        pjob = &(jobs[i]);
+        if (pjob->ret < 0) {
+            fprintf(stderr, "edio24rec skip the broken chunk at offset %" PRIuSZ "\n", g_edio24rec.rd.chunks[pjob->idx].offset);
+        } else if (pjob->num_samples > 0) {
+            if (g_edio24rec.flg_has_last && ((g_edio24rec.last ^ pjob->first) & g_edio24rec.mask)) {
+                edio24rec_edge(pjob->time_first, (g_edio24rec.last ^ pjob->first) & g_edio24rec.mask, pjob->first);
+            }
+            for (j = 0; j < pjob->num_edges; j ++) {
+                edio24rec_edge(pjob->edges[j].time, pjob->edges[j].changed, pjob->edges[j].value);
+            }
+            g_edio24rec.last = pjob->last;
+            g_edio24rec.flg_has_last = 1;
+        }
+        free(pjob->edges);
+    }
+    free(jobs);
+
+    if (EDIO24REC_HISTOGRAM == g_edio24rec.query) {
+        printf("pin,level,min_us,max_us,count\n");
+        for (pin = 0; pin < EDIO24REC_NUM_PINS; pin ++) {
+            for (level = 1; level >= 0; level --) {
+                for (b = 0; b < EDIO24REC_NUM_BUCKETS; b ++) {
+                    if (g_edio24rec.hist[pin][level][b] > 0) {
+                        printf("%d,%d,%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n", pin, level, (b > 0 ? (uint64_t)1 << b : 0)
+                            , ((uint64_t)1 << b) * 2 - 1, g_edio24rec.hist[pin][level][b]);
+                    }
+                }
+            }
+        }
+    }
+    fflush(stdout);
+    uv_loop_close(loop);
+    return 0;
+}
+
+/**
+ * \brief print the samples of a time range
+ * \param fn: the recording
+ * \param time_begin: the microseconds since the Epoch, the first sample printed
+ * \param time_end: the samples before it are printed
+ * \param device: the device, <0 for all of the devices
+ * \param cmd: the command, <0 for all of the commands
+ * \param flg_stats: 1 -- print the statistics only
+ * \return 0 on success, <0 on error
+ */
+static int
+edio24rec_query (const char * fn, uint64_t time_begin, uint64_t time_end, int device, int cmd, char flg_stats)
+{
+    edio24_rec_reader_t * prd = &(g_edio24rec.rd);
+    edio24_rec_t * recs = NULL;
+    struct timespec ts0;
+    struct timespec ts1;
+    size_t num_chunks = 0;
+    size_t sz_recs = 0;
+    size_t num_match = 0;
+    size_t num_total = 0;
+    struct stat st;
+    void * p;
+    ssize_t ret;
+    size_t i;
+    ssize_t j;
+    int fd;
+
+    fd = open(fn, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "edio24rec error in open '%s'\n", fn);
+        return -1;
+    }
+    if ((fstat(fd, &st) < 0) || (st.st_size < EDIO24_REC_HDR_SIZE)) {
+        fprintf(stderr, "edio24rec not a recording: '%s'\n", fn);
+        close(fd);
+        return -1;
+    }
+    p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == p) {
+        return -1;
+    }
+    if (edio24_rec_reader_init(prd, (const uint8_t *)p, st.st_size) < 0) {
+        fprintf(stderr, "edio24rec not a recording: '%s'\n", fn);
+        munmap(p, st.st_size);
+        return -1;
+    }
+    if (EDIO24REC_LIST != g_edio24rec.query) {
+        g_edio24rec.time_begin = time_begin;
+        g_edio24rec.time_end = time_end;
+        g_edio24rec.device = device;
+        g_edio24rec.cmd = (cmd < 0 ? EDIO24_CMD_DIN_R : cmd);
+        clock_gettime(CLOCK_MONOTONIC, &ts0);
+        ret = edio24rec_query_edges(&num_chunks);
+        clock_gettime(CLOCK_MONOTONIC, &ts1);
+        fprintf(stderr, "edio24rec %" PRIuSZ " results of %" PRIuSZ " chunks in %.3f ms\n", g_edio24rec.num_out, num_chunks
+            , (ts1.tv_sec - ts0.tv_sec) * 1000.0 + (ts1.tv_nsec - ts0.tv_nsec) / 1000000.0);
+        edio24_rec_reader_clean(prd);
+        munmap(p, st.st_size);
+        return ret;
+    }
+    for (i = edio24_rec_reader_seek(prd, time_begin); (i < prd->num_chunks) && (prd->chunks[i].time_first < time_end); i ++) {
+        if (prd->chunks[i].num_records > sz_recs) {
+            edio24_rec_t * pnew = (edio24_rec_t *)realloc(recs, prd->chunks[i].num_records * sizeof(*recs));
+            if (NULL == pnew) {
+                break;
+            }
+            recs = pnew;
+            sz_recs = prd->chunks[i].num_records;
+        }
+        ret = edio24_rec_reader_decode(prd, i, recs, sz_recs);
+        if (ret < 0) {
+            fprintf(stderr, "edio24rec skip the broken chunk at offset %" PRIuSZ "\n", prd->chunks[i].offset);
+            continue;
+        }
+        num_total += ret;
+        for (j = 0; j < ret; j ++) {
+            if ((recs[j].time < time_begin) || (recs[j].time >= time_end)
+                || ((device >= 0) && (recs[j].device != device))
+                || ((cmd >= 0) && (recs[j].cmd != cmd))) {
+                continue;
+            }
+            num_match ++;
+            if (! flg_stats) {
+                printf("%" PRIu64 " %d %s 0x%06X\n", recs[j].time, (int)(recs[j].device), edio24_val2cstr_cmd(recs[j].cmd), recs[j].value);
+            }
+        }
+    }
+    if (flg_stats) {
+        printf("file: %" PRIuSZ " bytes, %" PRIuSZ " chunks", (size_t)st.st_size, prd->num_chunks);
+        if (prd->num_chunks > 0) {
+            printf(", from %" PRIu64 " to %" PRIu64, prd->chunks[0].time_first, prd->chunks[prd->num_chunks - 1].time_last);
+        }
+        printf("\n");
+        if (prd->sz_valid < (size_t)st.st_size) {
+            printf("incomplete tail: %" PRIuSZ " bytes\n", (size_t)st.st_size - prd->sz_valid);
+        }
+        printf("decoded: %" PRIuSZ " samples, matched: %" PRIuSZ "\n", num_total, num_match);
+    }
+    free(recs);
+    edio24_rec_reader_clean(prd);
+    munmap(p, st.st_size);
+    return 0;
+}
+
+static void
+version (void)
+{
+    printf ("E-DIO24 recording query v%d.%d\n", EDIO24REC_MAIN, EDIO24REC_MINOR);
+}
+
+static void
+help(const char * progname)
+{
+    printf ("Usage: \n"
+            "\t%s [-h] [-b <time>] [-e <time>] [-d <device>] [-c <command>] [-s] <file>\n"
+            , basename((char *)progname));
+    printf ("\nOptions:\n");
+    printf ("\t-b <time>\tthe first microsecond since the Epoch, default the beginning\n");
+    printf ("\t-e <time>\tthe end microsecond since the Epoch, default the end\n");
+    printf ("\t-d <num>\tthe samples of a device only\n");
+    printf ("\t-c <command>\tthe samples of a command only, the keyword of the script, for example DIn\n");
+    printf ("\t-s\tprint the statistics only\n");
+    printf ("\t-q <query>\tthe pins of a device (-d) by CSV: edges, rising, falling, pulses, histogram\n");
+    printf ("\t-p <pin>\tthe pin 0-23 of the query, it can be used more than once, default all\n");
+    printf ("\t-P <port>\tthe 8 pins of the port 0-2 of the query\n");
+    printf ("\t-o <format>\tthe output of edges and pulses: csv (default) or bin\n");
+    printf ("\t-j <num>\tthe number of the threads of the query\n");
+    printf ("\t-h\tPrint this message.\n");
+    printf ("\nOutput: a line of '<time> <device> <command> <value>' for each sample\n");
+    printf ("\tedges, rising, falling: 'time,device,pin,level'; binary: [time, 8][device, 2][pin][level]\n");
+    printf ("\tpulses: 'start,width,device,pin,level'; binary: [start, 8][width, 8][device, 2][pin][level]\n");
+    printf ("\thistogram: 'pin,level,min_us,max_us,count', the widths of the pulses by powers of 2\n");
+    printf ("\tthe integers of the binary output are little endian\n");
+}
+
+static void
+usage (char *progname)
+{
+    version ();
+    help (progname);
+}
+
+int
+main(int argc, char * argv[])
+{
+    const edio24_script_cmd_t * pcmd;
+    uint64_t time_begin = 0;
+    uint64_t time_end = UINT64_MAX;
+    int device = -1;
+    int cmd = -1;
+    char flg_stats = 0;
+    const char * queries[] = { "list", "edges", "rising", "falling", "pulses", "histogram", };
+    char * endptr;
+    long pin;
+    size_t i;
+
+    int c;
+    struct option longopts[]  = {
+        { "begin",        1, 0, 'b' },
+        { "end",          1, 0, 'e' },
+        { "device",       1, 0, 'd' },
+        { "command",      1, 0, 'c' },
+        { "stats",        0, 0, 's' },
+        { "query",        1, 0, 'q' },
+        { "pin",          1, 0, 'p' },
+        { "port",         1, 0, 'P' },
+        { "output",       1, 0, 'o' },
+        { "threads",      1, 0, 'j' },
+
+        { "help",         0, 0, 'h' },
+        { 0,              0, 0,  0  },
+    };
+
+    while ((c = getopt_long( argc, argv, "b:e:d:c:sq:p:P:o:j:h", longopts, NULL )) != EOF) {
+        switch (c) {
+            case 'b':
+                time_begin = strtoull(optarg, NULL, 10);
+                break;
+            case 'e':
+                time_end = strtoull(optarg, NULL, 10);
+                break;
+            case 'd':
+                device = atoi(optarg);
+                break;
+            case 'c':
+                pcmd = edio24_script_lookup(optarg, strlen(optarg));
+                if ((NULL == pcmd) || (EDIO24_SCRIPT_PKT != pcmd->kind)) {
+                    fprintf (stderr, "Unknown command: '%s'.\n", optarg);
+                    exit (-1);
+                }
+                cmd = pcmd->cmd;
+                break;
+            case 's':
+                flg_stats = 1;
+                break;
+            case 'q':
+                for (i = 0; (i < NUM_ARRAY(queries)) && (0 != strcmp(optarg, queries[i])); i ++);
+                if (i >= NUM_ARRAY(queries)) {
+                    fprintf (stderr, "Unknown query: '%s'.\n", optarg);
+                    exit (-1);
+                }
+                g_edio24rec.query = i;
+                break;
+            case 'p':
+            case 'P':
+                pin = strtol(optarg, &endptr, 10);
+                if ((*endptr != 0) || (pin < 0) || (pin >= ('p' == c ? EDIO24REC_NUM_PINS : EDIO24REC_NUM_PINS / 8))) {
+                    fprintf (stderr, "Illegal %s: '%s'.\n", ('p' == c ? "pin" : "port"), optarg);
+                    exit (-1);
+                }
+                g_edio24rec.mask |= ('p' == c ? 1UL << pin : 0xFFUL << (8 * pin));
+                break;
+            case 'o':
+                g_edio24rec.flg_binary = (0 == strcmp(optarg, "bin"));
+                break;
+            case 'j':
+                // before the thread pool is started by the first work
+                setenv("UV_THREADPOOL_SIZE", optarg, 1);
+                break;
+
+            case 'h':
+                usage (argv[0]);
+                exit (0);
+                break;
+            default:
+                fprintf (stderr, "Unknown parameter: '%c'.\n", c);
+                fprintf (stderr, "Use '%s -h' for more information.\n", basename(argv[0]));
+                exit (-1);
+                break;
+        }
+    }
+    if (optind >= argc) {
+        usage (argv[0]);
+        exit (-1);
+    }
+    if ((EDIO24REC_LIST != g_edio24rec.query) && (device < 0)) {
+        fprintf (stderr, "The query needs a device: -d <num>.\n");
+        exit (-1);
+    }
+    if (0 == g_edio24rec.mask) {
+        g_edio24rec.mask = (1UL << EDIO24REC_NUM_PINS) - 1;
+    }
+    return (edio24rec_query(argv[optind], time_begin, time_end, device, cmd, flg_stats) < 0 ? 1 : 0);
+}
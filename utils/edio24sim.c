@@ -17,485 +17,302 @@
 #include <assert.h>
 #include <uv.h>
 
-#include "libedio24.h"
+#include "libedio24sim.h"
+#include "uvclock.h"
 
-#if DEBUG
-#include "hexdump.h"
-#else
-#define hex_dump_to_fd(fd, fragment, size)
-#endif
+#define EDIO24SIM_MAX_THREADS 256
+#define EDIO24SIM_MAX_DEVICES 4096
 
-#define DEFAULT_BACKLOG 128
-
-uv_loop_t * loop = NULL; /**< this have to be global variable, since it needs to access in on_xxxx() when service new connections */
-
-typedef struct _edio24svr_t {
-    char flg_used; /**< 1 -- if the service in busy, only one connect were allowed */
-    char flg_randfail; /**< 1 -- if the server send out fail message on requests */
-    time_t starttime;
+/**
+ * the context of one event loop, each worker thread owns one of it.
+ * all of the handles in the loop can reach it by handle->loop->data
+ */
+typedef struct _simworker_t {
+    int id;           /**< the index of the worker */
+    uv_loop_t * loop; /**< the loop of this worker */
+    uv_loop_t loop_data; /**< the storage of the loop if it's not the default loop */
+    uv_thread_t thread;
+    char flg_thread; /**< 1 -- if the worker runs in its own thread */
+
+    const char * host;
+    int port_udp; /**< the UDP port of the first device of this worker */
+    int port_tcp; /**< the TCP port of the first device of this worker */
+    int dev_first; /**< the index of the first device of this worker in all of the devices */
     time_t timeout;
 
-    size_t sz_data; /**< the lenght of data in the buffer */
-    uint8_t buffer[(EDIO24_PKT_LENGTH_MIN + 6) * 5]; /**< the buffer to cache the received packets */
-} edio24svr_t;
+    uv_signal_t sigint;
+    uvclock_t uvclk; /**< the real or virtual clock of the device */
+    edio24_timer_t tm_timeout;
 
-edio24svr_t g_edio24svr;
+    char flg_has_error;
+    int ret; /**< the return value of the worker */
 
-void
-alloc_buffer(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf)
-{
-    buf->base = malloc(suggested_size);
-    buf->len = suggested_size;
-}
-
-void
-realloc_buffer(size_t suggested_size, uv_buf_t *buf)
-{
-    if (buf->base && (buf->len >= suggested_size)) {
-        return;
-    }
-    buf->base = realloc(buf->base, suggested_size);
-    buf->len = suggested_size;
-}
+    edio24sim_t sim; /**< the simulated devices of this worker, the device i listens on the ports (port + i) */
+} simworker_t;
 
 /*****************************************************************************/
 
-typedef struct {
-    uv_udp_send_t req; // should be the first item to bring by the argument
-
-    // the other items bring by the 'req'
-    uv_buf_t buf;
-} udp_send_buf_t;
-
-void
-udp_send_buf_free (udp_send_buf_t *wr)
-{
-    free(wr->buf.base);
-    free(wr);
-}
-
-/*****************************************************************************/
-void
-on_udp_svr_close(uv_handle_t* handle)
+static void
+on_timeout (edio24_timer_t * ptm, void * userdata)
 {
-    fprintf(stderr, "udp svr closed.\n");
+    simworker_t * pwk = (simworker_t *)userdata;
+    pwk->flg_has_error = 1;
+    uv_stop(pwk->loop);
+    fprintf(stderr, "timeout: %d\n", (int)pwk->timeout);
 }
 
-void
-on_udp_svr_write(uv_udp_send_t *req, int status)
+static void
+on_uv_close(uv_handle_t* handle)
 {
-    if (status) {
-        fprintf(stderr, "udp svr write error %s\n", uv_strerror(status));
-    } else {
-        printf("wrote.\n");
+    if (handle != NULL) {
+        //delete handle;
     }
-    udp_send_buf_free ((udp_send_buf_t *)req);
 }
 
-void
-on_udp_srv_read(uv_udp_t *handle, ssize_t nread, const uv_buf_t *buf, const struct sockaddr *addr, unsigned flags)
+static void
+on_uv_walk(uv_handle_t* handle, void* arg)
 {
-    char flg_randfail = 0;
-    if (g_edio24svr.flg_randfail) {
-        if (rand() % 100 < 50) {
-            flg_randfail = 1;
-        }
+    if (! uv_is_closing(handle)) {
+        uv_close(handle, on_uv_close);
     }
-
-    fprintf(stderr, "udp svr read %" PRIiSZ "\n", nread);
-    if (nread < 0) {
-        fprintf(stderr, "udp svr read error %s\n", uv_err_name(nread));
-        uv_close(handle, on_udp_svr_close);
-        free(buf->base);
-        return;
-    }
-
-    if (NULL == addr) {
-        fprintf (stderr, "udp svr recv from addr NULL!\n");
-    } else {
-        char sender[17] = { 0 };
-        struct sockaddr_in *paddr = (struct sockaddr_in *)addr;
-        uv_ip4_name((const struct sockaddr_in*) addr, sender, sizeof(sender) - 1);
-        fprintf(stderr, "udp svr recv from addr %s, port %d\n", sender, ntohs(paddr->sin_port));
-    }
-
-    if ((NULL != buf) && (NULL != buf->base)) {
-        if ((nread == 1) && ('D' == buf->base[0])) {
-            /// discovery message
-            int ret;
-            size_t sz_out;
-            size_t sz_needed_out;
-            udp_send_buf_t *req = (udp_send_buf_t*) malloc(sizeof(udp_send_buf_t));
-            req->buf = uv_buf_init(buf->base, 64);
-            sz_out = 64;
-            sz_needed_out = 0;
-
-            ret = edio24_svr_process_udp(flg_randfail, (uint8_t *)(buf->base), nread, (uint8_t *)(buf->base), &sz_out, &sz_needed_out);
-            fprintf(stderr, "udp svr discovery process ret=%d, needout=%" PRIuSZ ", flg_randfail=%s; g_flg_randfail=%s\n", ret, sz_needed_out, (flg_randfail?"use fail":"use normal"), (g_edio24svr.flg_randfail?"use fail":"use normal"));
-            if ((sz_out > 0) && (NULL != addr)) {
-                fprintf(stderr, "udp svr send back sz=%" PRIuSZ "\n", sz_out);
-                int r = uv_udp_send(req, handle, &req->buf, 1, (const struct sockaddr *)addr, on_udp_svr_write);
-                if (r) {
-                    /* error */
-                    fprintf(stderr, "udp svr error in write() %s\n", uv_strerror(r));
-                    free(buf->base);
-                }
-            }
-
-        } else if ((nread == 5) && ('C' == buf->base[0])) {
-            /// start of new command session
-            udp_send_buf_t *req = (udp_send_buf_t*) malloc(sizeof(udp_send_buf_t));
-            req->buf = uv_buf_init(buf->base, 2);
-            req->buf.base[0] = 'C'; //0x43;
-            if (g_edio24svr.flg_used) {
-                req->buf.base[1] = 1;
-            } else {
-                req->buf.base[1] = 0;
-                if (flg_randfail) {
-                    req->buf.base[1] = 1;
-                }
-            }
-            //req->buf.len = 2;
-            if (NULL != addr) {
-                int r = uv_udp_send(req, handle, &req->buf, 1, (const struct sockaddr *)addr, on_udp_svr_write);
-                if (r) {
-                    /* error */
-                    fprintf(stderr, "udp svr error in write() %s\n", uv_strerror(r));
-                    free(buf->base);
-                }
-            }
-        } else {
-            // ignore
-            fflush(stderr);
-            fsync(STDERR_FILENO);
-            fprintf(stderr, "udp svr recv size(%" PRIuSZ ") != 5\n", nread);
-            hex_dump_to_fd(STDERR_FILENO, (opaque_t *)(buf->base), nread);
-            free(buf->base);
-            //buf->base = NULL; buf->len = 0;
-        }
-    }
-
-    //uv_udp_recv_stop(handle);
 }
 
-/*****************************************************************************/
-
-typedef struct {
-    uv_write_t req;
-    uv_buf_t buf;
-} write_buf_t;
-
-void
-write_buf_free (write_buf_t *wr)
-{
-    free(wr->buf.base);
-    free(wr);
-}
-
-/*****************************************************************************/
-void
-on_tcp_svr_close(uv_handle_t* handle)
-{
-    fprintf(stderr, "tcp svr client closed.\n");
-    g_edio24svr.flg_used = 0;
-    //raise(SIGINT); // send signal and handle by uv_signal_cb
-}
-
-void
-on_tcp_svr_write(uv_write_t* req, int status)
+static void
+on_sigint_received(uv_signal_t *handle, int signum)
 {
-    if (status) {
-        fprintf(stderr, "tcp svr write error %s\n", uv_strerror(status));
+    simworker_t * pwk = (simworker_t *)(handle->loop->data);
+    edio24sim_close(&(pwk->sim));
+    int result = uv_loop_close(handle->loop);
+    if (result == UV_EBUSY) {
+        uv_walk(handle->loop, on_uv_walk, NULL);
     }
-    write_buf_free((write_buf_t *)req);
 }
 
 /**
- * \brief process client packet in the buffer of edio24svr_t
- * \param ped: the edio24svr with buffer
- * \param stream: the libuv socket
- *
- * \return 0 on successs
+ * \brief run the loop of a worker
+ * \param arg: the worker context
  *
- * process the data in the buffer, and send response when possible,
- * until there's no more data can be processed in one round
+ * the result is stored in pwk->ret
  */
-ssize_t
-edio24svr_process_data (edio24svr_t * ped, uv_stream_t *stream)
+static void
+simworker_run (void * arg)
 {
-    uint8_t * buffer_in = NULL;
-    size_t sz_in;
-    uint8_t * buffer_out = NULL;
-    size_t sz_out;
-    size_t sz_processed;
-    size_t sz_needed_in;
-    size_t sz_needed_out;
-
-    //int flg_again = 0;
+    simworker_t * pwk = (simworker_t *)arg;
     int ret;
-    uv_buf_t buf;
-    char flg_randfail = 0;
-
-    assert (NULL != ped);
-    assert (NULL != stream);
-
-    alloc_buffer (NULL, 7+30, &buf);
-
-    while(1) { // while (ped->sz_data > 0) {
-        buffer_in = ped->buffer;
-        sz_in = ped->sz_data;
-        buffer_out = (uint8_t *)(buf.base);
-        sz_out = buf.len;
-        //flg_again = 0;
-        sz_processed = 0;
-        sz_needed_in = 0;
-        sz_needed_out = 0;
-
-        assert (NULL != buffer_in);
-        assert (sz_in >= 0);
-        assert (NULL != buffer_out);
-        assert (sz_out > 0);
-        flg_randfail = 0;
-        if (ped->flg_randfail) {
-            if (rand() % 100 < 50) {
-                flg_randfail = 1;
-            }
-        }
-        ret = edio24_svr_process_tcp(flg_randfail, buffer_in, sz_in, buffer_out, &sz_out,
-                                 &sz_processed, &sz_needed_in, &sz_needed_out);
-        if (sz_processed > 0) {
-            // remove the head of data of size sz_processed
-            size_t sz_rest;
-            assert (sz_processed <= ped->sz_data);
-            sz_rest = ped->sz_data - sz_processed;
-            if (sz_rest > 0) {
-                memmove (ped->buffer, &(ped->buffer[sz_processed]), sz_rest);
-            }
-            ped->sz_data = sz_rest;
-        }
-        if (sz_needed_in > 0) {
-            fprintf(stderr, "need more data: %" PRIuSZ "\n", sz_needed_in);
-            break;
-        }
-        if (sz_needed_out > 0) {
-            // extend the buffer_out
-            fprintf(stderr, "need more out buffer: %" PRIuSZ "\n", sz_needed_out);
-            realloc_buffer(buf.len + sz_needed_out, &buf);
-            //flg_again = 1;
-        }
-        if (sz_out > 0) {
-            fprintf(stderr, "send out packet size=%" PRIuSZ "\n", sz_out);
-            write_buf_t *req = (write_buf_t*) malloc(sizeof(write_buf_t));
-            alloc_buffer(NULL, sz_out, &(req->buf));
-            memmove (req->buf.base, buffer_out, sz_out);
-            assert ((uint8_t *)(buf.base) == buffer_out);
-            int r = uv_write((uv_write_t*) req, stream, &req->buf, 1, on_tcp_svr_write);
-            if (r) {
-                /* error */
-                fprintf(stderr, "tcp svr error in write() %s\n", uv_strerror(r));
-            }
-        }
-        if (ret < 0) {
-            break;
-        } else if (ret == 0) {
-            //flg_again = 1;
-        } else if (ret == 1) {
-            //flg_again = 1;
-        } else if (ret == 2) {
-            break;
+    size_t i;
+
+    assert (NULL != pwk);
+    pwk->ret = 1;
+    for (i = 0; i < pwk->sim.num; i ++) {
+        if (0 != edio24sim_listen (&(pwk->sim), i, pwk->host, pwk->port_udp + (int)i, pwk->port_tcp + (int)i, 0)) {
+            fprintf(stderr, "svr %d error in listen device %d\n", pwk->id, pwk->dev_first + (int)i);
+            edio24sim_close (&(pwk->sim));
+            return;
         }
     }
-    if (buf.base) {
-        free (buf.base);
-    }
-    return 0;
-}
-
-void
-on_tcp_svr_read(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf)
-{
-    if (nread > 0) {
-        // push the content to a center buffer for this TCP connection
-        // and fetch the cmd to fetch appriate length of data as a packet
-        // to process
-        size_t sz_copy;
-        size_t sz_processed;
-
-        fprintf(stderr,"tcp svr read block:\n");
-        hex_dump_to_fd(STDERR_FILENO, (opaque_t *)(buf->base), nread);
-
-        fprintf(stderr, "tcp svr process data 1\n");
-        edio24svr_process_data (&g_edio24svr, stream);
-        sz_processed = 0;
-        while (sz_processed < nread) {
-            sz_copy = nread - sz_processed;
-            assert (sizeof(g_edio24svr.buffer) >= g_edio24svr.sz_data);
-            if (sz_copy + g_edio24svr.sz_data > sizeof(g_edio24svr.buffer)) {
-                sz_copy = sizeof(g_edio24svr.buffer) - g_edio24svr.sz_data;
-            }
-            fprintf(stderr, "tcp svr push received data size=%" PRIuSZ ", processed=%" PRIuSZ "\n", sz_copy, sz_processed);
-            if (sz_copy > 0) {
-                memmove (g_edio24svr.buffer + g_edio24svr.sz_data, buf->base + sz_processed, sz_copy);
-                sz_processed += sz_copy;
-                g_edio24svr.sz_data += sz_copy;
-            } else {
-                // error? full?
-                fprintf(stderr, "tcp svr no more received data to be push\n");
-                break;
-            }
-            fprintf(stderr, "tcp svr process data 2\n");
-            edio24svr_process_data (&g_edio24svr, stream);
-        }
-        if (sz_processed < nread) {
-            // we're stalled here, because the content can't be processed by the function edio24svr_process_data()
-            // error
-            fprintf(stderr, "tcp svr data stalled\n");
-            uv_close((uv_handle_t *)stream, on_tcp_svr_close);
-        }
+    ret = uv_run(pwk->loop, UV_RUN_DEFAULT);
+    if (pwk->uvclk.clock.flg_virtual) {
+        fprintf(stderr, "svr %d virtual time elapsed: %" PRIu64 " microseconds\n", pwk->id, edio24_clock_now(&(pwk->uvclk.clock)));
     }
-    if (nread == 0) {
-        fprintf(stderr,"tcp svr read zero!\n");
+    if (ret != 0) {
+        pwk->ret = ret;
+        return;
     }
-    if (nread < 0) {
-        if (nread != UV_EOF) {
-            fprintf(stderr, "tcp svr read error %s\n", uv_err_name(nread));
-        }
-
-        fprintf(stderr,"tcp svr close remote!\n");
-        uv_close((uv_handle_t *)stream, on_tcp_svr_close);
+    if (pwk->flg_has_error) {
+        return;
     }
-
-    fprintf(stderr, "tcp svr read end\n");
-    free(buf->base);
+    pwk->ret = 0;
 }
 
-void
-on_tcp_svr_accept (uv_stream_t *server, int status)
+/**
+ * \brief initialize a worker context
+ * \param pwk: the worker context
+ * \param id: the index of the worker, the worker 0 uses the default loop
+ * \param dev_first: the index of the first device of the worker
+ * \param num_devs: the number of devices of the worker
+ *
+ * The device (dev_first + i) listens on the ports (port_udp + dev_first + i) and (port_tcp + dev_first + i),
+ * so the workers don't share any port and each device keeps its own connection state.
+ *
+ * \return 0 on successs, <0 on error
+ */
+static int
+simworker_init (simworker_t * pwk, int id, int dev_first, int num_devs, const char * host, int port_udp, int port_tcp, time_t timeout, char flg_randfail, char flg_virtual, uint64_t latency)
 {
-    uv_tcp_t *client;
-
-    if (status < 0) {
-        fprintf(stderr, "tcp svr new connection error %s\n", uv_strerror(status));
-        // error!
-        return;
+    edio24sim_dev_t * pdev;
+    int i;
+
+    assert (NULL != pwk);
+    memset (pwk, 0, sizeof(*pwk));
+    pwk->id = id;
+    pwk->host = host;
+    pwk->dev_first = dev_first;
+    pwk->port_udp = port_udp + dev_first;
+    pwk->port_tcp = port_tcp + dev_first;
+    pwk->timeout = timeout;
+
+    if (0 == id) {
+        pwk->loop = uv_default_loop();
+    } else {
+        if (0 != uv_loop_init(&(pwk->loop_data))) {
+            return -1;
+        }
+        pwk->loop = &(pwk->loop_data);
     }
+    assert (NULL != pwk->loop);
+    pwk->loop->data = pwk;
 
-    fprintf(stderr, "tcp svr accept()\n");
-    if (g_edio24svr.flg_used) {
-        fprintf(stderr, "device busy\n");
-        return;
+    uv_signal_init(pwk->loop, &(pwk->sigint));
+    uv_signal_start(&(pwk->sigint), on_sigint_received, SIGINT);
+    if (uvclock_init(pwk->loop, &(pwk->uvclk), flg_virtual) < 0) {
+        return -1;
     }
-    g_edio24svr.flg_used = 1;
-
-    client = malloc(sizeof(uv_tcp_t));
-    uv_tcp_init(loop, client);
-    if (uv_accept(server, (uv_stream_t *)client) == 0) {
-
-        int r = uv_read_start((uv_stream_t *)client, alloc_buffer, on_tcp_svr_read);
-        if (r) {
-            /* error */
-            fprintf(stderr, "tcp svr accept client error %s\n", uv_strerror(status));
-        }
-    } else {
-        g_edio24svr.flg_used = 0;
-        fprintf(stderr, "tcp svr failed at accept, close client socket\n");
-        uv_close((uv_handle_t *)client, on_tcp_svr_close);
+    edio24_timer_init(&(pwk->tm_timeout));
+    if (timeout > 0) {
+        edio24_timer_start(&(pwk->uvclk.clock), &(pwk->tm_timeout), (uint64_t)timeout * 1000000, on_timeout, pwk);
     }
-}
-
-/*****************************************************************************/
-
-static char flg_has_error = 0;
 
-static void
-idle_cb (uv_idle_t *handle)
-{
-    time_t curtime;
-    time(&curtime);
-    if (g_edio24svr.starttime + g_edio24svr.timeout <= curtime) {
-        flg_has_error = 1;
-        uv_stop(uv_default_loop());
-        fprintf(stderr, "timeout: %d\n", (int)g_edio24svr.timeout);
+    // setup service related info
+    if (edio24sim_init(&(pwk->sim), pwk->loop, num_devs, &(pwk->uvclk.clock)) < 0) {
+        return -1;
     }
+    for (i = 0; i < num_devs; i ++) {
+        pdev = edio24sim_dev(&(pwk->sim), i);
+        pdev->dev.id = dev_first + i;
+        pdev->flg_randfail = flg_randfail;
+        pdev->latency = latency;
+    }
+    return 0;
 }
 
+/**
+ * \brief release a worker context after its loop ends
+ * \param pwk: the worker context
+ *
+ * close all of the handles left in the loop, let the loop finish the close callbacks and close the loop
+ */
 static void
-on_uv_close(uv_handle_t* handle)
+simworker_clean (simworker_t * pwk)
 {
-    if (handle != NULL) {
-        //delete handle;
+    assert (NULL != pwk);
+    if (NULL == pwk->loop) {
+        return;
     }
+    edio24sim_close (&(pwk->sim));
+    uv_walk(pwk->loop, on_uv_walk, NULL);
+    uv_run(pwk->loop, UV_RUN_DEFAULT);
+    edio24sim_clean (&(pwk->sim));
+    uvclock_clean (&(pwk->uvclk));
+    uv_loop_close(pwk->loop);
+    pwk->loop = NULL;
 }
 
+/**
+ * \brief add the statistics of a device to the total
+ * \param total: the merged statistics
+ * \param stats: the statistics to be added
+ */
 static void
-on_uv_walk(uv_handle_t* handle, void* arg)
+sim_stats_merge (edio24sim_stats_t * total, const edio24sim_stats_t * stats)
 {
-    uv_close(handle, on_uv_close);
+    total->num_accept  += stats->num_accept;
+    total->num_reject  += stats->num_reject;
+    total->num_udp     += stats->num_udp;
+    total->num_request += stats->num_request;
+    total->num_respond += stats->num_respond;
+    total->bytes_in    += stats->bytes_in;
+    total->bytes_out   += stats->bytes_out;
 }
 
 static void
-on_sigint_received(uv_signal_t *handle, int signum)
+sim_stats_print (FILE * fp, const char * title, const edio24sim_stats_t * stats)
 {
-    int result = uv_loop_close(handle->loop);
-    if (result == UV_EBUSY) {
-        uv_walk(handle->loop, on_uv_walk, NULL);
-    }
+    fprintf(fp, "%s: accept=%" PRIuSZ ", reject=%" PRIuSZ ", udp=%" PRIuSZ ", request=%" PRIuSZ ", respond=%" PRIuSZ ", bytes_in=%" PRIuSZ ", bytes_out=%" PRIuSZ "\n"
+        , title, stats->num_accept, stats->num_reject, stats->num_udp, stats->num_request, stats->num_respond, stats->bytes_in, stats->bytes_out);
 }
 
 int
-main_svr(const char * host, int port_udp, int port_tcp, time_t timeout, char flg_randfail)
+main_svr(const char * host, int port_udp, int port_tcp, time_t timeout, char flg_randfail, int num_threads, int num_devs, char flg_virtual, uint64_t latency)
 {
     int ret = 0;
-    struct sockaddr_in addr_udp;
-    struct sockaddr_in addr_tcp;
-    uv_udp_t uvudp;
-    uv_tcp_t uvtcp;
-    uv_idle_t idler;
-    uv_signal_t sigint;
-
-    // setup service related info
-    memset (&g_edio24svr, 0, sizeof (g_edio24svr));
-    g_edio24svr.flg_used = 0;
-    g_edio24svr.sz_data = 0;
-    g_edio24svr.flg_randfail = flg_randfail;
-
-    loop = uv_default_loop();
-    assert (NULL != loop);
-
-    uv_signal_init(loop, &sigint);
-    uv_signal_start(&sigint, on_sigint_received, SIGINT);
-    if (timeout > 0) {
-        uv_idle_init(loop, &idler);
-        uv_idle_start(&idler, idle_cb);
+    int i;
+    size_t j;
+    int dev_first;
+    int cnt;
+    simworker_t * list_wk = NULL;
+    edio24sim_stats_t stats_total;
+    edio24sim_stats_t stats_worker;
+    char title[32];
+
+    if (num_devs < 1) {
+        num_devs = 1;
     }
-    time (&(g_edio24svr.starttime));
-    g_edio24svr.timeout = timeout;
-
-    // setup the UDP listen port
-    uv_ip4_addr(host, port_udp, &addr_udp);
-    uv_udp_init(loop, &uvudp);
-    uv_udp_bind(&uvudp, (const struct sockaddr *)&addr_udp, UV_UDP_REUSEADDR);
-    uv_udp_recv_start(&uvudp, alloc_buffer, on_udp_srv_read);
-
-    // setup the TCP listen port
-    uv_ip4_addr(host, port_tcp, &addr_tcp);
-    uv_tcp_init(loop, &uvtcp);
-    uv_tcp_bind(&uvtcp, (const struct sockaddr*)&addr_tcp, 0);
-
-    int r = uv_listen((uv_stream_t *)&uvtcp, DEFAULT_BACKLOG, on_tcp_svr_accept);
-    if (r) {
-        fprintf(stderr, "tcp svr listen error %s\n", uv_strerror(r));
+    if (num_threads < 1) {
+        num_threads = 1;
+    }
+    if (num_threads > num_devs) {
+        // a worker without device has nothing to serve
+        num_threads = num_devs;
+    }
+    if ((port_udp + num_devs > 65536) || (port_tcp + num_devs > 65536)) {
+        fprintf(stderr, "error in the ports of %d devices: udp %d, tcp %d\n", num_devs, port_udp, port_tcp);
         return 1;
     }
+    list_wk = (simworker_t *)calloc(num_threads, sizeof(simworker_t));
+    if (NULL == list_wk) {
+        fprintf(stderr, "error in alloc %d workers\n", num_threads);
+        return 1;
+    }
+    dev_first = 0;
+    for (i = 0; i < num_threads; i ++) {
+        // split the devices into the ranges of the workers
+        cnt = num_devs / num_threads + ((i < num_devs % num_threads) ? 1 : 0);
+        if (0 != simworker_init (&(list_wk[i]), i, dev_first, cnt, host, port_udp, port_tcp, timeout, flg_randfail, flg_virtual, latency)) {
+            fprintf(stderr, "error in init worker %d\n", i);
+            num_threads = i;
+            ret = 1;
+            break;
+        }
+        dev_first += cnt;
+    }
 
-    ret = uv_run(loop, UV_RUN_DEFAULT);
-    if (ret != 0) {
-        return ret;
+    if (0 == ret) {
+        // the worker 0 runs in the main thread
+        for (i = 1; i < num_threads; i ++) {
+            if (0 != uv_thread_create(&(list_wk[i].thread), simworker_run, &(list_wk[i]))) {
+                fprintf(stderr, "error in create thread for worker %d\n", i);
+                list_wk[i].ret = 1;
+                continue;
+            }
+            list_wk[i].flg_thread = 1;
+        }
+        simworker_run (&(list_wk[0]));
+        for (i = 1; i < num_threads; i ++) {
+            if (list_wk[i].flg_thread) {
+                uv_thread_join(&(list_wk[i].thread));
+            }
+        }
     }
-    if (flg_has_error) {
-        return 1;
+
+    memset (&stats_total, 0, sizeof(stats_total));
+    for (i = 0; i < num_threads; i ++) {
+        memset (&stats_worker, 0, sizeof(stats_worker));
+        for (j = 0; j < list_wk[i].sim.num; j ++) {
+            sim_stats_merge (&stats_worker, &(list_wk[i].sim.devs[j].stats));
+        }
+        if (num_threads > 1) {
+            snprintf(title, sizeof(title), "worker %d", i);
+            sim_stats_print (stderr, title, &stats_worker);
+        }
+        sim_stats_merge (&stats_total, &stats_worker);
+        simworker_clean (&(list_wk[i]));
+        if (0 == ret) {
+            ret = list_wk[i].ret;
+        }
     }
-    return 0;
+    sim_stats_print (stderr, "total", &stats_total);
+    free (list_wk);
+    return ret;
 }
 
 /*****************************************************************************/
@@ -516,6 +333,10 @@ help(const char * progname)
     printf ("\t-t <port>\tE-DIO24 command (TCP) listen port\n");
     printf ("\t-u <port>\tE-DIO24 discover (UDP) listen port\n");
     printf ("\t-m <time>\tthe seconds of timeout\n");
+    printf ("\t-d <num>\tthe number of simulated devices, the device i listens on the UDP and TCP ports (port + i)\n");
+    printf ("\t-n <num>\tthe number of threads, each runs a range of the devices on its own loop\n");
+    printf ("\t-y <usec>\tthe simulated latency of the device to respond a request\n");
+    printf ("\t-s\tUse the virtual time, the latency and timeout advance without waiting\n");
     printf ("\t-l\tSend out fail message randomly on requests.\n");
     printf ("\t-h\tPrint this message.\n");
     printf ("\t-v\tVerbose information.\n");
@@ -537,6 +358,10 @@ main(int argc, char * argv[])
     int port_udp = EDIO24_PORT_DISCOVER;
     int port_tcp = EDIO24_PORT_COMMAND;
     time_t timeout = 0;
+    int num_threads = 1;
+    int num_devs = 1;
+    char flg_virtual = 0;
+    uint64_t latency = 0;
 
     int c;
     struct option longopts[]  = {
@@ -544,6 +369,10 @@ main(int argc, char * argv[])
         { "portudp",      1, 0, 'u' },
         { "porttcp",      1, 0, 't' },
         { "timeout",      1, 0, 'm' },
+        { "devices",      1, 0, 'd' },
+        { "threads",      1, 0, 'n' },
+        { "latency",      1, 0, 'y' },
+        { "virtualtime",  0, 0, 's' },
 
         { "randomfail",   0, 0, 'l' },
 
@@ -552,7 +381,7 @@ main(int argc, char * argv[])
         { 0,              0, 0,  0  },
     };
 
-    while ((c = getopt_long( argc, argv, "a:u:t:lhv", longopts, NULL )) != EOF) {
+    while ((c = getopt_long( argc, argv, "a:u:t:m:d:n:y:slhv", longopts, NULL )) != EOF) {
         switch (c) {
             case 'm':
                 if (strlen (optarg) > 0) {
@@ -574,6 +403,32 @@ main(int argc, char * argv[])
                     port_udp = atoi(optarg);
                 }
                 break;
+            case 'd':
+                if (strlen (optarg) > 0) {
+                    num_devs = atoi(optarg);
+                }
+                if ((num_devs < 1) || (num_devs > EDIO24SIM_MAX_DEVICES)) {
+                    fprintf (stderr, "The number of devices should be in 1-%d.\n", EDIO24SIM_MAX_DEVICES);
+                    exit (-1);
+                }
+                break;
+            case 'n':
+                if (strlen (optarg) > 0) {
+                    num_threads = atoi(optarg);
+                }
+                if ((num_threads < 1) || (num_threads > EDIO24SIM_MAX_THREADS)) {
+                    fprintf (stderr, "The number of threads should be in 1-%d.\n", EDIO24SIM_MAX_THREADS);
+                    exit (-1);
+                }
+                break;
+            case 'y':
+                if (strlen (optarg) > 0) {
+                    latency = strtoull(optarg, NULL, 10);
+                }
+                break;
+            case 's':
+                flg_virtual = 1;
+                break;
             case 'l':
                 flg_randfail = 1;
                 break;
@@ -594,5 +449,5 @@ main(int argc, char * argv[])
     }
     (void)flg_verbose;
 
-    return main_svr(host, port_udp, port_tcp, timeout, flg_randfail);
+    return main_svr(host, port_udp, port_tcp, timeout, flg_randfail, num_threads, num_devs, flg_virtual, latency);
 }
@@ -13,8 +13,14 @@
 #include <getopt.h>
 #include <assert.h>
 
+#include <uv.h>
+
 #include "libedio24.h" // PRIuSZ
+#include "edio24cmdstream.h"
+#include "edio24session.h"
 #include "utils.h"
+#include "uvclock.h"
+#include "uvtransport.h"
 
 #define EDIO24_INVALID_INT (-1)
 
@@ -133,56 +139,532 @@ parse_values_power (const char * arg, unsigned int * mask_pin)
     return 0;
 }
 
+/*****************************************************************************/
+// the bitsets of the clusters, the positions and the boards
+
+/** a bitset of any size */
+typedef struct _gencct_bits_t {
+    uint64_t * words;
+    size_t num;         /**< the number of the bits */
+} gencct_bits_t;
+
+#define GENCCT_BITS_WORDS(num) (((num) + 63) / 64)
+
+/**
+ * \brief init the bitset, all of the bits are cleared
+ * \param pbits: the bitset
+ * \param num: the number of the bits
+ * \return 0 on success, <0 on error
+ */
 int
-output_power(FILE * outf, void * user_arg)
+gencct_bits_init (gencct_bits_t * pbits, size_t num)
 {
-    char * arg = (char *)user_arg;
-    unsigned int mask_pin = 1;
+    assert (NULL != pbits);
+    pbits->num = num;
+    pbits->words = (uint64_t *)calloc(GENCCT_BITS_WORDS(num) + 1, sizeof(uint64_t));
+    if (NULL == pbits->words) {
+        pbits->num = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void
+gencct_bits_clean (gencct_bits_t * pbits)
+{
+    assert (NULL != pbits);
+    free (pbits->words);
+    memset(pbits, 0, sizeof(*pbits));
+}
+
+#define gencct_bits_test(pbits, i) ((i) < (pbits)->num && ((pbits)->words[(i) / 64] >> ((i) % 64)) & 1)
+
+/**
+ * \brief set the bits in the range [start, end), the bits out of the bitset are ignored
+ * \param pbits: the bitset
+ * \param start: the first bit
+ * \param end: the bit after the last one
+ */
+void
+gencct_bits_set_range (gencct_bits_t * pbits, size_t start, size_t end)
+{
+    size_t w;
+    uint64_t m;
+
+    assert (NULL != pbits);
+    if (end > pbits->num) {
+        end = pbits->num;
+    }
+    if (start >= end) {
+        return;
+    }
+    for (w = start / 64; w <= (end - 1) / 64; w ++) {
+        m = ~0ULL;
+        if (w == start / 64) {
+            m &= ~0ULL << (start % 64);
+        }
+        if ((w == (end - 1) / 64) && (end % 64)) {
+            m &= ~0ULL >> (64 - end % 64);
+        }
+        pbits->words[w] |= m;
+    }
+}
+
+#define gencct_bits_set(pbits, i) gencct_bits_set_range((pbits), (i), (i) + 1)
+
+/**
+ * \brief dst = dst & src, or dst = dst | src
+ * \param pdst: the bitset
+ * \param psrc: the bitset of the same size
+ * \param flg_or: 1 -- or, 0 -- and
+ */
+void
+gencct_bits_merge (gencct_bits_t * pdst, const gencct_bits_t * psrc, char flg_or)
+{
+    size_t w;
+    assert (NULL != pdst);
+    assert (NULL != psrc);
+    assert (pdst->num == psrc->num);
+    if (flg_or) {
+        for (w = 0; w < GENCCT_BITS_WORDS(pdst->num); w ++) {
+            pdst->words[w] |= psrc->words[w];
+        }
+    } else {
+        for (w = 0; w < GENCCT_BITS_WORDS(pdst->num); w ++) {
+            pdst->words[w] &= psrc->words[w];
+        }
+    }
+}
+
+/**
+ * \brief find the next bit set
+ * \param pbits: the bitset
+ * \param from: the first bit to be checked
+ * \return the index of the bit, pbits->num if not found
+ */
+size_t
+gencct_bits_next (const gencct_bits_t * pbits, size_t from)
+{
+    size_t w;
+    uint64_t m;
+
+    assert (NULL != pbits);
+    if (from >= pbits->num) {
+        return pbits->num;
+    }
+    w = from / 64;
+    m = pbits->words[w] & (~0ULL << (from % 64));
+    while (0 == m) {
+        w ++;
+        if (w >= GENCCT_BITS_WORDS(pbits->num)) {
+            return pbits->num;
+        }
+        m = pbits->words[w];
+    }
+    w = w * 64 + __builtin_ctzll(m);
+    return (w < pbits->num ? w : pbits->num);
+}
+
+/**
+ * \brief parse the arg of a selector to a bitset
+ * \param arg: the input string
+ * \param pbits: the bitset, the numbers out of it are ignored
+ * \param val: the return value for 'v'
+ * \return 0 on success, <0 on error
+ *
+ * The format is the same as parse_values_atten(), and the ranges are supported:
+ *    "p=0,3-5,1000;v=31" -- positions 0, 3, 4, 5 and 1000; value 31
+ */
+int
+parse_values_bits (const char * arg, gencct_bits_t * pbits, unsigned int * val)
+{
+    const char * p;
+    char * pend;
+    unsigned long start;
+    unsigned long end;
+    int type = 0;
+    int got = 0;
+
+    assert (NULL != arg);
+    assert (NULL != pbits);
+    assert (NULL != val);
+
+    memset(pbits->words, 0, sizeof(uint64_t) * GENCCT_BITS_WORDS(pbits->num));
+    if (strlen(arg) < 1) {
+        return -1;
+    }
+    for (p = arg; *p; p ++) {
+        if (0 == strncmp(p, "p=", 2)) {
+            type = 1;
+            got = 0;
+            p += 1;
+        } else if (0 == strncmp(p, "v=", 2)) {
+            type = 2;
+            got = 0;
+            p += 1;
+        } else if (0 == strncmp(p, "all", 3)) {
+            if (type != 1) {
+                fprintf(stderr, "Error selector arg, invalid values only for 'p'");
+                return -1;
+            }
+            gencct_bits_set_range(pbits, 0, pbits->num);
+            p += 2;
+            type = 0;
+            got = 1;
+        } else if (*p == ',') {
+        } else if (*p == ';') {
+            type = 0;
+        } else if (isdigit(*p)) {
+            start = end = strtoul(p, &pend, 10);
+            if (('-' == *pend) && isdigit(pend[1])) {
+                end = strtoul(pend + 1, &pend, 10);
+            }
+            p = pend - 1;
+            if (type == 1) {
+                gencct_bits_set_range(pbits, start, end + 1);
+            } else if (type == 2) {
+                *val = start;
+            }
+            got = 1;
+        } else {
+            fprintf(stderr, "parse error for char '%c'\n", *p);
+            return -1;
+        }
+    }
+    if (type == 2 && ! got) {
+        return -1;
+    }
+    return 0;
+}
+
+/*****************************************************************************/
+// the commands for the devices are generated as the structures, and passed to a sink:
+// the text lines for edio24cli, or the command streams executed by this process
+
+#define GENCCT_OP_DEVICE 1 /**< the following commands are for the device, '# ConnectTo ...' */
+#define GENCCT_OP_DCONFW 2 /**< 'DConfigW <mask> <value>' */
+#define GENCCT_OP_DOUTW  3 /**< 'DOutW <mask> <value>' */
+#define GENCCT_OP_DOUTR  4 /**< 'DOutR' */
+#define GENCCT_OP_SLEEP  5 /**< 'Sleep <microseconds>' */
+#define GENCCT_OP_END    6 /**< the end of a group of the commands, an empty line */
+
+/** a command generated */
+typedef struct _gencct_cmd_t {
+    uint8_t op;         /**< GENCCT_OP_xxx */
+    int device;         /**< the index of the device in the EDIO24 list, for GENCCT_OP_DEVICE */
+    const char * line;  /**< the record line of the device, for GENCCT_OP_DEVICE */
+    uint32_t mask;
+    uint32_t value;     /**< the value, or the microseconds of GENCCT_OP_SLEEP */
+} gencct_cmd_t;
+
+typedef struct _gencct_sink_t gencct_sink_t;
+
+/** the receiver of the commands generated */
+struct _gencct_sink_t {
+    /** process a command, return 0 on success, <0 on error */
+    int (* emit)(gencct_sink_t * psink, const gencct_cmd_t * pcmd);
+    void * userdata;
+};
+
+/**
+ * \brief pass a command to the sink
+ * \param psink: the sink
+ * \param op: GENCCT_OP_xxx
+ * \param mask: the mask
+ * \param value: the value, or the microseconds of GENCCT_OP_SLEEP
+ * \return 0 on success, <0 on error
+ */
+static int
+gencct_emit (gencct_sink_t * psink, uint8_t op, uint32_t mask, uint32_t value)
+{
+    gencct_cmd_t cmd;
+    assert (NULL != psink);
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.op = op;
+    cmd.device = -1;
+    cmd.mask = mask;
+    cmd.value = value;
+    return psink->emit(psink, &cmd);
+}
+
+/**
+ * \brief pass the command to select a device to the sink
+ * \param psink: the sink
+ * \param device: the index of the device in the EDIO24 list
+ * \param line: the record line of the device
+ * \return 0 on success, <0 on error
+ */
+static int
+gencct_emit_device (gencct_sink_t * psink, int device, const char * line)
+{
+    gencct_cmd_t cmd;
+    assert (NULL != psink);
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.op = GENCCT_OP_DEVICE;
+    cmd.device = device;
+    cmd.line = line;
+    return psink->emit(psink, &cmd);
+}
 
+/**
+ * \brief the sink writes the commands as the text lines of edio24cli
+ * \param psink: the sink, the userdata is the FILE pointer
+ * \param pcmd: the command
+ * \return 0 on success, <0 on error
+ */
+static int
+gencct_sink_text_emit (gencct_sink_t * psink, const gencct_cmd_t * pcmd)
+{
+    FILE * outf = (FILE *)(psink->userdata);
     assert (NULL != outf);
-    //fprintf (stderr, "output_power: arg='%s'\n", user_arg);
+    switch (pcmd->op) {
+    case GENCCT_OP_DEVICE:
+        fprintf(outf, "# ConnectTo %s # %d\n", pcmd->line, pcmd->device + 1);
+        break;
+    case GENCCT_OP_DCONFW:
+        fprintf(outf, "DConfigW 0x%06X 0x%06X\n", pcmd->mask, pcmd->value);
+        break;
+    case GENCCT_OP_DOUTW:
+        fprintf(outf, "DOutW 0x%06X 0x%06X\n", pcmd->mask, pcmd->value);
+        break;
+    case GENCCT_OP_DOUTR:
+        fprintf(outf, "DOutR\n");
+        break;
+    case GENCCT_OP_SLEEP:
+        fprintf(outf, "Sleep %u\n", pcmd->value);
+        break;
+    case GENCCT_OP_END:
+        fprintf(outf, "\n");
+        break;
+    default:
+        return -1;
+    }
+    return 0;
+}
 
-    if (0 != parse_values_power (arg, &mask_pin)) {
-        fprintf (stderr, "Error: parse the power values arg='%s'\n", arg);
-        return 1;
+#define GENCCT_SINK_TEXT_INIT(outf) { gencct_sink_text_emit, (void *)(outf) }
+
+/** the peephole optimizer of the commands, it passes the commands to the next sink
+ *
+ * The latch of the DIO keeps its value, so a write of the bits to the values they already have
+ * is dropped (only the bits changed are written), and the Sleeps in a row are merged into one.
+ * The DOutW are not merged: after the redundant bits are dropped, the writes left next to each
+ * other are a latch enable of the attenuators closed and then a write of the data bus, which has
+ * to wait until the latch is closed.
+ * The states are forgotten when another device is selected.
+ */
+typedef struct _gencct_opt_t {
+    gencct_sink_t * pnext;  /**< the next sink */
+    uint32_t dconf_known;   /**< the bits of dconf written */
+    uint32_t dconf;
+    uint32_t dout_known;    /**< the bits of dout written */
+    uint32_t dout;
+    gencct_cmd_t pending;   /**< the Sleep being merged, op is 0 if none */
+    size_t num_in;          /**< the number of DConfigW/DOutW/DOutR/Sleep received */
+    size_t num_out;         /**< the number of DConfigW/DOutW/DOutR/Sleep passed */
+} gencct_opt_t;
+
+/**
+ * \brief init the optimizer
+ * \param popt: the optimizer
+ * \param pnext: the sink of the optimized commands
+ */
+static void
+gencct_opt_init (gencct_opt_t * popt, gencct_sink_t * pnext)
+{
+    assert (NULL != popt);
+    assert (NULL != pnext);
+    memset(popt, 0, sizeof(*popt));
+    popt->pnext = pnext;
+}
+
+/**
+ * \brief pass the pending command to the next sink
+ * \param popt: the optimizer
+ * \return 0 on success, <0 on error
+ */
+static int
+gencct_opt_flush (gencct_opt_t * popt)
+{
+    int ret;
+    if (0 == popt->pending.op) {
+        return 0;
     }
-    mask_pin &= 0xFF;
-    fprintf (stderr, "output_power: arg='%s', pin=0x%02X\n", arg, mask_pin);
+    ret = popt->pnext->emit(popt->pnext, &(popt->pending));
+    popt->pending.op = 0;
+    popt->num_out ++;
+    return ret;
+}
+
+/**
+ * \brief update the known bits of a register, return the bits changed by the write
+ * \param pknown: the known bits of the register
+ * \param pval: the register
+ * \param mask: the mask of the write
+ * \param value: the value of the write
+ * \return the bits of the mask which are unknown or different
+ */
+static uint32_t
+gencct_opt_write (uint32_t * pknown, uint32_t * pval, uint32_t mask, uint32_t value)
+{
+    uint32_t changed = mask & ~(*pknown & ~(*pval ^ value));
+    *pknown |= mask;
+    *pval = (*pval & ~mask) | (value & mask);
+    return changed;
+}
+
+/**
+ * \brief the sink optimizes the commands, see gencct_opt_t
+ * \param psink: the sink, the userdata is the optimizer
+ * \param pcmd: the command
+ * \return 0 on success, <0 on error
+ */
+static int
+gencct_opt_emit (gencct_sink_t * psink, const gencct_cmd_t * pcmd)
+{
+    gencct_opt_t * popt = (gencct_opt_t *)(psink->userdata);
+    gencct_cmd_t cmd = *pcmd;
+
+    assert (NULL != popt);
+    switch (cmd.op) {
+    case GENCCT_OP_DEVICE:
+        if (gencct_opt_flush(popt) < 0) {
+            return -1;
+        }
+        popt->dconf_known = 0;
+        popt->dout_known = 0;
+        return popt->pnext->emit(popt->pnext, &cmd);
+
+    case GENCCT_OP_END:
+        if (gencct_opt_flush(popt) < 0) {
+            return -1;
+        }
+        return popt->pnext->emit(popt->pnext, &cmd);
+
+    case GENCCT_OP_DCONFW:
+        popt->num_in ++;
+        cmd.mask = gencct_opt_write(&(popt->dconf_known), &(popt->dconf), cmd.mask, cmd.value);
+        if (0 == cmd.mask) {
+            return 0;
+        }
+        break;
+
+    case GENCCT_OP_DOUTW:
+        popt->num_in ++;
+        cmd.mask = gencct_opt_write(&(popt->dout_known), &(popt->dout), cmd.mask, cmd.value);
+        if (0 == cmd.mask) {
+            return 0;
+        }
+        cmd.value &= cmd.mask;
+        break;
+
+    case GENCCT_OP_SLEEP:
+        popt->num_in ++;
+        if (GENCCT_OP_SLEEP == popt->pending.op) {
+            popt->pending.value += cmd.value;
+            return 0;
+        }
+        if (gencct_opt_flush(popt) < 0) {
+            return -1;
+        }
+        popt->pending = cmd;
+        return 0;
+
+    case GENCCT_OP_DOUTR:
+        popt->num_in ++;
+        break;
+
+    default:
+        return -1;
+    }
+    if (gencct_opt_flush(popt) < 0) {
+        return -1;
+    }
+    popt->num_out ++;
+    return popt->pnext->emit(popt->pnext, &cmd);
+}
+
+#define GENCCT_SINK_OPT_INIT(popt) { gencct_opt_emit, (void *)(popt) }
+
+/**
+ * \brief generate the commands to set power on/off of the pins
+ * \param psink: the sink of the commands
+ * \param mask: the power pins of the boards
+ * \param value: the pins to be powered on, the others in the mask are powered off
+ * \return 0 on success
+ */
+int
+gen_power_pins(gencct_sink_t * psink, uint32_t mask, uint32_t value)
+{
+    assert (NULL != psink);
 
     // set power at port 0:
     // all pin output
-    fprintf (outf, "DConfigW 0xFFFFFF 0x000000\n");
+    gencct_emit (psink, GENCCT_OP_DCONFW, 0xFFFFFF, 0x000000);
 
     // port 0, if 1 -- power on, 0 -- power off
     // pin 3 power on
-    fprintf (outf, "DOutW 0x0000FF 0x%06X\n", (mask_pin & 0xFF));
+    gencct_emit (psink, GENCCT_OP_DOUTW, mask, (value & mask));
 
-    fprintf (outf, "\n");
+    gencct_emit (psink, GENCCT_OP_END, 0, 0);
     return 0;
 }
 
+/**
+ * \brief generate the commands to set power on/off
+ * \param psink: the sink of the commands
+ * \param arg: the power values, 'p=0,1,2'
+ * \return 0 on success, 1 on error
+ */
 int
-output_power_read(FILE * outf, void * user_arg)
+gen_power(gencct_sink_t * psink, const char * arg)
 {
-    char * arg = (char *)user_arg;
-    assert (NULL != outf);
+    unsigned int mask_pin = 1;
+
+    assert (NULL != psink);
+    //fprintf (stderr, "output_power: arg='%s'\n", arg);
+
+    if (0 != parse_values_power (arg, &mask_pin)) {
+        fprintf (stderr, "Error: parse the power values arg='%s'\n", arg);
+        return 1;
+    }
+    mask_pin &= 0xFF;
+    fprintf (stderr, "output_power: arg='%s', pin=0x%02X\n", arg, mask_pin);
+    return gen_power_pins(psink, 0x0000FF, mask_pin);
+}
+
+/**
+ * \brief generate the commands to read the power status
+ * \param psink: the sink of the commands
+ * \param arg: not used
+ * \return 0 on success
+ */
+int
+gen_power_read(gencct_sink_t * psink, const char * arg)
+{
+    assert (NULL != psink);
     fprintf (stderr, "output_power_read: arg='%s'\n", arg);
 
-    fprintf (outf, "DOutR\n"); // & 0xFF
-    fprintf (outf, "\n");
+    gencct_emit (psink, GENCCT_OP_DOUTR, 0, 0); // & 0xFF
+    gencct_emit (psink, GENCCT_OP_END, 0, 0);
     return 0;
 }
 
+/**
+ * \brief generate the commands to set the attenuation
+ * \param psink: the sink of the commands
+ * \param arg: the atten values, 'p=0,1,2;v=31'
+ * \return 0 on success, 1 on error
+ */
 int
-output_atten(FILE * outf, void * user_arg)
+gen_atten(gencct_sink_t * psink, const char * arg)
 {
-    char * arg = (char *)user_arg;
     unsigned int mask_pin = 1;
     unsigned int val = 31;
     uint32_t hval = 0x01;
 
-    assert (NULL != outf);
-    //fprintf (stderr, "output_atten: arg='%s'\n", user_arg);
+    assert (NULL != psink);
+    //fprintf (stderr, "output_atten: arg='%s'\n", arg);
 
     if (0 != parse_values_atten (arg, &mask_pin, &val)) {
         fprintf (stderr, "Error: parse the atten values: '%s'\n", arg);
@@ -192,42 +674,66 @@ output_atten(FILE * outf, void * user_arg)
     fprintf (stderr, "output_atten: arg='%s', pin=0x%02X, val=0x%04X\n", arg, mask_pin, val);
 
     // all pin output
-    fprintf (outf, "DConfigW 0xFFFFFF 0x000000\n");
+    gencct_emit (psink, GENCCT_OP_DCONFW, 0xFFFFFF, 0x000000);
 
     // tha latch for atten are at port 1
     // the data port of atten are at port 2
     // pin low, for example, pin 3
     hval = (mask_pin & 0xFF) << 8;
-    fprintf (outf, "DOutW 0x%06X 0x000000\n", hval);
+    gencct_emit (psink, GENCCT_OP_DOUTW, hval, 0x000000);
 
     // set the value 31 at port 2
     hval = (val & 0xFF) << 16;
-    fprintf (outf, "DOutW 0xFF0000 0x%06X\n", hval);
+    gencct_emit (psink, GENCCT_OP_DOUTW, 0xFF0000, hval);
 
     // usleep 1
-    fprintf (outf, "Sleep 1\n");
+    gencct_emit (psink, GENCCT_OP_SLEEP, 0, 1);
 
     // pin high, for pin 3
     hval = (mask_pin & 0xFF) << 8;
-    fprintf (outf, "DOutW 0x%06X 0x%06X\n", hval, hval);
+    gencct_emit (psink, GENCCT_OP_DOUTW, hval, hval);
 
     // usleep 1
-    fprintf (outf, "Sleep 1\n");
+    gencct_emit (psink, GENCCT_OP_SLEEP, 0, 1);
 
     // pin low again
     hval = (mask_pin & 0xFF) << 8;
-    fprintf (outf, "DOutW 0x%06X 0x000000\n", hval);
+    gencct_emit (psink, GENCCT_OP_DOUTW, hval, 0x000000);
 
     // set the data bus(port 2) to low
-    fprintf (outf, "DOutW 0xFF0000 0x000000\n");
+    gencct_emit (psink, GENCCT_OP_DOUTW, 0xFF0000, 0x000000);
 
     // usleep 1
-    //fprintf (outf, "Sleep 1\n");
+    //gencct_emit (psink, GENCCT_OP_SLEEP, 0, 1);
 
-    fprintf (outf, "\n");
+    gencct_emit (psink, GENCCT_OP_END, 0, 0);
     return 0;
 }
 
+int
+output_power(FILE * outf, void * user_arg)
+{
+    gencct_sink_t sink = GENCCT_SINK_TEXT_INIT(outf);
+    assert (NULL != outf);
+    return gen_power(&sink, (const char *)user_arg);
+}
+
+int
+output_power_read(FILE * outf, void * user_arg)
+{
+    gencct_sink_t sink = GENCCT_SINK_TEXT_INIT(outf);
+    assert (NULL != outf);
+    return gen_power_read(&sink, (const char *)user_arg);
+}
+
+int
+output_atten(FILE * outf, void * user_arg)
+{
+    gencct_sink_t sink = GENCCT_SINK_TEXT_INIT(outf);
+    assert (NULL != outf);
+    return gen_atten(&sink, (const char *)user_arg);
+}
+
 #if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
 #include <ciut.h>
 #include <ciut-sio.h>
@@ -405,13 +911,23 @@ TEST_CASE( .description="test gencctcmd output_xxx.", .skip=0 ) {
 /*****************************************************************************/
 // read the config files
 
+struct _board_inv_t;
+
 typedef struct _board_list_t {
     size_t sz_max;
     size_t sz_cur;
     char ** list;
+    struct _board_inv_t * inv; /**< the parsed columns of the rows, built by the first lookup */
+    char * arena;              /**< the rows loaded by brdlst_load(), the list and the strings in one block */
+    size_t sz_arena;
 } board_list_t;
 
-#define BRDLST_DECLARE_INIT(a) board_list_t a = {0, 0, NULL}
+#define BRDLST_DECLARE_INIT(a) board_list_t a = {0, 0, NULL, NULL, NULL, 0}
+
+/** if the pointer is in the arena of the list */
+#define BRDLST_IN_ARENA(plst, p) (((char *)(p) >= (plst)->arena) && ((char *)(p) < (plst)->arena + (plst)->sz_arena))
+
+static void brdinv_free (struct _board_inv_t * pinv);
 
 /**
  * \brief init the structure
@@ -439,10 +955,16 @@ brdlst_clean(board_list_t * plst)
         fprintf(stderr, "clean the brdlst list: sz=%" PRIuSZ ", max=%" PRIuSZ "\n", plst->sz_cur, plst->sz_max);
         for (i = 0; i < plst->sz_cur; i ++) {
             assert (NULL != plst->list[i]);
-            free (plst->list[i]);
+            if (! BRDLST_IN_ARENA(plst, plst->list[i])) {
+                free (plst->list[i]);
+            }
+        }
+        if (! BRDLST_IN_ARENA(plst, plst->list)) {
+            free (plst->list);
         }
-        free (plst->list);
     }
+    free (plst->arena);
+    brdinv_free (plst->inv);
     memset(plst, 0, sizeof(*plst));
 }
 
@@ -510,7 +1032,15 @@ brdlst_append(board_list_t * plst, const char * cstr)
         }
         assert (sz_buf > 0);
         assert (sz_buf > plst->sz_max);
-        list_new = realloc(plst->list, sizeof(char *) * sz_buf);
+        if ((NULL != plst->list) && BRDLST_IN_ARENA(plst, plst->list)) {
+            // move the list out of the arena
+            list_new = malloc(sizeof(char *) * sz_buf);
+            if (list_new) {
+                memmove(list_new, plst->list, sizeof(char *) * plst->sz_cur);
+            }
+        } else {
+            list_new = realloc(plst->list, sizeof(char *) * sz_buf);
+        }
         if (! list_new) {
             fprintf(stderr, "error in double memory\n");
             return -1;
@@ -656,56 +1186,609 @@ TEST_CASE( .description="test cstr_line_get_column.", .skip=0 ) {
 #endif /* CIUT_ENABLED */
 
 
-BRDLST_DECLARE_INIT(g_lst_brd);
-BRDLST_DECLARE_INIT(g_lst_edio24);
+/*****************************************************************************/
+// the inventory of a board list: the rows are parsed once into the columns,
+// the strings are interned in a pool and the looked-up columns are indexed by hash tables
+
+#define BRDINV_COL_NAME    0
+#define BRDINV_COL_SERIAL  1
+#define BRDINV_COL_INVID   2
+#define BRDINV_COL_NGCMAC  3
+#define BRDINV_COL_MAC     4
+#define BRDINV_COL_IP      5
+#define BRDINV_COL_IPV6    6
+#define BRDINV_COL_IPV6ALT 7
+#define BRDINV_COLUMNS     8          /**< the max number of the columns of a row */
+#define BRDINV_NONE        UINT32_MAX /**< the row has no such column */
+#define BRDINV_STR         (-1)       /**< the table is the intern table of the pool */
+
+typedef struct _board_inv_t {
+    size_t num;                      /**< the number of the rows parsed */
+    size_t sz_max;                   /**< the max number of the rows of the columns */
+    uint32_t * cols[BRDINV_COLUMNS]; /**< the offsets of the strings in the pool of each row */
+
+    char * pool;                     /**< the interned strings */
+    size_t sz_pool;
+    size_t sz_pool_max;
+    uint32_t * strs;                 /**< the intern table, the offset + 1 of the string, 0 -- empty */
+    size_t num_strs;
+    size_t slots_strs;               /**< the size of the intern table, a power of 2 */
+
+    uint32_t * idx[BRDINV_COLUMNS];  /**< the hash index of a column, the row + 1, 0 -- empty; NULL if not indexed */
+    size_t num_idx[BRDINV_COLUMNS];
+    size_t slots_idx[BRDINV_COLUMNS];
+} board_inv_t;
 
 /**
- * \brief process a line of a file
- * \param pos: the position of the line in the file
- * \param buf: the data of the line
- * \param size: the size of the buffer
- * \param userdata: the argument passed by user
- * \return 0 on success, <0 on failed
+ * \brief free the inventory
+ * \param pinv: the pointer to the inventory, may be NULL
  */
-int
-cb_process_brdlst_line (off_t pos, char * buf, size_t size, void *userdata)
+static void
+brdinv_free (struct _board_inv_t * pinv)
 {
-    board_list_t *plst = (board_list_t *)userdata;
-    assert (NULL != userdata);
-
-    //fprintf(stdout, "process edio24 line: '%s'\n", buf);
-    // strip the string
-    if (0 != cstr_strip (buf, buf, size)) {
-        fprintf(stderr, "error in process line: '%s'\n", buf);
-        return -1;
-    }
-    // if the line is comment line
-    if ('#' == buf[0]) {
-        fprintf(stderr, "skip line: '%s'\n", buf);
-        return 0;
+    int i;
+    if (NULL == pinv) {
+        return;
     }
-    if (0 == buf[0]) {
-        //fprintf(stderr, "skip line: '%s'\n", buf);
-        return 0;
+    for (i = 0; i < BRDINV_COLUMNS; i ++) {
+        free (pinv->cols[i]);
+        free (pinv->idx[i]);
     }
-    //fprintf(stderr, "start line: '%s'\n", buf);
-    // if the line is invalid
+    free (pinv->pool);
+    free (pinv->strs);
+    free (pinv);
+}
 
-    // add to the list
-    return brdlst_append(plst, buf);
+/* FNV-1a */
+static uint32_t
+brdinv_hash (const char * key)
+{
+    uint32_t h = 2166136261u;
+    for (; *key; key ++) {
+        h ^= (uint8_t)(*key);
+        h *= 16777619u;
+    }
+    return h;
 }
 
 /**
- * \brief read file and store the data in a global variable for EDIO24
- * \param fn: the file name of the edio24 config
+ * \brief find the slot of a key in a hash table
+ * \param pinv: the pointer to the inventory
+ * \param slots: the hash table
+ * \param num_slots: the size of the hash table, a power of 2
+ * \param column: the column indexed by the table, or BRDINV_STR for the intern table
+ * \param key: the key
+ * \return the index of the slot of the key, or the empty slot to store the key
  */
-static void
-read_file_edio24(const char * fn)
+static size_t
+brdinv_slot (const board_inv_t * pinv, const uint32_t * slots, size_t num_slots, int column, const char * key)
 {
-    board_list_t *plst = &g_lst_edio24;
+    size_t i;
+    uint32_t off;
+    assert (num_slots > 0);
+    assert (0 == (num_slots & (num_slots - 1)));
+    for (i = brdinv_hash(key) & (num_slots - 1); slots[i]; i = (i + 1) & (num_slots - 1)) {
+        off = (BRDINV_STR == column) ? (slots[i] - 1) : pinv->cols[column][slots[i] - 1];
+        if (0 == strcmp(pinv->pool + off, key)) {
+            break;
+        }
+    }
+    return i;
+}
+
+/**
+ * \brief grow a hash table to keep the load factor no more than 1/2
+ * \param pinv: the pointer to the inventory
+ * \param pslots: the pointer to the hash table
+ * \param pnum_slots: the pointer to the size of the hash table
+ * \param column: the column indexed by the table, or BRDINV_STR for the intern table
+ * \param num_keys: the number of the keys to be stored
+ * \return 0 on success, <0 on failed
+ */
+static int
+brdinv_reserve (board_inv_t * pinv, uint32_t ** pslots, size_t * pnum_slots, int column, size_t num_keys)
+{
+    size_t i;
+    size_t num_new;
+    uint32_t off;
+    uint32_t * slots_new;
+
+    if ((NULL != *pslots) && (num_keys * 2 <= *pnum_slots)) {
+        return 0;
+    }
+    for (num_new = 16; num_new < num_keys * 2; num_new *= 2);
+    slots_new = (uint32_t *)calloc(num_new, sizeof(uint32_t));
+    if (NULL == slots_new) {
+        fprintf(stderr, "error in malloc the hash table\n");
+        return -1;
+    }
+    for (i = 0; (NULL != *pslots) && (i < *pnum_slots); i ++) {
+        if (0 == (*pslots)[i]) {
+            continue;
+        }
+        off = (BRDINV_STR == column) ? ((*pslots)[i] - 1) : pinv->cols[column][(*pslots)[i] - 1];
+        slots_new[brdinv_slot(pinv, slots_new, num_new, column, pinv->pool + off)] = (*pslots)[i];
+    }
+    free (*pslots);
+    *pslots = slots_new;
+    *pnum_slots = num_new;
+    return 0;
+}
+
+/**
+ * \brief intern a string in the pool
+ * \param pinv: the pointer to the inventory
+ * \param str: the string, not NUL terminated
+ * \param len: the length of the string
+ * \return the offset of the string in the pool, BRDINV_NONE on failed
+ */
+static uint32_t
+brdinv_intern (board_inv_t * pinv, const char * str, size_t len)
+{
+    size_t i;
+    uint32_t off;
+
+    if (brdinv_reserve (pinv, &(pinv->strs), &(pinv->slots_strs), BRDINV_STR, pinv->num_strs + 1) < 0) {
+        return BRDINV_NONE;
+    }
+    // copy the string to the end of the pool, it is dropped if the pool has it already
+    if (pinv->sz_pool + len + 1 > pinv->sz_pool_max) {
+        size_t sz_new = (pinv->sz_pool_max > 0) ? (pinv->sz_pool_max * 2) : 1024;
+        char * pool_new;
+        for (; sz_new < pinv->sz_pool + len + 1; sz_new *= 2);
+        if (sz_new >= BRDINV_NONE) {
+            fprintf(stderr, "error: the pool of the strings is too large\n");
+            return BRDINV_NONE;
+        }
+        pool_new = (char *)realloc(pinv->pool, sz_new);
+        if (NULL == pool_new) {
+            fprintf(stderr, "error in double memory\n");
+            return BRDINV_NONE;
+        }
+        pinv->pool = pool_new;
+        pinv->sz_pool_max = sz_new;
+    }
+    off = pinv->sz_pool;
+    memmove (pinv->pool + off, str, len);
+    pinv->pool[off + len] = 0;
+
+    i = brdinv_slot (pinv, pinv->strs, pinv->slots_strs, BRDINV_STR, pinv->pool + off);
+    if (pinv->strs[i]) {
+        return pinv->strs[i] - 1;
+    }
+    pinv->strs[i] = off + 1;
+    pinv->num_strs ++;
+    pinv->sz_pool += len + 1;
+    return off;
+}
+
+/**
+ * \brief add a row to the hash index of a column
+ * \param pinv: the pointer to the inventory
+ * \param column: the column
+ * \param row: the index of the row
+ * \return 0 on success, <0 on failed
+ */
+static int
+brdinv_index_row (board_inv_t * pinv, int column, size_t row)
+{
+    size_t i;
+    uint32_t off = pinv->cols[column][row];
+
+    if ((BRDINV_NONE == off) || (0 == pinv->pool[off])) {
+        return 0;
+    }
+    if (brdinv_reserve (pinv, &(pinv->idx[column]), &(pinv->slots_idx[column]), column, pinv->num_idx[column] + 1) < 0) {
+        return -1;
+    }
+    i = brdinv_slot (pinv, pinv->idx[column], pinv->slots_idx[column], column, pinv->pool + off);
+    if (pinv->idx[column][i]) {
+        // the first row is used
+        fprintf(stderr, "skip duplicated key of column %d at row %" PRIuSZ ": '%s'\n", column, row, pinv->pool + off);
+        return 0;
+    }
+    pinv->idx[column][i] = row + 1;
+    pinv->num_idx[column] ++;
+    return 0;
+}
+
+/**
+ * \brief grow the columns of the inventory
+ * \param pinv: the pointer to the inventory
+ * \param num: the number of the rows to be stored
+ * \return 0 on success, <0 on failed
+ */
+static int
+brdinv_reserve_rows (board_inv_t * pinv, size_t num)
+{
+    int i;
+    void * col_new;
+
+    if (num < 32) {
+        num = 32;
+    }
+    if (num <= pinv->sz_max) {
+        return 0;
+    }
+    for (i = 0; i < BRDINV_COLUMNS; i ++) {
+        col_new = realloc(pinv->cols[i], sizeof(uint32_t) * num);
+        if (NULL == col_new) {
+            fprintf(stderr, "error in double memory\n");
+            return -1;
+        }
+        pinv->cols[i] = (uint32_t *)col_new;
+    }
+    pinv->sz_max = num;
+    return 0;
+}
+
+/**
+ * \brief parse a row to the columns
+ * \param pinv: the pointer to the inventory
+ * \param line: the record line, the columns are separated by '\t'
+ * \return 0 on success, <0 on failed
+ */
+static int
+brdinv_append (board_inv_t * pinv, const char * line)
+{
+    int i;
+    const char * pstart;
+    const char * pend;
+
+    if ((pinv->num >= pinv->sz_max) && (brdinv_reserve_rows (pinv, pinv->sz_max * 2) < 0)) {
+        return -1;
+    }
+    assert (pinv->num < pinv->sz_max);
+
+    for (i = 0; i < BRDINV_COLUMNS; i ++) {
+        if (NULL == line) {
+            pinv->cols[i][pinv->num] = BRDINV_NONE;
+            continue;
+        }
+        for (pend = line; *pend && (! MY_DATA_SPLIT(*pend)); pend ++);
+        for (pstart = line; (pstart < pend) && MY_ISSPACE(*pstart); pstart ++);
+        line = (MY_DATA_SPLIT(*pend) ? (pend + 1) : NULL);
+        for (; (pend > pstart) && MY_ISSPACE(pend[-1]); pend --);
+        pinv->cols[i][pinv->num] = brdinv_intern (pinv, pstart, pend - pstart);
+        if (BRDINV_NONE == pinv->cols[i][pinv->num]) {
+            return -1;
+        }
+    }
+    pinv->num ++;
+    for (i = 0; i < BRDINV_COLUMNS; i ++) {
+        if ((NULL != pinv->idx[i]) && (brdinv_index_row (pinv, i, pinv->num - 1) < 0)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * \brief get the inventory of the list, parse the rows appended since the last call
+ * \param plst: the pointer to a board list
+ * \return the pointer to the inventory, NULL on failed
+ */
+static board_inv_t *
+brdlst_inventory (board_list_t * plst)
+{
+    assert (NULL != plst);
+    if (NULL == plst->inv) {
+        plst->inv = (board_inv_t *)calloc(1, sizeof(board_inv_t));
+        if (NULL == plst->inv) {
+            fprintf(stderr, "error in malloc the inventory\n");
+            return NULL;
+        }
+    }
+    if (brdinv_reserve_rows (plst->inv, plst->sz_cur) < 0) {
+        return NULL;
+    }
+    for (; plst->inv->num < plst->sz_cur; ) {
+        if (brdinv_append (plst->inv, plst->list[plst->inv->num]) < 0) {
+            return NULL;
+        }
+    }
+    return plst->inv;
+}
+
+/**
+ * \brief get a column of a row
+ * \param plst: the pointer to a board list
+ * \param row: the index of the row
+ * \param column: the index of column, start from 0
+ * \return the string of the column, NULL if not exist
+ */
+const char *
+brdlst_column (board_list_t * plst, size_t row, int column)
+{
+    board_inv_t * pinv;
+    if ((column < 0) || (column >= BRDINV_COLUMNS)) {
+        return NULL;
+    }
+    pinv = brdlst_inventory (plst);
+    if ((NULL == pinv) || (row >= pinv->num)) {
+        return NULL;
+    }
+    if (BRDINV_NONE == pinv->cols[column][row]) {
+        return NULL;
+    }
+    return pinv->pool + pinv->cols[column][row];
+}
+
+/**
+ * \brief copy a column of a row to the buffer
+ * \param plst: the pointer to a board list
+ * \param row: the index of the row
+ * \param column: the index of column, start from 0
+ * \param ret_buf: the buffer to store the result
+ * \param sz_buf: the size of the buffer
+ * \return 0 on success, <0 on failed
+ */
+int
+brdlst_get_column (board_list_t * plst, size_t row, int column, char * ret_buf, size_t sz_buf)
+{
+    size_t len;
+    const char * str = brdlst_column (plst, row, column);
+    if ((NULL == str) || (NULL == ret_buf)) {
+        return -1;
+    }
+    len = strlen(str);
+    if (len >= sz_buf) {
+        return -1;
+    }
+    memmove (ret_buf, str, len + 1);
+    return 0;
+}
+
+/**
+ * \brief find the first row by the value of a column
+ * \param plst: the pointer to a board list
+ * \param column: the index of column, BRDINV_COL_NAME, BRDINV_COL_MAC, BRDINV_COL_IP etc.
+ * \param key: the value of the column
+ * \return the index of the row, <0 if not found
+ *
+ * The column is indexed by the first call, the rows need not be sorted.
+ */
+ssize_t
+brdlst_find (board_list_t * plst, int column, const char * key)
+{
+    size_t i;
+    board_inv_t * pinv;
+
+    if ((NULL == key) || (0 == key[0]) || (column < 0) || (column >= BRDINV_COLUMNS)) {
+        return -1;
+    }
+    pinv = brdlst_inventory (plst);
+    if ((NULL == pinv) || (0 == pinv->num)) {
+        return -1;
+    }
+    if (NULL == pinv->idx[column]) {
+        if (brdinv_reserve (pinv, &(pinv->idx[column]), &(pinv->slots_idx[column]), column, pinv->num) < 0) {
+            return -1;
+        }
+        for (i = 0; i < pinv->num; i ++) {
+            if (brdinv_index_row (pinv, column, i) < 0) {
+                return -1;
+            }
+        }
+    }
+    i = brdinv_slot (pinv, pinv->idx[column], pinv->slots_idx[column], column, key);
+    if (0 == pinv->idx[column][i]) {
+        return -1;
+    }
+    return pinv->idx[column][i] - 1;
+}
+
+#if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
+#include <ciut.h>
+
+TEST_CASE( .name="board-inventory", .description="test the inventory of a board list.", .skip=0 ) {
+    char buf[100] = "";
+
+    SECTION("test columns and lookups") {
+        BRDLST_DECLARE_INIT(lst_test);
+
+        REQUIRE(-1 == brdlst_find(&lst_test, BRDINV_COL_NAME, "CCT_C01-01"));
+        REQUIRE(NULL == brdlst_column(&lst_test, 0, BRDINV_COL_NAME));
+
+        // not sorted, with a duplicated name and the short rows
+        brdlst_append(&lst_test, "CCT_C01-02	112233498	717	99887766558D6DB8	334455667518	192.168.1.89	fe80:cb:0:b062::5c36	fe80:cb:0:b088::3ee4	");
+        brdlst_append(&lst_test, " CCT_C01-01 	112233479	707	99887766558D6DA5	33445566752C	192.168.1.19");
+        brdlst_append(&lst_test, "Beside CNT	112233359	1029	998877665506F505	3344556679CF	192.168.1.153	fe80:cb:0:b062::xx	fe80:cb:0:b088::xx");
+        brdlst_append(&lst_test, "CCT_C01-01	112233480	718	99887766558D6DA6	33445566752B	192.168.1.28");
+        brdlst_append(&lst_test, "CCT_C01-03");
+
+        REQUIRE(1 == brdlst_find(&lst_test, BRDINV_COL_NAME, "CCT_C01-01"));
+        REQUIRE(0 == brdlst_find(&lst_test, BRDINV_COL_NAME, "CCT_C01-02"));
+        REQUIRE(2 == brdlst_find(&lst_test, BRDINV_COL_NAME, "Beside CNT"));
+        REQUIRE(4 == brdlst_find(&lst_test, BRDINV_COL_NAME, "CCT_C01-03"));
+        REQUIRE(-1 == brdlst_find(&lst_test, BRDINV_COL_NAME, "CCT_C01-04"));
+        REQUIRE(-1 == brdlst_find(&lst_test, BRDINV_COL_NAME, ""));
+        REQUIRE(-1 == brdlst_find(&lst_test, BRDINV_COL_NAME, NULL));
+        REQUIRE(-1 == brdlst_find(&lst_test, BRDINV_COLUMNS, "CCT_C01-01"));
+
+        REQUIRE(3 == brdlst_find(&lst_test, BRDINV_COL_MAC, "33445566752B"));
+        REQUIRE(2 == brdlst_find(&lst_test, BRDINV_COL_IP, "192.168.1.153"));
+        REQUIRE(-1 == brdlst_find(&lst_test, BRDINV_COL_IP, "192.168.1.15"));
+
+        REQUIRE(0 == brdlst_get_column(&lst_test, 1, BRDINV_COL_NAME, buf, sizeof(buf)));
+        REQUIRE(0 == strcmp("CCT_C01-01", buf));
+        REQUIRE(0 == brdlst_get_column(&lst_test, 0, BRDINV_COL_IPV6ALT, buf, sizeof(buf)));
+        REQUIRE(0 == strcmp("fe80:cb:0:b088::3ee4", buf));
+        REQUIRE(-1 == brdlst_get_column(&lst_test, 1, BRDINV_COL_IPV6, buf, sizeof(buf)));
+        REQUIRE(-1 == brdlst_get_column(&lst_test, 4, BRDINV_COL_SERIAL, buf, sizeof(buf)));
+        REQUIRE(-1 == brdlst_get_column(&lst_test, 5, BRDINV_COL_NAME, buf, sizeof(buf)));
+        REQUIRE(-1 == brdlst_get_column(&lst_test, 1, BRDINV_COL_NAME, buf, 10));
+        REQUIRE(0 == brdlst_get_column(&lst_test, 1, BRDINV_COL_NAME, buf, 11));
+
+        // the strings are interned
+        REQUIRE(brdlst_column(&lst_test, 1, BRDINV_COL_NAME) == brdlst_column(&lst_test, 3, BRDINV_COL_NAME));
+
+        // the rows appended later are indexed by the next lookup
+        brdlst_append(&lst_test, "CCT_C01-04	112233476	720	99887766558D6DA2	33445566752F	192.168.1.11");
+        REQUIRE(5 == brdlst_find(&lst_test, BRDINV_COL_NAME, "CCT_C01-04"));
+        REQUIRE(5 == brdlst_find(&lst_test, BRDINV_COL_IP, "192.168.1.11"));
+
+        brdlst_clean(&lst_test);
+        REQUIRE(NULL == lst_test.inv);
+        REQUIRE(-1 == brdlst_find(&lst_test, BRDINV_COL_NAME, "CCT_C01-04"));
+        brdlst_clean(&lst_test);
+    }
+    SECTION("test large inventory") {
+        int i;
+        BRDLST_DECLARE_INIT(lst_test);
+
+        for (i = 5000; i > 0; i --) {
+            snprintf(buf, sizeof(buf), "CCT_C%04d-%02d\t%d\t%d\t0\t%012X\t10.%d.%d.%d", i / 8, i % 8, i, i, i, (i >> 16) & 0xFF, (i >> 8) & 0xFF, i & 0xFF);
+            REQUIRE(0 == brdlst_append(&lst_test, buf));
+        }
+        for (i = 1; i <= 5000; i ++) {
+            snprintf(buf, sizeof(buf), "CCT_C%04d-%02d", i / 8, i % 8);
+            REQUIRE(5000 - i == brdlst_find(&lst_test, BRDINV_COL_NAME, buf));
+            snprintf(buf, sizeof(buf), "%012X", i);
+            REQUIRE(5000 - i == brdlst_find(&lst_test, BRDINV_COL_MAC, buf));
+            snprintf(buf, sizeof(buf), "10.%d.%d.%d", (i >> 16) & 0xFF, (i >> 8) & 0xFF, i & 0xFF);
+            REQUIRE(5000 - i == brdlst_find(&lst_test, BRDINV_COL_IP, buf));
+        }
+        // the column of NGC MAC has only one string
+        REQUIRE(brdlst_column(&lst_test, 0, BRDINV_COL_NGCMAC) == brdlst_column(&lst_test, 4999, BRDINV_COL_NGCMAC));
+        brdlst_clean(&lst_test);
+    }
+}
+#endif /* CIUT_ENABLED */
+
+BRDLST_DECLARE_INIT(g_lst_brd);
+BRDLST_DECLARE_INIT(g_lst_edio24);
+
+/**
+ * \brief strip a line of a list, the empty lines and the comment lines are skipped
+ * \param pline: the start of the line, return the start of the line stripped
+ * \param sz: the size of the line, not including the terminator
+ * \return the size of the line stripped, 0 if the line is skipped
+ */
+static size_t
+brdlst_line_normalize (const char ** pline, size_t sz)
+{
+    const char * p = *pline;
+    const char * q = p + sz;
+
+    // strip the string
+    for (; (p < q) && MY_ISSPACE(*p); p ++);
+    for (; (q > p) && MY_ISSPACE(q[-1]); q --);
+    // if the line is comment line
+    if ((p < q) && ('#' == *p)) {
+        fprintf(stderr, "skip line: '%.*s'\n", (int)(q - p), p);
+        return 0;
+    }
+    *pline = p;
+    return q - p;
+}
+
+/**
+ * \brief process a line of a file
+ * \param pos: the position of the line in the file
+ * \param buf: the data of the line
+ * \param size: the size of the buffer
+ * \param userdata: the argument passed by user
+ * \return 0 on success, <0 on failed
+ */
+int
+cb_process_brdlst_line (off_t pos, char * buf, size_t size, void *userdata)
+{
+    board_list_t *plst = (board_list_t *)userdata;
+    const char * p = buf;
+    size_t sz;
+    assert (NULL != userdata);
+
+    sz = brdlst_line_normalize (&p, strnlen(buf, size));
+    if (sz < 1) {
+        return 0;
+    }
+    memmove (buf, p, sz);
+    buf[sz] = 0;
+    // add to the list
+    return brdlst_append(plst, buf);
+}
+
+/**
+ * \brief load the rows of a file to the list, replace the old rows
+ * \param plst: the pointer to a structure
+ * \param fn: the file name, NULL for stdin
+ * \return 0 on success, <0 on failed
+ *
+ * The file is mapped and split by memchr(), the list and the stripped rows
+ * are stored in one arena, which is freed by brdlst_clean().
+ */
+int
+brdlst_load(board_list_t * plst, const char * fn)
+{
+    const char * data;
+    const char * p;
+    const char * pend;
+    const char * pnl;
+    const char * q;
+    size_t sz_line;
+    size_t sz_data;
+    size_t num;
+    char * arena;
+    char * text;
+    char ** list;
+
+    assert (NULL != plst);
     brdlst_clean(plst);
     brdlst_init(plst);
-    read_file_lines(fn, (void *)(plst), cb_process_brdlst_line);
+
+    data = mmap_file_read(fn, &sz_data);
+    if (NULL == data) {
+        // stdin, an empty file or not a regular file
+        return read_file_lines(fn, (void *)(plst), cb_process_brdlst_line);
+    }
+    pend = data + sz_data;
+    for (num = 1, p = data; NULL != (p = (const char *)memchr(p, '\n', pend - p)); p ++, num ++);
+
+    plst->sz_arena = sizeof(char *) * num + sz_data + num;
+    arena = (char *)malloc(plst->sz_arena);
+    if (NULL == arena) {
+        fprintf(stderr, "error in malloc the arena of '%s'\n", fn);
+        mmap_file_close(data, sz_data);
+        plst->sz_arena = 0;
+        return -1;
+    }
+    list = (char **)arena;
+    text = arena + sizeof(char *) * num;
+    plst->arena = arena;
+    plst->list = list;
+    plst->sz_max = num;
+
+    for (p = data; p < pend; p = pnl) {
+        pnl = (const char *)memchr(p, '\n', pend - p);
+        pnl = (NULL == pnl ? pend : pnl + 1);
+        q = p;
+        sz_line = brdlst_line_normalize (&q, pnl - p);
+        if (sz_line < 1) {
+            continue;
+        }
+        assert (plst->sz_cur < num);
+        memmove (text, q, sz_line);
+        text[sz_line] = 0;
+        list[plst->sz_cur ++] = text;
+        text += sz_line + 1;
+    }
+    assert (text <= arena + plst->sz_arena);
+    mmap_file_close(data, sz_data);
+    if (0 == plst->sz_cur) {
+        brdlst_clean(plst);
+    }
+    return 0;
+}
+
+/**
+ * \brief read file and store the data in a global variable for EDIO24
+ * \param fn: the file name of the edio24 config
+ */
+static void
+read_file_edio24(const char * fn)
+{
+    brdlst_load(&g_lst_edio24, fn);
 }
 
 /**
@@ -715,10 +1798,7 @@ read_file_edio24(const char * fn)
 static void
 read_file_board(const char * fn)
 {
-    board_list_t *plst = &g_lst_brd;
-    brdlst_clean(plst);
-    brdlst_init(plst);
-    read_file_lines(fn, (void *)(plst), cb_process_brdlst_line);
+    brdlst_load(&g_lst_brd, fn);
 }
 
 #if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
@@ -816,6 +1896,64 @@ TEST_CASE( .name="read-conf", .description="test read_file_xxx.", .skip=0 ) {
         read_file_board(FN_CONF_BOARDS);
         REQUIRE(6 == brdlst_length(plst));
     }
+
+    SECTION("test brdlst_load") {
+        FILE *fp;
+        BRDLST_DECLARE_INIT(lst_test);
+
+        fp = fopen(FN_CONF_BOARDS, "w+");
+        REQUIRE(NULL != fp);
+        fprintf(fp, "#Locataion	Serial_Nbr\r\n\n   \n  CCT_C01-02	112233498	717	99887766558D6DB8	334455667518	192.168.1.89 \r\n");
+        fprintf(fp, "CCT_C01-01	112233479	707	99887766558D6DA5	33445566752C	192.168.1.19");
+        fclose(fp);
+
+        REQUIRE(0 == brdlst_load(&lst_test, FN_CONF_BOARDS));
+        REQUIRE(2 == brdlst_length(&lst_test));
+        REQUIRE(NULL != lst_test.arena);
+        REQUIRE(0 == strcmp("CCT_C01-02	112233498	717	99887766558D6DB8	334455667518	192.168.1.89", brdlst_get(&lst_test, 0)));
+        REQUIRE(0 == strcmp("CCT_C01-01	112233479	707	99887766558D6DA5	33445566752C	192.168.1.19", brdlst_get(&lst_test, 1)));
+        REQUIRE(1 == brdlst_find(&lst_test, BRDINV_COL_NAME, "CCT_C01-01"));
+        {
+            // the lines read one by one (stdin) are normalized in the same way
+            BRDLST_DECLARE_INIT(lst_line);
+            const char * lines[] = { "#Locataion	Serial_Nbr\r\n", "\n", "   \n", "  CCT_C01-02	112233498	717	99887766558D6DB8	334455667518	192.168.1.89 \r\n", "CCT_C01-01	112233479	707	99887766558D6DA5	33445566752C	192.168.1.19" };
+            char line[200];
+            size_t i;
+            for (i = 0; i < NUM_ARRAY(lines); i ++) {
+                snprintf(line, sizeof(line), "%s", lines[i]);
+                REQUIRE(0 == cb_process_brdlst_line(0, line, sizeof(line), &lst_line));
+            }
+            REQUIRE(brdlst_length(&lst_test) == brdlst_length(&lst_line));
+            for (i = 0; i < brdlst_length(&lst_test); i ++) {
+                REQUIRE(0 == strcmp(brdlst_get(&lst_test, i), brdlst_get(&lst_line, i)));
+            }
+            brdlst_clean(&lst_line);
+        }
+
+        // the list is moved out of the arena
+        while (BRDLST_IN_ARENA(&lst_test, lst_test.list)) {
+            REQUIRE(0 == brdlst_append(&lst_test, "CCT_C09-09"));
+        }
+        REQUIRE(6 == brdlst_length(&lst_test));
+        REQUIRE(BRDLST_IN_ARENA(&lst_test, brdlst_get(&lst_test, 0)));
+        REQUIRE(0 == strcmp("CCT_C01-01	112233479	707	99887766558D6DA5	33445566752C	192.168.1.19", brdlst_get(&lst_test, 1)));
+        REQUIRE(2 == brdlst_find(&lst_test, BRDINV_COL_NAME, "CCT_C09-09"));
+
+        // replaced by the next load
+        REQUIRE(0 == create_test_file_boardsconf(FN_CONF_BOARDS));
+        REQUIRE(0 == brdlst_load(&lst_test, FN_CONF_BOARDS));
+        REQUIRE(6 == brdlst_length(&lst_test));
+        REQUIRE(-1 == brdlst_find(&lst_test, BRDINV_COL_NAME, "CCT_C09-09"));
+
+        fp = fopen(FN_CONF_BOARDS, "w+");
+        REQUIRE(NULL != fp);
+        fclose(fp);
+        REQUIRE(0 == brdlst_load(&lst_test, FN_CONF_BOARDS));
+        REQUIRE(0 == brdlst_length(&lst_test));
+        REQUIRE(NULL == lst_test.arena);
+        REQUIRE(0 > brdlst_load(&lst_test, "tmp-noexist.txt"));
+        brdlst_clean(&lst_test);
+    }
 }
 
 #endif /* CIUT_ENABLED */
@@ -831,15 +1969,10 @@ TEST_CASE( .name="read-conf", .description="test read_file_xxx.", .skip=0 ) {
 int
 get_ip_of_edio24(int id, char * ret_buf, size_t sz_buf)
 {
-    char * line;
-
-    line = brdlst_get(&g_lst_edio24, id);
-    if (NULL == line) {
+    if (id < 0) {
         return -1;
     }
-    // find the first column
-    assert (NULL != line);
-    return cstr_line_get_column (line, 0, ret_buf, sz_buf);
+    return brdlst_get_column (&g_lst_edio24, id, 0, ret_buf, sz_buf);
 }
 
 /**
@@ -852,14 +1985,10 @@ get_ip_of_edio24(int id, char * ret_buf, size_t sz_buf)
 int
 get_name_of_edio24(int id, char * ret_buf, size_t sz_buf)
 {
-    char * line;
-
-    line = brdlst_get(&g_lst_edio24, id);
-    if (NULL == line) {
+    if (id < 0) {
         return -1;
     }
-    assert (NULL != line);
-    return cstr_line_get_column (line, 2, ret_buf, sz_buf);
+    return brdlst_get_column (&g_lst_edio24, id, 2, ret_buf, sz_buf);
 }
 
 /**
@@ -872,33 +2001,10 @@ get_name_of_edio24(int id, char * ret_buf, size_t sz_buf)
 int
 get_mac_of_edio24(int id, char * ret_buf, size_t sz_buf)
 {
-    char * line;
-
-    line = brdlst_get(&g_lst_edio24, id);
-    if (NULL == line) {
+    if (id < 0) {
         return -1;
     }
-    assert (NULL != line);
-    return cstr_line_get_column (line, 1, ret_buf, sz_buf);
-}
-
-/*"data_list[idx] - *data_pin"*/
-int
-pf_bsearch_cb_comp_brdlst_board_name(void *userdata, size_t idx, void * data_pin)
-{
-    int ret;
-    char * line = NULL;
-    char buf[100] = "";
-    board_list_t *plst = (board_list_t *)userdata;
-    assert (NULL != plst);
-    assert (NULL != data_pin);
-
-    assert ((0 <= idx) && (idx < plst->sz_cur));
-    line = brdlst_get(plst, idx);
-    assert (NULL != line);
-    ret = cstr_line_get_column (line, 0, buf, sizeof(buf));
-    assert (ret >= 0);
-    return strcmp(buf, (const char *)data_pin);
+    return brdlst_get_column (&g_lst_edio24, id, 1, ret_buf, sz_buf);
 }
 
 /**
@@ -911,22 +2017,11 @@ pf_bsearch_cb_comp_brdlst_board_name(void *userdata, size_t idx, void * data_pin
 int
 get_ip_of_board(const char *name_id, char * ret_buf, size_t sz_buf)
 {
-    int ret;
-    char * line = NULL;
-    size_t idx = 0;
-    board_list_t *plst = &g_lst_brd;
-
-    ret = pf_bsearch_r((void *)plst, brdlst_length(plst), pf_bsearch_cb_comp_brdlst_board_name, (void *)name_id, &idx);
-    if (ret < 0) {
-        return -1;
-    }
-    line = brdlst_get(plst, idx);
-    if (NULL == line) {
+    ssize_t row = brdlst_find(&g_lst_brd, BRDINV_COL_NAME, name_id);
+    if (row < 0) {
         return -1;
     }
-    // find the first column
-    assert (NULL != line);
-    return cstr_line_get_column (line, 5, ret_buf, sz_buf);
+    return brdlst_get_column (&g_lst_brd, row, BRDINV_COL_IP, ret_buf, sz_buf);
 }
 
 /**
@@ -939,22 +2034,11 @@ get_ip_of_board(const char *name_id, char * ret_buf, size_t sz_buf)
 int
 get_mac_of_board(const char *name_id, char * ret_buf, size_t sz_buf)
 {
-    int ret;
-    char * line = NULL;
-    size_t idx = 0;
-    board_list_t *plst = &g_lst_brd;
-
-    ret = pf_bsearch_r((void *)plst, brdlst_length(plst), pf_bsearch_cb_comp_brdlst_board_name, (void *)name_id, &idx);
-    if (ret < 0) {
-        return -1;
-    }
-    line = brdlst_get(plst, idx);
-    if (NULL == line) {
+    ssize_t row = brdlst_find(&g_lst_brd, BRDINV_COL_NAME, name_id);
+    if (row < 0) {
         return -1;
     }
-    // find the first column
-    assert (NULL != line);
-    return cstr_line_get_column (line, 4, ret_buf, sz_buf);
+    return brdlst_get_column (&g_lst_brd, row, BRDINV_COL_MAC, ret_buf, sz_buf);
 }
 
 /**
@@ -967,22 +2051,11 @@ get_mac_of_board(const char *name_id, char * ret_buf, size_t sz_buf)
 int
 get_ngcmac_of_board(const char *name_id, char * ret_buf, size_t sz_buf)
 {
-    int ret;
-    char * line = NULL;
-    size_t idx = 0;
-    board_list_t *plst = &g_lst_brd;
-
-    ret = pf_bsearch_r((void *)plst, brdlst_length(plst), pf_bsearch_cb_comp_brdlst_board_name, (void *)name_id, &idx);
-    if (ret < 0) {
+    ssize_t row = brdlst_find(&g_lst_brd, BRDINV_COL_NAME, name_id);
+    if (row < 0) {
         return -1;
     }
-    line = brdlst_get(plst, idx);
-    if (NULL == line) {
-        return -1;
-    }
-    // find the first column
-    assert (NULL != line);
-    return cstr_line_get_column (line, 3, ret_buf, sz_buf);
+    return brdlst_get_column (&g_lst_brd, row, BRDINV_COL_NGCMAC, ret_buf, sz_buf);
 }
 
 #if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
@@ -1124,6 +2197,444 @@ TEST_CASE( .description="test get_ip_of_board.", .skip=0 ) {
 }
 #endif /* CIUT_ENABLED */
 
+/*****************************************************************************/
+// the topology: cluster -> device -> pin -> board
+//
+// The boards are sorted by the cluster and the position, the boards of a cluster are in a range,
+// and the boards of a position are in a bitset, so a selection is a few operations on the words.
+
+#define GENCCT_TOPO_CLUSTERS  16 /**< the min number of the clusters of the default topology, without the root cluster 0 */
+#define GENCCT_TOPO_POSITIONS 9  /**< the positions of a cluster of the default topology, 0 is the root */
+#define GENCCT_TOPO_POWER_PINS 8 /**< the power pins of the boards are the pins 0-7 of the port 0 */
+
+/** a board in the topology */
+typedef struct _gencct_board_t {
+    uint32_t cluster;
+    uint32_t position;  /**< the position in the cluster, the 'p=' of the board selector */
+    int device;         /**< the index of the EDIO24 in the list, -1 if none */
+    int pin;            /**< the power pin of the board on the device, -1 if none */
+    const char * name;  /**< the name in the board list */
+} gencct_board_t;
+
+/** the topology of the boards */
+typedef struct _gencct_topo_t {
+    gencct_board_t * boards;
+    size_t num;
+    size_t sz_max;
+    size_t num_clusters;      /**< the max cluster + 1 */
+    size_t num_positions;     /**< the max position + 1 */
+    size_t num_devices;       /**< the max device + 1 */
+    size_t * cluster_start;   /**< the first board of each cluster, num_clusters + 1 items */
+    gencct_bits_t * pos_boards; /**< the boards at each position */
+    uint32_t * names_idx;     /**< the hash table of the names, the index of the board + 1 */
+    size_t num_names_idx;     /**< the size of the hash table, a power of 2 */
+    char * names;             /**< the names of the default topology */
+    board_list_t lst;         /**< the rows of the topology file */
+    ssize_t num_default;      /**< the number of the EDIO24s of the default topology, -1 if loaded from a file */
+} gencct_topo_t;
+
+static gencct_topo_t g_topo = { 0 };
+
+/**
+ * \brief init the topology
+ * \param ptopo: the topology
+ */
+void
+gencct_topo_init (gencct_topo_t * ptopo)
+{
+    assert (NULL != ptopo);
+    memset(ptopo, 0, sizeof(*ptopo));
+    ptopo->num_default = -1;
+}
+
+/**
+ * \brief clean the topology
+ * \param ptopo: the topology
+ */
+void
+gencct_topo_clean (gencct_topo_t * ptopo)
+{
+    size_t i;
+    assert (NULL != ptopo);
+    if (NULL != ptopo->pos_boards) {
+        for (i = 0; i < ptopo->num_positions; i ++) {
+            gencct_bits_clean(&(ptopo->pos_boards[i]));
+        }
+    }
+    free (ptopo->pos_boards);
+    free (ptopo->cluster_start);
+    free (ptopo->names_idx);
+    free (ptopo->boards);
+    free (ptopo->names);
+    brdlst_clean(&(ptopo->lst));
+    gencct_topo_init(ptopo);
+}
+
+/**
+ * \brief add a board to the topology, gencct_topo_build() is required before the selection
+ * \param ptopo: the topology
+ * \param cluster: the cluster
+ * \param position: the position in the cluster
+ * \param device: the index of the EDIO24, -1 if none
+ * \param pin: the power pin on the device, -1 if none
+ * \param name: the name of the board, it is not copied
+ * \return 0 on success, <0 on error
+ */
+int
+gencct_topo_add (gencct_topo_t * ptopo, uint32_t cluster, uint32_t position, int device, int pin, const char * name)
+{
+    gencct_board_t * pbrd;
+
+    assert (NULL != ptopo);
+    if (ptopo->num >= ptopo->sz_max) {
+        size_t sz_new = (ptopo->sz_max > 0 ? ptopo->sz_max * 2 : 256);
+        void * p = realloc(ptopo->boards, sizeof(gencct_board_t) * sz_new);
+        if (NULL == p) {
+            fprintf(stderr, "error in double memory\n");
+            return -1;
+        }
+        ptopo->boards = (gencct_board_t *)p;
+        ptopo->sz_max = sz_new;
+    }
+    pbrd = &(ptopo->boards[ptopo->num ++]);
+    pbrd->cluster = cluster;
+    pbrd->position = position;
+    pbrd->device = device;
+    pbrd->pin = pin;
+    pbrd->name = name;
+    return 0;
+}
+
+static int
+pf_qsort_cb_comp_board (const void * a, const void * b)
+{
+    const gencct_board_t * pa = (const gencct_board_t *)a;
+    const gencct_board_t * pb = (const gencct_board_t *)b;
+    if (pa->cluster != pb->cluster) {
+        return (pa->cluster < pb->cluster ? -1 : 1);
+    }
+    if (pa->position != pb->position) {
+        return (pa->position < pb->position ? -1 : 1);
+    }
+    return 0;
+}
+
+/**
+ * \brief find the slot of a name in the hash table of the names
+ * \param ptopo: the topology
+ * \param name: the name
+ * \return the slot of the name, or the empty slot to store it
+ */
+static size_t
+gencct_topo_slot (const gencct_topo_t * ptopo, const char * name)
+{
+    size_t i;
+    size_t mask = ptopo->num_names_idx - 1;
+    for (i = brdinv_hash(name) & mask; ptopo->names_idx[i]; i = (i + 1) & mask) {
+        if (0 == strcmp(ptopo->boards[ptopo->names_idx[i] - 1].name, name)) {
+            break;
+        }
+    }
+    return i;
+}
+
+/**
+ * \brief sort the boards and build the indexes of the topology
+ * \param ptopo: the topology
+ * \return 0 on success, <0 on error
+ */
+int
+gencct_topo_build (gencct_topo_t * ptopo)
+{
+    size_t i;
+    size_t c;
+
+    assert (NULL != ptopo);
+    if (NULL != ptopo->pos_boards) {
+        for (i = 0; i < ptopo->num_positions; i ++) {
+            gencct_bits_clean(&(ptopo->pos_boards[i]));
+        }
+    }
+    free (ptopo->pos_boards);
+    free (ptopo->cluster_start);
+    free (ptopo->names_idx);
+    ptopo->pos_boards = NULL;
+    ptopo->cluster_start = NULL;
+    ptopo->names_idx = NULL;
+
+    qsort(ptopo->boards, ptopo->num, sizeof(gencct_board_t), pf_qsort_cb_comp_board);
+    ptopo->num_clusters = 0;
+    ptopo->num_positions = 0;
+    ptopo->num_devices = 0;
+    for (i = 0; i < ptopo->num; i ++) {
+        gencct_board_t * pbrd = &(ptopo->boards[i]);
+        if ((i > 0) && (0 == pf_qsort_cb_comp_board(pbrd - 1, pbrd))) {
+            fprintf(stderr, "Warning: the boards '%s' and '%s' are at the same cluster %u position %u\n", pbrd[-1].name, pbrd->name, pbrd->cluster, pbrd->position);
+        }
+        if (ptopo->num_clusters <= pbrd->cluster) {
+            ptopo->num_clusters = pbrd->cluster + 1;
+        }
+        if (ptopo->num_positions <= pbrd->position) {
+            ptopo->num_positions = pbrd->position + 1;
+        }
+        if ((pbrd->device >= 0) && (ptopo->num_devices <= pbrd->device)) {
+            ptopo->num_devices = pbrd->device + 1;
+        }
+    }
+
+    ptopo->cluster_start = (size_t *)malloc(sizeof(size_t) * (ptopo->num_clusters + 1));
+    ptopo->pos_boards = (gencct_bits_t *)calloc(ptopo->num_positions + 1, sizeof(gencct_bits_t));
+    if ((NULL == ptopo->cluster_start) || (NULL == ptopo->pos_boards)) {
+        fprintf(stderr, "error in malloc the index of the topology\n");
+        return -1;
+    }
+    for (c = 0, i = 0; c <= ptopo->num_clusters; c ++) {
+        for (; (i < ptopo->num) && (ptopo->boards[i].cluster < c); i ++);
+        ptopo->cluster_start[c] = i;
+    }
+    for (i = 0; i < ptopo->num_positions; i ++) {
+        if (gencct_bits_init(&(ptopo->pos_boards[i]), ptopo->num) < 0) {
+            return -1;
+        }
+    }
+    for (i = 0; i < ptopo->num; i ++) {
+        gencct_bits_set(&(ptopo->pos_boards[ptopo->boards[i].position]), i);
+    }
+
+    // the names, the first board of a name is found
+    for (ptopo->num_names_idx = 16; ptopo->num_names_idx < ptopo->num * 2; ptopo->num_names_idx *= 2);
+    ptopo->names_idx = (uint32_t *)calloc(ptopo->num_names_idx, sizeof(uint32_t));
+    if (NULL == ptopo->names_idx) {
+        fprintf(stderr, "error in malloc the index of the topology\n");
+        return -1;
+    }
+    for (i = 0; i < ptopo->num; i ++) {
+        size_t k = gencct_topo_slot(ptopo, ptopo->boards[i].name);
+        if (0 == ptopo->names_idx[k]) {
+            ptopo->names_idx[k] = i + 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * \brief find a board by the name
+ * \param ptopo: the topology
+ * \param name: the name of the board
+ * \return the index of the board, <0 if not found
+ */
+ssize_t
+gencct_topo_find (const gencct_topo_t * ptopo, const char * name)
+{
+    size_t k;
+    assert (NULL != ptopo);
+    if (NULL == ptopo->names_idx) {
+        return -1;
+    }
+    k = gencct_topo_slot(ptopo, name);
+    return (ssize_t)(ptopo->names_idx[k]) - 1;
+}
+
+/**
+ * \brief the default topology: the cluster i is at the EDIO24 i-1, and the board at position j is powered by the pin j-1
+ * \param ptopo: the topology
+ * \param num_edio24: the number of the EDIO24s
+ * \return 0 on success, <0 on error
+ *
+ * The boards are named as 'CCT_C01-02', the cluster 0 and the position 0 are the root.
+ */
+int
+gencct_topo_default (gencct_topo_t * ptopo, size_t num_edio24)
+{
+    size_t num_clusters = (num_edio24 > GENCCT_TOPO_CLUSTERS ? num_edio24 : GENCCT_TOPO_CLUSTERS) + 1;
+    size_t i;
+    size_t j;
+    char * name;
+#define GENCCT_TOPO_SZ_NAME 20
+
+    gencct_topo_clean(ptopo);
+    ptopo->names = (char *)malloc(num_clusters * GENCCT_TOPO_POSITIONS * GENCCT_TOPO_SZ_NAME);
+    if (NULL == ptopo->names) {
+        return -1;
+    }
+    name = ptopo->names;
+    for (i = 0; i < num_clusters; i ++) {
+        for (j = 0; j < GENCCT_TOPO_POSITIONS; j ++) {
+            snprintf(name, GENCCT_TOPO_SZ_NAME, "CCT_C%02d-%02d", (int)i, (int)j);
+            if (gencct_topo_add(ptopo, i, j, (i > 0 ? (int)i - 1 : -1), (j > 0 ? (int)j - 1 : -1), name) < 0) {
+                return -1;
+            }
+            name += GENCCT_TOPO_SZ_NAME;
+        }
+    }
+#undef GENCCT_TOPO_SZ_NAME
+    ptopo->num_default = num_edio24;
+    return gencct_topo_build(ptopo);
+}
+
+/**
+ * \brief load the topology file
+ * \param ptopo: the topology
+ * \param fn: the file name
+ * \return 0 on success, <0 on error
+ *
+ * Each line is a board: '<cluster> <position> <device> <pin> <name>',
+ * the device is the index of the EDIO24 in its list, the device and the pin are -1 if none.
+ * The pin is a power pin at the port 0, a line of the other pins is rejected.
+ */
+int
+gencct_topo_load (gencct_topo_t * ptopo, const char * fn)
+{
+    size_t i;
+    long vals[4];
+    char * p;
+    char * pend;
+    int k;
+
+    gencct_topo_clean(ptopo);
+    if (brdlst_load(&(ptopo->lst), fn) < 0) {
+        return -1;
+    }
+    for (i = 0; i < brdlst_length(&(ptopo->lst)); i ++) {
+        p = brdlst_get(&(ptopo->lst), i);
+        for (k = 0; k < 4; k ++) {
+            vals[k] = strtol(p, &pend, 10);
+            if (pend == p) {
+                break;
+            }
+            p = pend;
+        }
+        for (; MY_ISSPACE(*p); p ++);
+        for (pend = p; *pend && ! MY_ISSPACE(*pend); pend ++);
+        *pend = 0;
+        if ((k < 4) || (vals[0] < 0) || (vals[1] < 0) || (0 == *p)) {
+            fprintf(stderr, "Error in the topology line %" PRIuSZ ": '%s'\n", i + 1, brdlst_get(&(ptopo->lst), i));
+            continue;
+        }
+        if (vals[3] >= GENCCT_TOPO_POWER_PINS) {
+            fprintf(stderr, "Error in the topology line %" PRIuSZ ": the pin %ld of '%s' is not a power pin (0-%d)\n", i + 1, vals[3], p, GENCCT_TOPO_POWER_PINS - 1);
+            continue;
+        }
+        if (gencct_topo_add(ptopo, vals[0], vals[1], (vals[2] < 0 ? -1 : (int)vals[2]), (vals[3] < 0 ? -1 : (int)vals[3]), p) < 0) {
+            return -1;
+        }
+    }
+    return gencct_topo_build(ptopo);
+}
+
+/**
+ * \brief get the global topology, the default one follows the EDIO24 list
+ * \return the topology
+ */
+static gencct_topo_t *
+gencct_topo_get (void)
+{
+    if ((-1 != g_topo.num_default) && ((NULL == g_topo.boards) || (g_topo.num_default != brdlst_length(&g_lst_edio24)))) {
+        gencct_topo_default(&g_topo, brdlst_length(&g_lst_edio24));
+    }
+    return &g_topo;
+}
+
+/**
+ * \brief select the boards
+ * \param ptopo: the topology
+ * \param pclusters: the clusters selected, num_clusters bits
+ * \param ppositions: the positions selected, num_positions bits; NULL for all
+ * \param psel: the boards selected, num bits, initialized by the function
+ * \return 0 on success, <0 on error
+ */
+int
+gencct_topo_select (const gencct_topo_t * ptopo, const gencct_bits_t * pclusters, const gencct_bits_t * ppositions, gencct_bits_t * psel)
+{
+    gencct_bits_t bits;
+    size_t c;
+    size_t p;
+
+    assert (NULL != ptopo);
+    assert (NULL != pclusters);
+    if (gencct_bits_init(psel, ptopo->num) < 0) {
+        return -1;
+    }
+    for (c = gencct_bits_next(pclusters, 0); c < ptopo->num_clusters; c = gencct_bits_next(pclusters, c + 1)) {
+        gencct_bits_set_range(psel, ptopo->cluster_start[c], ptopo->cluster_start[c + 1]);
+    }
+    if (NULL == ppositions) {
+        return 0;
+    }
+    if (gencct_bits_init(&bits, ptopo->num) < 0) {
+        return -1;
+    }
+    for (p = gencct_bits_next(ppositions, 0); p < ptopo->num_positions; p = gencct_bits_next(ppositions, p + 1)) {
+        gencct_bits_merge(&bits, &(ptopo->pos_boards[p]), 1);
+    }
+    gencct_bits_merge(psel, &bits, 0);
+    gencct_bits_clean(&bits);
+    return 0;
+}
+
+/**
+ * \brief parse the cluster and the position selectors, and select the boards
+ * \param ptopo: the topology
+ * \param arg_cluster: the cluster selector, 'p=1,2'
+ * \param arg_cmd: the position selector, 'p=1-8;v=31'; NULL for all positions
+ * \param psel: the boards selected
+ * \param val: the return value of 'v'
+ * \return 0 on success, <0 on error
+ */
+static int
+gencct_topo_parse_select (const gencct_topo_t * ptopo, const char * arg_cluster, const char * arg_cmd, gencct_bits_t * psel, unsigned int * val)
+{
+    gencct_bits_t clusters;
+    gencct_bits_t positions;
+    unsigned int val_c = EDIO24_INVALID_INT;
+    int ret;
+
+    if (gencct_bits_init(&clusters, ptopo->num_clusters) < 0) {
+        return -1;
+    }
+    if (gencct_bits_init(&positions, ptopo->num_positions) < 0) {
+        gencct_bits_clean(&clusters);
+        return -1;
+    }
+    parse_values_bits((NULL == arg_cluster ? "" : arg_cluster), &clusters, &val_c);
+    if (NULL != arg_cmd) {
+        parse_values_bits(arg_cmd, &positions, val);
+    }
+    ret = gencct_topo_select(ptopo, &clusters, (NULL == arg_cmd ? NULL : &positions), psel);
+    gencct_bits_clean(&clusters);
+    gencct_bits_clean(&positions);
+    return ret;
+}
+
+/**
+ * \brief get the devices of the boards, in the order of the boards
+ * \param ptopo: the topology
+ * \param psel: the boards
+ * \param devices: the return devices, num_devices items at most
+ * \return the number of the devices, <0 on error
+ */
+static ssize_t
+gencct_topo_devices (const gencct_topo_t * ptopo, const gencct_bits_t * psel, int * devices)
+{
+    gencct_bits_t seen;
+    size_t num = 0;
+    size_t i;
+    int dev;
+
+    if (gencct_bits_init(&seen, ptopo->num_devices) < 0) {
+        return -1;
+    }
+    for (i = gencct_bits_next(psel, 0); i < psel->num; i = gencct_bits_next(psel, i + 1)) {
+        dev = ptopo->boards[i].device;
+        if ((dev >= 0) && ! gencct_bits_test(&seen, (size_t)dev)) {
+            gencct_bits_set(&seen, (size_t)dev);
+            devices[num ++] = dev;
+        }
+    }
+    gencct_bits_clean(&seen);
+    return num;
+}
+
 /*****************************************************************************/
 /**
  * \brief get the IP of boards
@@ -1134,39 +2645,23 @@ TEST_CASE( .description="test get_ip_of_board.", .skip=0 ) {
 void
 do_get_ip_board(FILE *fp, const char * arg_cluster, const char *arg_cmd)
 {
-    int i;
-    int j;
+    gencct_topo_t * ptopo = gencct_topo_get();
+    gencct_bits_t sel;
+    size_t i;
     int ret;
-    unsigned int val;
-    unsigned int mask_c;
-    unsigned int mask_p;
+    unsigned int val = 0;
     char buf[200];
 
-    if (NULL == arg_cluster) {
-        arg_cluster = "";
-    }
-    val = 0;
-    parse_values_atten (arg_cluster, &mask_c, &val);
-
-    if (NULL == arg_cmd) {
-        arg_cmd = "";
+    if (gencct_topo_parse_select(ptopo, arg_cluster, (NULL == arg_cmd ? "" : arg_cmd), &sel, &val) < 0) {
+        return;
     }
-    val = 0;
-    parse_values_atten (arg_cmd, &mask_p, &val);
-
-    for (i = 0; i <= 16; i ++) {
-        if (mask_c & (0x0001 << i)) {
-            for (j = 0; j <= 8; j ++) {
-                if (mask_p & (0x0001 << j)) {
-                    snprintf(buf, sizeof(buf) - 1, "CCT_C%02d-%02d", i, j);
-                    ret = get_ip_of_board(buf, buf, sizeof(buf));
-                    if (ret >= 0) {
-                        fprintf (fp, "CCT_C%02d-%02d\t%s", i, j, buf);
-                    }
-                }
-            }
+    for (i = gencct_bits_next(&sel, 0); i < sel.num; i = gencct_bits_next(&sel, i + 1)) {
+        ret = get_ip_of_board(ptopo->boards[i].name, buf, sizeof(buf));
+        if (ret >= 0) {
+            fprintf (fp, "%s\t%s", ptopo->boards[i].name, buf);
         }
     }
+    gencct_bits_clean(&sel);
 }
 
 /**
@@ -1177,61 +2672,35 @@ do_get_ip_board(FILE *fp, const char * arg_cluster, const char *arg_cmd)
 void
 do_get_all_board(FILE *fp, const char * arg_cluster, const char *arg_cmd)
 {
-    int i;
-    int j;
+    gencct_topo_t * ptopo = gencct_topo_get();
+    gencct_bits_t sel;
+    board_list_t *plst = &g_lst_brd;
     unsigned int val = EDIO24_INVALID_INT;
-    unsigned int mask_c;
-    unsigned int mask_p;
-    char buf[200];
+    ssize_t row;
+    char * line = NULL;
+    size_t i;
 
-    if (NULL == arg_cmd) {
-        arg_cmd = "";
-    }
-    val = EDIO24_INVALID_INT;
-    parse_values_atten (arg_cmd, &mask_p, &val);
-    if (EDIO24_INVALID_INT != val) {
-        fprintf(stderr, "Error: set the forbidden value\n");
+    if (gencct_topo_parse_select(ptopo, arg_cluster, (NULL == arg_cmd ? "" : arg_cmd), &sel, &val) < 0) {
         return;
     }
-
-    if (NULL == arg_cluster) {
-        arg_cluster = "";
-    }
-    val = EDIO24_INVALID_INT;
-    parse_values_atten (arg_cluster, &mask_c, &val);
     if (EDIO24_INVALID_INT != val) {
         fprintf(stderr, "Error: set the forbidden value\n");
+        gencct_bits_clean(&sel);
         return;
     }
-
-    for (i = 0; i <= 16; i ++) {
-        if (mask_c & (0x0001 << i)) {
-            for (j = 0; j <= 8; j ++) {
-                if (mask_p & (0x0001 << j)) {
-
-                    int ret;
-                    char * line = NULL;
-                    size_t idx = 0;
-                    board_list_t *plst = &g_lst_brd;
-                    assert (NULL != plst);
-                    assert (0 < brdlst_length(plst));
-
-                    snprintf(buf, sizeof(buf) - 1, "CCT_C%02d-%02d", i, j);
-
-                    ret = pf_bsearch_r(plst, brdlst_length(plst), pf_bsearch_cb_comp_brdlst_board_name, buf, &idx);
-                    if (ret < 0) {
-                        continue;
-                    }
-                    line = brdlst_get(plst, idx);
-                    if (NULL == line) {
-                        continue;
-                    }
-
-                    fprintf (fp, "%s\n", line);
-                }
-            }
+    assert (0 < brdlst_length(plst));
+    for (i = gencct_bits_next(&sel, 0); i < sel.num; i = gencct_bits_next(&sel, i + 1)) {
+        row = brdlst_find(plst, BRDINV_COL_NAME, ptopo->boards[i].name);
+        if (row < 0) {
+            continue;
         }
+        line = brdlst_get(plst, row);
+        if (NULL == line) {
+            continue;
+        }
+        fprintf (fp, "%s\n", line);
     }
+    gencct_bits_clean(&sel);
 }
 
 #if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
@@ -1304,30 +2773,37 @@ TEST_CASE( .name="get-boards", .description="test get boards.", .skip=0 ) {
 #endif /* CIUT_ENABLED */
 
 /**
- * \brief get the EDIO24 raw commands sequence to set attenuations
- * \param fp: the FILE pointer for output
+ * \brief generate the EDIO24 commands to set attenuations
+ * \param psink: the sink of the commands
  * \param arg_cluster: the C string for cluster info
  * \param arg_cmd: the C string for board info
  */
 void
-do_setatten(FILE *fp, const char * arg_cluster, const char *arg_cmd)
+gen_setatten(gencct_sink_t * psink, const char * arg_cluster, const char *arg_cmd)
 {
-    int i;
+    gencct_topo_t * ptopo = gencct_topo_get();
+    gencct_bits_t sel;
+    int * devices;
+    ssize_t num;
+    ssize_t i;
     int j;
     int ret;
     unsigned int val;
     unsigned int val1;
     unsigned int val2;
-    unsigned int mask_c;
     unsigned int mask_p;
     char buf[200];
 
-    if (NULL == arg_cluster) {
-        arg_cluster = "";
+    devices = (int *)malloc(sizeof(int) * (ptopo->num_devices + 1));
+    if (NULL == devices) {
+        return;
     }
-    val = 0;
-    parse_values_atten (arg_cluster, &mask_c, &val);
-    mask_c &= 0x1FFFF;
+    if (gencct_topo_parse_select(ptopo, arg_cluster, NULL, &sel, &val) < 0) {
+        free (devices);
+        return;
+    }
+    num = gencct_topo_devices(ptopo, &sel, devices);
+    gencct_bits_clean(&sel);
 
     if (NULL == arg_cmd) {
         arg_cmd = "";
@@ -1348,338 +2824,1699 @@ do_setatten(FILE *fp, const char * arg_cluster, const char *arg_cmd)
     }
     //fprintf(stderr, "do_setatten: arg_cluster='%s', arg_cmd='%s'; mask_p=0x%02X, val=%d\n", arg_cluster, arg_cmd, mask_p, val);
 
-    // skip the cluster 0 (root)
-    for (i = 1; i <= 16; i ++) {
-        //fprintf(stderr, "do_setatten: cluster i=%d\n", i);
-        if (mask_c & (0x0001 << i)) {
-            ret = get_ip_of_edio24(i-1, buf, sizeof(buf));
-            if (ret < 0) {
-                fprintf(stderr, "error in get the ip of edio24 at idx=%d\n", i);
-                continue;
+    // the EDIO24s of the clusters, the root cluster 0 has no device
+    for (i = 0; i < num; i ++) {
+        ret = get_ip_of_edio24(devices[i], buf, sizeof(buf));
+        if (ret < 0) {
+            fprintf(stderr, "error in get the ip of edio24 at idx=%d\n", devices[i] + 1);
+            continue;
+        }
+        gencct_emit_device(psink, devices[i], brdlst_get(&g_lst_edio24, devices[i]));
+        assert (val == val1 + val2);
+        if (val1 == val2) {
+            char *p = buf;
+            snprintf(buf, sizeof(buf)-1, "v=%d;p=", val1);
+            p = buf + strlen(buf);
+            assert(p < buf + sizeof(buf));
+            j = 0;
+            if (mask_p & (0x0001 << j)) {
+                //fprintf(stderr, "mask_p active at idx=%d\n", j);
+                snprintf(p, sizeof(buf)-1-(p-buf), "%d,%d", j*2, j*2+1);
             }
-            fprintf(fp, "# ConnectTo %s # %d\n", brdlst_get(&g_lst_edio24, i-1), i);
-            assert (val == val1 + val2);
-            if (val1 == val2) {
-                char *p = buf;
-                snprintf(buf, sizeof(buf)-1, "v=%d;p=", val1);
-                p = buf + strlen(buf);
-                assert(p < buf + sizeof(buf));
-                j = 0;
-                if (mask_p & (0x0001 << j)) {
-                    //fprintf(stderr, "mask_p active at idx=%d\n", j);
-                    snprintf(p, sizeof(buf)-1-(p-buf), "%d,%d", j*2, j*2+1);
-                }
-                p = buf + strlen(buf);
-                assert(p < buf + sizeof(buf));
-                j = 1;
-                if (mask_p & (0x0001 << j)) {
-                    //fprintf(stderr, "mask_p active at idx=%d\n", j);
-                    snprintf(p, sizeof(buf)-1-(p-buf), ",%d,%d", j*2, j*2+1);
-                }
-                p = buf + strlen(buf);
-                assert(p < buf + sizeof(buf));
-                output_atten(fp, buf);
-            } else {
-                char *p = buf;
-                snprintf(buf, sizeof(buf)-1, "v=%d;p=", val1);
-                p = buf + strlen(buf);
-                assert(p < buf + sizeof(buf));
-                j = 0;
-                if (mask_p & (0x0001 << j)) {
-                    //fprintf(stderr, "2 mask_p active at idx=%d\n", j);
-                    snprintf(p, sizeof(buf)-1-(p-buf), "%d", j*2);
-                }
-                p = buf + strlen(buf);
-                assert(p < buf + sizeof(buf));
-                j = 1;
-                if (mask_p & (0x0001 << j)) {
-                    //fprintf(stderr, "2 mask_p active at idx=%d\n", j);
-                    snprintf(p, sizeof(buf)-1-(p-buf), ",%d", j*2);
-                }
-                output_atten(fp, buf);
-                snprintf(buf, sizeof(buf)-1, "v=%d;p=", val2);
-                p = buf + strlen(buf);
-                assert(p < buf + sizeof(buf));
-                j = 0;
-                if (mask_p & (0x0001 << j)) {
-                    //fprintf(stderr, "2 mask_p active at idx=%d\n", j);
-                    snprintf(p, sizeof(buf)-1-(p-buf), "%d", j*2+1);
-                }
-                p = buf + strlen(buf);
-                assert(p < buf + sizeof(buf));
-                j = 1;
-                if (mask_p & (0x0001 << j)) {
-                    //fprintf(stderr, "2 mask_p active at idx=%d\n", j);
-                    snprintf(p, sizeof(buf)-1-(p-buf), ",%d", j*2+1);
-                }
-                p = buf + strlen(buf);
-                assert(p < buf + sizeof(buf));
-                output_atten(fp, buf);
+            p = buf + strlen(buf);
+            assert(p < buf + sizeof(buf));
+            j = 1;
+            if (mask_p & (0x0001 << j)) {
+                //fprintf(stderr, "mask_p active at idx=%d\n", j);
+                snprintf(p, sizeof(buf)-1-(p-buf), ",%d,%d", j*2, j*2+1);
             }
-
+            p = buf + strlen(buf);
+            assert(p < buf + sizeof(buf));
+            gen_atten(psink, buf);
+        } else {
+            char *p = buf;
+            snprintf(buf, sizeof(buf)-1, "v=%d;p=", val1);
+            p = buf + strlen(buf);
+            assert(p < buf + sizeof(buf));
+            j = 0;
+            if (mask_p & (0x0001 << j)) {
+                //fprintf(stderr, "2 mask_p active at idx=%d\n", j);
+                snprintf(p, sizeof(buf)-1-(p-buf), "%d", j*2);
+            }
+            p = buf + strlen(buf);
+            assert(p < buf + sizeof(buf));
+            j = 1;
+            if (mask_p & (0x0001 << j)) {
+                //fprintf(stderr, "2 mask_p active at idx=%d\n", j);
+                snprintf(p, sizeof(buf)-1-(p-buf), ",%d", j*2);
+            }
+            gen_atten(psink, buf);
+            snprintf(buf, sizeof(buf)-1, "v=%d;p=", val2);
+            p = buf + strlen(buf);
+            assert(p < buf + sizeof(buf));
+            j = 0;
+            if (mask_p & (0x0001 << j)) {
+                //fprintf(stderr, "2 mask_p active at idx=%d\n", j);
+                snprintf(p, sizeof(buf)-1-(p-buf), "%d", j*2+1);
+            }
+            p = buf + strlen(buf);
+            assert(p < buf + sizeof(buf));
+            j = 1;
+            if (mask_p & (0x0001 << j)) {
+                //fprintf(stderr, "2 mask_p active at idx=%d\n", j);
+                snprintf(p, sizeof(buf)-1-(p-buf), ",%d", j*2+1);
+            }
+            p = buf + strlen(buf);
+            assert(p < buf + sizeof(buf));
+            gen_atten(psink, buf);
         }
     }
+    free (devices);
 }
 
 /**
- * \brief get the EDIO24 raw commands sequence to set power on/off
+ * \brief get the EDIO24 raw commands sequence to set attenuations
  * \param fp: the FILE pointer for output
  * \param arg_cluster: the C string for cluster info
  * \param arg_cmd: the C string for board info
  */
 void
-do_setpower(FILE *fp, const char * arg_cluster, const char *arg_cmd)
+do_setatten(FILE *fp, const char * arg_cluster, const char *arg_cmd)
 {
-    int i;
-    int j;
-    int ret;
-    unsigned int val;
-    unsigned int mask_c;
-    unsigned int mask_p;
+    gencct_sink_t sink = GENCCT_SINK_TEXT_INIT(fp);
+    gen_setatten(&sink, arg_cluster, arg_cmd);
+}
+
+/**
+ * \brief generate the EDIO24 commands to set power on/off
+ * \param psink: the sink of the commands
+ * \param arg_cluster: the C string for cluster info
+ * \param arg_cmd: the C string for board info
+ */
+void
+gen_setpower(gencct_sink_t * psink, const char * arg_cluster, const char *arg_cmd)
+{
+    gencct_topo_t * ptopo = gencct_topo_get();
+    gencct_bits_t span;
+    gencct_bits_t sel;
+    uint32_t * masks;
+    int * devices;
+    ssize_t num;
+    ssize_t i;
+    size_t k;
+    int ret;
+    unsigned int val = 0;
     char buf[200];
 
-    if (NULL == arg_cluster) {
-        arg_cluster = "";
+    if (gencct_topo_parse_select(ptopo, arg_cluster, NULL, &span, &val) < 0) {
+        return;
+    }
+    if (gencct_topo_parse_select(ptopo, arg_cluster, (NULL == arg_cmd ? "" : arg_cmd), &sel, &val) < 0) {
+        gencct_bits_clean(&span);
+        return;
+    }
+    // the power pins of the clusters on each device, and the pins of the boards selected
+    devices = (int *)malloc(sizeof(int) * (ptopo->num_devices + 1));
+    masks = (uint32_t *)calloc(ptopo->num_devices * 2 + 1, sizeof(uint32_t));
+    if ((NULL == devices) || (NULL == masks)) {
+        goto end_setpower;
+    }
+    num = gencct_topo_devices(ptopo, &span, devices);
+    for (k = gencct_bits_next(&span, 0); k < span.num; k = gencct_bits_next(&span, k + 1)) {
+        const gencct_board_t * pbrd = &(ptopo->boards[k]);
+        if ((pbrd->device < 0) || (pbrd->pin < 0)) {
+            continue;
+        }
+        masks[pbrd->device * 2] |= (1UL << pbrd->pin);
+        if (gencct_bits_test(&sel, k)) {
+            masks[pbrd->device * 2 + 1] |= (1UL << pbrd->pin);
+        }
+    }
+    fprintf(stderr, "do_setpower: arg_cluster='%s', arg_cmd='%s'; devices=%" PRIiSZ ", val=%d\n", arg_cluster, arg_cmd, num, val);
+
+    for (i = 0; i < num; i ++) {
+        ret = get_ip_of_edio24(devices[i], buf, sizeof(buf));
+        if (ret < 0) {
+            fprintf(stderr, "error in get the ip of edio24 at idx=%d\n", devices[i] + 1);
+            continue;
+        }
+        gencct_emit_device(psink, devices[i], brdlst_get(&g_lst_edio24, devices[i]));
+        gen_power_pins(psink, masks[devices[i] * 2], masks[devices[i] * 2 + 1]);
+    }
+end_setpower:
+    free (masks);
+    free (devices);
+    gencct_bits_clean(&span);
+    gencct_bits_clean(&sel);
+}
+
+/**
+ * \brief get the EDIO24 raw commands sequence to set power on/off
+ * \param fp: the FILE pointer for output
+ * \param arg_cluster: the C string for cluster info
+ * \param arg_cmd: the C string for board info
+ */
+void
+do_setpower(FILE *fp, const char * arg_cluster, const char *arg_cmd)
+{
+    gencct_sink_t sink = GENCCT_SINK_TEXT_INIT(fp);
+    gen_setpower(&sink, arg_cluster, arg_cmd);
+}
+
+/**
+ * \brief generate the EDIO24 commands to get power status
+ * \param psink: the sink of the commands
+ * \param arg_cluster: the C string for cluster info
+ * \param arg_cmd: the C string for board info
+ */
+void
+gen_getpower(gencct_sink_t * psink, const char * arg_cluster, const char *arg_cmd)
+{
+    gencct_topo_t * ptopo = gencct_topo_get();
+    gencct_bits_t sel;
+    int * devices;
+    ssize_t num;
+    ssize_t i;
+    int ret;
+    unsigned int val = 0;
+    char buf[200];
+
+    devices = (int *)malloc(sizeof(int) * (ptopo->num_devices + 1));
+    if (NULL == devices) {
+        return;
+    }
+    if (gencct_topo_parse_select(ptopo, arg_cluster, NULL, &sel, &val) < 0) {
+        free (devices);
+        return;
+    }
+    num = gencct_topo_devices(ptopo, &sel, devices);
+    gencct_bits_clean(&sel);
+    fprintf(stderr, "do_getpower: arg_cluster='%s', arg_cmd='%s'; devices=%" PRIiSZ "\n", arg_cluster, arg_cmd, num);
+
+    for (i = 0; i < num; i ++) {
+        ret = get_ip_of_edio24(devices[i], buf, sizeof(buf));
+        if (ret < 0) {
+            fprintf(stderr, "error in get the ip of edio24 at idx=%d\n", devices[i] + 1);
+            continue;
+        }
+        gencct_emit_device(psink, devices[i], brdlst_get(&g_lst_edio24, devices[i]));
+        gen_power_read(psink, arg_cmd);
+    }
+    free (devices);
+}
+
+/**
+ * \brief get the EDIO24 raw commands sequence to get power status
+ * \param fp: the FILE pointer for output
+ * \param arg_cluster: the C string for cluster info
+ * \param arg_cmd: the C string for board info
+ */
+void
+do_getpower(FILE *fp, const char * arg_cluster, const char *arg_cmd)
+{
+    gencct_sink_t sink = GENCCT_SINK_TEXT_INIT(fp);
+    gen_getpower(&sink, arg_cluster, arg_cmd);
+}
+
+/**
+ * \brief generate the EDIO24 commands of a list of the board actions, one power write for each device
+ * \param psink: the sink of the commands
+ * \param plst: the lines of '<board name> <on|off>'
+ * \return the number of the lines failed
+ *
+ * The boards are grouped by the EDIO24s in the topology, only the power pins of the boards listed are written.
+ * If a board is listed more than once, the last action is used.
+ */
+int
+gen_actions(gencct_sink_t * psink, board_list_t * plst)
+{
+    gencct_topo_t * ptopo = gencct_topo_get();
+    gencct_bits_t touched;
+    uint32_t * masks;
+    const gencct_board_t * pbrd;
+    ssize_t row;
+    size_t i;
+    size_t dev;
+    int errors = 0;
+    int on;
+    char * line;
+    char * act;
+    char buf[200];
+
+    masks = (uint32_t *)calloc(ptopo->num_devices * 2 + 1, sizeof(uint32_t));
+    if ((NULL == masks) || (gencct_bits_init(&touched, ptopo->num_devices) < 0)) {
+        free (masks);
+        return brdlst_length(plst);
+    }
+    for (i = 0; i < brdlst_length(plst); i ++) {
+        line = brdlst_get(plst, i);
+        for (act = line; *act && ! MY_ISSPACE(*act); act ++);
+        snprintf(buf, sizeof(buf), "%.*s", (int)(act - line), line);
+        for (; MY_ISSPACE(*act); act ++);
+        if ((0 == strcmp(act, "on")) || (0 == strcmp(act, "1"))) {
+            on = 1;
+        } else if ((0 == strcmp(act, "off")) || (0 == strcmp(act, "0"))) {
+            on = 0;
+        } else {
+            fprintf(stderr, "Error: unknown action of the line '%s'\n", line);
+            errors ++;
+            continue;
+        }
+        row = gencct_topo_find(ptopo, buf);
+        if (row < 0) {
+            fprintf(stderr, "Error: not found the board '%s'\n", buf);
+            errors ++;
+            continue;
+        }
+        pbrd = &(ptopo->boards[row]);
+        if ((pbrd->device < 0) || (pbrd->pin < 0)) {
+            fprintf(stderr, "Error: no power pin of the board '%s'\n", buf);
+            errors ++;
+            continue;
+        }
+        if ((masks[pbrd->device * 2] & (1UL << pbrd->pin)) && (on != !!(masks[pbrd->device * 2 + 1] & (1UL << pbrd->pin)))) {
+            fprintf(stderr, "Warning: the board '%s' is set again, to %s\n", buf, act);
+        }
+        gencct_bits_set(&touched, (size_t)pbrd->device);
+        masks[pbrd->device * 2] |= (1UL << pbrd->pin);
+        masks[pbrd->device * 2 + 1] &= ~(1UL << pbrd->pin);
+        if (on) {
+            masks[pbrd->device * 2 + 1] |= (1UL << pbrd->pin);
+        }
+    }
+
+    for (dev = gencct_bits_next(&touched, 0); dev < touched.num; dev = gencct_bits_next(&touched, dev + 1)) {
+        if (get_ip_of_edio24(dev, buf, sizeof(buf)) < 0) {
+            fprintf(stderr, "error in get the ip of edio24 at idx=%d\n", (int)dev + 1);
+            errors ++;
+            continue;
+        }
+        gencct_emit_device(psink, dev, brdlst_get(&g_lst_edio24, dev));
+        gen_power_pins(psink, masks[dev * 2], masks[dev * 2 + 1]);
+    }
+    gencct_bits_clean(&touched);
+    free (masks);
+    return errors;
+}
+
+/**
+ * \brief generate the EDIO24 commands of the board actions in a file
+ * \param psink: the sink of the commands
+ * \param fn: the file of the lines '<board name> <on|off>', "-" for stdin
+ * \return the number of the lines failed, <0 on error
+ */
+int
+gen_actions_file(gencct_sink_t * psink, const char * fn)
+{
+    BRDLST_DECLARE_INIT(lst);
+    int ret;
+
+    if (brdlst_load(&lst, (0 == strcmp(fn, "-") ? NULL : fn)) < 0) {
+        fprintf(stderr, "Error in read the actions '%s'\n", fn);
+        return -1;
+    }
+    ret = gen_actions(psink, &lst);
+    brdlst_clean(&lst);
+    return ret;
+}
+
+/**
+ * \brief get the EDIO24 raw commands sequence of the board actions in a file
+ * \param fp: the FILE pointer for output
+ * \param fn: the file of the lines '<board name> <on|off>', "-" for stdin
+ * \return the number of the lines failed, <0 on error
+ */
+int
+do_actions(FILE *fp, const char * fn)
+{
+    gencct_sink_t sink = GENCCT_SINK_TEXT_INIT(fp);
+    return gen_actions_file(&sink, fn);
+}
+
+#if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
+
+#include <ciut.h>
+
+typedef struct _ciut_test_dotest_t {
+    const char * arg_cluster;
+    const char * arg_cmd;
+} ciut_test_dotest_t;
+
+static int
+cb_ciut_check_output_doatten (FILE * outf, void * user_arg)
+{
+    ciut_test_dotest_t * arg = (ciut_test_dotest_t *)user_arg;
+    do_setatten(outf, arg->arg_cluster, arg->arg_cmd);
+    return 0;
+}
+
+static int
+cb_ciut_check_output_dosetpower (FILE * outf, void * user_arg)
+{
+    ciut_test_dotest_t * arg = (ciut_test_dotest_t *)user_arg;
+    do_setpower(outf, arg->arg_cluster, arg->arg_cmd);
+    return 0;
+}
+
+static int
+cb_ciut_check_output_dogetpower (FILE * outf, void * user_arg)
+{
+    ciut_test_dotest_t * arg = (ciut_test_dotest_t *)user_arg;
+    do_getpower(outf, arg->arg_cluster, arg->arg_cmd);
+    return 0;
+}
+
+TEST_CASE( .name="do-test", .description="test output cluster.", .skip=0 ) {
+
+    int i;
+    ciut_test_dotest_t args;
+
+    static const char * iodata_atten[] = {
+        // cluster, atten pos, output
+        "p=1", "p=all;v=20",   "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDConfigW 0xFFFFFF 0x000000\nDOutW 0x000F00 0x000000\nDOutW 0xFF0000 0x0A0000\nSleep 1\nDOutW 0x000F00 0x000F00\nSleep 1\nDOutW 0x000F00 0x000000\nDOutW 0xFF0000 0x000000\n\n",
+        "p=1", "p=all;v=31",   "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDConfigW 0xFFFFFF 0x000000\nDOutW 0x000500 0x000000\nDOutW 0xFF0000 0x0F0000\nSleep 1\nDOutW 0x000500 0x000500\nSleep 1\nDOutW 0x000500 0x000000\nDOutW 0xFF0000 0x000000\n\nDConfigW 0xFFFFFF 0x000000\nDOutW 0x000A00 0x000000\nDOutW 0xFF0000 0x100000\nSleep 1\nDOutW 0x000A00 0x000A00\nSleep 1\nDOutW 0x000A00 0x000000\nDOutW 0xFF0000 0x000000\n\n",
+        "p=1", "p=0;v=31",     "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDConfigW 0xFFFFFF 0x000000\nDOutW 0x000100 0x000000\nDOutW 0xFF0000 0x0F0000\nSleep 1\nDOutW 0x000100 0x000100\nSleep 1\nDOutW 0x000100 0x000000\nDOutW 0xFF0000 0x000000\n\nDConfigW 0xFFFFFF 0x000000\nDOutW 0x000200 0x000000\nDOutW 0xFF0000 0x100000\nSleep 1\nDOutW 0x000200 0x000200\nSleep 1\nDOutW 0x000200 0x000000\nDOutW 0xFF0000 0x000000\n\n",
+    };
+    static const char * iodata_power[] = {
+        // cluster, board pos, output
+        "p=1", "p=",       "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDConfigW 0xFFFFFF 0x000000\nDOutW 0x0000FF 0x000000\n\n",
+        "p=1", "p=0,1,2",  "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDConfigW 0xFFFFFF 0x000000\nDOutW 0x0000FF 0x000003\n\n",
+        "p=1", "p=1,2",    "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDConfigW 0xFFFFFF 0x000000\nDOutW 0x0000FF 0x000003\n\n",
+        "p=1", "p=1,2,3",  "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDConfigW 0xFFFFFF 0x000000\nDOutW 0x0000FF 0x000007\n\n",
+        "p=1", "p=all",    "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDConfigW 0xFFFFFF 0x000000\nDOutW 0x0000FF 0x0000FF\n\n",
+    };
+    static const char * iodata_power_read[] = {
+        // cluster, board pos, output
+        "p=1", "p=",       "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDOutR\n\n",
+        "p=1", "p=0,1,2",  "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDOutR\n\n",
+        "p=1", "p=all",    "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDOutR\n\n",
+#if 1
+        "p=0,1", "p=all",    "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDOutR\n\n",
+        "p=0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,15", "p=all",
+            "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDOutR\n\n"
+            "# ConnectTo 192.168.1.102	00:11:22:33:44:02	E-DIO24-334402 # 2\nDOutR\n\n"
+            "# ConnectTo 192.168.1.103	00:11:22:33:44:03	E-DIO24-334403 # 3\nDOutR\n\n"
+            "# ConnectTo 192.168.1.104	00:11:22:33:44:04	E-DIO24-334404 # 4\nDOutR\n\n"
+            "# ConnectTo 192.168.1.105	00:11:22:33:44:05	E-DIO24-334405 # 5\nDOutR\n\n"
+            "# ConnectTo 192.168.1.106	00:11:22:33:44:06	E-DIO24-334406 # 6\nDOutR\n\n"
+            "# ConnectTo 192.168.1.107	00:11:22:33:44:07	E-DIO24-334407 # 7\nDOutR\n\n"
+            "# ConnectTo 192.168.1.108	00:11:22:33:44:08	E-DIO24-334408 # 8\nDOutR\n\n"
+            "# ConnectTo 192.168.1.109	00:11:22:33:44:09	E-DIO24-334409 # 9\nDOutR\n\n"
+            "# ConnectTo 192.168.1.110	00:11:22:33:44:10	E-DIO24-334410 # 10\nDOutR\n\n"
+            "# ConnectTo 192.168.1.111	00:11:22:33:44:11	E-DIO24-334411 # 11\nDOutR\n\n"
+            "# ConnectTo 192.168.1.112	00:11:22:33:44:12	E-DIO24-334412 # 12\nDOutR\n\n"
+            "# ConnectTo 192.168.1.113	00:11:22:33:44:13	E-DIO24-334413 # 13\nDOutR\n\n"
+            "# ConnectTo 192.168.1.114	00:11:22:33:44:14	E-DIO24-334414 # 14\nDOutR\n\n"
+            "# ConnectTo 192.168.1.115	00:11:22:33:44:15	E-DIO24-334415 # 15\nDOutR\n\n"
+            ,
+        "p=0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16", "p=all",
+            "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDOutR\n\n"
+            "# ConnectTo 192.168.1.102	00:11:22:33:44:02	E-DIO24-334402 # 2\nDOutR\n\n"
+            "# ConnectTo 192.168.1.103	00:11:22:33:44:03	E-DIO24-334403 # 3\nDOutR\n\n"
+            "# ConnectTo 192.168.1.104	00:11:22:33:44:04	E-DIO24-334404 # 4\nDOutR\n\n"
+            "# ConnectTo 192.168.1.105	00:11:22:33:44:05	E-DIO24-334405 # 5\nDOutR\n\n"
+            "# ConnectTo 192.168.1.106	00:11:22:33:44:06	E-DIO24-334406 # 6\nDOutR\n\n"
+            "# ConnectTo 192.168.1.107	00:11:22:33:44:07	E-DIO24-334407 # 7\nDOutR\n\n"
+            "# ConnectTo 192.168.1.108	00:11:22:33:44:08	E-DIO24-334408 # 8\nDOutR\n\n"
+            "# ConnectTo 192.168.1.109	00:11:22:33:44:09	E-DIO24-334409 # 9\nDOutR\n\n"
+            "# ConnectTo 192.168.1.110	00:11:22:33:44:10	E-DIO24-334410 # 10\nDOutR\n\n"
+            "# ConnectTo 192.168.1.111	00:11:22:33:44:11	E-DIO24-334411 # 11\nDOutR\n\n"
+            "# ConnectTo 192.168.1.112	00:11:22:33:44:12	E-DIO24-334412 # 12\nDOutR\n\n"
+            "# ConnectTo 192.168.1.113	00:11:22:33:44:13	E-DIO24-334413 # 13\nDOutR\n\n"
+            "# ConnectTo 192.168.1.114	00:11:22:33:44:14	E-DIO24-334414 # 14\nDOutR\n\n"
+            "# ConnectTo 192.168.1.115	00:11:22:33:44:15	E-DIO24-334415 # 15\nDOutR\n\n"
+            "# ConnectTo 192.168.1.116	00:11:22:33:44:16	E-DIO24-334416 # 16\nDOutR\n\n"
+            ,
+#endif
+    };
+
+    board_list_t *plst = &g_lst_edio24;
+
+    brdlst_clean(plst);
+    brdlst_init(plst);
+
+    //CIUT_LOG ("insert data");
+    brdlst_append(plst, "192.168.1.101	00:11:22:33:44:01	E-DIO24-334401");
+    brdlst_append(plst, "192.168.1.102	00:11:22:33:44:02	E-DIO24-334402");
+    brdlst_append(plst, "192.168.1.103	00:11:22:33:44:03	E-DIO24-334403");
+    brdlst_append(plst, "192.168.1.104	00:11:22:33:44:04	E-DIO24-334404");
+    brdlst_append(plst, "192.168.1.105	00:11:22:33:44:05	E-DIO24-334405");
+    brdlst_append(plst, "192.168.1.106	00:11:22:33:44:06	E-DIO24-334406");
+    brdlst_append(plst, "192.168.1.107	00:11:22:33:44:07	E-DIO24-334407");
+    brdlst_append(plst, "192.168.1.108	00:11:22:33:44:08	E-DIO24-334408");
+    brdlst_append(plst, "192.168.1.109	00:11:22:33:44:09	E-DIO24-334409");
+    brdlst_append(plst, "192.168.1.110	00:11:22:33:44:10	E-DIO24-334410");
+    brdlst_append(plst, "192.168.1.111	00:11:22:33:44:11	E-DIO24-334411");
+    brdlst_append(plst, "192.168.1.112	00:11:22:33:44:12	E-DIO24-334412");
+    brdlst_append(plst, "192.168.1.113	00:11:22:33:44:13	E-DIO24-334413");
+    brdlst_append(plst, "192.168.1.114	00:11:22:33:44:14	E-DIO24-334414");
+    brdlst_append(plst, "192.168.1.115	00:11:22:33:44:15	E-DIO24-334415");
+    brdlst_append(plst, "192.168.1.116	00:11:22:33:44:16	E-DIO24-334416");
+
+    SECTION("test output atten's valid p arg") {
+        for (i = 0; i < ARRAY_NUM(iodata_atten); i += 3) {
+            CIUT_LOG ("output atten idx=%d", i/3);
+            args.arg_cluster = iodata_atten[i + 0];
+            args.arg_cmd = iodata_atten[i + 1];
+            REQUIRE(0 == ciut_check_output(cb_ciut_check_output_doatten, (void *)(&args), iodata_atten[i + 2]));
+        }
+    }
+    SECTION("test output power's valid p arg") {
+        for (i = 0; i < ARRAY_NUM(iodata_power); i += 3) {
+            CIUT_LOG ("output power idx=%d", i/3);
+            args.arg_cluster = iodata_power[i + 0];
+            args.arg_cmd = iodata_power[i + 1];
+            REQUIRE(0 == ciut_check_output(cb_ciut_check_output_dosetpower, (void *)(&args), iodata_power[i + 2]));
+        }
+    }
+    SECTION("test output power_read valid p arg") {
+        for (i = 0; i < ARRAY_NUM(iodata_power_read); i += 3) {
+            CIUT_LOG ("output power idx=%d", i/3);
+            args.arg_cluster = iodata_power_read[i + 0];
+            args.arg_cmd = iodata_power_read[i + 1];
+            REQUIRE(0 == ciut_check_output(cb_ciut_check_output_dogetpower, (void *)(&args), iodata_power_read[i + 2]));
+        }
+    }
+
+    brdlst_clean(plst);
+    REQUIRE(0 == plst->sz_max);
+    REQUIRE(0 == plst->sz_cur);
+    REQUIRE(NULL == plst->list);
+    brdlst_init(plst);
+    REQUIRE(0 == plst->sz_max);
+    REQUIRE(0 == plst->sz_cur);
+    REQUIRE(NULL == plst->list);
+}
+
+#endif /* CIUT_ENABLED */
+
+
+/*****************************************************************************/
+// the commands are compiled to a command stream for each device, see edio24cmdstream.h
+
+/** the command stream of a device */
+typedef struct _gencct_target_t {
+    int device;              /**< the index of the device in the EDIO24 list, -1 for the single device */
+    edio24_cmdstream_t cmds; /**< the packets, the frame ids are set when they are sent */
+    size_t num_pkts;
+} gencct_target_t;
+
+/** the command streams of the devices, the sink of gencct_plan_emit() */
+typedef struct _gencct_plan_t {
+    size_t num;
+    size_t sz_max;
+    gencct_target_t * targets;
+    size_t cur;              /**< the target of the following commands, num if not selected */
+} gencct_plan_t;
+
+/**
+ * \brief init the plan
+ * \param pplan: the plan
+ */
+void
+gencct_plan_init (gencct_plan_t * pplan)
+{
+    assert (NULL != pplan);
+    memset(pplan, 0, sizeof(*pplan));
+}
+
+/**
+ * \brief clean the plan
+ * \param pplan: the plan
+ */
+void
+gencct_plan_clean (gencct_plan_t * pplan)
+{
+    size_t i;
+    assert (NULL != pplan);
+    for (i = 0; i < pplan->num; i ++) {
+        edio24_cmdstream_clean(&(pplan->targets[i].cmds));
+    }
+    free (pplan->targets);
+    memset(pplan, 0, sizeof(*pplan));
+}
+
+/**
+ * \brief get the target of a device, add it if not exist
+ * \param pplan: the plan
+ * \param device: the index of the device in the EDIO24 list, -1 for the single device
+ * \return the index of the target, <0 on error
+ */
+static ssize_t
+gencct_plan_target (gencct_plan_t * pplan, int device)
+{
+    size_t i;
+    for (i = 0; i < pplan->num; i ++) {
+        if (device == pplan->targets[i].device) {
+            return i;
+        }
+    }
+    if (pplan->num >= pplan->sz_max) {
+        size_t sz_new = (pplan->sz_max > 0 ? pplan->sz_max * 2 : 16);
+        void * p = realloc(pplan->targets, sizeof(gencct_target_t) * sz_new);
+        if (NULL == p) {
+            fprintf(stderr, "error in double memory\n");
+            return -1;
+        }
+        pplan->targets = (gencct_target_t *)p;
+        pplan->sz_max = sz_new;
+    }
+    memset(&(pplan->targets[pplan->num]), 0, sizeof(gencct_target_t));
+    pplan->targets[pplan->num].device = device;
+    if (edio24_cmdstream_init(&(pplan->targets[pplan->num].cmds)) < 0) {
+        return -1;
+    }
+    pplan->num ++;
+    return pplan->num - 1;
+}
+
+/**
+ * \brief the sink compiles the commands to the command stream of the device selected
+ * \param psink: the sink, the userdata is the plan
+ * \param pcmd: the command
+ * \return 0 on success, <0 on error
+ *
+ * The commands before the first GENCCT_OP_DEVICE are for the single device.
+ */
+static int
+gencct_plan_emit (gencct_sink_t * psink, const gencct_cmd_t * pcmd)
+{
+    gencct_plan_t * pplan = (gencct_plan_t *)(psink->userdata);
+    gencct_target_t * ptarget;
+    uint8_t pkt[EDIO24_PKT_LENGTH_MIN + 8];
+    uint8_t frame = 0;
+    ssize_t ret;
+
+    assert (NULL != pplan);
+    if (GENCCT_OP_END == pcmd->op) {
+        return 0;
+    }
+    if ((GENCCT_OP_DEVICE == pcmd->op) || (pplan->cur >= pplan->num)) {
+        ret = gencct_plan_target(pplan, (GENCCT_OP_DEVICE == pcmd->op ? pcmd->device : -1));
+        if (ret < 0) {
+            return -1;
+        }
+        pplan->cur = ret;
+        if (GENCCT_OP_DEVICE == pcmd->op) {
+            return 0;
+        }
+    }
+    ptarget = &(pplan->targets[pplan->cur]);
+    switch (pcmd->op) {
+    case GENCCT_OP_DCONFW:
+        ret = edio24_pkt_create_cmd_dconfw(pkt, sizeof(pkt), &frame, pcmd->mask, pcmd->value);
+        break;
+    case GENCCT_OP_DOUTW:
+        ret = edio24_pkt_create_cmd_doutw(pkt, sizeof(pkt), &frame, pcmd->mask, pcmd->value);
+        break;
+    case GENCCT_OP_DOUTR:
+        ret = edio24_pkt_create_cmd_doutr(pkt, sizeof(pkt), &frame);
+        break;
+    case GENCCT_OP_SLEEP:
+        return edio24_cmdstream_add_sleep(&(ptarget->cmds), pcmd->value);
+    default:
+        return -1;
+    }
+    if ((ret < 0) || (edio24_cmdstream_add_pkt(&(ptarget->cmds), pkt, ret) < 0)) {
+        return -1;
+    }
+    ptarget->num_pkts ++;
+    return 0;
+}
+
+#define GENCCT_SINK_PLAN_INIT(pplan) { gencct_plan_emit, (void *)(pplan) }
+
+#if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
+#include <ciut.h>
+#include "edio24script.h"
+
+/**
+ * \brief compile the text lines of the commands to the streams of the devices, as edio24cli does for each device
+ */
+static int
+ciut_gencct_compile_text (gencct_plan_t * pplan, const char * text)
+{
+    const char * p;
+    const char * pnl;
+    const char * pdev;
+    edio24_script_err_t err;
+    ssize_t ret;
+
+    pplan->cur = pplan->num;
+    for (p = text; *p; p = pnl) {
+        pnl = strchr(p, '\n');
+        pnl = (NULL == pnl ? p + strlen(p) : pnl + 1);
+        if (0 == strncmp(p, "# ConnectTo ", 12)) {
+            pdev = strstr(p, " # ");
+            assert (NULL != pdev);
+            ret = gencct_plan_target(pplan, atoi(pdev + 3) - 1);
+            if (ret < 0) {
+                return -1;
+            }
+            pplan->cur = ret;
+            continue;
+        }
+        if (pplan->cur >= pplan->num) {
+            ret = gencct_plan_target(pplan, -1);
+            if (ret < 0) {
+                return -1;
+            }
+            pplan->cur = ret;
+        }
+        if (edio24_script_compile_line(&(pplan->targets[pplan->cur].cmds), p, pnl - p, &err) < 0) {
+            return -1;
+        }
+    }
+    // count the packets
+    for (pplan->cur = 0; pplan->cur < pplan->num; pplan->cur ++) {
+        gencct_target_t * ptarget = &(pplan->targets[pplan->cur]);
+        edio24_cmdrec_t rec;
+        size_t off;
+        for (off = EDIO24_CMDSTREAM_HDR_SIZE; (ret = edio24_cmdstream_next(ptarget->cmds.buf, ptarget->cmds.sz, off, &rec)) > 0; off += ret) {
+            if (EDIO24_CMDSTREAM_OP_PKT == rec.op) {
+                ptarget->num_pkts ++;
+            }
+        }
+    }
+    return 0;
+}
+
+TEST_CASE( .name="gencct-plan", .description="test the commands compiled for the devices.", .skip=0 ) {
+    gencct_plan_t plan;
+    gencct_plan_t plan_text;
+    gencct_sink_t sink = GENCCT_SINK_PLAN_INIT(&plan);
+    gencct_sink_t sink_text;
+    char * text = NULL;
+    size_t sz_text = 0;
+    FILE * fp;
+    size_t i;
+
+    unlink(FN_CONF_EDIO24);
+    REQUIRE(0 == create_test_file_edio24conf(FN_CONF_EDIO24));
+    read_file_edio24(FN_CONF_EDIO24);
+    REQUIRE(16 == brdlst_length(&g_lst_edio24));
+
+    SECTION("test the streams are the same as the text compiled") {
+        gencct_plan_init(&plan);
+        gencct_plan_init(&plan_text);
+
+        fp = open_memstream(&text, &sz_text);
+        REQUIRE(NULL != fp);
+        sink_text.emit = gencct_sink_text_emit;
+        sink_text.userdata = fp;
+
+#define GENCCT_TEST_BOTH(func, ...) func(&sink, __VA_ARGS__); func(&sink_text, __VA_ARGS__)
+        GENCCT_TEST_BOTH(gen_power, "p=0,1");
+        GENCCT_TEST_BOTH(gen_setatten, "p=1,3", "p=0,1;v=21");
+        GENCCT_TEST_BOTH(gen_setpower, "p=3,16", "p=all");
+        GENCCT_TEST_BOTH(gen_getpower, "p=1,16", "p=1");
+        GENCCT_TEST_BOTH(gen_atten, "p=0;v=3");
+#undef GENCCT_TEST_BOTH
+        fclose(fp);
+        REQUIRE(0 == ciut_gencct_compile_text(&plan_text, text));
+        free(text);
+
+        // the single device and the clusters 1, 3, 16
+        REQUIRE(4 == plan.num);
+        REQUIRE(plan_text.num == plan.num);
+        REQUIRE(-1 == plan.targets[0].device);
+        REQUIRE(0 == plan.targets[1].device);
+        REQUIRE(2 == plan.targets[2].device);
+        REQUIRE(15 == plan.targets[3].device);
+        // the commands following a device are for the device
+        REQUIRE(2 == plan.targets[0].num_pkts);
+        REQUIRE(6 * 2 + 1 == plan.targets[1].num_pkts);
+        REQUIRE(6 * 2 + 2 == plan.targets[2].num_pkts);
+        REQUIRE(2 + 1 + 6 == plan.targets[3].num_pkts);
+        for (i = 0; i < plan.num; i ++) {
+            REQUIRE(plan_text.targets[i].device == plan.targets[i].device);
+            REQUIRE(plan_text.targets[i].num_pkts == plan.targets[i].num_pkts);
+            REQUIRE(plan_text.targets[i].cmds.sz == plan.targets[i].cmds.sz);
+            REQUIRE(0 == memcmp(plan_text.targets[i].cmds.buf, plan.targets[i].cmds.buf, plan.targets[i].cmds.sz));
+            REQUIRE(0 < edio24_cmdstream_check(plan.targets[i].cmds.buf, plan.targets[i].cmds.sz));
+        }
+        gencct_plan_clean(&plan);
+        gencct_plan_clean(&plan_text);
+        REQUIRE(0 == plan.num);
+        REQUIRE(NULL == plan.targets);
+    }
+}
+
+/** the commands received by the test sink */
+typedef struct _ciut_gencct_rec_t {
+    gencct_cmd_t cmds[256];
+    size_t num;
+} ciut_gencct_rec_t;
+
+static int
+ciut_gencct_rec_emit (gencct_sink_t * psink, const gencct_cmd_t * pcmd)
+{
+    ciut_gencct_rec_t * prec = (ciut_gencct_rec_t *)(psink->userdata);
+    if (prec->num >= NUM_ARRAY(prec->cmds)) {
+        return -1;
+    }
+    prec->cmds[prec->num ++] = *pcmd;
+    return 0;
+}
+
+/**
+ * \brief run the commands of a device on the latches, get the values seen at the timing edges
+ * \param prec: the commands
+ * \param edges: the values of dout and dconf at each Sleep and DOutR, and at the end
+ * \param max: the max number of the values
+ * \return the number of the values
+ *
+ * The bits start from an arbitrary value, the same values seen in a row are counted once.
+ */
+static size_t
+ciut_gencct_rec_edges (const ciut_gencct_rec_t * prec, uint64_t * edges, size_t max)
+{
+    uint32_t dout = 0xA5C3F0;
+    uint32_t dconf = 0x5A3C0F;
+    size_t num = 0;
+    size_t i;
+    uint64_t v;
+
+    for (i = 0; i <= prec->num; i ++) {
+        const gencct_cmd_t * pcmd = &(prec->cmds[i]);
+        if ((i < prec->num) && (GENCCT_OP_DOUTW == pcmd->op)) {
+            dout = (dout & ~pcmd->mask) | (pcmd->value & pcmd->mask);
+            continue;
+        }
+        if ((i < prec->num) && (GENCCT_OP_DCONFW == pcmd->op)) {
+            dconf = (dconf & ~pcmd->mask) | (pcmd->value & pcmd->mask);
+            continue;
+        }
+        if ((i < prec->num) && (GENCCT_OP_SLEEP != pcmd->op) && (GENCCT_OP_DOUTR != pcmd->op)) {
+            continue;
+        }
+        v = ((uint64_t)dconf << 32) | dout;
+        if ((num > 0) && (edges[num - 1] == v)) {
+            continue;
+        }
+        assert (num < max);
+        edges[num ++] = v;
+    }
+    return num;
+}
+
+static size_t
+ciut_gencct_rec_count (const ciut_gencct_rec_t * prec, uint8_t op)
+{
+    size_t i;
+    size_t num = 0;
+    for (i = 0; i < prec->num; i ++) {
+        if (op == prec->cmds[i].op) {
+            num ++;
+        }
+    }
+    return num;
+}
+
+TEST_CASE( .name="gencct-opt", .description="test the peephole optimizer of the commands.", .skip=0 ) {
+    ciut_gencct_rec_t rec_raw;
+    ciut_gencct_rec_t rec_opt;
+    gencct_sink_t sink_raw = { ciut_gencct_rec_emit, &rec_raw };
+    gencct_sink_t sink_rec = { ciut_gencct_rec_emit, &rec_opt };
+    gencct_opt_t opt;
+    gencct_sink_t sink_opt = GENCCT_SINK_OPT_INIT(&opt);
+    uint64_t edges_raw[128];
+    uint64_t edges_opt[128];
+    size_t num;
+    size_t i;
+
+    unlink(FN_CONF_EDIO24);
+    REQUIRE(0 == create_test_file_edio24conf(FN_CONF_EDIO24));
+    read_file_edio24(FN_CONF_EDIO24);
+    REQUIRE(16 == brdlst_length(&g_lst_edio24));
+
+    SECTION("test the two attenuators of different values") {
+        memset(&rec_raw, 0, sizeof(rec_raw));
+        memset(&rec_opt, 0, sizeof(rec_opt));
+        gencct_opt_init(&opt, &sink_rec);
+        // v=21 is set as 10 on the pins 0,2 and 11 on the pins 1,3
+        gen_setatten(&sink_raw, "p=1", "p=0,1;v=21");
+        gen_setatten(&sink_opt, "p=1", "p=0,1;v=21");
+        REQUIRE(0 == gencct_opt_flush(&opt));
+
+        REQUIRE(2 == ciut_gencct_rec_count(&rec_raw, GENCCT_OP_DCONFW));
+        REQUIRE(10 == ciut_gencct_rec_count(&rec_raw, GENCCT_OP_DOUTW));
+        // the second DConfigW is dropped, the DOutW are not merged
+        REQUIRE(1 == ciut_gencct_rec_count(&rec_opt, GENCCT_OP_DCONFW));
+        REQUIRE(10 == ciut_gencct_rec_count(&rec_opt, GENCCT_OP_DOUTW));
+        REQUIRE(ciut_gencct_rec_count(&rec_raw, GENCCT_OP_SLEEP) == ciut_gencct_rec_count(&rec_opt, GENCCT_OP_SLEEP));
+        REQUIRE(ciut_gencct_rec_count(&rec_raw, GENCCT_OP_DEVICE) == ciut_gencct_rec_count(&rec_opt, GENCCT_OP_DEVICE));
+        REQUIRE(ciut_gencct_rec_count(&rec_raw, GENCCT_OP_END) == ciut_gencct_rec_count(&rec_opt, GENCCT_OP_END));
+        REQUIRE(2 + 10 + 4 == opt.num_in);
+        REQUIRE(1 + 10 + 4 == opt.num_out);
+        // the packets sent to the device, 12 without the optimizer
+        REQUIRE(12 == ciut_gencct_rec_count(&rec_raw, GENCCT_OP_DCONFW) + ciut_gencct_rec_count(&rec_raw, GENCCT_OP_DOUTW) + ciut_gencct_rec_count(&rec_raw, GENCCT_OP_DOUTR));
+        REQUIRE(11 == ciut_gencct_rec_count(&rec_opt, GENCCT_OP_DCONFW) + ciut_gencct_rec_count(&rec_opt, GENCCT_OP_DOUTW) + ciut_gencct_rec_count(&rec_opt, GENCCT_OP_DOUTR));
+
+        // the first strobe: the pins 0,2 low, the bus 10, the pins high, the pins low, then the bus low
+        REQUIRE(GENCCT_OP_DEVICE == rec_opt.cmds[0].op);
+        REQUIRE(GENCCT_OP_DCONFW == rec_opt.cmds[1].op);
+        REQUIRE(GENCCT_OP_DOUTW == rec_opt.cmds[2].op);
+        REQUIRE(0x000500 == rec_opt.cmds[2].mask);
+        REQUIRE(0x000000 == rec_opt.cmds[2].value);
+        REQUIRE(GENCCT_OP_DOUTW == rec_opt.cmds[3].op);
+        REQUIRE(0xFF0000 == rec_opt.cmds[3].mask);
+        REQUIRE(0x0A0000 == rec_opt.cmds[3].value);
+        REQUIRE(GENCCT_OP_SLEEP == rec_opt.cmds[4].op);
+        REQUIRE(GENCCT_OP_DOUTW == rec_opt.cmds[5].op);
+        REQUIRE(0x000500 == rec_opt.cmds[5].mask);
+        REQUIRE(0x000500 == rec_opt.cmds[5].value);
+        REQUIRE(GENCCT_OP_SLEEP == rec_opt.cmds[6].op);
+        // the latch is closed before the data bus is released
+        REQUIRE(GENCCT_OP_DOUTW == rec_opt.cmds[7].op);
+        REQUIRE(0x000500 == rec_opt.cmds[7].mask);
+        REQUIRE(0x000000 == rec_opt.cmds[7].value);
+        REQUIRE(GENCCT_OP_DOUTW == rec_opt.cmds[8].op);
+        REQUIRE(0x0A0000 == rec_opt.cmds[8].mask);
+        REQUIRE(0x000000 == rec_opt.cmds[8].value);
+        for (i = 0; i < rec_opt.num; i ++) {
+            if (GENCCT_OP_DOUTW == rec_opt.cmds[i].op) {
+                // the latch enables at port 1 are never written with the data bus
+                REQUIRE((0 == (rec_opt.cmds[i].mask & 0x00FF00)) || (0 == (rec_opt.cmds[i].mask & ~0x00FF00)));
+            }
+        }
+
+        num = ciut_gencct_rec_edges(&rec_raw, edges_raw, NUM_ARRAY(edges_raw));
+        REQUIRE(num == ciut_gencct_rec_edges(&rec_opt, edges_opt, NUM_ARRAY(edges_opt)));
+        for (i = 0; i < num; i ++) {
+            REQUIRE(edges_raw[i] == edges_opt[i]);
+        }
+    }
+    SECTION("test the commands of a device") {
+        memset(&rec_raw, 0, sizeof(rec_raw));
+        memset(&rec_opt, 0, sizeof(rec_opt));
+        gencct_opt_init(&opt, &sink_rec);
+        gen_power(&sink_raw, "p=0,1");
+        gen_power(&sink_opt, "p=0,1");
+        gen_power(&sink_raw, "p=0,1");
+        gen_power(&sink_opt, "p=0,1");
+        gen_atten(&sink_raw, "p=0,1;v=31");
+        gen_atten(&sink_opt, "p=0,1;v=31");
+        gen_atten(&sink_raw, "p=0,1;v=31");
+        gen_atten(&sink_opt, "p=0,1;v=31");
+        gen_power_read(&sink_raw, "");
+        gen_power_read(&sink_opt, "");
+        num = ciut_gencct_rec_edges(&rec_raw, edges_raw, NUM_ARRAY(edges_raw));
+        REQUIRE(num == ciut_gencct_rec_edges(&rec_opt, edges_opt, NUM_ARRAY(edges_opt)));
+        for (i = 0; i < num; i ++) {
+            REQUIRE(edges_raw[i] == edges_opt[i]);
+        }
+        // the second power, the DConfigW of the attenuators and the pin low of the second are dropped
+        REQUIRE(2 * 2 + 8 * 2 + 1 == opt.num_in);
+        REQUIRE(2 + 7 + 6 + 1 == opt.num_out);
+        REQUIRE(ciut_gencct_rec_count(&rec_raw, GENCCT_OP_END) == ciut_gencct_rec_count(&rec_opt, GENCCT_OP_END));
+
+        // the states are forgotten at another device
+        memset(&rec_opt, 0, sizeof(rec_opt));
+        gen_getpower(&sink_opt, "p=1,2", "p=1");
+        gen_setpower(&sink_opt, "p=1,2", "p=0");
+        REQUIRE(2 == ciut_gencct_rec_count(&rec_opt, GENCCT_OP_DCONFW));
+        REQUIRE(2 == ciut_gencct_rec_count(&rec_opt, GENCCT_OP_DOUTW));
+        REQUIRE(2 == ciut_gencct_rec_count(&rec_opt, GENCCT_OP_DOUTR));
+    }
+}
+
+#define FN_CONF_TOPO "tmp-conf-topo.txt"
+
+TEST_CASE( .name="gencct-topology", .description="test the topology of the boards.", .skip=0 ) {
+    gencct_topo_t topo;
+    gencct_bits_t bits;
+    gencct_bits_t sel;
+    unsigned int val;
+    char * text = NULL;
+    size_t sz_text = 0;
+    size_t i;
+    size_t num;
+    FILE * fp;
+
+    unlink(FN_CONF_EDIO24);
+    REQUIRE(0 == create_test_file_edio24conf(FN_CONF_EDIO24));
+    read_file_edio24(FN_CONF_EDIO24);
+    REQUIRE(16 == brdlst_length(&g_lst_edio24));
+
+    SECTION("test the bitsets") {
+        REQUIRE(0 == gencct_bits_init(&bits, 200));
+        REQUIRE(200 == gencct_bits_next(&bits, 0));
+        gencct_bits_set_range(&bits, 60, 130);
+        REQUIRE(! gencct_bits_test(&bits, 59));
+        REQUIRE(gencct_bits_test(&bits, 60));
+        REQUIRE(gencct_bits_test(&bits, 64));
+        REQUIRE(gencct_bits_test(&bits, 129));
+        REQUIRE(! gencct_bits_test(&bits, 130));
+        REQUIRE(60 == gencct_bits_next(&bits, 0));
+        REQUIRE(128 == gencct_bits_next(&bits, 128));
+        REQUIRE(200 == gencct_bits_next(&bits, 130));
+        gencct_bits_set(&bits, 199);
+        gencct_bits_set(&bits, 200);
+        REQUIRE(199 == gencct_bits_next(&bits, 130));
+        REQUIRE(200 == gencct_bits_next(&bits, 200));
+
+        val = EDIO24_INVALID_INT;
+        REQUIRE(0 == parse_values_bits("p=1,3-5,130,1000;v=31", &bits, &val));
+        REQUIRE(31 == val);
+        for (num = 0, i = gencct_bits_next(&bits, 0); i < bits.num; i = gencct_bits_next(&bits, i + 1), num ++);
+        REQUIRE(5 == num);
+        REQUIRE(gencct_bits_test(&bits, 1));
+        REQUIRE(gencct_bits_test(&bits, 4));
+        REQUIRE(gencct_bits_test(&bits, 130));
+        REQUIRE(0 == parse_values_bits("p=all", &bits, &val));
+        REQUIRE(0 == gencct_bits_next(&bits, 0));
+        REQUIRE(199 == gencct_bits_next(&bits, 199));
+        REQUIRE(0 > parse_values_bits("p=1;v=", &bits, &val));
+        REQUIRE(0 > parse_values_bits("c=1", &bits, &val));
+        gencct_bits_clean(&bits);
+    }
+    SECTION("test the topology file") {
+        fp = fopen(FN_CONF_TOPO, "w");
+        REQUIRE(NULL != fp);
+        fprintf(fp, "# cluster position device pin name\n");
+        fprintf(fp, "2\t1\t0\t4\tCCT_B-1\n");
+        fprintf(fp, "2\t2\t0\t5\tCCT_B-2\n");
+        fprintf(fp, "1\t1\t0\t0\tCCT_A-1\n");
+        fprintf(fp, "1\t2\t0\t1\tCCT_A-2\n");
+        fprintf(fp, "3\t1\t1\t0\tCCT_C-1\n");
+        fprintf(fp, "3\t2\t2\t0\tCCT_C-2\n");
+        fprintf(fp, "0\t0\t-1\t-1\tCCT_ROOT\n");
+        fprintf(fp, "3\tx\n");
+        // not the power pins
+        fprintf(fp, "3\t3\t2\t8\tCCT_C-3\n");
+        fprintf(fp, "3\t3\t2\t40\tCCT_C-4\n");
+        fclose(fp);
+        REQUIRE(0 == gencct_topo_load(&g_topo, FN_CONF_TOPO));
+        REQUIRE(7 == g_topo.num);
+        REQUIRE(0 > gencct_topo_find(&g_topo, "CCT_C-3"));
+        REQUIRE(0 > gencct_topo_find(&g_topo, "CCT_C-4"));
+        REQUIRE(4 == g_topo.num_clusters);
+        REQUIRE(3 == g_topo.num_positions);
+        REQUIRE(3 == g_topo.num_devices);
+        REQUIRE(0 == strcmp("CCT_ROOT", g_topo.boards[0].name));
+        REQUIRE(0 == strcmp("CCT_A-1", g_topo.boards[1].name));
+        REQUIRE(&g_topo == gencct_topo_get());
+
+        fp = open_memstream(&text, &sz_text);
+        REQUIRE(NULL != fp);
+        // two clusters on one device
+        do_setpower(fp, "p=1,2", "p=2");
+        // one cluster on two devices
+        do_setpower(fp, "p=3", "p=1");
+        do_getpower(fp, "p=all", "");
+        fclose(fp);
+        REQUIRE(0 == strcmp(text,
+            "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\n"
+            "DConfigW 0xFFFFFF 0x000000\n"
+            "DOutW 0x000033 0x000022\n"
+            "\n"
+            "# ConnectTo 192.168.1.102	00:11:22:33:44:02	E-DIO24-334402 # 2\n"
+            "DConfigW 0xFFFFFF 0x000000\n"
+            "DOutW 0x000001 0x000001\n"
+            "\n"
+            "# ConnectTo 192.168.1.103	00:11:22:33:44:03	E-DIO24-334403 # 3\n"
+            "DConfigW 0xFFFFFF 0x000000\n"
+            "DOutW 0x000001 0x000000\n"
+            "\n"
+            "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\n"
+            "DOutR\n"
+            "\n"
+            "# ConnectTo 192.168.1.102	00:11:22:33:44:02	E-DIO24-334402 # 2\n"
+            "DOutR\n"
+            "\n"
+            "# ConnectTo 192.168.1.103	00:11:22:33:44:03	E-DIO24-334403 # 3\n"
+            "DOutR\n"
+            "\n"
+            ));
+        free(text);
+        unlink(FN_CONF_TOPO);
+        // back to the default
+        REQUIRE(0 == gencct_topo_default(&g_topo, brdlst_length(&g_lst_edio24)));
+        REQUIRE(17 * 9 == g_topo.num);
+    }
+    SECTION("test the selection of a large topology") {
+        gencct_topo_init(&topo);
+        REQUIRE(0 == gencct_topo_default(&topo, 1000));
+        REQUIRE(1001 * 9 == topo.num);
+        REQUIRE(1001 == topo.num_clusters);
+        REQUIRE(1000 == topo.num_devices);
+        REQUIRE(0 == gencct_topo_parse_select(&topo, "p=2-1000", "p=1,8", &sel, &val));
+        for (num = 0, i = gencct_bits_next(&sel, 0); i < sel.num; i = gencct_bits_next(&sel, i + 1), num ++) {
+            REQUIRE(topo.boards[i].cluster >= 2);
+            REQUIRE((1 == topo.boards[i].position) || (8 == topo.boards[i].position));
+        }
+        REQUIRE(999 * 2 == num);
+        REQUIRE(0 == strcmp("CCT_C1000-08", topo.boards[sel.num - 1].name));
+        gencct_bits_clean(&sel);
+        gencct_topo_clean(&topo);
+    }
+}
+
+#define FN_CONF_ACTIONS "tmp-conf-actions.txt"
+
+TEST_CASE( .name="gencct-actions", .description="test the power actions of the boards.", .skip=0 ) {
+    gencct_plan_t plan;
+    gencct_sink_t sink = GENCCT_SINK_PLAN_INIT(&plan);
+    BRDLST_DECLARE_INIT(lst);
+    char * text = NULL;
+    size_t sz_text = 0;
+    size_t i;
+    char buf[100];
+    FILE * fp;
+
+    unlink(FN_CONF_EDIO24);
+    REQUIRE(0 == create_test_file_edio24conf(FN_CONF_EDIO24));
+    read_file_edio24(FN_CONF_EDIO24);
+    REQUIRE(16 == brdlst_length(&g_lst_edio24));
+
+    SECTION("test the actions are merged for each device") {
+        fp = fopen(FN_CONF_ACTIONS, "w");
+        REQUIRE(NULL != fp);
+        fprintf(fp, "CCT_C16-08 on\n");
+        fprintf(fp, "CCT_C01-03 on\n");
+        fprintf(fp, "CCT_C02-01\ton\n");
+        fprintf(fp, "CCT_C01-05 off\n");
+        fprintf(fp, "CCT_C01-03 off\n");
+        fprintf(fp, "CCT_C01-06 1\n");
+        fprintf(fp, "CCT_C99-01 on\n");
+        fprintf(fp, "CCT_C00-01 on\n");
+        fprintf(fp, "CCT_C01-01 reset\n");
+        fclose(fp);
+
+        fp = open_memstream(&text, &sz_text);
+        REQUIRE(NULL != fp);
+        // not found, no device, unknown action
+        REQUIRE(3 == do_actions(fp, FN_CONF_ACTIONS));
+        fclose(fp);
+        REQUIRE(0 == strcmp(text,
+            "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\n"
+            "DConfigW 0xFFFFFF 0x000000\n"
+            "DOutW 0x000034 0x000020\n"
+            "\n"
+            "# ConnectTo 192.168.1.102	00:11:22:33:44:02	E-DIO24-334402 # 2\n"
+            "DConfigW 0xFFFFFF 0x000000\n"
+            "DOutW 0x000001 0x000001\n"
+            "\n"
+            "# ConnectTo 192.168.1.116	00:11:22:33:44:16	E-DIO24-334416 # 16\n"
+            "DConfigW 0xFFFFFF 0x000000\n"
+            "DOutW 0x000080 0x000080\n"
+            "\n"
+            ));
+        free(text);
+        unlink(FN_CONF_ACTIONS);
+    }
+    SECTION("test all of the boards, one write for each device") {
+        for (i = 1; i <= 16; i ++) {
+            snprintf(buf, sizeof(buf), "CCT_C%02d-%02d on", (int)(17 - i), (int)(i % 8 + 1));
+            brdlst_append(&lst, buf);
+            snprintf(buf, sizeof(buf), "CCT_C%02d-%02d off", (int)i, (int)((i + 3) % 8 + 1));
+            brdlst_append(&lst, buf);
+        }
+        gencct_plan_init(&plan);
+        REQUIRE(0 == gen_actions(&sink, &lst));
+        REQUIRE(16 == plan.num);
+        for (i = 0; i < plan.num; i ++) {
+            REQUIRE(i == plan.targets[i].device);
+            REQUIRE(2 == plan.targets[i].num_pkts);
+        }
+        gencct_plan_clean(&plan);
+        brdlst_clean(&lst);
+    }
+}
+#endif /* CIUT_ENABLED */
+
+#if ! defined(CIUT_ENABLED) || (CIUT_ENABLED == 0)
+/*****************************************************************************/
+// execute the command streams of the plan, all of the devices are driven by one loop
+
+/** a device being driven */
+typedef struct _gencct_dev_t {
+    gencct_target_t * ptarget;
+    char host[64];          /**< the IPv4 address of the device */
+    struct sockaddr_in addr_tcp;
+    struct sockaddr_in addr_udp;
+    uv_udp_t uvudp;
+    uv_udp_send_t req_udp;
+    uint8_t pkt_udp[8];     /**< the 'open device' packet */
+    uv_tcp_t uvtcp;
+    uv_connect_t connect;
+    uvtransport_t transport;
+    uvtransport_t * put;    /**< the transport of TCP, NULL for the simulated device */
+    uvloopback_t uvlb;      /**< the transport to the simulated device */
+    edio24_svrsession_t svr; /**< the simulated device */
+    edio24_session_t session;
+    char flg_session;       /**< 1 -- the session is ready */
+    char flg_done;          /**< 1 -- all of the responses have been received, or failed */
+    size_t off_next;        /**< the offset of the next record in the stream */
+    uint64_t offset_next;   /**< the requested time of the next record, in microseconds from the start */
+    uint64_t time_start;
+    edio24_timer_t tm_job;
+    size_t num_requests;
+    size_t num_responds;
+    size_t num_errors;      /**< the number of the responses failed */
+    size_t num_burst;       /**< the number of the requests released together, for -S */
+    uint64_t time_sent;     /**< the time the burst is written */
+    uint64_t time_ack;      /**< the time the burst is all responded, 0 if not yet */
+} gencct_dev_t;
+
+#define GENCCT_EXEC_TIMEOUT 10 /**< the default seconds of timeout of the execution */
+
+/** the execution of a plan */
+typedef struct _gencct_exec_t {
+    uv_loop_t * loop;
+    uvclock_t uvclk;
+    edio24_timer_t tm_timeout;
+    char flg_loopback;      /**< 1 -- the devices are simulated in the process */
+    char flg_timeout;
+    char flg_sync;          /**< 1 -- the first bursts of the devices are released together */
+    char flg_adaptive;      /**< 1 -- the requests in flight of a device are limited by the adaptive window of its session */
+    uint64_t deadline;      /**< the microseconds to wait for the response of a request, 0 -- no limit */
+    char flg_released;      /**< 1 -- the bursts are released */
+    char flg_staging;       /**< 1 -- the bursts are being staged */
+    size_t num_devs;
+    size_t num_done;
+    size_t num_ready;       /**< the number of the sessions ready */
+    size_t num_failed_open; /**< the number of the devices failed before the session is ready */
+    uint64_t time_release;
+    gencct_dev_t * devs;
+} gencct_exec_t;
+
+static gencct_exec_t g_gencct_exec;
+
+static void
+gencct_alloc_buffer (uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf)
+{
+    buf->base = malloc(suggested_size);
+    buf->len = (NULL == buf->base ? 0 : suggested_size);
+}
+
+static void
+on_gencct_close (uv_handle_t * handle)
+{
+}
+
+static void
+on_gencct_walk (uv_handle_t * handle, void * arg)
+{
+    if (! uv_is_closing(handle)) {
+        uv_close(handle, on_gencct_close);
+    }
+}
+
+static void gencct_exec_release (void);
+
+/**
+ * \brief the device is finished, stop the loop if it is the last one
+ * \param pdev: the device
+ */
+static void
+gencct_dev_done (gencct_dev_t * pdev)
+{
+    if (pdev->flg_done) {
+        return;
+    }
+    pdev->flg_done = 1;
+    edio24_timer_stop(&(g_gencct_exec.uvclk.clock), &(pdev->tm_job));
+    g_gencct_exec.num_done ++;
+    if (! pdev->flg_session) {
+        g_gencct_exec.num_failed_open ++;
+        gencct_exec_release();
+    }
+    fprintf(stderr, "gencctcmd device %d(%s) done: requests=%" PRIuSZ ", responds=%" PRIuSZ ", errors=%" PRIuSZ ", retries=%" PRIuSZ ", timeouts=%" PRIuSZ "\n"
+        , pdev->ptarget->device + 1, pdev->host, pdev->num_requests, pdev->num_responds, pdev->num_errors, pdev->session.stats.num_retry, pdev->session.stats.num_timeout);
+    if (g_gencct_exec.flg_adaptive && pdev->flg_session) {
+        edio24_session_stats_t * pst = &(pdev->session.stats);
+        fprintf(stderr, "gencctcmd device %d(%s) window=%" PRIuSZ ", rtt min=%" PRIu64 ", avg=%" PRIu64 " microseconds, backoff busy=%" PRIuSZ ", rtt=%" PRIuSZ "\n"
+            , pdev->ptarget->device + 1, pdev->host, edio24_session_window(&(pdev->session)), pst->rtt_min, pst->rtt_avg, pst->num_backoff_busy, pst->num_backoff_rtt);
+    }
+    if (g_gencct_exec.num_done >= g_gencct_exec.num_devs) {
+        // close all of the handles to end the loop
+        edio24_timer_stop(&(g_gencct_exec.uvclk.clock), &(g_gencct_exec.tm_timeout));
+        uv_walk(g_gencct_exec.loop, on_gencct_walk, NULL);
+    }
+}
+
+/**
+ * \brief the device is failed, the requests waiting for the responses are cancelled
+ * \param pdev: the device
+ * \param msg: the error
+ */
+static void
+gencct_dev_fail (gencct_dev_t * pdev, const char * msg)
+{
+    fprintf(stderr, "gencctcmd device %d(%s) %s\n", pdev->ptarget->device + 1, pdev->host, msg);
+    pdev->num_errors ++;
+    if (pdev->flg_session) {
+        // on_gencct_respond() ignores the requests cancelled
+        edio24_session_clean(&(pdev->session));
+    }
+    gencct_dev_done(pdev);
+}
+
+static void gencct_dev_run (gencct_dev_t * pdev);
+
+static void
+on_gencct_job (edio24_timer_t * ptm, void * userdata)
+{
+    gencct_dev_run((gencct_dev_t *)userdata);
+}
+
+/**
+ * \brief the callback of the session for the responses
+ * \param pss: the session
+ * \param presp: the response, NULL if the request is cancelled
+ * \param userdata: the device
+ */
+static void
+on_gencct_respond (edio24_session_t * pss, const edio24_response_t * presp, void * userdata)
+{
+    gencct_dev_t * pdev = (gencct_dev_t *)userdata;
+    uint32_t val = 0;
+
+    if (NULL == presp) {
+        return;
+    }
+    pdev->num_responds ++;
+    if ((pdev->num_burst > 0) && (0 == pdev->time_ack) && (pdev->num_responds >= pdev->num_burst)) {
+        pdev->time_ack = edio24_clock_now(&(g_gencct_exec.uvclk.clock));
+    }
+    if (EDIO24_STATUS_SUCCESS != presp->status) {
+        pdev->num_errors ++;
+        fprintf(stderr, "gencctcmd device %d(%s) %s error: 0x%02X(%s)\n", pdev->ptarget->device + 1, pdev->host
+            , edio24_val2cstr_cmd(presp->cmd), presp->status, edio24_val2cstr_status(presp->status));
+    } else if ((EDIO24_CMD_DOUT_R == presp->cmd) && (edio24_pkt_read_ret_doutr(presp->pkt, presp->sz_pkt, &val) >= 0)) {
+        fprintf(stdout, "%d\t%s\tDOutR\t0x%06X\n", pdev->ptarget->device + 1, pdev->host, val);
+    }
+    gencct_dev_run(pdev);
+}
+
+static void
+on_gencct_respond_unknown (edio24_session_t * pss, const edio24_response_t * presp, void * userdata)
+{
+    gencct_dev_t * pdev = (gencct_dev_t *)userdata;
+    fprintf(stderr, "gencctcmd device %d(%s) unexpected response: cmd=%s(0x%02X), frame=%d\n", pdev->ptarget->device + 1, pdev->host
+        , edio24_val2cstr_cmd(presp->cmd), presp->cmd, presp->frame);
+}
+
+/**
+ * \brief send the records of the device which are due, and arm the timer to the next one
+ * \param pdev: the device
+ *
+ * The same as the scheduler of edio24cli: a Sleep moves the time of the following records,
+ * a Barrier holds them until all of the previous requests are responded, and a packet is held
+ * while the adaptive window is full, except in the burst released together.
+ */
+static void
+gencct_dev_stage (gencct_dev_t * pdev)
+{
+    edio24_clock_t * pclk = &(g_gencct_exec.uvclk.clock);
+    edio24_cmdstream_t * pcs = &(pdev->ptarget->cmds);
+    edio24_cmdrec_t rec;
+    uint8_t pkt[EDIO24_PKT_LENGTH_MIN + 1024];
+    ssize_t ret;
+    ssize_t sz_pkt;
+    uint64_t target;
+    uint64_t now;
+
+    while (! pdev->flg_done) {
+        ret = edio24_cmdstream_next(pcs->buf, pcs->sz, pdev->off_next, &rec);
+        if (ret < 0) {
+            fprintf(stderr, "gencctcmd device %d(%s) error in the stream at pos(%" PRIuSZ ")\n", pdev->ptarget->device + 1, pdev->host, pdev->off_next);
+            pdev->num_errors ++;
+            gencct_dev_done(pdev);
+            return;
+        }
+        if ((ret > 0) && (EDIO24_CMDSTREAM_OP_SLEEP == rec.op)) {
+            if (g_gencct_exec.flg_staging) {
+                // the burst released together ends at the first Sleep, the rest is sent by the timer
+                edio24_timer_start_at(pclk, &(pdev->tm_job), edio24_clock_now(pclk), on_gencct_job, pdev);
+                return;
+            }
+            pdev->offset_next += rec.sleep;
+            pdev->off_next += ret;
+            continue;
+        }
+        target = pdev->time_start + pdev->offset_next;
+        now = edio24_clock_now(pclk);
+        if (target > now) {
+            edio24_timer_start_at(pclk, &(pdev->tm_job), target, on_gencct_job, pdev);
+            return;
+        }
+        if (0 == ret) {
+            if (0 == edio24_session_inflight(&(pdev->session))) {
+                gencct_dev_done(pdev);
+            }
+            return;
+        }
+        if ((EDIO24_CMDSTREAM_OP_BARRIER == rec.op) && (edio24_session_inflight(&(pdev->session)) > 0)) {
+            return;
+        }
+        if ((EDIO24_CMDSTREAM_OP_PKT == rec.op) && g_gencct_exec.flg_adaptive && (! g_gencct_exec.flg_staging)
+            && (edio24_session_inflight(&(pdev->session)) >= edio24_session_window(&(pdev->session)))) {
+            // sent by on_gencct_respond() when a response frees a slot
+            return;
+        }
+        pdev->off_next += ret;
+        if (EDIO24_CMDSTREAM_OP_PKT != rec.op) {
+            continue;
+        }
+        sz_pkt = edio24_cmdstream_emit(&rec, pkt, sizeof(pkt), &(pdev->session.frame));
+        if ((sz_pkt < 0) || (edio24_session_send(&(pdev->session), pkt, sz_pkt, on_gencct_respond, pdev) < 0)) {
+            fprintf(stderr, "gencctcmd device %d(%s) error in send the packet at pos(%" PRIuSZ ")\n", pdev->ptarget->device + 1, pdev->host, rec.pos);
+            pdev->num_errors ++;
+            continue;
+        }
+        pdev->num_requests ++;
+    }
+}
+
+/**
+ * \brief send the records of the device which are due, in one write of the socket
+ * \param pdev: the device
+ */
+static void
+gencct_dev_run (gencct_dev_t * pdev)
+{
+    if (NULL == pdev->put) {
+        gencct_dev_stage(pdev);
+        return;
+    }
+    uvtransport_cork(pdev->put);
+    gencct_dev_stage(pdev);
+    if (uvtransport_uncork(pdev->put) < 0) {
+        gencct_dev_fail(pdev, "error in write the packets");
+    }
+}
+
+/**
+ * \brief release the first bursts of all of the devices together, if all of the sessions are ready
+ *
+ * The packets due are staged in the transports of all devices first, then written one socket after another.
+ */
+static void
+gencct_exec_release (void)
+{
+    edio24_clock_t * pclk = &(g_gencct_exec.uvclk.clock);
+    gencct_dev_t * pdev;
+    uint64_t now;
+    size_t i;
+
+    if ((! g_gencct_exec.flg_sync) || g_gencct_exec.flg_released) {
+        return;
     }
-    val = 0;
-    parse_values_atten (arg_cluster, &mask_c, &val);
-    mask_c &= 0x1FFFF;
-
-    if (NULL == arg_cmd) {
-        arg_cmd = "";
+    if (g_gencct_exec.num_ready + g_gencct_exec.num_failed_open < g_gencct_exec.num_devs) {
+        return;
     }
-    val = 0;
-    parse_values_atten (arg_cmd, &mask_p, &val);
-    mask_p &= 0x01FF;
-    mask_p >>= 1; // remove the position 0(for root)
-    fprintf(stderr, "do_setpower: arg_cluster='%s', arg_cmd='%s'; mask_p=0x%02X, val=%d\n", arg_cluster, arg_cmd, mask_p, val);
-
-    // skip the cluster 0 (root)
-    for (i = 1; i <= 16; i ++) {
-        if (mask_c & (0x0001 << i)) {
-            ret = get_ip_of_edio24(i-1, buf, sizeof(buf));
-            if (ret < 0) {
-                fprintf(stderr, "error in get the ip of edio24 at idx=%d\n", i);
-                continue;
-            }
-            fprintf(fp, "# ConnectTo %s # %d\n", brdlst_get(&g_lst_edio24, i-1), i);
-            snprintf(buf, sizeof(buf)-1, "p=");
-            for(j = 0; j < 8; j++) {
-                if (mask_p & (0x0001 << j)) {
-                    snprintf(buf+strlen(buf), sizeof(buf)-1-strlen(buf), "%d,", j);
-                }
-            }
-            output_power(fp, buf);
+    g_gencct_exec.flg_released = 1;
+    g_gencct_exec.flg_staging = 1;
+    now = edio24_clock_now(pclk);
+    g_gencct_exec.time_release = now;
+    for (i = 0; i < g_gencct_exec.num_devs; i ++) {
+        pdev = &(g_gencct_exec.devs[i]);
+        if ((! pdev->flg_session) || pdev->flg_done) {
+            continue;
+        }
+        // the same start time, the Sleeps of the devices are aligned
+        pdev->time_start = now;
+        if (NULL != pdev->put) {
+            uvtransport_cork(pdev->put);
+        }
+        gencct_dev_stage(pdev);
+        pdev->num_burst = pdev->num_requests;
+    }
+    g_gencct_exec.flg_staging = 0;
+    for (i = 0; i < g_gencct_exec.num_devs; i ++) {
+        pdev = &(g_gencct_exec.devs[i]);
+        if (pdev->num_burst < 1) {
+            continue;
+        }
+        if ((NULL != pdev->put) && (uvtransport_uncork(pdev->put) < 0)) {
+            gencct_dev_fail(pdev, "error in write the burst");
+            continue;
         }
+        pdev->time_sent = edio24_clock_now(pclk);
     }
 }
 
 /**
- * \brief get the EDIO24 raw commands sequence to get power status
- * \param fp: the FILE pointer for output
- * \param arg_cluster: the C string for cluster info
- * \param arg_cmd: the C string for board info
+ * \brief start the stream of the device on the session
+ * \param pdev: the device
+ * \param ptr: the transport of the session
  */
-void
-do_getpower(FILE *fp, const char * arg_cluster, const char *arg_cmd)
+static void
+gencct_dev_start (gencct_dev_t * pdev, edio24_transport_t * ptr)
 {
-    int i;
-    int ret;
-    unsigned int val;
-    unsigned int mask_c;
-    unsigned int mask_p;
-    char buf[200];
-
-    if (NULL == arg_cluster) {
-        arg_cluster = "";
+    edio24_session_init(&(pdev->session), ptr);
+    edio24_session_set_default(&(pdev->session), on_gencct_respond_unknown, pdev);
+    if (g_gencct_exec.flg_adaptive) {
+        edio24_session_set_window(&(pdev->session), &(g_gencct_exec.uvclk.clock), 1, EDIO24_SESSION_WINDOW_MAX);
     }
-    val = 0;
-    parse_values_atten (arg_cluster, &mask_c, &val);
-    mask_c &= 0x1FFFF;
-
-    if (NULL == arg_cmd) {
-        arg_cmd = "";
+    edio24_session_set_retry(&(pdev->session), &(g_gencct_exec.uvclk.clock), EDIO24_SESSION_RETRY_BACKOFF, EDIO24_SESSION_RETRY_BUDGET);
+    if (g_gencct_exec.deadline > 0) {
+        edio24_session_set_timeout(&(pdev->session), &(g_gencct_exec.uvclk.clock), g_gencct_exec.deadline);
     }
-    val = 0;
-    parse_values_atten (arg_cmd, &mask_p, &val);
-    mask_p &= 0x01FF;
-    mask_p >>= 1; // remove the position 0(for root)
-    fprintf(stderr, "do_getpower: arg_cluster='%s', arg_cmd='%s'; mask_p=0x%02X, mask_c=0x%02X, val=%d\n", arg_cluster, arg_cmd, mask_p, mask_c, val);
-
-    // skip the cluster 0 (root)
-    for (i = 1; i <= 16; i ++) {
-        if (mask_c & (0x0001 << i)) {
-            ret = get_ip_of_edio24(i-1, buf, sizeof(buf));
-            if (ret < 0) {
-                fprintf(stderr, "error in get the ip of edio24 at idx=%d\n", i);
-                continue;
-            }
-            fprintf(fp, "# ConnectTo %s # %d\n", brdlst_get(&g_lst_edio24, i-1), i);
-            output_power_read(fp, (void *)arg_cmd);
-        }
+    pdev->flg_session = 1;
+    pdev->off_next = EDIO24_CMDSTREAM_HDR_SIZE;
+    pdev->offset_next = 0;
+    pdev->time_start = edio24_clock_now(&(g_gencct_exec.uvclk.clock));
+    if (g_gencct_exec.flg_sync) {
+        g_gencct_exec.num_ready ++;
+        gencct_exec_release();
+        return;
     }
+    gencct_dev_run(pdev);
 }
 
-#if defined(CIUT_ENABLED) && (CIUT_ENABLED == 1)
+static void
+on_gencct_tcp_read (uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf)
+{
+    gencct_dev_t * pdev = (gencct_dev_t *)(stream->data);
+    if (nread > 0) {
+        // the session calls on_gencct_respond() for each response
+        uvtransport_recv(&(pdev->transport), (uint8_t *)(buf->base), nread);
+    } else if (nread < 0) {
+        fprintf(stderr, "gencctcmd device %d(%s) closed: %s\n", pdev->ptarget->device + 1, pdev->host, uv_strerror(nread));
+        pdev->num_errors ++;
+        gencct_dev_done(pdev);
+    }
+    free(buf->base);
+}
 
-#include <ciut.h>
+static void
+on_gencct_tcp_connect (uv_connect_t* connection, int status)
+{
+    gencct_dev_t * pdev = (gencct_dev_t *)(connection->data);
 
-typedef struct _ciut_test_dotest_t {
-    const char * arg_cluster;
-    const char * arg_cmd;
-} ciut_test_dotest_t;
+    if (status < 0) {
+        fprintf(stderr, "gencctcmd device %d(%s) connect error: %s\n", pdev->ptarget->device + 1, pdev->host, uv_strerror(status));
+        pdev->num_errors ++;
+        gencct_dev_done(pdev);
+        return;
+    }
+    uvtransport_init(&(pdev->transport), connection->handle);
+    pdev->put = &(pdev->transport);
+    pdev->uvtcp.data = pdev;
+    uv_read_start(connection->handle, gencct_alloc_buffer, on_gencct_tcp_read);
+    gencct_dev_start(pdev, &(pdev->transport.base));
+}
 
-static int
-cb_ciut_check_output_doatten (FILE * outf, void * user_arg)
+static void
+on_gencct_udp_read (uv_udp_t *handle, ssize_t nread, const uv_buf_t *buf, const struct sockaddr *addr, unsigned flags)
 {
-    ciut_test_dotest_t * arg = (ciut_test_dotest_t *)user_arg;
-    do_setatten(outf, arg->arg_cluster, arg->arg_cmd);
-    return 0;
+    gencct_dev_t * pdev = (gencct_dev_t *)(handle->data);
+
+    if ((nread == 0) && (NULL == addr)) {
+        // nothing to read
+        free(buf->base);
+        return;
+    }
+    uv_udp_recv_stop(handle);
+    if ((nread == 2) && ('C' == buf->base[0]) && (0 == buf->base[1])) {
+        pdev->connect.data = pdev;
+        uv_tcp_connect(&(pdev->connect), &(pdev->uvtcp), (const struct sockaddr*)&(pdev->addr_tcp), on_gencct_tcp_connect);
+    } else {
+        fprintf(stderr, "gencctcmd device %d(%s) open failed: size=%" PRIiSZ "\n", pdev->ptarget->device + 1, pdev->host, nread);
+        pdev->num_errors ++;
+        gencct_dev_done(pdev);
+    }
+    free(buf->base);
 }
 
-static int
-cb_ciut_check_output_dosetpower (FILE * outf, void * user_arg)
+static void
+on_gencct_udp_send (uv_udp_send_t *req, int status)
 {
-    ciut_test_dotest_t * arg = (ciut_test_dotest_t *)user_arg;
-    do_setpower(outf, arg->arg_cluster, arg->arg_cmd);
-    return 0;
+    gencct_dev_t * pdev = (gencct_dev_t *)(req->handle->data);
+    if (status < 0) {
+        fprintf(stderr, "gencctcmd device %d(%s) send error: %s\n", pdev->ptarget->device + 1, pdev->host, uv_strerror(status));
+        pdev->num_errors ++;
+        gencct_dev_done(pdev);
+        return;
+    }
+    uv_udp_recv_start(req->handle, gencct_alloc_buffer, on_gencct_udp_read);
 }
 
-static int
-cb_ciut_check_output_dogetpower (FILE * outf, void * user_arg)
+static void
+on_gencct_timeout (edio24_timer_t * ptm, void * userdata)
 {
-    ciut_test_dotest_t * arg = (ciut_test_dotest_t *)user_arg;
-    do_getpower(outf, arg->arg_cluster, arg->arg_cmd);
-    return 0;
+    size_t i;
+    g_gencct_exec.flg_timeout = 1;
+    fprintf(stderr, "gencctcmd timeout\n");
+    for (i = 0; i < g_gencct_exec.num_devs; i ++) {
+        g_gencct_exec.devs[i].num_errors ++;
+        gencct_dev_done(&(g_gencct_exec.devs[i]));
+    }
 }
 
-TEST_CASE( .name="do-test", .description="test output cluster.", .skip=0 ) {
-
-    int i;
-    ciut_test_dotest_t args;
+/**
+ * \brief print the times of the bursts released together, and the skews between the devices
+ */
+static void
+gencct_exec_report_skew (void)
+{
+    gencct_dev_t * pdev;
+    uint64_t sent_min = UINT64_MAX;
+    uint64_t sent_max = 0;
+    uint64_t ack_min = UINT64_MAX;
+    uint64_t ack_max = 0;
+    size_t num = 0;
+    size_t i;
+
+    for (i = 0; i < g_gencct_exec.num_devs; i ++) {
+        pdev = &(g_gencct_exec.devs[i]);
+        if ((pdev->num_burst < 1) || (0 == pdev->time_ack)) {
+            fprintf(stderr, "gencctcmd device %d(%s) sync: not acknowledged\n", pdev->ptarget->device + 1, pdev->host);
+            continue;
+        }
+        fprintf(stderr, "gencctcmd device %d(%s) sync: requests=%" PRIuSZ ", sent=%" PRIu64 " us, ack=%" PRIu64 " us, send-to-ack=%" PRIu64 " us\n"
+            , pdev->ptarget->device + 1, pdev->host, pdev->num_burst
+            , pdev->time_sent - g_gencct_exec.time_release, pdev->time_ack - g_gencct_exec.time_release, pdev->time_ack - pdev->time_sent);
+        sent_min = (pdev->time_sent < sent_min ? pdev->time_sent : sent_min);
+        sent_max = (pdev->time_sent > sent_max ? pdev->time_sent : sent_max);
+        ack_min = (pdev->time_ack < ack_min ? pdev->time_ack : ack_min);
+        ack_max = (pdev->time_ack > ack_max ? pdev->time_ack : ack_max);
+        num ++;
+    }
+    if (num > 0) {
+        fprintf(stderr, "gencctcmd sync: devices=%" PRIuSZ ", send skew=%" PRIu64 " us, ack skew=%" PRIu64 " us\n", num, sent_max - sent_min, ack_max - ack_min);
+    }
+}
 
-    static const char * iodata_atten[] = {
-        // cluster, atten pos, output
-        "p=1", "p=all;v=20",   "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDConfigW 0xFFFFFF 0x000000\nDOutW 0x000F00 0x000000\nDOutW 0xFF0000 0x0A0000\nSleep 1\nDOutW 0x000F00 0x000F00\nSleep 1\nDOutW 0x000F00 0x000000\nDOutW 0xFF0000 0x000000\n\n",
-        "p=1", "p=all;v=31",   "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDConfigW 0xFFFFFF 0x000000\nDOutW 0x000500 0x000000\nDOutW 0xFF0000 0x0F0000\nSleep 1\nDOutW 0x000500 0x000500\nSleep 1\nDOutW 0x000500 0x000000\nDOutW 0xFF0000 0x000000\n\nDConfigW 0xFFFFFF 0x000000\nDOutW 0x000A00 0x000000\nDOutW 0xFF0000 0x100000\nSleep 1\nDOutW 0x000A00 0x000A00\nSleep 1\nDOutW 0x000A00 0x000000\nDOutW 0xFF0000 0x000000\n\n",
-        "p=1", "p=0;v=31",     "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDConfigW 0xFFFFFF 0x000000\nDOutW 0x000100 0x000000\nDOutW 0xFF0000 0x0F0000\nSleep 1\nDOutW 0x000100 0x000100\nSleep 1\nDOutW 0x000100 0x000000\nDOutW 0xFF0000 0x000000\n\nDConfigW 0xFFFFFF 0x000000\nDOutW 0x000200 0x000000\nDOutW 0xFF0000 0x100000\nSleep 1\nDOutW 0x000200 0x000200\nSleep 1\nDOutW 0x000200 0x000000\nDOutW 0xFF0000 0x000000\n\n",
-    };
-    static const char * iodata_power[] = {
-        // cluster, board pos, output
-        "p=1", "p=",       "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDConfigW 0xFFFFFF 0x000000\nDOutW 0x0000FF 0x000000\n\n",
-        "p=1", "p=0,1,2",  "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDConfigW 0xFFFFFF 0x000000\nDOutW 0x0000FF 0x000003\n\n",
-        "p=1", "p=1,2",    "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDConfigW 0xFFFFFF 0x000000\nDOutW 0x0000FF 0x000003\n\n",
-        "p=1", "p=1,2,3",  "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDConfigW 0xFFFFFF 0x000000\nDOutW 0x0000FF 0x000007\n\n",
-        "p=1", "p=all",    "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDConfigW 0xFFFFFF 0x000000\nDOutW 0x0000FF 0x0000FF\n\n",
-    };
-    static const char * iodata_power_read[] = {
-        // cluster, board pos, output
-        "p=1", "p=",       "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDOutR\n\n",
-        "p=1", "p=0,1,2",  "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDOutR\n\n",
-        "p=1", "p=all",    "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDOutR\n\n",
-#if 1
-        "p=0,1", "p=all",    "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDOutR\n\n",
-        "p=0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,15", "p=all",
-            "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDOutR\n\n"
-            "# ConnectTo 192.168.1.102	00:11:22:33:44:02	E-DIO24-334402 # 2\nDOutR\n\n"
-            "# ConnectTo 192.168.1.103	00:11:22:33:44:03	E-DIO24-334403 # 3\nDOutR\n\n"
-            "# ConnectTo 192.168.1.104	00:11:22:33:44:04	E-DIO24-334404 # 4\nDOutR\n\n"
-            "# ConnectTo 192.168.1.105	00:11:22:33:44:05	E-DIO24-334405 # 5\nDOutR\n\n"
-            "# ConnectTo 192.168.1.106	00:11:22:33:44:06	E-DIO24-334406 # 6\nDOutR\n\n"
-            "# ConnectTo 192.168.1.107	00:11:22:33:44:07	E-DIO24-334407 # 7\nDOutR\n\n"
-            "# ConnectTo 192.168.1.108	00:11:22:33:44:08	E-DIO24-334408 # 8\nDOutR\n\n"
-            "# ConnectTo 192.168.1.109	00:11:22:33:44:09	E-DIO24-334409 # 9\nDOutR\n\n"
-            "# ConnectTo 192.168.1.110	00:11:22:33:44:10	E-DIO24-334410 # 10\nDOutR\n\n"
-            "# ConnectTo 192.168.1.111	00:11:22:33:44:11	E-DIO24-334411 # 11\nDOutR\n\n"
-            "# ConnectTo 192.168.1.112	00:11:22:33:44:12	E-DIO24-334412 # 12\nDOutR\n\n"
-            "# ConnectTo 192.168.1.113	00:11:22:33:44:13	E-DIO24-334413 # 13\nDOutR\n\n"
-            "# ConnectTo 192.168.1.114	00:11:22:33:44:14	E-DIO24-334414 # 14\nDOutR\n\n"
-            "# ConnectTo 192.168.1.115	00:11:22:33:44:15	E-DIO24-334415 # 15\nDOutR\n\n"
-            ,
-        "p=0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16", "p=all",
-            "# ConnectTo 192.168.1.101	00:11:22:33:44:01	E-DIO24-334401 # 1\nDOutR\n\n"
-            "# ConnectTo 192.168.1.102	00:11:22:33:44:02	E-DIO24-334402 # 2\nDOutR\n\n"
-            "# ConnectTo 192.168.1.103	00:11:22:33:44:03	E-DIO24-334403 # 3\nDOutR\n\n"
-            "# ConnectTo 192.168.1.104	00:11:22:33:44:04	E-DIO24-334404 # 4\nDOutR\n\n"
-            "# ConnectTo 192.168.1.105	00:11:22:33:44:05	E-DIO24-334405 # 5\nDOutR\n\n"
-            "# ConnectTo 192.168.1.106	00:11:22:33:44:06	E-DIO24-334406 # 6\nDOutR\n\n"
-            "# ConnectTo 192.168.1.107	00:11:22:33:44:07	E-DIO24-334407 # 7\nDOutR\n\n"
-            "# ConnectTo 192.168.1.108	00:11:22:33:44:08	E-DIO24-334408 # 8\nDOutR\n\n"
-            "# ConnectTo 192.168.1.109	00:11:22:33:44:09	E-DIO24-334409 # 9\nDOutR\n\n"
-            "# ConnectTo 192.168.1.110	00:11:22:33:44:10	E-DIO24-334410 # 10\nDOutR\n\n"
-            "# ConnectTo 192.168.1.111	00:11:22:33:44:11	E-DIO24-334411 # 11\nDOutR\n\n"
-            "# ConnectTo 192.168.1.112	00:11:22:33:44:12	E-DIO24-334412 # 12\nDOutR\n\n"
-            "# ConnectTo 192.168.1.113	00:11:22:33:44:13	E-DIO24-334413 # 13\nDOutR\n\n"
-            "# ConnectTo 192.168.1.114	00:11:22:33:44:14	E-DIO24-334414 # 14\nDOutR\n\n"
-            "# ConnectTo 192.168.1.115	00:11:22:33:44:15	E-DIO24-334415 # 15\nDOutR\n\n"
-            "# ConnectTo 192.168.1.116	00:11:22:33:44:16	E-DIO24-334416 # 16\nDOutR\n\n"
-            ,
-#endif
-    };
+/**
+ * \brief send the command streams of the plan to the devices concurrently
+ * \param pplan: the plan
+ * \param host: the address of the single device
+ * \param port_udp: the UDP port of the devices
+ * \param port_tcp: the TCP port of the devices
+ * \param timeout: the seconds of timeout, 0 -- no limit
+ * \param flg_loopback: 1 -- the devices are simulated in the process
+ * \param flg_sync: 1 -- wait for all of the sessions, and release the first bursts together
+ * \param flg_adaptive: 1 -- the requests in flight of each device are limited by an adaptive window
+ * \param deadline: the milliseconds to wait for the response of a request, 0 -- no limit
+ * \return 0 on success, 1 if any of the devices failed, <0 on error
+ */
+int
+gencct_exec (gencct_plan_t * pplan, const char * host, int port_udp, int port_tcp, time_t timeout, char flg_loopback, char flg_sync, char flg_adaptive, time_t deadline)
+{
+    gencct_dev_t * pdev;
+    size_t num_failed = 0;
+    ssize_t sz;
+    size_t i;
+    int ret;
 
-    board_list_t *plst = &g_lst_edio24;
+    assert (NULL != pplan);
+    if (pplan->num < 1) {
+        fprintf(stderr, "gencctcmd no command to execute\n");
+        return 0;
+    }
+    memset(&g_gencct_exec, 0, sizeof(g_gencct_exec));
+    g_gencct_exec.flg_loopback = flg_loopback;
+    g_gencct_exec.flg_sync = flg_sync;
+    g_gencct_exec.flg_adaptive = flg_adaptive;
+    g_gencct_exec.deadline = (uint64_t)deadline * 1000;
+    g_gencct_exec.devs = (gencct_dev_t *)calloc(pplan->num, sizeof(gencct_dev_t));
+    if (NULL == g_gencct_exec.devs) {
+        return -1;
+    }
+    g_gencct_exec.num_devs = pplan->num;
+    g_gencct_exec.loop = uv_default_loop();
+    if (uvclock_init(g_gencct_exec.loop, &(g_gencct_exec.uvclk), 0) < 0) {
+        free(g_gencct_exec.devs);
+        return -1;
+    }
+    edio24_timer_init(&(g_gencct_exec.tm_timeout));
+    if (timeout > 0) {
+        edio24_timer_start(&(g_gencct_exec.uvclk.clock), &(g_gencct_exec.tm_timeout), (uint64_t)timeout * 1000000, on_gencct_timeout, NULL);
+    }
 
-    brdlst_clean(plst);
-    brdlst_init(plst);
+    for (i = 0; i < pplan->num; i ++) {
+        pdev = &(g_gencct_exec.devs[i]);
+        pdev->ptarget = &(pplan->targets[i]);
+        edio24_timer_init(&(pdev->tm_job));
+        if (pdev->ptarget->device < 0) {
+            snprintf(pdev->host, sizeof(pdev->host), "%s", host);
+        } else if (get_ip_of_edio24(pdev->ptarget->device, pdev->host, sizeof(pdev->host)) < 0) {
+            fprintf(stderr, "error in get the ip of edio24 at idx=%d\n", pdev->ptarget->device + 1);
+            pdev->num_errors ++;
+            gencct_dev_done(pdev);
+            continue;
+        }
+        if (flg_loopback) {
+            uvloopback_init(g_gencct_exec.loop, &(pdev->uvlb), 0);
+            edio24_svrsession_init(&(pdev->svr), edio24_loopback_device(&(pdev->uvlb.lb)), 0);
+            gencct_dev_start(pdev, edio24_loopback_client(&(pdev->uvlb.lb)));
+            continue;
+        }
+        uv_ip4_addr(pdev->host, port_tcp, &(pdev->addr_tcp));
+        uv_ip4_addr(pdev->host, port_udp, &(pdev->addr_udp));
+        uv_tcp_init(g_gencct_exec.loop, &(pdev->uvtcp));
+        pdev->uvtcp.data = pdev;
+        uv_udp_init(g_gencct_exec.loop, &(pdev->uvudp));
+        pdev->uvudp.data = pdev;
+        sz = edio24_pkt_create_opendev(pdev->pkt_udp, sizeof(pdev->pkt_udp), 0);
+        if (sz > 0) {
+            uv_buf_t msg = uv_buf_init((char *)(pdev->pkt_udp), sz);
+            ret = uv_udp_send(&(pdev->req_udp), &(pdev->uvudp), &msg, 1, (const struct sockaddr *)&(pdev->addr_udp), on_gencct_udp_send);
+        } else {
+            ret = -1;
+        }
+        if (ret < 0) {
+            fprintf(stderr, "gencctcmd device %d(%s) error in open the device\n", pdev->ptarget->device + 1, pdev->host);
+            pdev->num_errors ++;
+            gencct_dev_done(pdev);
+        }
+    }
 
-    //CIUT_LOG ("insert data");
-    brdlst_append(plst, "192.168.1.101	00:11:22:33:44:01	E-DIO24-334401");
-    brdlst_append(plst, "192.168.1.102	00:11:22:33:44:02	E-DIO24-334402");
-    brdlst_append(plst, "192.168.1.103	00:11:22:33:44:03	E-DIO24-334403");
-    brdlst_append(plst, "192.168.1.104	00:11:22:33:44:04	E-DIO24-334404");
-    brdlst_append(plst, "192.168.1.105	00:11:22:33:44:05	E-DIO24-334405");
-    brdlst_append(plst, "192.168.1.106	00:11:22:33:44:06	E-DIO24-334406");
-    brdlst_append(plst, "192.168.1.107	00:11:22:33:44:07	E-DIO24-334407");
-    brdlst_append(plst, "192.168.1.108	00:11:22:33:44:08	E-DIO24-334408");
-    brdlst_append(plst, "192.168.1.109	00:11:22:33:44:09	E-DIO24-334409");
-    brdlst_append(plst, "192.168.1.110	00:11:22:33:44:10	E-DIO24-334410");
-    brdlst_append(plst, "192.168.1.111	00:11:22:33:44:11	E-DIO24-334411");
-    brdlst_append(plst, "192.168.1.112	00:11:22:33:44:12	E-DIO24-334412");
-    brdlst_append(plst, "192.168.1.113	00:11:22:33:44:13	E-DIO24-334413");
-    brdlst_append(plst, "192.168.1.114	00:11:22:33:44:14	E-DIO24-334414");
-    brdlst_append(plst, "192.168.1.115	00:11:22:33:44:15	E-DIO24-334415");
-    brdlst_append(plst, "192.168.1.116	00:11:22:33:44:16	E-DIO24-334416");
+    uv_run(g_gencct_exec.loop, UV_RUN_DEFAULT);
 
-    SECTION("test output atten's valid p arg") {
-        for (i = 0; i < ARRAY_NUM(iodata_atten); i += 3) {
-            CIUT_LOG ("output atten idx=%d", i/3);
-            args.arg_cluster = iodata_atten[i + 0];
-            args.arg_cmd = iodata_atten[i + 1];
-            REQUIRE(0 == ciut_check_output(cb_ciut_check_output_doatten, (void *)(&args), iodata_atten[i + 2]));
-        }
+    if (flg_sync) {
+        gencct_exec_report_skew();
     }
-    SECTION("test output power's valid p arg") {
-        for (i = 0; i < ARRAY_NUM(iodata_power); i += 3) {
-            CIUT_LOG ("output power idx=%d", i/3);
-            args.arg_cluster = iodata_power[i + 0];
-            args.arg_cmd = iodata_power[i + 1];
-            REQUIRE(0 == ciut_check_output(cb_ciut_check_output_dosetpower, (void *)(&args), iodata_power[i + 2]));
+    for (i = 0; i < g_gencct_exec.num_devs; i ++) {
+        pdev = &(g_gencct_exec.devs[i]);
+        if ((pdev->num_errors > 0) || (pdev->num_responds < pdev->num_requests)) {
+            num_failed ++;
         }
-    }
-    SECTION("test output power_read valid p arg") {
-        for (i = 0; i < ARRAY_NUM(iodata_power_read); i += 3) {
-            CIUT_LOG ("output power idx=%d", i/3);
-            args.arg_cluster = iodata_power_read[i + 0];
-            args.arg_cmd = iodata_power_read[i + 1];
-            REQUIRE(0 == ciut_check_output(cb_ciut_check_output_dogetpower, (void *)(&args), iodata_power_read[i + 2]));
+        if (pdev->flg_session) {
+            edio24_session_clean(&(pdev->session));
+        }
+        if (NULL != pdev->put) {
+            uvtransport_clean(pdev->put);
+        }
+        if (flg_loopback) {
+            edio24_svrsession_clean(&(pdev->svr));
+            uvloopback_clean(&(pdev->uvlb));
         }
     }
-
-    brdlst_clean(plst);
-    REQUIRE(0 == plst->sz_max);
-    REQUIRE(0 == plst->sz_cur);
-    REQUIRE(NULL == plst->list);
-    brdlst_init(plst);
-    REQUIRE(0 == plst->sz_max);
-    REQUIRE(0 == plst->sz_cur);
-    REQUIRE(NULL == plst->list);
+    uvclock_clean(&(g_gencct_exec.uvclk));
+    uv_loop_close(g_gencct_exec.loop);
+    fprintf(stderr, "gencctcmd executed: devices=%" PRIuSZ ", failed=%" PRIuSZ "\n", g_gencct_exec.num_devs, num_failed);
+    free(g_gencct_exec.devs);
+    memset(&g_gencct_exec, 0, sizeof(g_gencct_exec));
+    return (num_failed > 0 ? 1 : 0);
 }
 
-#endif /* CIUT_ENABLED */
-
-
 /*****************************************************************************/
-#if ! defined(CIUT_ENABLED) || (CIUT_ENABLED == 0)
 static void
 version (void)
 {
@@ -1701,8 +4538,20 @@ help(const char * progname)
 
     fprintf (stderr, "\t-i <edio24 file>\tEDIO24 config file\n");
     fprintf (stderr, "\t-j <board file>\tCCT board config file\n");
+    fprintf (stderr, "\t-m <topology file>\tthe boards of the clusters, the lines of '<cluster> <position> <device> <pin> <board name>', the pin is 0-7 of the port 0\n");
+    fprintf (stderr, "\t\tdefault: the cluster i is at the EDIO24 i-1, the board 'CCT_Cii-jj' is powered by the pin j-1\n");
     fprintf (stderr, "\t-a <ATTEN VALUES>\tgenerate EDIO24 commands for attenuation of a specify device\n");
     fprintf (stderr, "\t-p <POWER VALUES>\tgenerate EDIO24 commands for power on/off of a specify device\n");
+    fprintf (stderr, "\t-f <actions file>\tgenerate one power write for each EDIO24 of the lines '<board name> <on|off>', '-' for stdin\n");
+
+    fprintf (stderr, "\t-x\texecute the commands on the devices concurrently, instead of printing them for edio24cli\n");
+    fprintf (stderr, "\t-H <addr>\tthe address of the single EDIO24 of -x, default 127.0.0.1\n");
+    fprintf (stderr, "\t-L\tthe devices of -x are simulated in the process\n");
+    fprintf (stderr, "\t-T <seconds>\tthe timeout of -x, default %d, 0 -- no limit\n", GENCCT_EXEC_TIMEOUT);
+    fprintf (stderr, "\t-O\tdrop the redundant commands and merge the Sleeps\n");
+    fprintf (stderr, "\t-S\tthe commands of -x are released to all of the devices together, and the skew is reported\n");
+    fprintf (stderr, "\t-D <time>\tthe milliseconds of -x to wait for the response of a request, 0 -- no limit (default)\n");
+    fprintf (stderr, "\t-A\tthe requests of -x in flight are limited by a window adapted to each device by the busy errors and the RTT\n");
 
     fprintf (stderr, "\t-h\tPrint this message.\n");
     fprintf (stderr, "\t-v\tVerbose information.\n");
@@ -1716,6 +4565,9 @@ help(const char * progname)
     fprintf (stderr, "\nATTEN VALUES\n");
     fprintf (stderr, "\t'p=0,1,2;v=31' -- pin 0, 1, and 2; value 31.\n");
 
+    fprintf (stderr, "\nCLUSTER and BOARD VALUES of -c, -a, -p, -r, -b\n");
+    fprintf (stderr, "\t'p=1,3-5' -- the clusters or the positions 1, 3, 4 and 5.\n");
+
     fprintf (stderr, "\nExamples for single EDIO24\n");
     fprintf (stderr, "\t%s -n 'p=0,1;v=21'\n", progname);
     fprintf (stderr, "\t%s -w 'p=all' \n", progname);
@@ -1736,6 +4588,10 @@ help(const char * progname)
     fprintf (stderr, "\t\tget the record line of the board('CCT_C16-08').\n\n");
     fprintf (stderr, "\t* %s -i cct-edio24-list.txt -j cct-board-list.txt -c 'p=1' -r 'p=1' \n", progname);
     fprintf (stderr, "\t\tread the power status of the board at cluster 1('CCT_C01-01').\n\n");
+    fprintf (stderr, "\t* %s -i cct-edio24-list.txt -f actions.txt \n", progname);
+    fprintf (stderr, "\t\tpower on/off the boards listed, such as 'CCT_C01-02 on', with one write to each EDIO24.\n\n");
+    fprintf (stderr, "\t* %s -x -i cct-edio24-list.txt -j cct-board-list.txt -c 'p=all' -p 'p=all' \n", progname);
+    fprintf (stderr, "\t\tpower on all of boards in all clusters, the EDIO24s are driven by this process.\n\n");
 }
 
 static void
@@ -1749,6 +4605,21 @@ int
 main(int argc, char * argv[])
 {
     char flg_verbose = 0;
+    char flg_exec = 0;
+    char flg_loopback = 0;
+    char flg_sync = 0;
+    char flg_adaptive = 0;
+    time_t deadline = 0;
+    const char * host = "127.0.0.1";
+    time_t timeout = GENCCT_EXEC_TIMEOUT;
+    gencct_plan_t plan;
+    gencct_sink_t sink_text = GENCCT_SINK_TEXT_INIT(stdout);
+    gencct_sink_t sink_plan = GENCCT_SINK_PLAN_INIT(&plan);
+    gencct_opt_t opt;
+    gencct_sink_t sink_opt = GENCCT_SINK_OPT_INIT(&opt);
+    gencct_sink_t * psink = &sink_text;
+    char flg_opt = 0;
+    int ret = 0;
     char * cluster = "";
     int c;
     struct option longopts[]  = {
@@ -1758,31 +4629,82 @@ main(int argc, char * argv[])
 
         { "config-edio24", 1, 0, 'i' }, /* the config file for EDIO24 */
         { "config-board", 1, 0, 'j' }, /* the config file for boards */
+        { "topology",     1, 0, 'm' }, /* the topology file of the boards */
+        { "actions",      1, 0, 'f' }, /* the power actions of the boards */
         { "getboard",     1, 0, 'b' }, /* get the device line, 0 for root, 1-8 for boards */
         { "setatten",     1, 0, 'a' }, /* set the attenuation. p: 0-upper, 1-lower */
         { "setpower",     1, 0, 'p' }, /* set the power on/off 0-8, 0 for root, 1-8 for boards */
         { "getpower",     1, 0, 'r' }, /* get the power status of 0-8, 0 for root, 1-8 for boards */
         { "cluster",      1, 0, 'c' }, /* the cluster number 0-16, 0 for root, 1-16 for boards */
 
+        { "exec",         0, 0, 'x' }, /* execute the commands instead of printing them */
+        { "host",         1, 0, 'H' }, /* the address of the single EDIO24 */
+        { "loopback",     0, 0, 'L' }, /* the devices are simulated */
+        { "timeout",      1, 0, 'T' }, /* the seconds of timeout */
+        { "optimize",     0, 0, 'O' }, /* optimize the commands */
+        { "sync",         0, 0, 'S' }, /* release the commands to the devices together */
+        { "adaptive",     0, 0, 'A' }, /* adapt the window of the requests to each device */
+        { "deadline",     1, 0, 'D' }, /* the milliseconds to wait for a response */
+
         { "help",         0, 0, 'h' },
         { "verbose",      0, 0, 'v' },
         { 0,              0, 0,  0  },
     };
+#define GENCCT_OPTSTRING "w:n:dr:c:i:j:m:f:b:a:p:xH:LT:OSAD:hv"
+
+    gencct_plan_init(&plan);
+    /* the sink is selected before any command is generated */
+    opterr = 0;
+    while ((c = getopt_long( argc, argv, GENCCT_OPTSTRING, longopts, NULL )) != EOF) {
+        switch (c) {
+            case 'x':
+                flg_exec = 1;
+                psink = &sink_plan;
+                break;
+            case 'H':
+                host = optarg;
+                break;
+            case 'L':
+                flg_loopback = 1;
+                break;
+            case 'T':
+                timeout = atoi(optarg);
+                break;
+            case 'O':
+                flg_opt = 1;
+                break;
+            case 'S':
+                flg_sync = 1;
+                break;
+            case 'A':
+                flg_adaptive = 1;
+                break;
+            case 'D':
+                deadline = atoi(optarg);
+                break;
+        }
+    }
+    opterr = 1;
+    optind = 1;
+    if (flg_opt) {
+        gencct_opt_init(&opt, psink);
+        psink = &sink_opt;
+    }
 
-    while ((c = getopt_long( argc, argv, "w:n:dr:c:i:j:b:a:p:hv", longopts, NULL )) != EOF) {
+    while ((c = getopt_long( argc, argv, GENCCT_OPTSTRING, longopts, NULL )) != EOF) {
         switch (c) {
             /* generate commands for single EDIO24 */
             case 'w':
                 if (strlen (optarg) > 0) {
-                    output_power(stdout, optarg);
+                    gen_power(psink, optarg);
                 }
                 break;
             case 'd':
-                output_power_read(stdout, "");
+                gen_power_read(psink, "");
                 break;
             case 'n':
                 if (strlen (optarg) > 0) {
-                    output_atten(stdout, optarg);
+                    gen_atten(psink, optarg);
                 }
                 break;
 
@@ -1799,14 +4721,33 @@ main(int argc, char * argv[])
             case 'j':
                 read_file_board(optarg);
                 break;
+            case 'm':
+                if (gencct_topo_load(&g_topo, optarg) < 0) {
+                    fprintf(stderr, "Error in load the topology file '%s'\n", optarg);
+                }
+                break;
             case 'a':
-                do_setatten(stdout, cluster, optarg);
+                gen_setatten(psink, cluster, optarg);
                 break;
             case 'p':
-                do_setpower(stdout, cluster, optarg);
+                gen_setpower(psink, cluster, optarg);
                 break;
             case 'r':
-                do_getpower(stdout, cluster, optarg);
+                gen_getpower(psink, cluster, optarg);
+                break;
+            case 'f':
+                if (0 != gen_actions_file(psink, optarg)) {
+                    ret = 1;
+                }
+                break;
+            case 'x':
+            case 'H':
+            case 'L':
+            case 'T':
+            case 'O':
+            case 'S':
+            case 'A':
+            case 'D':
                 break;
 
             case 'h':
@@ -1825,9 +4766,18 @@ main(int argc, char * argv[])
     }
     (void)flg_verbose;
 
+    if (flg_opt) {
+        gencct_opt_flush(&opt);
+        fprintf(stderr, "gencctcmd optimized the commands: %" PRIuSZ " -> %" PRIuSZ "\n", opt.num_in, opt.num_out);
+    }
+    if (flg_exec && (0 == ret)) {
+        ret = gencct_exec(&plan, host, EDIO24_PORT_DISCOVER, EDIO24_PORT_COMMAND, timeout, flg_loopback, flg_sync, flg_adaptive, deadline);
+    }
+    gencct_plan_clean(&plan);
+    gencct_topo_clean(&g_topo);
     brdlst_clean(&g_lst_brd);
     brdlst_clean(&g_lst_edio24);
-    return 0;
+    return (ret < 0 ? 1 : ret);
 }
 
 #endif /* CIUT_ENABLED */
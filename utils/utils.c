@@ -9,6 +9,9 @@
 #include <stdlib.h> // free()
 #include <ctype.h> // isblank()
 #include <assert.h>
+#include <fcntl.h>    // open()
+#include <sys/mman.h> // mmap()
+#include <sys/stat.h>
 
 #include "utils.h"
 
@@ -276,6 +279,102 @@ fread_lines (FILE *fp, void * userdata, int (* process)(off_t pos, char * buf, s
 }
 
 
+/**
+ * \brief map a regular file to the memory for reading
+ * \param fn: the file name
+ * \param psz: the pointer to store the byte size of the file
+ *
+ * \return the mapping, NULL on failed or if the file is empty or not a regular file
+ *
+ */
+const char *
+mmap_file_read (const char * fn, size_t * psz)
+{
+    struct stat st;
+    void * p;
+    int fd;
+
+    assert (NULL != psz);
+    *psz = 0;
+    if (NULL == fn) {
+        return NULL;
+    }
+    fd = open(fn, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    if ((fstat(fd, &st) < 0) || (! S_ISREG(st.st_mode)) || (st.st_size < 1)) {
+        close(fd);
+        return NULL;
+    }
+    p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == p) {
+        return NULL;
+    }
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+    *psz = st.st_size;
+    return (const char *)p;
+}
+
+/**
+ * \brief unmap the file mapped by mmap_file_read()
+ * \param buf: the mapping
+ * \param sz: the byte size of the mapping
+ */
+void
+mmap_file_close (const char * buf, size_t sz)
+{
+    if (NULL != buf) {
+        munmap((void *)buf, sz);
+    }
+}
+
+/**
+ * \brief feed the lines of a buffer to user callback
+ * \param data: the content of the file
+ * \param sz_data: the byte size of the content
+ * \param userdata: the user data
+ * \param process: the callback function
+ *
+ * \return 0 on success, <0 on failed
+ *
+ * The lines are split by memchr(), each one is copied to a reused buffer
+ * with its new line and a trailing zero, as fgets() does.
+ */
+static int
+mread_lines (const char * data, size_t sz_data, void * userdata, int (* process)(off_t pos, char * buf, size_t size, void *userdata))
+{
+    char * buffer = NULL;
+    size_t szbuf = 0;
+    size_t len;
+    const char * p;
+    const char * pend = data + sz_data;
+    const char * pnl;
+
+    for (p = data; p < pend; p = pnl) {
+        pnl = (const char *)memchr(p, '\n', pend - p);
+        pnl = (NULL == pnl ? pend : pnl + 1);
+        len = pnl - p;
+        if (len + 1 > szbuf) {
+            char * buf_new;
+            szbuf = (szbuf > 0 ? szbuf : 5000);
+            for (; szbuf < len + 1; szbuf *= 2);
+            buf_new = (char *)realloc(buffer, szbuf);
+            if (NULL == buf_new) {
+                free (buffer);
+                return -1;
+            }
+            buffer = buf_new;
+        }
+        memmove (buffer, p, len);
+        buffer[len] = 0;
+        process (p - data, buffer, len, userdata);
+    }
+    free (buffer);
+    return 0;
+}
+
 /**
  * \brief read the lines from file and process the commands of the lines
  * \param fn_conf: the file name
@@ -290,6 +389,18 @@ read_file_lines(const char * fn_conf, void * userdata, int (* process)(off_t pos
 {
     int ret = 0;
     FILE *fp = NULL;
+    const char * data;
+    size_t sz_data;
+
+    data = mmap_file_read(fn_conf, &sz_data);
+    if (NULL != data) {
+        ret = 0;
+        if (NULL != process) {
+            ret = mread_lines (data, sz_data, userdata, process);
+        }
+        mmap_file_close(data, sz_data);
+        return ret;
+    }
     if (NULL == fn_conf) {
         fp = stdin;
     } else {
@@ -393,6 +504,36 @@ TEST_CASE( .name="read-file-lines", .description="test utils.", .skip=0 ) {
         REQUIRE(0 == read_file_lines(FN_TEST, &val, process_test_readln));
         REQUIRE(6 == val);
     }
+    SECTION("test read mapped file") {
+        int val = 0;
+        size_t sz = 1;
+        const char * data;
+        FILE *fp;
+
+        // the last line has no new line
+        fp = fopen(FN_TEST, "a");
+        REQUIRE(NULL != fp);
+        fprintf(fp, "\n40");
+        fclose(fp);
+        data = mmap_file_read(FN_TEST, &sz);
+        REQUIRE(NULL != data);
+        REQUIRE(9 == sz);
+        REQUIRE(0 == memcmp("1\n2\n3\n\n40", data, sz));
+        mmap_file_close(data, sz);
+        REQUIRE(0 == read_file_lines(FN_TEST, &val, process_test_readln));
+        REQUIRE(46 == val);
+
+        REQUIRE(NULL == mmap_file_read(NULL, &sz));
+        REQUIRE(0 == sz);
+        REQUIRE(NULL == mmap_file_read("/", &sz));
+        fp = fopen(FN_TEST, "w");
+        REQUIRE(NULL != fp);
+        fclose(fp);
+        REQUIRE(NULL == mmap_file_read(FN_TEST, &sz));
+        val = 0;
+        REQUIRE(0 == read_file_lines(FN_TEST, &val, process_test_readln));
+        REQUIRE(0 == val);
+    }
     unlink(FN_TEST);
 }
 #endif /* CIUT_ENABLED */
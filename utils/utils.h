@@ -35,6 +35,8 @@ typedef int (* fread_line_cb_process_t)(off_t pos, char * buf, size_t size, void
 
 //int fread_lines (FILE *fp, void * userdata, int (* process)(off_t pos, char * buf, size_t size, void *userdata));
 int read_file_lines(const char * fn_conf, void * userdata, int (* process)(off_t pos, char * buf, size_t size, void *userdata));
+const char * mmap_file_read (const char * fn, size_t * psz);
+void mmap_file_close (const char * buf, size_t sz);
 
 int cstr_strip(const char * orig, char * buf, size_t sz_buf);
 
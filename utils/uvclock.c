@@ -0,0 +1,160 @@
+/**
+ * \file    uvclock.c
+ * \brief   drive the edio24 clock by a libuv loop
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ *
+ * A real clock arms one timer of the loop to its earliest deadline.
+ * On Linux it is a timerfd set to the absolute monotonic time of the deadline and polled by the loop,
+ * so the timers fire within microseconds; the other systems use a uv_timer_t rounded up to milliseconds.
+ * A virtual clock is not touched by the loop, it only moves forward by edio24_clock_forward(),
+ * so waiting for the network costs no virtual time.
+ */
+
+#include <stdio.h>
+#include <string.h> // memset()
+#include <unistd.h> // read(), close()
+#include <assert.h>
+
+#include "uvclock.h"
+
+static void uvclock_arm (edio24_clock_t * pclk, void * userdata);
+
+#if UVCLOCK_USE_TIMERFD
+static void
+on_uvclock_poll(uv_poll_t * handle, int status, int events)
+{
+    uvclock_t * puc = (uvclock_t *)(handle->data);
+    uint64_t expirations = 0;
+    assert (NULL != puc);
+    if (read(puc->fd, &expirations, sizeof(expirations)) < 0) {
+        /* EAGAIN, the timer was re-armed after the fd is ready */
+        return;
+    }
+    if (0 == edio24_clock_run(&(puc->clock))) {
+        uvclock_arm(&(puc->clock), puc);
+    }
+}
+#endif
+
+static void
+on_uvclock_timer(uv_timer_t * handle)
+{
+    uvclock_t * puc = (uvclock_t *)(handle->data);
+    assert (NULL != puc);
+    if (0 == edio24_clock_run(&(puc->clock))) {
+        /* woke up a little early, the timer is rounded to milliseconds */
+        uvclock_arm(&(puc->clock), puc);
+    }
+}
+
+/**
+ * \brief re-arm the uv timer to the earliest deadline of the clock
+ * \param pclk: the clock
+ * \param userdata: the uvclock_t
+ */
+static void
+uvclock_arm (edio24_clock_t * pclk, void * userdata)
+{
+    uvclock_t * puc = (uvclock_t *)userdata;
+    uint64_t timeout = 0;
+
+    assert (NULL != puc);
+    assert (pclk == &(puc->clock));
+    if (pclk->flg_virtual) {
+        return;
+    }
+#if UVCLOCK_USE_TIMERFD
+    if (puc->fd >= 0) {
+        struct itimerspec its;
+        uint64_t tm_abs;
+        memset(&its, 0, sizeof(its));
+        if (edio24_clock_next_deadline(pclk, &tm_abs) >= 0) {
+            /* the earliest deadline in the monotonic time of the system, 0 disarms the timerfd */
+            tm_abs += pclk->time_base;
+            if (tm_abs < 1) {
+                tm_abs = 1;
+            }
+            its.it_value.tv_sec = tm_abs / 1000000;
+            its.it_value.tv_nsec = (tm_abs % 1000000) * 1000;
+        }
+        timerfd_settime(puc->fd, TFD_TIMER_ABSTIME, &its, NULL);
+        return;
+    }
+#endif
+    if (edio24_clock_next(pclk, &timeout) < 0) {
+        uv_timer_stop(&(puc->timer));
+        return;
+    }
+    uv_timer_start(&(puc->timer), on_uvclock_timer, (timeout + 999) / 1000, 0);
+}
+
+/**
+ * \brief initialize a clock driven by the loop
+ * \param loop: the libuv loop
+ * \param puc: the clock
+ * \param flg_virtual: 1 -- use the virtual time; 0 -- use the real time
+ * \return 0 on success, <0 on error
+ */
+int
+uvclock_init (uv_loop_t * loop, uvclock_t * puc, char flg_virtual)
+{
+    int ret;
+    if ((NULL == loop) || (NULL == puc)) {
+        return -1;
+    }
+    if (edio24_clock_init(&(puc->clock), flg_virtual) < 0) {
+        return -1;
+    }
+    ret = uv_timer_init(loop, &(puc->timer));
+    if (ret < 0) {
+        fprintf(stderr, "uv_timer_init error: %s\n", uv_strerror(ret));
+        edio24_clock_clean(&(puc->clock));
+        return -1;
+    }
+    puc->timer.data = puc;
+#if UVCLOCK_USE_TIMERFD
+    puc->fd = -1;
+    if (! flg_virtual) {
+        puc->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (puc->fd >= 0) {
+            ret = uv_poll_init(loop, &(puc->poll), puc->fd);
+            if (ret < 0) {
+                fprintf(stderr, "uv_poll_init error: %s\n", uv_strerror(ret));
+                close(puc->fd);
+                puc->fd = -1;
+            } else {
+                puc->poll.data = puc;
+                uv_poll_start(&(puc->poll), UV_READABLE, on_uvclock_poll);
+            }
+        }
+        /* fall back to the uv timer if no timerfd */
+    }
+#endif
+    edio24_clock_set_notify(&(puc->clock), uvclock_arm, puc);
+    return 0;
+}
+
+/**
+ * \brief stop the clock, the uv timer should be closed with the other handles of the loop
+ * \param puc: the clock
+ */
+void
+uvclock_clean (uvclock_t * puc)
+{
+    assert (NULL != puc);
+    edio24_clock_set_notify(&(puc->clock), NULL, NULL);
+    edio24_clock_clean(&(puc->clock));
+    if (! uv_is_closing((uv_handle_t *)&(puc->timer))) {
+        uv_timer_stop(&(puc->timer));
+    }
+#if UVCLOCK_USE_TIMERFD
+    if (puc->fd >= 0) {
+        if (! uv_is_closing((uv_handle_t *)&(puc->poll))) {
+            uv_poll_stop(&(puc->poll));
+        }
+        close(puc->fd);
+        puc->fd = -1;
+    }
+#endif
+}
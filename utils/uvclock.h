@@ -0,0 +1,42 @@
+/**
+ * \file    uvclock.h
+ * \brief   drive the edio24 clock by a libuv loop
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ */
+#ifndef _UVCLOCK_H
+#define _UVCLOCK_H 1
+
+#include <uv.h>
+
+#include "edio24clock.h"
+
+#if defined(__linux__)
+#include <sys/timerfd.h>
+#define UVCLOCK_USE_TIMERFD 1
+#else
+#define UVCLOCK_USE_TIMERFD 0
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/** a clock driven by one timer of the loop */
+typedef struct _uvclock_t {
+    edio24_clock_t clock; /**< the clock, the timers are started on it */
+    uv_timer_t timer;     /**< the libuv timer armed to the earliest deadline of a real clock */
+#if UVCLOCK_USE_TIMERFD
+    int fd;               /**< the timerfd used instead of the uv timer, -1 if not available */
+    uv_poll_t poll;       /**< watch the timerfd */
+#endif
+} uvclock_t;
+
+int  uvclock_init (uv_loop_t * loop, uvclock_t * puc, char flg_virtual);
+void uvclock_clean (uvclock_t * puc);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif /* _UVCLOCK_H */
@@ -0,0 +1,229 @@
+/**
+ * \file    uvtransport.c
+ * \brief   the edio24 transports driven by a libuv loop
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ */
+
+#include <stdio.h>
+#include <string.h> // memmove()
+#include <assert.h>
+
+#include "uvtransport.h"
+
+typedef struct {
+    uv_write_t req;
+    uv_buf_t buf;
+} uvtransport_write_t;
+
+static void
+on_uvtransport_write (uv_write_t* req, int status)
+{
+    uvtransport_write_t * wr = (uvtransport_write_t *)req;
+    if (status) {
+        fprintf(stderr, "transport write error %s.\n", uv_strerror(status));
+    }
+    free(wr->buf.base);
+    free(wr);
+}
+
+static ssize_t
+uvtransport_send (edio24_transport_t * ptr, const uint8_t * buf, size_t sz)
+{
+    uvtransport_t * put = (uvtransport_t *)(ptr->data);
+    uvtransport_write_t * wr;
+    int r;
+
+    assert (NULL != put);
+    if (put->flg_cork) {
+        if (put->sz_cork + sz > put->sz_corkmax) {
+            size_t sz_new = (put->sz_corkmax > 0 ? put->sz_corkmax * 2 : 256);
+            uint8_t * p;
+            for (; sz_new < put->sz_cork + sz; sz_new *= 2);
+            p = (uint8_t *)realloc(put->cork, sz_new);
+            if (NULL == p) {
+                return -1;
+            }
+            put->cork = p;
+            put->sz_corkmax = sz_new;
+        }
+        memmove (put->cork + put->sz_cork, buf, sz);
+        put->sz_cork += sz;
+        return sz;
+    }
+    wr = (uvtransport_write_t *)malloc(sizeof(*wr));
+    if (NULL == wr) {
+        return -1;
+    }
+    wr->buf.base = (char *)malloc(sz);
+    if (NULL == wr->buf.base) {
+        free(wr);
+        return -1;
+    }
+    wr->buf.len = sz;
+    memmove (wr->buf.base, buf, sz);
+    r = uv_write((uv_write_t *)wr, put->stream, &(wr->buf), 1, on_uvtransport_write);
+    if (r) {
+        fprintf(stderr, "transport error in write() %s\n", uv_strerror(r));
+        free(wr->buf.base);
+        free(wr);
+        return -1;
+    }
+    return sz;
+}
+
+/**
+ * \brief initialize a transport on a connected libuv stream
+ * \param put: the transport
+ * \param stream: the stream
+ * \return 0 on success, <0 on error
+ *
+ * The caller reads the stream and passes the data to uvtransport_recv().
+ */
+int
+uvtransport_init (uvtransport_t * put, uv_stream_t * stream)
+{
+    if ((NULL == put) || (NULL == stream)) {
+        return -1;
+    }
+    memset(put, 0, sizeof(*put));
+    put->stream = stream;
+    put->base.send = uvtransport_send;
+    put->base.data = put;
+    return 0;
+}
+
+/**
+ * \brief release the data held by the transport
+ * \param put: the transport
+ */
+void
+uvtransport_clean (uvtransport_t * put)
+{
+    assert (NULL != put);
+    free(put->cork);
+    put->cork = NULL;
+    put->sz_cork = 0;
+    put->sz_corkmax = 0;
+    put->flg_cork = 0;
+}
+
+/**
+ * \brief hold the data sent, until uvtransport_uncork()
+ * \param put: the transport
+ */
+void
+uvtransport_cork (uvtransport_t * put)
+{
+    assert (NULL != put);
+    put->flg_cork = 1;
+}
+
+/**
+ * \brief write the data held in one write request, and stop holding the data
+ * \param put: the transport
+ * \return 0 on success, <0 on error
+ */
+int
+uvtransport_uncork (uvtransport_t * put)
+{
+    uvtransport_write_t * wr;
+    int r;
+
+    assert (NULL != put);
+    put->flg_cork = 0;
+    if (put->sz_cork < 1) {
+        return 0;
+    }
+    if (uv_is_closing((uv_handle_t *)(put->stream))) {
+        put->sz_cork = 0;
+        return -1;
+    }
+    wr = (uvtransport_write_t *)malloc(sizeof(*wr));
+    if (NULL == wr) {
+        put->sz_cork = 0;
+        return -1;
+    }
+    // the buffer is passed to the request
+    wr->buf = uv_buf_init((char *)(put->cork), put->sz_cork);
+    put->cork = NULL;
+    put->sz_cork = 0;
+    put->sz_corkmax = 0;
+    r = uv_write((uv_write_t *)wr, put->stream, &(wr->buf), 1, on_uvtransport_write);
+    if (r) {
+        fprintf(stderr, "transport error in write() %s\n", uv_strerror(r));
+        free(wr->buf.base);
+        free(wr);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * \brief pass the data read from the stream to the receiver of the transport
+ * \param put: the transport
+ * \param buf: the data
+ * \param sz: the byte size of the data
+ */
+void
+uvtransport_recv (uvtransport_t * put, uint8_t * buf, size_t sz)
+{
+    assert (NULL != put);
+    if (NULL != put->base.cb_recv) {
+        put->base.cb_recv(put->base.userdata_recv, buf, sz);
+    }
+}
+
+/*****************************************************************************/
+static void
+on_uvloopback_idle (uv_idle_t * handle)
+{
+    uvloopback_t * pul = (uvloopback_t *)(handle->data);
+    assert (NULL != pul);
+    edio24_loopback_pump(&(pul->lb));
+    uv_idle_stop(handle);
+}
+
+static void
+uvloopback_notify (edio24_loopback_t * plb, void * userdata)
+{
+    uvloopback_t * pul = (uvloopback_t *)userdata;
+    assert (NULL != pul);
+    if (! uv_is_closing((uv_handle_t *)&(pul->idler))) {
+        uv_idle_start(&(pul->idler), on_uvloopback_idle);
+    }
+}
+
+/**
+ * \brief initialize a loopback pumped by the loop
+ * \param loop: the libuv loop
+ * \param pul: the loopback
+ * \param sz_ring: the initial size of the ring buffers
+ * \return 0 on success, <0 on error
+ */
+int
+uvloopback_init (uv_loop_t * loop, uvloopback_t * pul, size_t sz_ring)
+{
+    if ((NULL == loop) || (NULL == pul)) {
+        return -1;
+    }
+    if (edio24_loopback_init(&(pul->lb), sz_ring) < 0) {
+        return -1;
+    }
+    uv_idle_init(loop, &(pul->idler));
+    pul->idler.data = pul;
+    edio24_loopback_set_notify(&(pul->lb), uvloopback_notify, pul);
+    return 0;
+}
+
+/**
+ * \brief release the loopback, the idle handle should be closed with the other handles of the loop
+ * \param pul: the loopback
+ */
+void
+uvloopback_clean (uvloopback_t * pul)
+{
+    assert (NULL != pul);
+    edio24_loopback_set_notify(&(pul->lb), NULL, NULL);
+    edio24_loopback_clean(&(pul->lb));
+}
@@ -0,0 +1,47 @@
+/**
+ * \file    uvtransport.h
+ * \brief   the edio24 transports driven by a libuv loop
+ * \author  Yunhui Fu <yhfudev@gmail.com>
+ * \version 1.0
+ */
+#ifndef _UVTRANSPORT_H
+#define _UVTRANSPORT_H 1
+
+#include <uv.h>
+
+#include "edio24session.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/** a transport on a libuv stream (TCP) */
+typedef struct _uvtransport_t {
+    edio24_transport_t base;
+    uv_stream_t * stream;
+    char flg_cork;      /**< 1 -- the data sent are held until uvtransport_uncork() */
+    uint8_t * cork;     /**< the data held */
+    size_t sz_cork;
+    size_t sz_corkmax;
+} uvtransport_t;
+
+int  uvtransport_init (uvtransport_t * put, uv_stream_t * stream);
+void uvtransport_clean (uvtransport_t * put);
+void uvtransport_recv (uvtransport_t * put, uint8_t * buf, size_t sz);
+void uvtransport_cork (uvtransport_t * put);
+int  uvtransport_uncork (uvtransport_t * put);
+
+/** a loopback pumped by an idle handle of the loop when it has data */
+typedef struct _uvloopback_t {
+    edio24_loopback_t lb;
+    uv_idle_t idler;
+} uvloopback_t;
+
+int  uvloopback_init (uv_loop_t * loop, uvloopback_t * pul, size_t sz_ring);
+void uvloopback_clean (uvloopback_t * pul);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif /* _UVTRANSPORT_H */